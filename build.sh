@@ -1 +1 @@
-g++ -std=c++11 -O2 main.cpp SDLBufferRenderer.cpp SDLAudioPlayer.cpp SDLInputChecker.cpp gb/gbz80cpu.cpp gb/gbmem.cpp gb/gbcart.cpp gb/gbpad.cpp gb/gblcd.cpp gb/gbaudio.cpp gb/gbserial.cpp -lSDL2 -lSDL2_mixer -o yagbe 
+g++ -std=c++11 -O2 main.cpp SDLBufferRenderer.cpp SDLAudioPlayer.cpp SDLInputChecker.cpp NullAudioPlayer.cpp gb/gbz80cpu.cpp gb/gbmem.cpp gb/gbcart.cpp gb/gbpad.cpp gb/gblcd.cpp gb/gbaudio.cpp gb/gbserial.cpp gb/gbjit.cpp gb/gbscheduler.cpp gb/gbtimer.cpp gb/gbmbc.cpp gb/gbmbc1.cpp gb/gbmbc2.cpp gb/gbmbc3.cpp gb/gbmbc5.cpp gb/gbromimage.cpp gb/gbsavefile.cpp gb/gbbus.cpp gb/gblinekernels.cpp -lSDL2 -lSDL2_mixer -o yagbe 
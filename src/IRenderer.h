@@ -1,13 +1,11 @@
 #pragma once
+#include <stdint.h>
 #include "constants.h"
 
-//Forward declare RGB Color struct since we need to inclue IRenderer in GBLCD where RGBColor is defined
-#ifndef RBGColor
-struct RGBColor;
-#endif
-
 class IRenderer{
   public:
-    virtual void update(RGBColor** buffer, int width, int height) = 0;
+    //Takes a frame of 32 bit ARGB pixels, row-major with pitch pixels from the start of one row to the next.
+    //Pixels are only valid for the duration of the call, so renderers should upload them straight from the buffer rather than keep the pointer.
+    virtual void update(const uint32_t* pixels, int pitch, int width, int height) = 0;
     virtual void render() = 0;
 };
\ No newline at end of file
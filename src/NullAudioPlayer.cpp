@@ -0,0 +1,16 @@
+#include "NullAudioPlayer.h"
+
+void NullAudioPlayer::addNote(uint16_t note){
+    
+}
+
+void NullAudioPlayer::mixNotes(uint16_t* src, uint16_t* dest, long long length){
+    //Keep mixing roughly the same cost as a real player
+    for(long long i = 0; i < length; i++){
+        dest[i] += src[i];
+    }
+}
+
+uint32_t NullAudioPlayer::getSampleRate(){
+    return NULL_PLAYBACK_FREQUENCY;
+}
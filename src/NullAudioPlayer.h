@@ -0,0 +1,14 @@
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include "IAudioPlayer.h"
+
+#define NULL_PLAYBACK_FREQUENCY 44100
+
+//Audio player that throws everything away. Used when running without a window, such as for benchmarking.
+class NullAudioPlayer : public IAudioPlayer {
+    public:
+        void addNote(uint16_t note);
+        void mixNotes(uint16_t* src, uint16_t* dest, long long length);
+        uint32_t getSampleRate();
+};
@@ -14,11 +14,9 @@ class SDLBufferRenderer : public IRenderer {
     private:
       SDL_Renderer* m_Renderer;
       SDL_Texture* m_OutputTexture;
-      unsigned char* m_TextureBytes = NULL;
-      int m_TexturePitch;
 
     public:
       SDLBufferRenderer(SDL_Renderer* renderer);
-      void update(RGBColor** buffer, int width, int height);
+      void update(const uint32_t* pixels, int pitch, int width, int height);
       void render();
 };
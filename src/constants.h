@@ -14,3 +14,33 @@
 #define BLAARG_TEST_OUTPUT false
 #define ENABLE_BOOTROM true
 #define USE_THREADED_AUDIO true
+#define USE_LAZY_FLAGS true
+#define USE_HALT_FAST_FORWARD true
+#define USE_IDLE_LOOP_DETECTION true
+#define USE_BACKGROUND_SAVE true
+#define USE_SIMD_LINE_KERNELS true
+
+//Build the CPU loop as a direct threaded interpreter. Needs GCC or Clang.
+#ifndef USE_THREADED_DISPATCH
+#define USE_THREADED_DISPATCH false
+#endif
+
+//Route CPU memory accesses through GBInstrumentedBus, for watchpoints, tracing and access stats. Slower.
+#ifndef USE_INSTRUMENTED_BUS
+#define USE_INSTRUMENTED_BUS false
+#endif
+
+//Compile hot rom blocks to native code on x86-64. Off until -bench shows it beating the block cache on its own.
+#ifndef USE_JIT
+#define USE_JIT false
+#endif
+
+//Cached and JIT compiled code reads its instructions from memory once, when it is decoded, so the instrumented bus would miss fetches.
+//Both are left out of instrumented builds so every fetch is seen.
+#if USE_INSTRUMENTED_BUS
+#define USE_BLOCK_CACHE false
+#undef USE_JIT
+#define USE_JIT false
+#else
+#define USE_BLOCK_CACHE true
+#endif
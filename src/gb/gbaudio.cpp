@@ -13,57 +13,67 @@ GBAudio::~GBAudio(){
 }
 
 void GBAudio::tick(long long hz){
-    static long long rollover = 0;
-    uint8_t* tempBuffer = new uint8_t[hz];
-    uint8_t* mixedBuffer = new uint8_t[hz];
+    //Audio catches up on its own schedule, so hz can cover any number of samples.
+    //Run the channels up to each sample point, send the sample, then carry on with what's left.
+    long long skip = getSampleSkip();
+    if (skip < 1) {
+        //Very low clock multipliers would otherwise never finish a sample
+        skip = 1;
+    }
+    
+    while ((m_sampleRollover + hz) >= skip) {
+        long long sampleHz = skip - m_sampleRollover;
+        if (sampleHz < 0) {
+            sampleHz = 0;
+        }
+        
+        m_player->addNote(tickChannels(sampleHz) * 500);
+        
+        hz -= sampleHz;
+        m_sampleRollover = m_sampleRollover + sampleHz - skip;
+    }
+    
+    tickChannels(hz);
+    m_sampleRollover += hz;
+}
+
+//Ticks every channel and returns the mix of the enabled ones
+uint16_t GBAudio::tickChannels(long long hz){
     uint16_t currentNote = 0;
     uint16_t mixedNote = 0;
-	
-    uint32_t skip = (CLOCK_GB * MHZ_TO_HZ * m_gbmemory->getClockMultiplier()) / m_player->getSampleRate() / 2;
-    if ((rollover + hz) >= skip) {
-		
-		currentNote = tickSquare1(hz);
-        if(m_square1Enabled){
-            m_player->mixNotes(&currentNote, &mixedNote, 1);
-        }
+    
+    currentNote = tickSquare1(hz);
+    if(m_square1Enabled){
+        m_player->mixNotes(&currentNote, &mixedNote, 1);
+    }
 
-		currentNote = tickSquare2(hz);
-        if(m_square2Enabled){
-            m_player->mixNotes(&currentNote, &mixedNote, 1);
-        }
+    currentNote = tickSquare2(hz);
+    if(m_square2Enabled){
+        m_player->mixNotes(&currentNote, &mixedNote, 1);
+    }
 
-		currentNote = tickWave(hz);
-        if(m_waveEnabled){
-            m_player->mixNotes(&currentNote, &mixedNote, 1);
-        }
-        
-		currentNote = tickNoise(hz);
-        if(m_noiseEnabled){
-            m_player->mixNotes(&currentNote, &mixedNote, 1);
-        }
-        
-        m_player->addNote(mixedNote * 500);
-        rollover = rollover + hz - skip;
-    } else {
-		
-		tickSquare1(hz);
-		tickSquare2(hz);
-		tickWave(hz);
-		tickNoise(hz);
-		
-        rollover += hz;
+    currentNote = tickWave(hz);
+    if(m_waveEnabled){
+        m_player->mixNotes(&currentNote, &mixedNote, 1);
+    }
+    
+    currentNote = tickNoise(hz);
+    if(m_noiseEnabled){
+        m_player->mixNotes(&currentNote, &mixedNote, 1);
     }
+    
+    return mixedNote;
+}
 
-    delete tempBuffer;
-    delete mixedBuffer;
+//Gets the number of clock cycles between samples sent to the player
+uint32_t GBAudio::getSampleSkip(){
+    return (CLOCK_GB * MHZ_TO_HZ * m_gbmemory->getClockMultiplier()) / m_player->getSampleRate() / 2;
 }
 
 uint16_t GBAudio::tickSquare1(long long hz){
-    static uint8_t nextDutyIndex = 0;
     bool bChannelEnabled = true;
     
 	//Execute volume envelope
-	static long long volumeEnvelopeCounter = 0;
 	if ((getNR12() & 0x7)) {
 		m_square1VolumeEnvelopeTimer += hz;
 		
@@ -80,9 +90,6 @@ uint16_t GBAudio::tickSquare1(long long hz){
 			m_square1VolumeEnvelopeTimer -= 64 * 512 * (getNR12() & 0x7) * 2; //Test * 2 to see if this fixes short note problem...
 		}
 	}
-	else {
-		volumeEnvelopeCounter = 0;
-	}
 
     //Execute length counter
 	if ((getNR14() & 0x40)) {
@@ -142,22 +149,18 @@ uint16_t GBAudio::tickSquare1(long long hz){
     uint8_t note = 0;
     if (bChannelEnabled) {
 
-        if (hz >= m_square1FrequencyTimer) {
-           
-            while (hz >= m_square1FrequencyTimer && m_square1FrequencyTimer >= 0) {
-                nextDutyIndex = (nextDutyIndex + 1) % 8;
-                note = SQUARE_DUTY_WAVEFORM_TABLE[(getNR11() >> 6) & 0x03][nextDutyIndex];
-                note *= m_square1Volume;
+        while (hz >= m_square1FrequencyTimer && m_square1FrequencyTimer >= 0) {
+            m_square1DutyIndex = (m_square1DutyIndex + 1) % 8;
+            note = SQUARE_DUTY_WAVEFORM_TABLE[(getNR11() >> 6) & 0x03][m_square1DutyIndex];
+            note *= m_square1Volume;
 
-                hz -= m_square1FrequencyTimer;
-                m_square1FrequencyTimer = (2048 - m_square1Frequency) * 4;
-            }
-
-        } else {
-            m_square1FrequencyTimer -= hz;
+            hz -= m_square1FrequencyTimer;
+            m_square1FrequencyTimer = (2048 - m_square1Frequency) * 4;
         }
 
-        note = SQUARE_DUTY_WAVEFORM_TABLE[(getNR11() >> 6) & 0x03][nextDutyIndex];
+        carryFrequencyTimer(m_square1FrequencyTimer, hz);
+
+        note = SQUARE_DUTY_WAVEFORM_TABLE[(getNR11() >> 6) & 0x03][m_square1DutyIndex];
         note *= m_square1Volume;
 
     } 
@@ -166,11 +169,9 @@ uint16_t GBAudio::tickSquare1(long long hz){
 }
 
 uint16_t GBAudio::tickSquare2(long long hz) {
-    static uint8_t nextDutyIndex = 0;
     bool bChannelEnabled = true;
 
 	//Execute volume envelope
-	static long long volumeEnvelopeCounter = 0;
 	if (getNR22() & 0x07) {
 		m_square2VolumeEnvelopeTimer += hz;
 		while (m_square2VolumeEnvelopeTimer > (64 * 512 * (getNR22() & 0x07))) {
@@ -185,9 +186,6 @@ uint16_t GBAudio::tickSquare2(long long hz) {
 			m_square2VolumeEnvelopeTimer -= 64 * 512 * (getNR22() & 0x07) * 2;
 		}
 	}
-	else {
-		volumeEnvelopeCounter = 0;
-	}
 
     //Execute length counter
 	if ((getNR24() & 0x40)) {
@@ -206,22 +204,18 @@ uint16_t GBAudio::tickSquare2(long long hz) {
 
     uint8_t note = 0;
     if (bChannelEnabled) {
-        if (hz >= m_square2FrequencyTimer) {
-           
-            while (hz >= m_square2FrequencyTimer && m_square2FrequencyTimer >= 0) {
-                nextDutyIndex = (nextDutyIndex + 1) % 8;
-                note = SQUARE_DUTY_WAVEFORM_TABLE[(getNR21() >> 6) & 0x03][nextDutyIndex];
-                note *= m_square2Volume;
-
-                hz -= m_square2FrequencyTimer;
-                m_square2FrequencyTimer = (2048 - m_square2Frequency) * 4;
-            }
+        while (hz >= m_square2FrequencyTimer && m_square2FrequencyTimer >= 0) {
+            m_square2DutyIndex = (m_square2DutyIndex + 1) % 8;
+            note = SQUARE_DUTY_WAVEFORM_TABLE[(getNR21() >> 6) & 0x03][m_square2DutyIndex];
+            note *= m_square2Volume;
 
-        } else {
-            m_square2FrequencyTimer -= hz;
+            hz -= m_square2FrequencyTimer;
+            m_square2FrequencyTimer = (2048 - m_square2Frequency) * 4;
         }
 
-        note = SQUARE_DUTY_WAVEFORM_TABLE[(getNR21() >> 6) & 0x03][nextDutyIndex];
+        carryFrequencyTimer(m_square2FrequencyTimer, hz);
+
+        note = SQUARE_DUTY_WAVEFORM_TABLE[(getNR21() >> 6) & 0x03][m_square2DutyIndex];
         note *= m_square2Volume;
     }
 
@@ -229,8 +223,6 @@ uint16_t GBAudio::tickSquare2(long long hz) {
 }
 
 uint16_t GBAudio::tickWave(long long hz){
-    //Samples are stored as 4-bit values, two per byte.
-    static bool bFirstByteSample = true;
     bool bChannelEnabled = true;
 
     //Execute length counter
@@ -252,25 +244,22 @@ uint16_t GBAudio::tickWave(long long hz){
     //Need to check NR30 for if DAC is enabled
     if (bChannelEnabled && getNR30()) {
 
-        if (hz >= m_waveFrequencyTimer) {
-            while (hz >= m_waveFrequencyTimer && m_waveFrequencyTimer >= 0) {
-                if (!bFirstByteSample) {
+        while (hz >= m_waveFrequencyTimer && m_waveFrequencyTimer >= 0) {
+            if (!m_bWaveFirstByteSample) {
 					m_waveSampleByteIndex = (m_waveSampleByteIndex + 1) % 16;
-                }
-                
-				bFirstByteSample = !bFirstByteSample;
-
-                hz -= m_waveFrequencyTimer;
-				m_waveFrequencyTimer = (2048 - m_waveFrequency) * 2;
             }
+            
+				m_bWaveFirstByteSample = !m_bWaveFirstByteSample;
 
-        } else {
-            m_waveFrequencyTimer -= hz;
+            hz -= m_waveFrequencyTimer;
+				m_waveFrequencyTimer = (2048 - m_waveFrequency) * 2;
         }
 
+        carryFrequencyTimer(m_waveFrequencyTimer, hz);
+
         note = m_gbmemory->direct_read(ADDRESS_WAVE_TABLE_DATA_START + m_waveSampleByteIndex);
 				
-        if(bFirstByteSample){
+        if(m_bWaveFirstByteSample){
             note = note >> 4;
         }
                 
@@ -298,7 +287,6 @@ uint16_t GBAudio::tickWave(long long hz){
 }
 
 uint16_t GBAudio::tickNoise(long long hz){
-    static uint8_t nextDutyIndex = 0;
     bool bChannelEnabled = true;
 
 	//Execute volume envelope
@@ -331,27 +319,24 @@ uint16_t GBAudio::tickNoise(long long hz){
 
     uint8_t note = 0;
     if (bChannelEnabled && m_noiseTriggered) {
-        if (hz >= m_noiseFrequencyTimer) {
-            while (hz >= m_noiseFrequencyTimer && m_noiseFrequencyTimer >= 0) {
-                uint16_t xorResult = ((m_lfsr & 0x01) ^ ((m_lfsr & 0x02) >> 1));
-                m_lfsr = ((m_lfsr >> 1) & 0x3FFF) | (xorResult << 14);
-
-                if (getNR43() & 0x08) {
-                    //Set sixth bit to xorResult as well
-                    m_lfsr &= ~(1 << 5);
-                    m_lfsr |= (xorResult << 5);
-                }
-
-                note = (~m_lfsr & 0x1) * m_noiseVolume;
-
-                hz -= m_noiseFrequencyTimer;
-                m_noiseFrequencyTimer = getNoiseDivisor() << ((getNR43() & 0xF0) >> 4);
+        while (hz >= m_noiseFrequencyTimer && m_noiseFrequencyTimer >= 0) {
+            uint16_t xorResult = ((m_lfsr & 0x01) ^ ((m_lfsr & 0x02) >> 1));
+            m_lfsr = ((m_lfsr >> 1) & 0x3FFF) | (xorResult << 14);
+
+            if (getNR43() & 0x08) {
+                //Set sixth bit to xorResult as well
+                m_lfsr &= ~(1 << 5);
+                m_lfsr |= (xorResult << 5);
             }
 
-        } else {
-            m_noiseFrequencyTimer -= hz;
+            note = (~m_lfsr & 0x1) * m_noiseVolume;
+
+            hz -= m_noiseFrequencyTimer;
+            m_noiseFrequencyTimer = getNoiseDivisor() << ((getNR43() & 0xF0) >> 4);
         }
 
+        carryFrequencyTimer(m_noiseFrequencyTimer, hz);
+
         note = (~m_lfsr & 0x1) * m_noiseVolume;
 
     }
@@ -359,6 +344,14 @@ uint16_t GBAudio::tickNoise(long long hz){
     return note;
 }
 
+//Counts any clock left over after a channel's last step towards its next one,
+//so the result doesn't depend on how often tick is called
+void GBAudio::carryFrequencyTimer(long long& frequencyTimer, long long hz) {
+    if (frequencyTimer >= 0) {
+        frequencyTimer -= hz;
+    }
+}
+
 uint8_t GBAudio::getNoiseDivisor() {
     uint8_t toReturn = 8;
     switch (getNR43() & 0x07) {
@@ -90,14 +90,18 @@ class GBAudio{
         bool m_waveEnabled = true;
         bool m_noiseEnabled = true;
     
-        bool m_square1Triggered;
-        bool m_square2Triggered;
-        bool m_waveTriggered;
-        bool m_noiseTriggered;
+        bool m_square1Triggered = false;
+        bool m_square2Triggered = false;
+        bool m_waveTriggered = false;
+        bool m_noiseTriggered = false;
+        
+        //Clock left over since the last sample was sent to the player
+        long long m_sampleRollover = 0;
         
         //Are globals needed? What happens if a value changes after being triggered?
-        uint8_t m_square1Duty;
-        uint16_t m_square1Frequency;
+        uint8_t m_square1Duty = 0;
+        uint16_t m_square1Frequency = 0;
+        uint8_t m_square1DutyIndex = 0;
         long long m_square1FrequencyTimer = 0;
         long long m_square1VolumeEnvelopeTimer = 0;
         long long m_square1LengthCounter = 0;
@@ -106,8 +110,9 @@ class GBAudio{
 		long long m_square1FrequencySweepTimer = 0;
 
 
-        uint8_t m_square2Duty;
-        uint16_t m_square2Frequency;
+        uint8_t m_square2Duty = 0;
+        uint16_t m_square2Frequency = 0;
+        uint8_t m_square2DutyIndex = 0;
         long long m_square2FrequencyTimer = 0;
         long long m_square2VolumeEnvelopeTimer = 0;
         long long m_square2LengthCounter = 0;
@@ -117,6 +122,8 @@ class GBAudio{
         uint16_t m_waveFrequency = 0;
         long long m_waveLengthCounter = 0;
         uint8_t m_waveSampleByteIndex = 0;
+        //Samples are stored as 4-bit values, two per byte.
+        bool m_bWaveFirstByteSample = true;
 
         long long m_noiseFrequencyTimer = 0;
         long long m_noiseFrequency = 0;
@@ -130,14 +137,22 @@ class GBAudio{
         uint16_t tickSquare2(long long hz);
         uint16_t tickWave(long long hz);
         uint16_t tickNoise(long long hz);
+        void carryFrequencyTimer(long long& frequencyTimer, long long hz);
+        
+        //Ticks every channel and returns the mix of the enabled ones
+        uint16_t tickChannels(long long hz);
 
         uint8_t getNoiseDivisor();
         
+        //Gets the number of clock cycles between samples sent to the player
+        uint32_t getSampleSkip();
+        
     public:
         GBAudio(GBMem* mem);
         ~GBAudio();
 
         void tick(long long hz);
+        
         void setPlayer(IAudioPlayer* player);
 
         void setSquare1Enabled(bool enabled);
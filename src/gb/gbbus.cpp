@@ -0,0 +1,68 @@
+#include <iostream>
+#include <cstring>
+#include "gbbus.h"
+
+GBInstrumentedBus::GBInstrumentedBus(){
+    memset(m_watchpoints, 0, sizeof(m_watchpoints));
+    m_bTrace = false;
+    m_watchpointHits = 0;
+    resetStats();
+}
+
+void GBInstrumentedBus::onAccess(uint16_t address, uint8_t value, bool bWrite){
+    if(bWrite){
+        m_pageWrites[address >> 8]++;
+    } else {
+        m_pageReads[address >> 8]++;
+    }
+
+    if(m_bTrace){
+        std::cout << std::hex << (bWrite ? "Write " : "Read ") << +address << ": " << +value << std::dec << std::endl;
+    }
+
+    if(m_watchpoints[address] & (bWrite ? BUS_WATCH_WRITE : BUS_WATCH_READ)){
+        m_watchpointHits++;
+        std::cout << std::hex << "Watchpoint hit! " << (bWrite ? "Write to " : "Read from ") << +address << ", value " << +value << std::dec << std::endl;
+    }
+}
+
+//Sets which accesses to an address are reported, as BUS_WATCH_ flags. 0 clears the watchpoint.
+void GBInstrumentedBus::setWatchpoint(uint16_t address, uint8_t flags){
+    m_watchpoints[address] = flags;
+}
+
+void GBInstrumentedBus::clearWatchpoints(){
+    memset(m_watchpoints, 0, sizeof(m_watchpoints));
+}
+
+uint64_t GBInstrumentedBus::getWatchpointHits(){
+    return m_watchpointHits;
+}
+
+//Prints every access when enabled
+void GBInstrumentedBus::setTraceEnabled(bool enabled){
+    m_bTrace = enabled;
+}
+
+uint64_t GBInstrumentedBus::getReadCount(uint16_t address){
+    return m_pageReads[address >> 8];
+}
+
+uint64_t GBInstrumentedBus::getWriteCount(uint16_t address){
+    return m_pageWrites[address >> 8];
+}
+
+void GBInstrumentedBus::resetStats(){
+    memset(m_pageReads, 0, sizeof(m_pageReads));
+    memset(m_pageWrites, 0, sizeof(m_pageWrites));
+}
+
+//Prints the access counts for every page that has been used
+void GBInstrumentedBus::printStats(){
+    std::cout << "Page   Reads        Writes" << std::endl;
+    for(int page = 0; page < 0x100; page++){
+        if(m_pageReads[page] || m_pageWrites[page]){
+            std::cout << std::hex << (page << 8) << std::dec << "   " << m_pageReads[page] << "   " << m_pageWrites[page] << std::endl;
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include "gbmem.h"
+#include "../constants.h"
+
+//Bus policies for the CPU. Every CPU memory access goes through the policy picked by USE_INSTRUMENTED_BUS.
+//Policies are resolved at compile time, so the fast policy costs nothing over calling memory directly.
+
+//Fast bus. The page table lookup inlines into each instruction, and only accesses that need a handler leave it.
+class GBFastBus{
+    public:
+        uint8_t read(GBMem* memory, uint16_t address){
+            return memory->read(address);
+        }
+
+        void write(GBMem* memory, uint16_t address, uint8_t value){
+            memory->write(address, value);
+        }
+};
+
+//Watchpoint flags
+#define BUS_WATCH_READ  0x1
+#define BUS_WATCH_WRITE 0x2
+
+//Instrumented bus, for debugging. Supports watchpoints, tracing of every access and per page access counts.
+class GBInstrumentedBus{
+    private:
+        uint8_t m_watchpoints[0x10000];
+        bool m_bTrace;
+
+        //Accesses per 256 byte page
+        uint64_t m_pageReads[0x100];
+        uint64_t m_pageWrites[0x100];
+        uint64_t m_watchpointHits;
+
+        void onAccess(uint16_t address, uint8_t value, bool bWrite);
+
+    public:
+        GBInstrumentedBus();
+
+        uint8_t read(GBMem* memory, uint16_t address){
+            uint8_t value = memory->read(address);
+            onAccess(address, value, false);
+            return value;
+        }
+
+        void write(GBMem* memory, uint16_t address, uint8_t value){
+            onAccess(address, value, true);
+            memory->write(address, value);
+        }
+
+        //Sets which accesses to an address are reported, as BUS_WATCH_ flags. 0 clears the watchpoint.
+        void setWatchpoint(uint16_t address, uint8_t flags);
+        void clearWatchpoints();
+        uint64_t getWatchpointHits();
+
+        //Prints every access when enabled
+        void setTraceEnabled(bool enabled);
+
+        //Access counts for the page containing address
+        uint64_t getReadCount(uint16_t address);
+        uint64_t getWriteCount(uint16_t address);
+        void resetStats();
+
+        //Prints the access counts for every page that has been used
+        void printStats();
+};
@@ -3,28 +3,23 @@
 #include <cstring>
 #include <string.h>
 #include <stdio.h>
-#include <ctime>
 
 #include "gbmem.h"
 #include "gbcart.h"
+#include "gbmbc1.h"
+#include "gbmbc2.h"
+#include "gbmbc3.h"
+#include "gbmbc5.h"
+#include "gbromimage.h"
 
 GBCart::GBCart(char* filename, char* bootrom){
+    m_romImage = NULL;
+    m_saveFile = NULL;
     m_bBootRomEnabled = false;
     loadCartFile(filename);
     
     m_romFileName = filename;
     
-    m_cartRomBank = 1;
-    m_cartRamBank = 0;
-    m_bCartRamEnabled = false;
-    m_bMBC1RomRamSelect = false;
-
-    m_rtcSeconds = 0;
-    m_rtcMinutes = 0;
-    m_rtcHours = 0;
-    m_rtcLowerDayCounter = 0;
-    m_rtcFlags = 0;
-    m_bRTCLatched = false;
     m_bBootRomLoaded = false;
     
     if(bootrom != NULL){
@@ -41,17 +36,29 @@ GBCart::GBCart(char* filename, char* bootrom){
         m_saveFileName[romNameLength + 4] = '\0';
         
         loadCartRam();
+        
+        if(USE_BACKGROUND_SAVE && (m_cartRamLength > 0)){
+            m_saveFile = new GBSaveFile(m_saveFileName, m_cartRamLength);
+            m_saveFile->load(m_cartRam);
+        }
     }
 }
 
 GBCart:: GBCart(uint8_t* cart, uint16_t size){
+    m_romImage = NULL;
+    m_saveFile = NULL;
     loadCartArray(cart, size);
     m_saveFileName = m_CartTitle;
 }
 
 GBCart::~GBCart(){
-    if(m_cartDataLength > 0){
-        delete m_cartRom;
+    delete m_saveFile;
+    delete m_mbc;
+    
+    if(m_romImage != NULL){
+        GBRomImage::release(m_romImage);
+    } else if(m_cartDataLength > 0){
+        delete[] m_cartRom;
     }
     
     if(m_cartRamLength > 0){
@@ -61,27 +68,12 @@ GBCart::~GBCart(){
 
 void GBCart::loadCartFile(char* filename){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "Loading cartridge " << filename << std::endl;
-    std::ifstream cart (filename, std::ios_base::binary);
-    if(cart.is_open()){
-        cart.seekg(0, std::ios_base::end);
-        std::streamsize size = cart.tellg();
-        if(CONSOLE_OUTPUT_ENABLED) std::cout << "Size of cartridge: " << size << std::endl;
-        cart.seekg(0, std::ios_base::beg);
-        
-        m_cartRom = new uint8_t[size];
-        m_cartDataLength = size;
-        
-        cart.read((char*)m_cartRom, size);
-        
-        if(CONSOLE_OUTPUT_ENABLED) std::cout << "Finished reading cart into cart buffer" << std::endl;
-        
-        std::streamsize readBytes = cart.gcount();
-        if(readBytes != size){
-            std::cout << "WARNING - only " << readBytes << " read!" << std::endl;
-            std::cin.get();
-        }
-        
-        cart.close();
+    
+    //Rom is shared with any other cart using the same file
+    m_romImage = GBRomImage::acquire(filename);
+    if(m_romImage != NULL){
+        m_cartRom = m_romImage->getData();
+        m_cartDataLength = m_romImage->getLength();
         
         postCartLoadSetup();
     } else {
@@ -123,7 +115,14 @@ void GBCart::loadBootRom(char* filename){
 }
 
 void GBCart::loadCartArray(uint8_t* cart, uint16_t size){
-    m_cartRom = new uint8_t[size];
+    //Pad to whole rom banks, as a loaded rom image would be
+    m_cartDataLength = ((size + ROM_IMAGE_BANK_SIZE - 1) / ROM_IMAGE_BANK_SIZE) * ROM_IMAGE_BANK_SIZE;
+    if(m_cartDataLength < ROM_IMAGE_BANK_SIZE * 2){
+        m_cartDataLength = ROM_IMAGE_BANK_SIZE * 2;
+    }
+    
+    m_cartRom = new uint8_t[m_cartDataLength];
+    memset(m_cartRom, 0, m_cartDataLength);
     memcpy(m_cartRom, cart, size);
     postCartLoadSetup();
 }    
@@ -169,9 +168,6 @@ void GBCart::saveCartRam(){
 }
     
 void GBCart::postCartLoadSetup(){
-    //Set the variable rom bank to 1
-    m_cartRomBank = 1;
-    
     //Set game title
     m_CartTitle = new char[16];
     memcpy(m_CartTitle, getCartridgeTitle().c_str(), 16);
@@ -228,7 +224,7 @@ void GBCart::postCartLoadSetup(){
     //Mask rom version
     m_MaskVersion = m_cartRom[ADDRESS_CART_MASK_ROM_VER];
     
-    //Set up read/write function pointers
+    //Determine bank controller type
     switch(m_CartType){
         case ROM_ONLY:
             std::cout << "Cart is a ROM-only cart" << std::endl;
@@ -254,8 +250,6 @@ void GBCart::postCartLoadSetup(){
         case ROM_MBC3_TIMER_BATT:
         case ROM_MBC3_TIMER_RAM_BATT:
             std::cout << "Cart is MBC3" << std::endl;
-            //cartRead = &GBCart::read_MBC3;
-            //cartWrite = &GBCart::write_MBC3;
             m_MBCType = MBC_3;
             break;
         case ROM_MBC5:
@@ -273,6 +267,26 @@ void GBCart::postCartLoadSetup(){
             break;
     }
     
+    //Set up the bank controller. The variable rom bank starts at 1.
+    switch(m_MBCType){
+        case MBC_1:
+            m_mbc = new GBMBC1(m_cartRom, m_cartDataLength, m_cartRam);
+            break;
+        case MBC_2:
+            m_mbc = new GBMBC2(m_cartRom, m_cartDataLength, m_cartRam);
+            break;
+        case MBC_3:
+            m_mbc = new GBMBC3(m_cartRom, m_cartDataLength, m_cartRam);
+            break;
+        case MBC_5:
+            m_mbc = new GBMBC5(m_cartRom, m_cartDataLength, m_cartRam);
+            break;
+        default:
+            m_mbc = new GBMBC(m_cartRom, m_cartDataLength, m_cartRam);
+            break;
+    }
+    m_mbc->init();
+    
     //Sets whether or not we have a battery
     switch(m_CartType){
         case ROM_MBC1_RAM_BATT:
@@ -290,200 +304,6 @@ void GBCart::postCartLoadSetup(){
     }
 }
     
-void GBCart::updateRTC(){
-    //TODO - figure out how to calculate day counter from system time. Possible?
-    if(m_bRTCLatched){
-        //RTC is latched, don't update. 
-        return;
-    }
-
-    //Get the current time since epoch
-    std::time_t unixTime = std::time(NULL);
-    std::tm* localTime = std::localtime(&unixTime);
-    m_rtcSeconds = localTime->tm_sec;
-    m_rtcMinutes = localTime->tm_min;
-    m_rtcHours = localTime->tm_hour;
-
-}
-
-uint8_t GBCart::read_MBC(uint16_t address){
-    uint8_t toReturn = 0xFF;
-
-    if(address >= ROM_BANK_N_START && address <= ROM_BANK_N_END){
-        //Largest possible bank value is 9-bit from MBC5
-        uint16_t realRomBank = m_cartRomBank & 0x01FF;
-
-        //Test for cart types and mask off appropriate bits
-        if(m_MBCType == MBC_1){
-            if(m_bMBC1RomRamSelect){
-                realRomBank &= 0x1F;
-            } else {
-                realRomBank &= 0x3F;
-            }
-        } else if(m_MBCType == MBC_3){
-            realRomBank = m_cartRomBank & 0x7F;
-        }
-        
-        //If the lower bits are 0 on MBC1, increment.
-        if((m_MBCType == MBC_1) && ((realRomBank & 0x1F) == 0)){
-            realRomBank |= 1;
-        }
-
-        //If entire rom bank is 0 on non-MBC5, increment
-        if((m_MBCType != MBC_5) && (realRomBank == 0)){
-            realRomBank |= 1;
-        }
-        
-        //TODO - check if in bounds of cart and wrap bank around until it fits!
-        // This will need to be done on write, not on read?
-        //https://github.com/Gekkio/mooneye-gb/blob/master/docs/accuracy.markdown
-        int realAddr = (address - ROM_BANK_N_START) + (realRomBank * ROM_BANK_N_START);
-        toReturn = m_cartRom[realAddr];
-    } else if (address >= EXTRAM_START && address <= EXTRAM_END){
-        if(m_bCartRamEnabled){
-            if(CONSOLE_OUTPUT_CART) std::cout << "MBC1 ram read" << std::endl;
-            uint16_t realRamBank = 0;
- 
-            //In MBC1, bank switching only occures if more than 8KB memory
-            if((m_MBCType != MBC_1) || (m_bMBC1RomRamSelect)){
-                realRamBank = m_cartRamBank;
-            }
-
-            //MBC3 uses ram bank to controll access to real time clock registers.
-            if((m_MBCType == MBC_3) && (realRamBank >= RTC_BANK_SECONDS)){
-                //Update real time clock registers
-                updateRTC();
-
-                //Fetch the appropriate value
-                switch(realRamBank){
-                    case RTC_BANK_SECONDS:
-                        toReturn = m_rtcSeconds;
-                        break;
-                    case RTC_BANK_MINUTES:
-                        toReturn =  m_rtcMinutes;
-                        break;
-                    case RTC_BANK_HOURS:
-                        toReturn = m_rtcHours;
-                        break;
-                    case RTC_BANK_DAYCOUNTER:
-                        toReturn = m_rtcLowerDayCounter;
-                        break;
-                    case RTC_BANK_FLAGS:
-                        toReturn = m_rtcFlags;
-                        break;
-                     default:
-                        std::cout << "Unrecognized MBC3 RTC register " << +realRamBank << std::endl;
-                        break;
-                }
-            } else {
-                int realAddr = ((EXTRAM_END - EXTRAM_START) * realRamBank) + (address - EXTRAM_START);
-                toReturn = m_cartRam[realAddr];
-
-                //MBC2 uses 4 bit values. Need to mask off upper bits
-                if(m_MBCType == MBC_2){
-                    toReturn &= 0x0F;
-                }
-            }
-        }
-    } 
-    
-    return toReturn;
-}
-
-void GBCart::write_MBC(uint16_t address, uint8_t val){
-	if (CONSOLE_OUTPUT_CART) std::cout << "Cart write. Address: " << +address << ", value: " << +val << std::endl;
-    
-    if(address >= ADDRESS_CART_RAM_ENABLE_START && address <= ADDRESS_CART_RAM_ENABLE_END){
-        bool bAllowRamToggle = true;
-
-        if(m_MBCType == MBC_2){
-            if((address & 0x0100)){
-                bAllowRamToggle = false;
-            }
-        }
-
-        if(bAllowRamToggle){
-            m_bCartRamEnabled = ((val & 0x0F) == CART_RAM_VALUE_ENABLED);
-        }
-
-		if (CONSOLE_OUTPUT_CART) std::cout << "Cart ram is now: " << (m_bCartRamEnabled ? "enabled" : "disabled") << std::endl;
-    } else if(address >= EXTRAM_START && address <= EXTRAM_END){
-		if (CONSOLE_OUTPUT_CART) std::cout << "Writing to cart ram!" << std::endl;
-        if(m_bCartRamEnabled){
-            int realAddr = ((EXTRAM_END - EXTRAM_START) * m_cartRamBank) + (address - EXTRAM_START);
-            m_cartRam[realAddr] = val;
-        }
-    } else if ((address >= ADDRESS_MBC1_ROM_BANK_NUM_START) && (address <= ADDRESS_MBC1_ROM_BANK_NUM_END)){
-		if (CONSOLE_OUTPUT_CART) std::cout << "Writing cart bank register lower bits" << std::endl;
-        
-        //Set rom bank according to bank controller
-        if(m_MBCType == MBC_1){
-            //Lower 5 bits only
-            m_cartRomBank = (m_cartRomBank & 0x60) | (val & 0x1F);
-
-        } else if (m_MBCType == MBC_2){
-            //4-bit only
-            m_cartRomBank = val & 0x0F;
-        } else if (m_MBCType == MBC_3){
-            //7-bit only
-            m_cartRomBank = /*(m_cartRomBank & 0x80) |*/ (val & 0x7F);
-        } else if (m_MBCType == MBC_5){
-            //TODO - DELCARE CONSTANTS
-            if(address < 0x3000){
-                //Set lower 8 bits
-                m_cartRomBank = (m_cartRomBank & 0x0100) | val;
-            } else {
-                //Set 9th bit
-                 m_cartRomBank = (m_cartRomBank & 0x0FF) | ((val & 0x01) << 9);
-            }
-        }
-       
-		if (CONSOLE_OUTPUT_CART) std::cout << "Rom bank is now " << +m_cartRomBank << std::endl;
-    } else if(address >= ADDRESS_MBC1_RAM_BANK_NUMBER_START && address <= ADDRESS_MBC1_RAM_BANK_NUMBER_END){
-		if (CONSOLE_OUTPUT_CART) std::cout << "Writing ram bank register" << std::endl;
-  
-        switch(m_MBCType){
-            case MBC_1:
-                //In MBC1, this can set both the rom or ram bank
-                if(m_bMBC1RomRamSelect){
-                    m_cartRamBank = val & 0x03;
-                } else {
-                    m_cartRomBank = (m_cartRomBank & 0x1F) | (0x03 & (val << 5));
-                }
-                break;
-            case MBC_2:
-                std::cout << "Attempt to set ram bank on MBC2!" << std::endl;
-                break;
-            case MBC_3:
-            case MBC_5:
-                //MBC3 only has banks 0-3, but also can be set to values 08-0C for RTC access
-                //MBC5 uses the full 4 bit value of the bank.
-                m_cartRamBank = val & 0x0F;
-                break;
-        }
-        
-    } else if (address >= ADDRESS_MBC1_MODE_SELECT_START && address <= ADDRESS_MBC1_MODE_SELECT_END){
-        if(m_MBCType == MBC_1){
-			if (CONSOLE_OUTPUT_CART) std::cout << "Attempt to set ROM or RAM write mode!" << std::endl;
-            m_bMBC1RomRamSelect = (val & 0x01) > 0;      
-			if (CONSOLE_OUTPUT_CART) std::cout << "Attempt to set ROM or RAM write mode! Current mode: " << (m_bMBC1RomRamSelect ? "RAM" : "ROM")  << std::endl;
-        } else if (m_MBCType == MBC_3) {
-            //RTC Latch is toggled in this register if a write of 0 is followed by a write of 1.
-            static uint8_t lastVal = 0xFF;
-            if((lastVal == 0x00) && (val == 0x01)){
-                //Since RTC is latched on access, need to update value first.
-                updateRTC();
-                m_bRTCLatched = !m_bRTCLatched;
-
-            }
-            lastVal = val; 
-        }
-    } else {
-        std::cout << "Attempting to write to an unsupported address" << std::endl;
-        std::cin.get();
-    }
-}
-    
 uint8_t GBCart::read(uint16_t address){
     uint8_t toReturn = 0xFF;
     if(m_bBootRomEnabled && ((address < 0x100) || (m_bBootRomIsGBC && (address >= 0x200) && (address <= 0x8FF)))){
@@ -492,8 +312,10 @@ uint8_t GBCart::read(uint16_t address){
         //Addresses up to the end of Bank 0 always return bank 0, regardless of cart type.
         if(address <= ROM_BANK_0_END){
             toReturn = m_cartRom[address];
-        } else {
-            toReturn = read_MBC(address);
+        } else if(address <= ROM_BANK_N_END){
+            toReturn = m_mbc->readRom(address);
+        } else if(address >= EXTRAM_START && address <= EXTRAM_END){
+            toReturn = m_mbc->readRam(address);
         }
     }
     
@@ -501,7 +323,57 @@ uint8_t GBCart::read(uint16_t address){
 }
 
 void GBCart::write(uint16_t address, uint8_t val){
-    write_MBC(address, val);
+    //Note which part of cart ram is about to change, so the save thread picks it up
+    if((m_saveFile != NULL) && (address >= EXTRAM_START) && (address <= EXTRAM_END)){
+        int32_t offset = m_mbc->getRamWriteOffset(address);
+        if(offset >= 0){
+            m_saveFile->markDirty(offset);
+        }
+    }
+    
+    m_mbc->write(address, val);
+}
+
+//Gets a pointer to the 256 byte page of rom or cart ram containing address, or NULL if reads there need to go through read.
+//Matches the addresses read would use.
+uint8_t* GBCart::getReadPage(uint16_t address){
+    address &= 0xFF00;
+    
+    if(m_bBootRomEnabled && ((address < 0x100) || (m_bBootRomIsGBC && (address >= 0x200) && (address <= 0x8FF)))){
+        return &m_bootRom[address];
+    }
+    
+    if(address <= ROM_BANK_0_END){
+        return &m_cartRom[address];
+    }
+    
+    if(address <= ROM_BANK_N_END){
+        return &m_mbc->getRomBankData()[address - ROM_BANK_N_START];
+    }
+    
+    uint8_t* ramBank = m_mbc->getRamReadData();
+    if((address < EXTRAM_START) || (address > EXTRAM_END) || (ramBank == NULL)){
+        return NULL;
+    }
+    
+    return &ramBank[address - EXTRAM_START];
+}
+
+//Gets a pointer to the 256 byte page of cart ram containing address, or NULL if writes there need to go through write.
+//Battery backed ram always goes through write, so saved pages can be tracked.
+uint8_t* GBCart::getWritePage(uint16_t address){
+    address &= 0xFF00;
+    
+    if(m_saveFile != NULL){
+        return NULL;
+    }
+    
+    int32_t offset = m_mbc->getRamWriteOffset(address);
+    if(offset < 0){
+        return NULL;
+    }
+    
+    return &m_cartRam[offset];
 }
 
 //Saves cart ram, if cart has a battery backup
@@ -509,7 +381,18 @@ void GBCart::save(){
     if(m_bHasBattery){
         std::cout << "Cart has a battery. Saving cart ram to " << m_saveFileName << std::endl;
         
-        saveCartRam();
+        if(m_saveFile != NULL){
+            m_saveFile->close(m_cartRam);
+        } else {
+            saveCartRam();
+        }
+    }
+}
+
+//Hands cart ram written since the last call to the save thread. Called regularly from the emulation thread.
+void GBCart::flushSave(){
+    if(m_saveFile != NULL){
+        m_saveFile->flush(m_cartRam);
     }
 }
 
@@ -532,6 +415,11 @@ bool GBCart::getBootRomEnabled(){
     return m_bBootRomEnabled;
 }
 
+//Gets the rom bank currently mapped to 0x4000-0x7FFF
+uint16_t GBCart::getRomBank(){
+    return m_mbc->getRomBank();
+}
+
 std::string GBCart::getCartridgeTitle(){
     char gameTitle[16];
     
@@ -556,11 +444,11 @@ void GBCart::printCartInfo(){
 }
 
 //Gets whether or not the cart supports GBC
-bool GBCart::cartSupportsGBC() {
+bool GBCart::cartSupportsGBC() {
 	return m_bIsGBC;
 }
 
 //Gets whether or not the cart supports SGB
-bool GBCart::cartSupportsSGB() {
+bool GBCart::cartSupportsSGB() {
 	return m_bIsSGB;
 }
@@ -2,6 +2,9 @@
 #include <stdlib.h>
 #include <string>
 #include <stdint.h>
+#include "gbmbc.h"
+#include "gbromimage.h"
+#include "gbsavefile.h"
 #include "../constants.h"
 
 #define ADDRESS_CART_NINTENDO_START 0x0104 //Scrolling nintendo logo
@@ -22,28 +25,6 @@
 #define ADDRESS_CART_CHECKSUM_START 0x014E
 #define ADDRESS_CART_CHECKSUM_END   0x014F
 
-#define ADDRESS_CART_RAM_ENABLE_START   0x0000
-#define ADDRESS_CART_RAM_ENABLE_END     0x1FFF
-#define ADDRESS_MBC1_ROM_BANK_NUM_START 0x2000
-#define ADDRESS_MBC1_ROM_BANK_NUM_END   0x3FFF
-#define ADDRESS_MBC1_RAM_BANK_NUMBER_START 0x4000
-#define ADDRESS_MBC1_RAM_BANK_NUMBER_END   0x5FFF
-#define ADDRESS_MBC1_MODE_SELECT_START     0x6000
-#define ADDRESS_MBC1_MODE_SELECT_END       0x7FFF
-
-#define CART_RAM_VALUE_ENABLED        0x0A
-#define CART_MBC1_ROM_RAM_MODE_SELECT 0x01
-
-#define RTC_FLAG_UPPER_DAY 0x00
-#define RTC_FLAG_HALT      0x20
-#define RTC_FLAG_DAY_CARRY 0x40
-
-#define RTC_BANK_SECONDS    0x08
-#define RTC_BANK_MINUTES    0x09
-#define RTC_BANK_HOURS      0x0A
-#define RTC_BANK_DAYCOUNTER 0x0B
-#define RTC_BANK_FLAGS      0x0C
-
 #define CART_PLATFORM_SGB	   0x03
 #define CART_PLATFORM_GBC_DMG  0x80
 #define CART_PLATFORM_GBC_ONLY 0xC0
@@ -54,6 +35,9 @@ class GBCart{
     uint8_t* m_cartRom;
     uint8_t* m_cartRam;
     
+    //Shared image the rom was loaded from. NULL for carts loaded from an array, which own m_cartRom.
+    GBRomImage* m_romImage;
+    
     uint32_t m_cartDataLength;
     uint32_t m_cartRamLength;
     
@@ -79,25 +63,16 @@ class GBCart{
     bool m_bBootRomEnabled;
     bool m_bBootRomIsGBC;
     
-    uint16_t m_cartRomBank;
-    uint8_t m_cartRamBank;
-    
-    bool m_bCartRamEnabled;
-    
-    bool m_bMBC1RomRamSelect;
-
-    //MBC3 RTC Registers
-    uint8_t m_rtcSeconds;
-    uint8_t m_rtcMinutes;
-    uint8_t m_rtcHours;
-    uint8_t m_rtcLowerDayCounter;
-    uint8_t m_rtcFlags;
-    bool m_bRTCLatched;
+    //Bank controller for the cart type. Owns the bank registers.
+    GBMBC* m_mbc;
 
 
     char* m_romFileName;
     char* m_saveFileName;
     
+    //Keeps the save file up to date while running. NULL unless the cart was loaded from a file and has battery backed ram.
+    GBSaveFile* m_saveFile;
+    
     void loadCartFile(char* filename);
     void loadBootRom(char* filename);
     
@@ -107,11 +82,6 @@ class GBCart{
     void postCartLoadSetup();
     void loadCartArray(uint8_t* cart, uint16_t size);    
     
-    void updateRTC();
-
-    uint8_t read_MBC(uint16_t address);
-    void write_MBC(uint16_t address, uint8_t val);
-    
   public:
     
     enum ROMType{
@@ -180,9 +150,19 @@ class GBCart{
     uint8_t read(uint16_t address);
     void write(uint16_t address, uint8_t val);
     
+    //Gets a pointer to the 256 byte page of rom or cart ram containing address, or NULL if reads there need to go through read.
+    //Only valid until the next write, which may switch banks.
+    uint8_t* getReadPage(uint16_t address);
+    
+    //Gets a pointer to the 256 byte page of cart ram containing address, or NULL if writes there need to go through write.
+    uint8_t* getWritePage(uint16_t address);
+    
     //Saves cart ram, if cart has a battery backup
     void save();
     
+    //Hands cart ram written since the last call to the save thread
+    void flushSave();
+    
     //Gets whether or not a boot rom has been loaded
     bool getBootRomLoaded();
     
@@ -195,6 +175,9 @@ class GBCart{
     //Gets whether the first 0xFF bytes are read from boot rom instead of cartridge
     bool getBootRomEnabled();
     
+    //Gets the rom bank currently mapped to 0x4000-0x7FFF
+    uint16_t getRomBank();
+    
     std::string getCartridgeTitle();
     void printCartInfo();
 
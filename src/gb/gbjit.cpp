@@ -0,0 +1,774 @@
+#include <iostream>
+#include "gbjit.h"
+#include "opcodes.h"
+#include "bytehelpers.h"
+
+#if JIT_SUPPORTED
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#endif
+
+//x86-64 code generator for hot GBZ80 blocks.
+//Compiled blocks keep the CPU pointer in rbx and address registers as [rbx + offset].
+//Loads, stores, 8-bit ALU ops and jumps are translated directly, working out F as they go from the host flags.
+//Plain memory is read and written through the GBMem page table. Anything else calls back into GBZ80.
+//A block is only entered when it can run to its end before the next scheduler event, so cycles are retired once, when it finishes.
+
+//Host registers, as encoded in ModRM
+#define HOST_AL 0
+#define HOST_CL 1
+#define HOST_DL 2
+
+//Host ALU opcodes for op r/m8, r8, in GB ALU order. ADD, ADC, SUB, SBC, AND, XOR, OR, CP.
+static const uint8_t s_hostAluOps[8] = {0x00, 0x10, 0x28, 0x18, 0x20, 0x30, 0x08, 0x38};
+
+GBJit::GBJit(GBZ80* cpu){
+    m_codeCache = NULL;
+    m_codeCacheUsed = 0;
+    m_pageSize = 0x1000;
+
+    m_offsetAF = (int32_t)((uint8_t*)&cpu->m_hot.AF - (uint8_t*)cpu);
+    m_offsetBC = (int32_t)((uint8_t*)&cpu->m_hot.BC - (uint8_t*)cpu);
+    m_offsetDE = (int32_t)((uint8_t*)&cpu->m_hot.DE - (uint8_t*)cpu);
+    m_offsetHL = (int32_t)((uint8_t*)&cpu->m_hot.HL - (uint8_t*)cpu);
+    m_offsetSP = (int32_t)((uint8_t*)&cpu->m_hot.SP - (uint8_t*)cpu);
+    m_offsetPC = (int32_t)((uint8_t*)&cpu->m_hot.PC - (uint8_t*)cpu);
+
+    GBMem* memory = cpu->m_gbmemory;
+    m_pageTable = (uint8_t*)&memory->m_pages[0];
+    m_pageStride = (int32_t)((uint8_t*)&memory->m_pages[1] - (uint8_t*)&memory->m_pages[0]);
+    m_pageReadOffset = (int32_t)((uint8_t*)&memory->m_pages[0].readData - (uint8_t*)&memory->m_pages[0]);
+    m_pageWriteOffset = (int32_t)((uint8_t*)&memory->m_pages[0].writeData - (uint8_t*)&memory->m_pages[0]);
+    m_codePageVersions = &memory->m_codePageVersions[0];
+
+#if JIT_SUPPORTED
+    //Mapped writable, but not executable. Each block is switched over to executable once it has been copied in.
+#ifdef _WIN32
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    m_pageSize = systemInfo.dwPageSize;
+    m_codeCache = (uint8_t*)VirtualAlloc(NULL, JIT_CODE_CACHE_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+    m_pageSize = sysconf(_SC_PAGESIZE);
+    void* cache = mmap(NULL, JIT_CODE_CACHE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    m_codeCache = (cache == MAP_FAILED) ? NULL : (uint8_t*)cache;
+#endif
+
+    if(m_codeCache == NULL){
+        std::cout << "Unable to allocate JIT code cache, falling back to interpreter" << std::endl;
+    }
+#endif
+}
+
+GBJit::~GBJit(){
+    free_code_cache();
+}
+
+//Releases the code cache, which turns the JIT off
+void GBJit::free_code_cache(){
+#if JIT_SUPPORTED
+    if(m_codeCache != NULL){
+#ifdef _WIN32
+        VirtualFree(m_codeCache, 0, MEM_RELEASE);
+#else
+        munmap(m_codeCache, JIT_CODE_CACHE_SIZE);
+#endif
+    }
+#endif
+
+    m_codeCache = NULL;
+    m_codeCacheUsed = 0;
+}
+
+bool GBJit::getEnabled(){
+    return m_codeCache != NULL;
+}
+
+//Compiles a block into a function that runs its ops once, in order.
+//Returns to the interpreter early if a callback says the rest of the block can't run yet.
+GBZ80::JitBlockFunc GBJit::compile(const GBZ80::CodeBlock* block){
+    if(m_codeCache == NULL){
+        return NULL;
+    }
+
+    m_code.clear();
+    m_exitJumps.clear();
+
+    //push rbx; sub rsp, 32 (keeps the stack aligned and leaves shadow space for Win64 calls)
+    emit_byte(0x53);
+    emit_byte(0x48); emit_byte(0x83); emit_byte(0xEC); emit_byte(0x20);
+
+    //mov rbx, cpu
+#ifdef _WIN32
+    emit_byte(0x48); emit_byte(0x89); emit_byte(0xCB);
+#else
+    emit_byte(0x48); emit_byte(0x89); emit_byte(0xFB);
+#endif
+
+    uint32_t cycles = 0;
+    for(size_t i = 0; i < block->ops.size(); i++){
+        const GBZ80::MicroOp& op = block->ops[i];
+        uint32_t site = JIT_SITE(i, cycles);
+        bool bLast = (i + 1 == block->ops.size());
+
+        //Callbacks set PC for the ops they run, so compiled code only has to for the last op.
+        //Like execute_micro_op, it points past the op before the op runs.
+        if(bLast){
+            emit_mov_cpu_word(m_offsetPC, op.address + op.length);
+        }
+
+        //Debug output comes from the instruction handlers, so don't skip them when it's on
+        if(CONSOLE_OUTPUT_ENABLED || !emit_native_op(op, site)){
+#ifdef _WIN32
+            //mov rcx, rbx; mov rdx, op; mov r8d, site
+            emit_byte(0x48); emit_byte(0x89); emit_byte(0xD9);
+            emit_byte(0x48); emit_byte(0xBA); emit_qword((uint64_t)&op);
+            emit_byte(0x41); emit_byte(0xB8); emit_dword(site);
+#else
+            //mov rdi, rbx; mov rsi, op; mov edx, site
+            emit_byte(0x48); emit_byte(0x89); emit_byte(0xDF);
+            emit_byte(0x48); emit_byte(0xBE); emit_qword((uint64_t)&op);
+            emit_byte(0xBA); emit_dword(site);
+#endif
+            emit_call((void*)&GBZ80::jit_execute);
+            emit_exit_unless_true();
+        } else if(bLast){
+#ifdef _WIN32
+            //mov rcx, rbx; mov edx, site
+            emit_byte(0x48); emit_byte(0x89); emit_byte(0xD9);
+            emit_byte(0xBA); emit_dword(site);
+#else
+            //mov rdi, rbx; mov esi, site
+            emit_byte(0x48); emit_byte(0x89); emit_byte(0xDF);
+            emit_byte(0xBE); emit_dword(site);
+#endif
+            emit_call((void*)&GBZ80::jit_finish);
+        }
+
+        cycles += op.entry->cycles;
+    }
+
+    //Patch exits to here. add rsp, 32; pop rbx; ret
+    for(size_t i = 0; i < m_exitJumps.size(); i++){
+        int32_t rel = (int32_t)m_code.size() - (int32_t)(m_exitJumps[i] + 4);
+        memcpy(&m_code[m_exitJumps[i]], &rel, 4);
+    }
+    emit_byte(0x48); emit_byte(0x83); emit_byte(0xC4); emit_byte(0x20);
+    emit_byte(0x5B);
+    emit_byte(0xC3);
+
+    //Keep blocks 16 byte aligned
+    size_t alignedSize = (m_code.size() + 15) & ~((size_t)15);
+    if(m_codeCacheUsed + alignedSize > JIT_CODE_CACHE_SIZE){
+        return NULL;
+    }
+
+    //Code is never writable and executable at the same time
+    uint8_t* code = m_codeCache + m_codeCacheUsed;
+    bool bWritten = protect_code(code, m_code.size(), true);
+    if(bWritten){
+        memcpy(code, &m_code[0], m_code.size());
+    }
+
+    if(!bWritten || !protect_code(code, m_code.size(), false)){
+        std::cout << "Unable to switch JIT code cache protection, falling back to interpreter" << std::endl;
+        free_code_cache();
+        return NULL;
+    }
+
+    m_codeCacheUsed += alignedSize;
+
+    if(CONSOLE_OUTPUT_ENABLED) std::cout << "Compiled block at " << +block->startAddress << " to " << m_code.size() << " bytes" << std::endl;
+
+    return (GBZ80::JitBlockFunc)code;
+}
+
+void GBJit::flush(){
+    m_codeCacheUsed = 0;
+}
+
+//Rounds the range out to whole pages. Other blocks sharing those pages aren't running while this one is written.
+bool GBJit::protect_code(uint8_t* start, size_t size, bool bWritable){
+#if JIT_SUPPORTED
+    uintptr_t first = (uintptr_t)start & ~((uintptr_t)m_pageSize - 1);
+    uintptr_t last = ((uintptr_t)start + size + m_pageSize - 1) & ~((uintptr_t)m_pageSize - 1);
+
+#ifdef _WIN32
+    DWORD oldProtect;
+    if(!VirtualProtect((void*)first, last - first, bWritable ? PAGE_READWRITE : PAGE_EXECUTE_READ, &oldProtect)){
+        return false;
+    }
+
+    if(!bWritable){
+        FlushInstructionCache(GetCurrentProcess(), start, size);
+    }
+    return true;
+#else
+    return mprotect((void*)first, last - first, bWritable ? (PROT_READ | PROT_WRITE) : (PROT_READ | PROT_EXEC)) == 0;
+#endif
+#else
+    return false;
+#endif
+}
+
+//Code emission
+
+void GBJit::emit_byte(uint8_t val){
+    m_code.push_back(val);
+}
+
+void GBJit::emit_word(uint16_t val){
+    emit_byte(getLSB(val));
+    emit_byte(getMSB(val));
+}
+
+void GBJit::emit_dword(uint32_t val){
+    emit_word(val & 0xFFFF);
+    emit_word(val >> 16);
+}
+
+void GBJit::emit_qword(uint64_t val){
+    emit_dword(val & 0xFFFFFFFF);
+    emit_dword(val >> 32);
+}
+
+//mov word [rbx + offset], val
+void GBJit::emit_mov_cpu_word(int32_t offset, uint16_t val){
+    emit_byte(0x66); emit_byte(0xC7); emit_byte(0x83);
+    emit_dword(offset);
+    emit_word(val);
+}
+
+//mov byte [rbx + offset], val
+void GBJit::emit_mov_cpu_byte(int32_t offset, uint8_t val){
+    emit_byte(0xC6); emit_byte(0x83);
+    emit_dword(offset);
+    emit_byte(val);
+}
+
+//mov al, [rbx + srcOffset]; mov [rbx + destOffset], al
+void GBJit::emit_copy_cpu_byte(int32_t destOffset, int32_t srcOffset){
+    emit_load_byte(HOST_AL, srcOffset);
+    emit_store_byte(HOST_AL, destOffset);
+}
+
+//inc word [rbx + offset]
+void GBJit::emit_inc_cpu_word(int32_t offset){
+    emit_byte(0x66); emit_byte(0xFF); emit_byte(0x83);
+    emit_dword(offset);
+}
+
+//dec word [rbx + offset]
+void GBJit::emit_dec_cpu_word(int32_t offset){
+    emit_byte(0x66); emit_byte(0xFF); emit_byte(0x8B);
+    emit_dword(offset);
+}
+
+//Byte op with an immediate on [rbx + offset]. op is the ModRM extension, 1 for or, 4 for and, 6 for xor.
+void GBJit::emit_op_cpu_byte(uint8_t op, int32_t offset, uint8_t val){
+    emit_byte(0x80); emit_byte(0x83 | (op << 3));
+    emit_dword(offset);
+    emit_byte(val);
+}
+
+//mov reg, [rbx + offset]
+void GBJit::emit_load_byte(uint8_t reg, int32_t offset){
+    emit_byte(0x8A); emit_byte(0x83 | (reg << 3));
+    emit_dword(offset);
+}
+
+//mov [rbx + offset], reg
+void GBJit::emit_store_byte(uint8_t reg, int32_t offset){
+    emit_byte(0x88); emit_byte(0x83 | (reg << 3));
+    emit_dword(offset);
+}
+
+//movzx ecx, word [rbx + offset]. Memory accesses take their address in ecx.
+void GBJit::emit_load_address(int32_t offset){
+    emit_byte(0x0F); emit_byte(0xB7); emit_byte(0x8B);
+    emit_dword(offset);
+}
+
+//mov ecx, address
+void GBJit::emit_set_address(uint16_t address){
+    emit_byte(0xB9);
+    emit_dword(address);
+}
+
+//Reads the byte at ecx into eax. Pages GBMem reads directly are read here, the rest through GBZ80::jit_read.
+void GBJit::emit_read_memory(uint32_t site){
+    //mov edx, ecx; shr edx, 8; imul edx, edx, stride
+    emit_byte(0x89); emit_byte(0xCA);
+    emit_byte(0xC1); emit_byte(0xEA); emit_byte(0x08);
+    emit_byte(0x69); emit_byte(0xD2); emit_dword(m_pageStride);
+
+    //mov r8, pageTable; mov r8, [r8 + rdx + readOffset]
+    emit_byte(0x49); emit_byte(0xB8); emit_qword((uint64_t)m_pageTable);
+    emit_byte(0x4D); emit_byte(0x8B); emit_byte(0x84); emit_byte(0x10); emit_dword(m_pageReadOffset);
+
+    //test r8, r8; jz slow
+    emit_byte(0x4D); emit_byte(0x85); emit_byte(0xC0);
+    size_t slow = emit_jump8(0x74);
+
+    //movzx edx, cl; movzx eax, byte [r8 + rdx]; jmp done
+    emit_byte(0x0F); emit_byte(0xB6); emit_byte(0xD1);
+    emit_byte(0x41); emit_byte(0x0F); emit_byte(0xB6); emit_byte(0x04); emit_byte(0x10);
+    size_t done = emit_jump8(0xEB);
+
+    patch_jump8(slow);
+#ifdef _WIN32
+    //mov edx, ecx; mov r8d, site; mov rcx, rbx
+    emit_byte(0x89); emit_byte(0xCA);
+    emit_byte(0x41); emit_byte(0xB8); emit_dword(site);
+    emit_byte(0x48); emit_byte(0x89); emit_byte(0xD9);
+#else
+    //mov esi, ecx; mov edx, site; mov rdi, rbx
+    emit_byte(0x89); emit_byte(0xCE);
+    emit_byte(0xBA); emit_dword(site);
+    emit_byte(0x48); emit_byte(0x89); emit_byte(0xDF);
+#endif
+    emit_call((void*)&GBZ80::jit_read);
+
+    //movzx eax, al
+    emit_byte(0x0F); emit_byte(0xB6); emit_byte(0xC0);
+
+    patch_jump8(done);
+}
+
+//Writes al to the byte at ecx. Pages GBMem writes directly are written here, the rest through GBZ80::jit_write,
+//which can end the block.
+void GBJit::emit_write_memory(uint32_t site){
+    //mov edx, ecx; shr edx, 8; imul edx, edx, stride
+    emit_byte(0x89); emit_byte(0xCA);
+    emit_byte(0xC1); emit_byte(0xEA); emit_byte(0x08);
+    emit_byte(0x69); emit_byte(0xD2); emit_dword(m_pageStride);
+
+    //mov r8, pageTable; mov r8, [r8 + rdx + writeOffset]
+    emit_byte(0x49); emit_byte(0xB8); emit_qword((uint64_t)m_pageTable);
+    emit_byte(0x4D); emit_byte(0x8B); emit_byte(0x84); emit_byte(0x10); emit_dword(m_pageWriteOffset);
+
+    //test r8, r8; jz slow
+    emit_byte(0x4D); emit_byte(0x85); emit_byte(0xC0);
+    size_t slow = emit_jump8(0x74);
+
+    //movzx edx, cl; mov [r8 + rdx], al
+    emit_byte(0x0F); emit_byte(0xB6); emit_byte(0xD1);
+    emit_byte(0x41); emit_byte(0x88); emit_byte(0x04); emit_byte(0x10);
+
+    //Bump the page version, as GBMem::write does. mov edx, ecx; shr edx, 8; mov r8, versions; inc dword [r8 + rdx * 4]; jmp done
+    emit_byte(0x89); emit_byte(0xCA);
+    emit_byte(0xC1); emit_byte(0xEA); emit_byte(0x08);
+    emit_byte(0x49); emit_byte(0xB8); emit_qword((uint64_t)m_codePageVersions);
+    emit_byte(0x41); emit_byte(0xFF); emit_byte(0x04); emit_byte(0x90);
+    size_t done = emit_jump8(0xEB);
+
+    patch_jump8(slow);
+#ifdef _WIN32
+    //mov edx, ecx; movzx r8d, al; mov r9d, site; mov rcx, rbx
+    emit_byte(0x89); emit_byte(0xCA);
+    emit_byte(0x44); emit_byte(0x0F); emit_byte(0xB6); emit_byte(0xC0);
+    emit_byte(0x41); emit_byte(0xB9); emit_dword(site);
+    emit_byte(0x48); emit_byte(0x89); emit_byte(0xD9);
+#else
+    //mov esi, ecx; movzx edx, al; mov ecx, site; mov rdi, rbx
+    emit_byte(0x89); emit_byte(0xCE);
+    emit_byte(0x0F); emit_byte(0xB6); emit_byte(0xD0);
+    emit_byte(0xB9); emit_dword(site);
+    emit_byte(0x48); emit_byte(0x89); emit_byte(0xDF);
+#endif
+    emit_call((void*)&GBZ80::jit_write);
+    emit_exit_unless_true();
+
+    patch_jump8(done);
+}
+
+//A = A op cl, using the host's own flags for Z, H and C. ADC and SBC take the GB carry into the host carry first.
+void GBJit::emit_alu(uint8_t aluOp, bool bCarryIn, bool bStore, uint8_t flagsFromHost, uint8_t flagsSet){
+    int32_t offsetA = m_offsetAF + 1;
+
+    emit_load_byte(HOST_AL, offsetA);
+
+    //mov dl, F; shr dl, 5 (shifts C out into the host carry)
+    if(bCarryIn){
+        emit_load_byte(HOST_DL, m_offsetAF);
+        emit_byte(0xC0); emit_byte(0xEA); emit_byte(0x05);
+    }
+
+    //op al, cl
+    emit_byte(aluOp); emit_byte(0xC8);
+
+    emit_store_flags(flagsFromHost, 0, flagsSet);
+
+    if(bStore){
+        emit_store_byte(HOST_AL, offsetA);
+    }
+}
+
+//INC or DEC of a register, or of (HL) when offset is negative. C is left alone.
+void GBJit::emit_inc_dec(int32_t offset, bool bDec, uint32_t site){
+    if(offset < 0){
+        emit_load_address(m_offsetHL);
+        emit_read_memory(site);
+    } else {
+        emit_load_byte(HOST_AL, offset);
+    }
+
+    //inc al or dec al
+    emit_byte(0xFE); emit_byte(bDec ? 0xC8 : 0xC0);
+
+    emit_store_flags(FLAG_BIT_Z | FLAG_BIT_H, FLAG_BIT_C, bDec ? FLAG_BIT_N : 0);
+
+    if(offset < 0){
+        emit_load_address(m_offsetHL);
+        emit_write_memory(site);
+    } else {
+        emit_store_byte(HOST_AL, offset);
+    }
+}
+
+//Builds F from the flags of the host op just run. Host flags keep ZF at bit 6, AF at bit 4 and CF at bit 0.
+//flagsKept come from the old F, flagsSet are always set. Leaves al alone.
+void GBJit::emit_store_flags(uint8_t flagsFromHost, uint8_t flagsKept, uint8_t flagsSet){
+    //pushfq; pop rdx
+    emit_byte(0x9C);
+    emit_byte(0x5A);
+
+    //mov ecx, edx; and ecx, 1; shl ecx, 4
+    if(flagsFromHost & FLAG_BIT_C){
+        emit_byte(0x89); emit_byte(0xD1);
+        emit_byte(0x83); emit_byte(0xE1); emit_byte(0x01);
+        emit_byte(0xC1); emit_byte(0xE1); emit_byte(0x04);
+    }
+
+    //Z and H are one bit below where GB keeps them. and edx, mask; add edx, edx
+    uint8_t hostMask = ((flagsFromHost & FLAG_BIT_Z) ? 0x40 : 0) | ((flagsFromHost & FLAG_BIT_H) ? 0x10 : 0);
+    emit_byte(0x83); emit_byte(0xE2); emit_byte(hostMask);
+    emit_byte(0x01); emit_byte(0xD2);
+
+    //or edx, ecx
+    if(flagsFromHost & FLAG_BIT_C){
+        emit_byte(0x09); emit_byte(0xCA);
+    }
+
+    //mov cl, F; and ecx, flagsKept; or edx, ecx
+    if(flagsKept){
+        emit_load_byte(HOST_CL, m_offsetAF);
+        emit_byte(0x83); emit_byte(0xE1); emit_byte(flagsKept);
+        emit_byte(0x09); emit_byte(0xCA);
+    }
+
+    //or edx, flagsSet
+    if(flagsSet){
+        emit_byte(0x83); emit_byte(0xCA); emit_byte(flagsSet);
+    }
+
+    emit_store_byte(HOST_DL, m_offsetAF);
+}
+
+//Sets PC to target, or only if (F & flagMask) is set or clear when flagMask isn't 0. PC has already been set past the op.
+void GBJit::emit_branch(uint8_t flagMask, bool bTakenIfSet, uint16_t target){
+    size_t skip = 0;
+
+    //test byte F, flagMask; jz or jnz past the jump
+    if(flagMask){
+        emit_byte(0xF6); emit_byte(0x83); emit_dword(m_offsetAF); emit_byte(flagMask);
+        skip = emit_jump8(bTakenIfSet ? 0x74 : 0x75);
+    }
+
+    emit_mov_cpu_word(m_offsetPC, target);
+
+    if(flagMask){
+        patch_jump8(skip);
+    }
+}
+
+//mov rax, func; call rax. Arguments are set up by the caller.
+void GBJit::emit_call(void* func){
+    emit_byte(0x48); emit_byte(0xB8);
+    emit_qword((uint64_t)func);
+    emit_byte(0xFF); emit_byte(0xD0);
+}
+
+//test al, al; jz exit. For callbacks that return false once they've retired the block.
+void GBJit::emit_exit_unless_true(){
+    emit_byte(0x84); emit_byte(0xC0);
+    emit_byte(0x0F); emit_byte(0x84);
+    m_exitJumps.push_back(m_code.size());
+    emit_dword(0);
+}
+
+//Emits a short jump to be patched by patch_jump8 and returns where its offset goes
+size_t GBJit::emit_jump8(uint8_t opcode){
+    emit_byte(opcode);
+    emit_byte(0);
+    return m_code.size() - 1;
+}
+
+//Points a short jump at the current end of the code
+void GBJit::patch_jump8(size_t position){
+    m_code[position] = (uint8_t)(m_code.size() - (position + 1));
+}
+
+//Registers are stored as little endian 16-bit pairs, so the high register is at +1
+int32_t GBJit::get_register_offset(uint8_t index){
+    switch(index){
+        case 0: return m_offsetBC + 1; //B
+        case 1: return m_offsetBC;     //C
+        case 2: return m_offsetDE + 1; //D
+        case 3: return m_offsetDE;     //E
+        case 4: return m_offsetHL + 1; //H
+        case 5: return m_offsetHL;     //L
+        case 7: return m_offsetAF + 1; //A
+        default: return -1;            //(HL) goes through memory
+    }
+}
+
+//Emits native code for an op, matching its interpreter handler
+bool GBJit::emit_native_op(const GBZ80::MicroOp& op, uint32_t site){
+    uint16_t nextAddress = op.address + op.length;
+    int32_t offsetA = m_offsetAF + 1;
+
+    //LD r,r'. 0x76 is HALT.
+    if((op.opcode >= OP_LD_B_B) && (op.opcode <= OP_LD_A_A)){
+        if(op.opcode == OP_HALT){
+            return false;
+        }
+
+        int32_t destOffset = get_register_offset((op.opcode >> 3) & 7);
+        int32_t srcOffset = get_register_offset(op.opcode & 7);
+        if(srcOffset < 0){
+            emit_load_address(m_offsetHL);
+            emit_read_memory(site);
+            emit_store_byte(HOST_AL, destOffset);
+        } else if(destOffset < 0){
+            emit_load_address(m_offsetHL);
+            emit_load_byte(HOST_AL, srcOffset);
+            emit_write_memory(site);
+        } else if(destOffset != srcOffset){
+            emit_copy_cpu_byte(destOffset, srcOffset);
+        }
+        return true;
+    }
+
+    //8-bit ALU ops on A, with a register, (HL) or an immediate. The ALU op is in bits 3-5 either way.
+    bool bAluRegister = (op.opcode >= OP_ADD_B) && (op.opcode <= OP_CP_A);
+    bool bAluConst = (op.opcode & 0xC7) == 0xC6;
+    if(bAluRegister || bAluConst){
+        uint8_t aluIndex = (op.opcode >> 3) & 7;
+        bool bSubtract = (aluIndex == 2) || (aluIndex == 3) || (aluIndex == 7);
+        bool bLogic = (aluIndex == 4) || (aluIndex == 5) || (aluIndex == 6);
+
+        //Operand goes in cl
+        if(bAluConst){
+            emit_byte(0xB1); emit_byte(getLSB(op.operand));
+        } else if(get_register_offset(op.opcode & 7) < 0){
+            emit_load_address(m_offsetHL);
+            emit_read_memory(site);
+            //mov ecx, eax
+            emit_byte(0x89); emit_byte(0xC1);
+        } else {
+            emit_load_byte(HOST_CL, get_register_offset(op.opcode & 7));
+        }
+
+        uint8_t flagsSet = bSubtract ? FLAG_BIT_N : ((aluIndex == 4) ? FLAG_BIT_H : 0);
+        emit_alu(s_hostAluOps[aluIndex], (aluIndex == 1) || (aluIndex == 3), aluIndex != 7, bLogic ? FLAG_BIT_Z : (FLAG_BIT_Z | FLAG_BIT_H | FLAG_BIT_C), flagsSet);
+        return true;
+    }
+
+    //INC r, DEC r and LD r,n, with the register in bits 3-5
+    if(op.opcode < 0x40){
+        int32_t offset = get_register_offset((op.opcode >> 3) & 7);
+
+        switch(op.opcode & 0x07){
+            case 0x04:
+                emit_inc_dec(offset, false, site);
+                return true;
+            case 0x05:
+                emit_inc_dec(offset, true, site);
+                return true;
+            case 0x06:
+                if(offset < 0){
+                    emit_load_address(m_offsetHL);
+                    emit_byte(0xB0); emit_byte(getLSB(op.operand));
+                    emit_write_memory(site);
+                } else {
+                    emit_mov_cpu_byte(offset, getLSB(op.operand));
+                }
+                return true;
+            default:
+                break;
+        }
+    }
+
+    switch(op.opcode){
+        case OP_NOP:
+            return true;
+
+        case OP_LD_BC_NN:
+            emit_mov_cpu_word(m_offsetBC, op.operand);
+            return true;
+        case OP_LD_DE_NN:
+            emit_mov_cpu_word(m_offsetDE, op.operand);
+            return true;
+        case OP_LD_HL_NN:
+            emit_mov_cpu_word(m_offsetHL, op.operand);
+            return true;
+        case OP_LD_SP_NN:
+            emit_mov_cpu_word(m_offsetSP, op.operand);
+            return true;
+
+        case OP_INC_BC:
+            emit_inc_cpu_word(m_offsetBC);
+            return true;
+        case OP_INC_DE:
+            emit_inc_cpu_word(m_offsetDE);
+            return true;
+        case OP_INC_HL:
+            emit_inc_cpu_word(m_offsetHL);
+            return true;
+        case OP_INC_SP:
+            emit_inc_cpu_word(m_offsetSP);
+            return true;
+        case OP_DEC_BC:
+            emit_dec_cpu_word(m_offsetBC);
+            return true;
+        case OP_DEC_DE:
+            emit_dec_cpu_word(m_offsetDE);
+            return true;
+        case OP_DEC_HL:
+            emit_dec_cpu_word(m_offsetHL);
+            return true;
+        case OP_DEC_SP:
+            emit_dec_cpu_word(m_offsetSP);
+            return true;
+
+        //Loads and stores through BC, DE, (nn) and the IO page
+        case OP_LD_A_BCI:
+        case OP_LD_A_DEI:
+        case OP_LD_A_NNI:
+        case OP_LDH_A_FF00NI:
+        case OP_LD_A_FF00CI:
+            if(op.opcode == OP_LD_A_BCI){
+                emit_load_address(m_offsetBC);
+            } else if(op.opcode == OP_LD_A_DEI){
+                emit_load_address(m_offsetDE);
+            } else if(op.opcode == OP_LD_A_NNI){
+                emit_set_address(op.operand);
+            } else if(op.opcode == OP_LDH_A_FF00NI){
+                emit_set_address(0xFF00 + getLSB(op.operand));
+            } else {
+                //movzx ecx, byte C; or ecx, 0xFF00
+                emit_byte(0x0F); emit_byte(0xB6); emit_byte(0x8B); emit_dword(m_offsetBC);
+                emit_byte(0x81); emit_byte(0xC9); emit_dword(0xFF00);
+            }
+            emit_read_memory(site);
+            emit_store_byte(HOST_AL, offsetA);
+            return true;
+
+        case OP_LD_BCI_A:
+        case OP_LD_DEI_A:
+        case OP_LD_NNI_A:
+        case OP_LDH_FF00NI_A:
+        case OP_LD_FF00CI_A:
+            if(op.opcode == OP_LD_BCI_A){
+                emit_load_address(m_offsetBC);
+            } else if(op.opcode == OP_LD_DEI_A){
+                emit_load_address(m_offsetDE);
+            } else if(op.opcode == OP_LD_NNI_A){
+                emit_set_address(op.operand);
+            } else if(op.opcode == OP_LDH_FF00NI_A){
+                emit_set_address(0xFF00 + getLSB(op.operand));
+            } else {
+                emit_byte(0x0F); emit_byte(0xB6); emit_byte(0x8B); emit_dword(m_offsetBC);
+                emit_byte(0x81); emit_byte(0xC9); emit_dword(0xFF00);
+            }
+            emit_load_byte(HOST_AL, offsetA);
+            emit_write_memory(site);
+            return true;
+
+        //HL is stepped before the access, so it's already done if a write ends the block
+        case OP_LDI_A_HLI:
+        case OP_LDD_A_HLI:
+            emit_load_address(m_offsetHL);
+            if(op.opcode == OP_LDI_A_HLI){
+                emit_inc_cpu_word(m_offsetHL);
+            } else {
+                emit_dec_cpu_word(m_offsetHL);
+            }
+            emit_read_memory(site);
+            emit_store_byte(HOST_AL, offsetA);
+            return true;
+
+        case OP_LDI_HLI_A:
+        case OP_LDD_HLI_A:
+            emit_load_address(m_offsetHL);
+            if(op.opcode == OP_LDI_HLI_A){
+                emit_inc_cpu_word(m_offsetHL);
+            } else {
+                emit_dec_cpu_word(m_offsetHL);
+            }
+            emit_load_byte(HOST_AL, offsetA);
+            emit_write_memory(site);
+            return true;
+
+        //Flag ops. F is always up to date in compiled code.
+        case OP_CPL:
+            emit_op_cpu_byte(6, offsetA, 0xFF);
+            emit_op_cpu_byte(1, m_offsetAF, FLAG_BIT_N | FLAG_BIT_H);
+            return true;
+        case OP_SCF:
+            emit_op_cpu_byte(4, m_offsetAF, FLAG_BIT_Z);
+            emit_op_cpu_byte(1, m_offsetAF, FLAG_BIT_C);
+            return true;
+        case OP_CCF:
+            emit_op_cpu_byte(4, m_offsetAF, FLAG_BIT_Z | FLAG_BIT_C);
+            emit_op_cpu_byte(6, m_offsetAF, FLAG_BIT_C);
+            return true;
+
+        //Jumps
+        case OP_JP:
+            emit_branch(0, false, op.operand);
+            return true;
+        case OP_JP_NZ:
+            emit_branch(FLAG_BIT_Z, false, op.operand);
+            return true;
+        case OP_JP_Z:
+            emit_branch(FLAG_BIT_Z, true, op.operand);
+            return true;
+        case OP_JP_NC:
+            emit_branch(FLAG_BIT_C, false, op.operand);
+            return true;
+        case OP_JP_C:
+            emit_branch(FLAG_BIT_C, true, op.operand);
+            return true;
+        case OP_JR:
+            emit_branch(0, false, nextAddress + (int8_t)getLSB(op.operand));
+            return true;
+        case OP_JR_NZ:
+            emit_branch(FLAG_BIT_Z, false, nextAddress + (int8_t)getLSB(op.operand));
+            return true;
+        case OP_JR_Z:
+            emit_branch(FLAG_BIT_Z, true, nextAddress + (int8_t)getLSB(op.operand));
+            return true;
+        case OP_JR_NC:
+            emit_branch(FLAG_BIT_C, false, nextAddress + (int8_t)getLSB(op.operand));
+            return true;
+        case OP_JR_C:
+            emit_branch(FLAG_BIT_C, true, nextAddress + (int8_t)getLSB(op.operand));
+            return true;
+        case OP_JP_HLI:
+            //movzx eax, word HL; mov word PC, ax
+            emit_byte(0x0F); emit_byte(0xB7); emit_byte(0x83); emit_dword(m_offsetHL);
+            emit_byte(0x66); emit_byte(0x89); emit_byte(0x83); emit_dword(m_offsetPC);
+            return true;
+
+        default:
+            break;
+    }
+
+    return false;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "gbz80cpu.h"
+#include "../constants.h"
+
+//Native code generation is only implemented for x86-64. Everything else stays on the interpreter.
+#if defined(__x86_64__) || defined(_M_X64)
+#define JIT_SUPPORTED true
+#else
+#define JIT_SUPPORTED false
+#endif
+
+//Size of the executable code cache. Flushed and refilled when it runs out.
+#define JIT_CODE_CACHE_SIZE 0x400000
+
+//Number of times a block has to be entered before it gets compiled
+#define JIT_HOT_BLOCK_THRESHOLD 32
+
+//Compiled code tells the callbacks which op it's on as (index << 16) | cycles from the start of the block to the op
+#define JIT_SITE(index, cycles) ((uint32_t)(((index) << 16) | (cycles)))
+#define JIT_SITE_INDEX(site) ((site) >> 16)
+#define JIT_SITE_CYCLES(site) ((site) & 0xFFFF)
+
+class GBJit{
+    private:
+        //Code memory, filled from the start. Pages are only writable while a block is being copied in.
+        uint8_t* m_codeCache;
+        size_t m_codeCacheUsed;
+        size_t m_pageSize;
+
+        //Code for the block currently being compiled
+        std::vector<uint8_t> m_code;
+
+        //Offsets of rel32 jumps to the block exit, patched once the exit has been emitted
+        std::vector<size_t> m_exitJumps;
+
+        //Offsets of the registers inside GBZ80, resolved once at startup
+        int32_t m_offsetAF;
+        int32_t m_offsetBC;
+        int32_t m_offsetDE;
+        int32_t m_offsetHL;
+        int32_t m_offsetSP;
+        int32_t m_offsetPC;
+
+        //GBMem page table, for reaching plain memory without calling back
+        uint8_t* m_pageTable;
+        int32_t m_pageStride;
+        int32_t m_pageReadOffset;
+        int32_t m_pageWriteOffset;
+        uint32_t* m_codePageVersions;
+
+        //Code emission
+        void emit_byte(uint8_t val);
+        void emit_word(uint16_t val);
+        void emit_dword(uint32_t val);
+        void emit_qword(uint64_t val);
+        void emit_mov_cpu_word(int32_t offset, uint16_t val);
+        void emit_mov_cpu_byte(int32_t offset, uint8_t val);
+        void emit_copy_cpu_byte(int32_t destOffset, int32_t srcOffset);
+        void emit_inc_cpu_word(int32_t offset);
+        void emit_dec_cpu_word(int32_t offset);
+        void emit_op_cpu_byte(uint8_t op, int32_t offset, uint8_t val);
+        void emit_load_byte(uint8_t reg, int32_t offset);
+        void emit_store_byte(uint8_t reg, int32_t offset);
+        void emit_load_address(int32_t offset);
+        void emit_set_address(uint16_t address);
+        void emit_read_memory(uint32_t site);
+        void emit_write_memory(uint32_t site);
+        void emit_alu(uint8_t aluOp, bool bCarryIn, bool bStore, uint8_t flagsFromHost, uint8_t flagsSet);
+        void emit_inc_dec(int32_t offset, bool bDec, uint32_t site);
+        void emit_store_flags(uint8_t flagsFromHost, uint8_t flagsKept, uint8_t flagsSet);
+        void emit_branch(uint8_t flagMask, bool bTakenIfSet, uint16_t target);
+        void emit_call(void* func);
+        void emit_exit_unless_true();
+        size_t emit_jump8(uint8_t opcode);
+        void patch_jump8(size_t position);
+
+        //Returns the offset of an 8-bit register from its index in the opcode. B, C, D, E, H, L, (HL), A.
+        int32_t get_register_offset(uint8_t index);
+
+        //Emits native code for an op. Returns false, without emitting anything, if the op needs the interpreter.
+        bool emit_native_op(const GBZ80::MicroOp& op, uint32_t site);
+
+        //Switches a range of the code cache between writable and executable
+        bool protect_code(uint8_t* start, size_t size, bool bWritable);
+
+        void free_code_cache();
+
+    public:
+        GBJit(GBZ80* cpu);
+        ~GBJit();
+
+        //False if executable memory couldn't be allocated
+        bool getEnabled();
+
+        //Compiles a decoded block to native code. Returns NULL if the code cache is full.
+        GBZ80::JitBlockFunc compile(const GBZ80::CodeBlock* block);
+
+        //Throws away all compiled code
+        void flush();
+};
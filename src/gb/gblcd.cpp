@@ -1,6 +1,10 @@
 #include <iostream>
 #include <cstring> //Needed for memset
 #include <math.h>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
 #include "gblcd.h"
 #include "gbmem.h"
 #include "bytehelpers.h"
@@ -11,20 +15,30 @@ GBLCD::GBLCD(GBMem* mem){
     //Clear pointers so we don't risk pre-existing garbage triggering a buffer update
     m_displayRenderer = NULL;
     
-	m_gbcBGPalettes = new uint8_t[0x3F];
-	m_gbcOAMPalettes = new uint8_t[0x3F];
+	m_gbcBGPalettes = new uint8_t[GBC_PALETTE_BYTES];
+	m_gbcOAMPalettes = new uint8_t[GBC_PALETTE_BYTES];
 
 	//GBC palettes are initialized to white on startup
-	memset(m_gbcBGPalettes, 0xFF, 0x3F);
-	memset(m_gbcOAMPalettes, 0xFF, 0x3F);
+	memset(m_gbcBGPalettes, 0xFF, GBC_PALETTE_BYTES);
+	memset(m_gbcOAMPalettes, 0xFF, GBC_PALETTE_BYTES);
+	for (uint8_t byteIndex = 0; byteIndex < GBC_PALETTE_BYTES; byteIndex += 2) {
+		m_gbcBGColors[byteIndex / 2] = getColorGBC(m_gbcBGPalettes, byteIndex / 8, (byteIndex % 8) / 2);
+		m_gbcOAMColors[byteIndex / 2] = getColorGBC(m_gbcOAMPalettes, byteIndex / 8, (byteIndex % 8) / 2);
+	}
 
     m_Frames = 0;
-    m_Framebuffer0 = new RGBColor*[FRAMEBUFFER_WIDTH];
-    m_Framebuffer1 = new RGBColor*[FRAMEBUFFER_WIDTH];
-    for(int col = 0; col < FRAMEBUFFER_WIDTH; col++){
-        m_Framebuffer0[col] = new RGBColor[FRAMEBUFFER_HEIGHT];
-        m_Framebuffer1[col] = new RGBColor[FRAMEBUFFER_HEIGHT];
-    }
+    m_bNewFrame = false;
+    m_bSwapBuffers = false;
+    m_Framebuffer0 = allocateFrame();
+    m_Framebuffer1 = allocateFrame();
+    
+    //Pick the line kernels before anything is decoded with them
+    m_kernels = USE_SIMD_LINE_KERNELS ? &GBLineKernels::getBest() : &GBLineKernels::getScalar();
+    if(CONSOLE_OUTPUT_ENABLED) std::cout << "Using " << m_kernels->name << " line kernels" << std::endl;
+    
+    //Decode whatever is already in vram
+    updateTileCache(0, 0, TILE_DATA_SIZE);
+    updateTileCache(1, 0, TILE_DATA_SIZE);
     
     if(!m_gbmemory->getBootRomEnabled()){
         setSTAT(0x85);
@@ -37,6 +51,11 @@ GBLCD::GBLCD(GBMem* mem){
         setLCDC(0);
     }   
     
+    //Palette registers may have been set before the LCD existed
+    updateBGColors();
+    updateSpriteColors(0);
+    updateSpriteColors(1);
+    
 	//Ensure scroll position is set to upper left on startup.
 	setScrollX(0);
 	setScrollY(0);
@@ -45,47 +64,80 @@ GBLCD::GBLCD(GBMem* mem){
     swapBuffers();
 
 	m_bHBlankDMAInProgress = false;
+    
+    //Platform is set by memory once it is known
+    setPlatform(PLATFORM_DMG);
+    
+    m_timeRollover = 0;
+    m_LYIncrementCount = 0;
 }
 
 GBLCD::~GBLCD(){
-    //TODO - properly delete each line in the arrays in addition to base pointer
-    delete m_Framebuffer0;
-    delete m_Framebuffer1;
-	delete m_gbcOAMPalettes;
-	delete m_gbcBGPalettes;
+    freeFrame(m_Framebuffer0);
+    freeFrame(m_Framebuffer1);
+	delete[] m_gbcOAMPalettes;
+	delete[] m_gbcBGPalettes;
 }
 
-void GBLCD::tick(long long hz){    
-    //Store any unused Hz so that we can factor it into the next update
-    static long long timeRollover = 0;
+//Allocates a frame aligned to FRAMEBUFFER_ALIGNMENT and clears it to black
+uint32_t* GBLCD::allocateFrame(){
+    void* pointer = NULL;
+#ifdef _WIN32
+    pointer = _aligned_malloc(FRAMEBUFFER_SIZE * sizeof(uint32_t), FRAMEBUFFER_ALIGNMENT);
+#else
+    if(posix_memalign(&pointer, FRAMEBUFFER_ALIGNMENT, FRAMEBUFFER_SIZE * sizeof(uint32_t)) != 0){
+        pointer = NULL;
+    }
+#endif
+    
+    if(pointer == NULL){
+        throw std::bad_alloc();
+    }
     
+    uint32_t* frame = (uint32_t*)pointer;
+    for(int pixel = 0; pixel < FRAMEBUFFER_SIZE; pixel++){
+        frame[pixel] = COLOR_BLACK;
+    }
+    
+    return frame;
+}
+
+void GBLCD::freeFrame(uint32_t* frame){
+#ifdef _WIN32
+    _aligned_free(frame);
+#else
+    free(frame);
+#endif
+}
+
+//Picks the line renderer for the platform. Called by memory whenever the platform changes.
+void GBLCD::setPlatform(Platform platform){
+    switch(platform){
+        case PLATFORM_GBC:
+            m_renderLine = &GBLCD::renderLine<PLATFORM_GBC>;
+            break;
+        case PLATFORM_GBC_BC:
+            m_renderLine = &GBLCD::renderLine<PLATFORM_GBC_BC>;
+            break;
+        default:
+            //SGB renders as DMG
+            m_renderLine = &GBLCD::renderLine<PLATFORM_DMG>;
+            break;
+    }
+}
+
+void GBLCD::tick(long long hz){    
     //Include any previous clock unused from the last update
-    hz += timeRollover;
+    hz += m_timeRollover;
     
     uint8_t currentLCDMode = getSTAT() & STAT_MODE_FLAG;
     
     bool bTimeForTasks = true; //TODO - rename this to something more elegant
     while(bTimeForTasks){
         //Figure out how much time we need to execute the mode
-        int currentModeTimeLength = 0;        
-        
-        switch(currentLCDMode){
-            case STAT_MODE0_HBLANK:
-                currentModeTimeLength = CYCLES_LCD_MODE0;
-                break;
-            case STAT_MODE1_VBLANK:
-                currentModeTimeLength = CYCLES_VBLANK_LYINCREMENT_INTERVAL;
-                break;
-            case STAT_MODE2_OAM:
-                currentModeTimeLength = CYCLES_LCD_MODE2;
-                break;
-            case STAT_MODE3_TRANSFER:
-                currentModeTimeLength = CYCLES_LCD_MODE3;
-                break;
-        }
+        int currentModeTimeLength = getModeLength(currentLCDMode);
         
         uint8_t currentSTAT = getSTAT();
-		static int LYIncrementCount = 0;
 
         //If we have time, perform needed logic and advance mode
         if(hz > currentModeTimeLength){            
@@ -107,7 +159,7 @@ void GBLCD::tick(long long hz){
                     
                     break;
                 case STAT_MODE1_VBLANK:
-                    if(LYIncrementCount == 0){                        
+                    if(m_LYIncrementCount == 0){                        
                         incrementLY();
                         
                         //Fire event if enabled and coincidence is hit
@@ -116,12 +168,12 @@ void GBLCD::tick(long long hz){
                             m_gbmemory->write(ADDRESS_IF, interruptFlags | INTERRUPT_FLAG_STAT);
                         }
                         
-                        LYIncrementCount++;
-                    } else if (LYIncrementCount >= VBLANK_LYINCREMENT_COUNT){
+                        m_LYIncrementCount++;
+                    } else if (m_LYIncrementCount >= VBLANK_LYINCREMENT_COUNT){
                         //VBlank is followed by mode 2
                         currentSTAT &= ~STAT_MODE1_VBLANK;
                         currentSTAT |= STAT_MODE2_OAM;
-                        LYIncrementCount = 0;
+                        m_LYIncrementCount = 0;
                         m_gbmemory->direct_write(ADDRESS_LY, 0);
                     } else {
                         incrementLY();
@@ -132,7 +184,7 @@ void GBLCD::tick(long long hz){
                             m_gbmemory->write(ADDRESS_IF, interruptFlags | INTERRUPT_FLAG_STAT);
                         }
                         
-                        LYIncrementCount++;
+                        m_LYIncrementCount++;
                     }
                     
                     //Set STAT directly so we can write the bottom three bits
@@ -180,7 +232,30 @@ void GBLCD::tick(long long hz){
     }
     
     //Store positive remaining time
-    timeRollover = (hz > 0) ? hz : 0;
+    m_timeRollover = (hz > 0) ? hz : 0;
+}
+
+//Gets the number of clock cycles the given mode lasts
+int GBLCD::getModeLength(uint8_t mode){
+    switch(mode){
+        case STAT_MODE0_HBLANK:
+            return CYCLES_LCD_MODE0;
+        case STAT_MODE1_VBLANK:
+            return CYCLES_VBLANK_LYINCREMENT_INTERVAL;
+        case STAT_MODE2_OAM:
+            return CYCLES_LCD_MODE2;
+        case STAT_MODE3_TRANSFER:
+            return CYCLES_LCD_MODE3;
+    }
+    
+    return 0;
+}
+
+//Gets the number of clock cycles tick needs before the current mode ends
+long long GBLCD::getCyclesUntilModeChange(){
+    //Modes only end once they have been given more than their length
+    long long remaining = getModeLength(getSTAT() & STAT_MODE_FLAG) + 1 - m_timeRollover;
+    return (remaining > 1) ? remaining : 1;
 }
 
 void GBLCD::performHBlank(){
@@ -194,7 +269,7 @@ void GBLCD::performHBlank(){
         }
 		
         //Render line
-        renderLine();
+        (this->*m_renderLine)();
         
         //Set line for next blank
         incrementLY();
@@ -239,8 +314,8 @@ void GBLCD::incrementLY(){
     m_gbmemory->direct_write(ADDRESS_LY, getLY() + 1);
 }
 
-RGBColor GBLCD::getColor(uint8_t palette, uint8_t colorIndex){
-    RGBColor toReturn;
+uint32_t GBLCD::getColor(uint8_t palette, uint8_t colorIndex){
+    uint32_t toReturn = COLOR_WHITE;
     
     uint8_t colorPalette[4];
     colorPalette[0] = palette & 0x03;
@@ -267,18 +342,12 @@ RGBColor GBLCD::getColor(uint8_t palette, uint8_t colorIndex){
             break;
     }
     
-    //The 0th color index indicates either a transparent sprite color or a background color which doesn't block transparent sprites.
-    if(colorIndex == 0){
-        toReturn.transparent = true;
-    }
-    
     return toReturn;
 }
 
 //Gets GBC color from the given color index within the given palette index of the palette buffer.
-RGBColor GBLCD::getColorGBC(uint8_t* paletteBuffer, uint8_t paletteIndex, uint8_t colorIndex) {
+uint32_t GBLCD::getColorGBC(uint8_t* paletteBuffer, uint8_t paletteIndex, uint8_t colorIndex) {
 	//std::cout << "Unimplemented getColorGBC" << std::endl;
-	RGBColor toReturn;
 
 	paletteIndex &= 0x3F;
 
@@ -291,33 +360,30 @@ RGBColor GBLCD::getColorGBC(uint8_t* paletteBuffer, uint8_t paletteIndex, uint8_
 	uint8_t green = (rawColor >> 5) & 0x1F;
 	uint8_t red = (rawColor >> 10) & 0x1F;
 	
-	//Create RGBColor, converting from 5-bit to 8-bit color in the process
-	toReturn = RGBColor(red * (0xFF/0x1F), green * (0xFF/0x1F), blue * (0xFF/0x1F));
-
-	//The 0th color index indicates either a transparent sprite color or a background color which doesn't block transparent sprites.
-	toReturn.transparent = (colorIndex == 0);
+	//Pack color, converting from 5-bit to 8-bit color in the process
+	return PIXEL_PACK(red * (0xFF/0x1F), green * (0xFF/0x1F), blue * (0xFF/0x1F));
+}
 
-	return toReturn;
+//Rebuilds the background colors from BGP
+void GBLCD::updateBGColors(){
+    uint8_t palette = getBGPalette();
+    for(int colorIndex = 0; colorIndex < 4; colorIndex++){
+        m_dmgBGColors[colorIndex] = getColor(palette, colorIndex);
+        m_bgShades[colorIndex] = (palette >> (colorIndex * 2)) & 0x03;
+    }
 }
 
-//Gets the default palette index for a given B&W RGB color
-int GBLCD::getDefaultIndexFromColor(RGBColor color){
-    int toReturn = 0;
-    
-    if(color.equals(COLOR_WHITE)){
-        toReturn = PALETTE_BW_WHITE;
-    } else if (color.equals(COLOR_LIGHTGRAY)){
-        toReturn = PALETTE_BW_LIGHTGRAY;
-    } else if (color.equals(COLOR_DARKGRAY)){
-        toReturn = PALETTE_BW_DARKGRAY;
-    } else if (color.equals(COLOR_BLACK)){
-        toReturn = PALETTE_BW_BLACK;
+//Rebuilds the colors for OBP0 or OBP1. Backwards compatibility colors also depend on the first GBC sprite palette.
+void GBLCD::updateSpriteColors(int palette){
+    uint8_t paletteRegister = palette ? getSpritePalette1() : getSpritePalette0();
+    for(int colorIndex = 0; colorIndex < 4; colorIndex++){
+        m_dmgSpriteColors[palette][colorIndex] = getColor(paletteRegister, colorIndex);
+        m_bcSpriteColors[palette][colorIndex] = getColorGBC(m_gbcOAMPalettes, 0, (paletteRegister >> (colorIndex * 2)) & 0x03);
     }
-    
-    return toReturn;
 }
 
-void GBLCD::updateBackgroundLine(RGBColor** frameBuffer){    
+template<Platform platform>
+void GBLCD::updateBackgroundLine(){    
     int bgPixelY = (getLY() + getScrollY()) % (BACKGROUND_MAP_HEIGHT * TILE_HEIGHT);
     
     uint16_t tileLocation = (getLCDC() & LCDC_BG_TILE_MAP_DISPLAY_SELECT) ? BG_TILE_MAP_DISPLAY_1 : BG_TILE_MAP_DISPLAY_0;
@@ -349,7 +415,7 @@ void GBLCD::updateBackgroundLine(RGBColor** frameBuffer){
         }
         
 		uint8_t gbcFlags = 0;
-		if (m_gbmemory->getGBCMode()) {
+		if (platform == PLATFORM_GBC) {
 			//Flags for background tiles are stored at the same address in bank 1 as where the tile map is in bank 0.
 			gbcFlags = m_gbmemory->direct_vram_read(tileLocation - VRAM_START, 1);
 		}
@@ -358,42 +424,38 @@ void GBLCD::updateBackgroundLine(RGBColor** frameBuffer){
 		uint8_t tileLineHeight = (bgPixelY % TILE_HEIGHT);
 
 		//If the vertical flip flag is set, flip it.
-		if (m_gbmemory->getGBCMode() && (gbcFlags & BGMAP_ATTRIBUTE_VERTICAL_FLIP)){
+		if ((platform == PLATFORM_GBC) && (gbcFlags & BGMAP_ATTRIBUTE_VERTICAL_FLIP)){
 			tileLineHeight = TILE_HEIGHT - tileLineHeight - 1;
 		}
 
-        getTileLine(m_TempTile, (gbcFlags & BGMAP_ATTRIBUTE_VRAM_BANK) > 0, tilePatternAddress, tileIndex, tileLineHeight);
+        //Tile line comes already flipped if the horizontal flip flag is set
+        const uint8_t* tileLine = getTileLine((gbcFlags & BGMAP_ATTRIBUTE_VRAM_BANK) > 0, tilePatternAddress, tileIndex, tileLineHeight, (gbcFlags & BGMAP_ATTRIBUTE_HORIZONTAL_FLIP) > 0);
         
         for(int tileX = (bScrolledTileDrawn ? 0 : (getScrollX() % TILE_WIDTH)); tileX < TILE_WIDTH; tileX++){
             if(bgPixelX  >= FRAMEBUFFER_WIDTH) break;
 
-			RGBColor pixelColor = COLOR_WHITE;
-
-			//Set pixel color based on platform 
-			if (m_gbmemory->getGBCMode()) {
-				//If the horizontal flip flag is set, flip it.
-				uint8_t orientedTileX = tileX;
-				if (gbcFlags & BGMAP_ATTRIBUTE_HORIZONTAL_FLIP) {
-					orientedTileX = TILE_WIDTH - tileX - 1;
-				}
+			uint8_t colorIndex = tileLine[tileX];
 
-				pixelColor = getColorGBC(m_gbcBGPalettes, gbcFlags & BGMAP_ATTRIBUTE_PALETTE, m_TempTile[orientedTileX]);
+			//Set pixel color index based on platform. Colors are looked up once the whole line is done.
+			if (platform == PLATFORM_GBC) {
+				m_lineColorIndices[bgPixelX] = ((gbcFlags & BGMAP_ATTRIBUTE_PALETTE) * 4) + colorIndex;
                 
                 //Set whether this pixel overrides sprite priority
-                m_gbcBGOverridesOAM[bgPixelX] |= (gbcFlags & BGMAP_ATTRIBUTE_OAM_PRIORITY) > 0;
+                if(gbcFlags & BGMAP_ATTRIBUTE_OAM_PRIORITY){
+                    m_linePriority[bgPixelX] |= LINE_PRIORITY_BG_OVER_OAM;
+                }
 			}
 			else {
-				//DMG Color
-				 pixelColor = getColor(getBGPalette(), m_TempTile[tileX]);
-                
-                //GBC Backwards Compatibility Color
-                if(m_gbmemory->getGBCBackwardsCompatMode()){
-                    int colorIndex = getDefaultIndexFromColor(pixelColor);
-                    pixelColor = getColorGBC(m_gbcBGPalettes, 0, colorIndex);
+                //GBC Backwards Compatibility Color uses the DMG shade as the index into the first GBC palette
+                if(platform == PLATFORM_GBC_BC){
+                    colorIndex = m_bgShades[colorIndex];
                 }
+                
+				m_lineColorIndices[bgPixelX] = colorIndex;
 			}
 
-			frameBuffer[bgPixelX][getLY()] = pixelColor;
+			//The 0th color index is a background color which doesn't block sprites drawn behind the background
+			setLineTransparent(bgPixelX, colorIndex == 0);
 
             bgPixelX++;
         }
@@ -407,7 +469,10 @@ void GBLCD::updateBackgroundLine(RGBColor** frameBuffer){
     }
 }
 
-void GBLCD::updateWindowLine(RGBColor** frameBuffer){    
+template<Platform platform>
+int GBLCD::updateWindowLine(){    
+    int firstPixel = FRAMEBUFFER_WIDTH;
+    
     if(getWindowX() >= 0 && getWindowX() < FRAMEBUFFER_WIDTH){
         if(getWindowY() <= getLY()){
             uint16_t tileLocation = (getLCDC() & LCDC_WINDOW_TILE_MAP_DISPLAY_SELECT) ? BG_TILE_MAP_DISPLAY_1 : BG_TILE_MAP_DISPLAY_0;
@@ -431,7 +496,7 @@ void GBLCD::updateWindowLine(RGBColor** frameBuffer){
                 }
 
 				uint8_t gbcFlags = 0;
-				if (m_gbmemory->getGBCMode()) {
+				if (platform == PLATFORM_GBC) {
 					//Flags for background tiles are stored at the same address in bank 1 as where the tile map is in bank 0.
 					gbcFlags = m_gbmemory->direct_vram_read(tileLocation - VRAM_START, 1);
 				}
@@ -440,11 +505,12 @@ void GBLCD::updateWindowLine(RGBColor** frameBuffer){
 				uint8_t tileLineHeight = ((getLY() - getWindowY()) % TILE_HEIGHT);
 
 				//If the vertical flip flag is set, flip it.
-				if (m_gbmemory->getGBCMode() && (gbcFlags & BGMAP_ATTRIBUTE_VERTICAL_FLIP)) {
+				if ((platform == PLATFORM_GBC) && (gbcFlags & BGMAP_ATTRIBUTE_VERTICAL_FLIP)) {
 					tileLineHeight = TILE_HEIGHT - tileLineHeight - 1;
 				}
 
-				getTileLine(m_TempTile, (gbcFlags & BGMAP_ATTRIBUTE_VRAM_BANK) > 0, tilePatternAddress, tileIndex, tileLineHeight);
+				//Tile line comes already flipped if the horizontal flip flag is set
+				const uint8_t* tileLine = getTileLine((gbcFlags & BGMAP_ATTRIBUTE_VRAM_BANK) > 0, tilePatternAddress, tileIndex, tileLineHeight, (gbcFlags & BGMAP_ATTRIBUTE_HORIZONTAL_FLIP) > 0);
                 
                 for(int tileX = 0; tileX < TILE_WIDTH && (tileX + bgPixelX) < FRAMEBUFFER_WIDTH; tileX++){
                     //Skip over any part of the tile off the left edge of the screen
@@ -453,31 +519,30 @@ void GBLCD::updateWindowLine(RGBColor** frameBuffer){
                     }
 				
                     if(bgPixelX + tileX < FRAMEBUFFER_WIDTH){
-						RGBColor pixelColor = COLOR_WHITE;
-
-						//Set pixel color based on platform
-						if (m_gbmemory->getGBCMode()) {
-							//If the horizontal flip flag is set, flip it.
-							uint8_t orientedTileX = tileX;
-							if (gbcFlags & BGMAP_ATTRIBUTE_HORIZONTAL_FLIP) {
-								orientedTileX = TILE_WIDTH - tileX - 1;
-							}
+						uint8_t colorIndex = tileLine[tileX];
 
-							pixelColor = getColorGBC(m_gbcBGPalettes, gbcFlags & BGMAP_ATTRIBUTE_PALETTE, m_TempTile[orientedTileX]);
+						//Set pixel color index based on platform
+						if (platform == PLATFORM_GBC) {
+							m_lineColorIndices[bgPixelX + tileX] = ((gbcFlags & BGMAP_ATTRIBUTE_PALETTE) * 4) + colorIndex;
                             
                             //Set whether this pixel overrides sprite priority
-                            m_gbcBGOverridesOAM[bgPixelX + tileX] |= (gbcFlags & BGMAP_ATTRIBUTE_OAM_PRIORITY) > 0;
+                            if(gbcFlags & BGMAP_ATTRIBUTE_OAM_PRIORITY){
+                                m_linePriority[bgPixelX + tileX] |= LINE_PRIORITY_BG_OVER_OAM;
+                            }
                             
 						} else {
-							pixelColor = getColor(getBGPalette(), m_TempTile[tileX]);
-                            
                             //GBC Backwards Compatibility Color
-                            if(m_gbmemory->getGBCBackwardsCompatMode()){
-                                int colorIndex = getDefaultIndexFromColor(pixelColor);
-                                pixelColor = getColorGBC(m_gbcBGPalettes, 0, colorIndex);
+                            if(platform == PLATFORM_GBC_BC){
+                                colorIndex = m_bgShades[colorIndex];
                             }
+                            
+							m_lineColorIndices[bgPixelX + tileX] = colorIndex;
+						}
+						setLineTransparent(bgPixelX + tileX, colorIndex == 0);
+						
+						if(bgPixelX + tileX < firstPixel){
+							firstPixel = bgPixelX + tileX;
 						}
-						frameBuffer[(bgPixelX + tileX)][getLY()] = pixelColor;
                     } else {
                         break;
                     }
@@ -487,10 +552,13 @@ void GBLCD::updateWindowLine(RGBColor** frameBuffer){
             }
         }
     }
+    
+    return firstPixel;
 }
 
 //Updates the sprites for the line indicated by LY
-void GBLCD::updateLineSprites(RGBColor** frameBuffer){
+template<Platform platform>
+void GBLCD::updateLineSprites(uint32_t* line){
     //return;
     uint8_t spriteXPos = 0;
     uint8_t spriteYPos = 0;
@@ -513,14 +581,14 @@ void GBLCD::updateLineSprites(RGBColor** frameBuffer){
         spriteFlags = m_gbmemory->direct_read(spriteAttributeAddress + 3);
         bXFlip = (spriteFlags & SPRITE_ATTRIBUTE_XFLIP) ? true : false;
         bYFlip = (spriteFlags & SPRITE_ATTRIBUTE_YFLIP) ? true : false;
-		if (m_gbmemory->getGBCMode()) {
+		if (platform == PLATFORM_GBC) {
 			vramBank = (spriteFlags & SPRITE_ATTRIBUTE_VRAM_BANK) > 0;
 			gbcPaletteNumber = spriteFlags & SPRITE_ATTRIBUTE_GBC_PALETTE;
 		}
         
         int realXPos = spriteXPos - SPRITE_X_OFFSET;
         int realYPos = spriteYPos - SPRITE_Y_OFFSET;
-        uint8_t palette = (spriteFlags & SPRITE_ATTRIBUTE_PALLETE) ? getSpritePalette1() : getSpritePalette0();
+        int palette = (spriteFlags & SPRITE_ATTRIBUTE_PALLETE) ? 1 : 0;
         
         //Check if sprite is actually on screen
         if((realXPos > -7 && realXPos < 168)){
@@ -536,34 +604,29 @@ void GBLCD::updateLineSprites(RGBColor** frameBuffer){
                     tileYSpriteLine = 7 - tileYSpriteLine;
                 }
                 
-                getTileLine(m_TempTile, vramBank, TILE_PATTERN_TABLE_1, spriteTileNum, tileYSpriteLine);
+                const uint8_t* tileLine = getTileLine(vramBank, TILE_PATTERN_TABLE_1, spriteTileNum, tileYSpriteLine, bXFlip);
                 
-                for(int tileX = 0; tileX < TILE_WIDTH; tileX++){
-                    int renderPosX = realXPos + tileX;
-                    if(renderPosX > 0 && renderPosX < FRAMEBUFFER_WIDTH){
-						RGBColor pixel = COLOR_WHITE;
-						if (m_gbmemory->getGBCMode()) {
-							pixel = getColorGBC(m_gbcOAMPalettes, gbcPaletteNumber, m_TempTile[(bXFlip ? (7 - tileX) : tileX)]);
-						} else {
-							pixel = getColor(palette, m_TempTile[(bXFlip ? (7 - tileX) : tileX)]);
-                            
-                            //GBC Backwards Compatibility Color
-                            if(m_gbmemory->getGBCBackwardsCompatMode()){
-                                bool originalTransparentcy = pixel.transparent;
-                                int colorIndex = getDefaultIndexFromColor(pixel);
-                                
-                                pixel = getColorGBC(m_gbcOAMPalettes, 0, colorIndex);
-                                pixel.transparent = originalTransparentcy;
-                            }
-						}
-                         
-                        if(!pixel.transparent && !m_gbcBGOverridesOAM[renderPosX]){
-							//On Gameboy Color, when bit 0 of LCDC is cleared sprites always have priority independent of priority flags.
-                            if((m_gbmemory->getGBCMode() && !(getLCDC() & LCDC_BG_DISPLAY)) || !(spriteFlags & SPRITE_ATTRIBUTE_BGPRIORITY) || frameBuffer[renderPosX][getLY()].transparent){
-                                frameBuffer[renderPosX][getLY()] = pixel;
-                            }
+                //Color for each of the sprite's palette indices
+                const uint32_t* spriteColors = m_dmgSpriteColors[palette];
+				if (platform == PLATFORM_GBC) {
+					spriteColors = &m_gbcOAMColors[gbcPaletteNumber * 4];
+				} else if (platform == PLATFORM_GBC_BC) {
+                    //GBC Backwards Compatibility Color
+                    spriteColors = m_bcSpriteColors[palette];
+				}
+                
+                //On Gameboy Color, when bit 0 of LCDC is cleared sprites always have priority independent of priority flags.
+                bool bBehindBackground = (spriteFlags & SPRITE_ATTRIBUTE_BGPRIORITY) && !((platform == PLATFORM_GBC) && !(getLCDC() & LCDC_BG_DISPLAY));
+                
+                if(realXPos > 0 && realXPos + TILE_WIDTH <= FRAMEBUFFER_WIDTH){
+                    m_kernels->mergeSprite(tileLine, spriteColors, bBehindBackground, &line[realXPos], &m_linePriority[realXPos]);
+                } else {
+                    //Sprite is partly off screen, so only draw the pixels on it
+                    for(int tileX = 0; tileX < TILE_WIDTH; tileX++){
+                        int renderPosX = realXPos + tileX;
+                        if(renderPosX > 0 && renderPosX < FRAMEBUFFER_WIDTH){
+                            GBLineKernels::mergeSpritePixel(tileLine[tileX], spriteColors, bBehindBackground, &line[renderPosX], &m_linePriority[renderPosX]);
                         }
-                        
                     }
                 }
             }
@@ -573,55 +636,70 @@ void GBLCD::updateLineSprites(RGBColor** frameBuffer){
 }
         
 //Renders the current line indicated by LY
+template<Platform platform>
 void GBLCD::renderLine(){
-    RGBColor** buffer = getNextUnfinishedFrame();
+    if(getLY() >= FRAMEBUFFER_HEIGHT){
+        return;
+    }
+    
+    uint32_t* buffer = getNextUnfinishedFrame() + (getLY() * FRAMEBUFFER_PITCH);
+    
+    //Clear gbc background priority over sprites. Without a background or window, sprites always show through.
+    memset(m_linePriority, LINE_PRIORITY_BG_TRANSPARENT, sizeof(m_linePriority));
     
-    //Clear gbc background priority over sprites
-    memset(m_gbcBGOverridesOAM, 0, sizeof(bool) * FRAMEBUFFER_WIDTH);
+    //Leftmost pixel drawn by the background or window
+    int firstPixel = FRAMEBUFFER_WIDTH;
     
     //Check if background is enabled and render if so.
     if((getLCDC() & LCDC_BG_DISPLAY)){ 
-        updateBackgroundLine(buffer);
+        updateBackgroundLine<platform>();
+        firstPixel = 0;
     }
     
     //Check if the window is enabled and render if so
     if(getLCDC() & LCDC_WINDOW_DISPLAY_ENABLE){
-        updateWindowLine(buffer);
+        int windowFirstPixel = updateWindowLine<platform>();
+        if(windowFirstPixel < firstPixel){
+            firstPixel = windowFirstPixel;
+        }
+    }
+    
+    //Look up the colors of the background and window pixels in one pass
+    if(firstPixel < FRAMEBUFFER_WIDTH){
+        if(platform == PLATFORM_GBC){
+            m_kernels->applyPalette32(&m_lineColorIndices[firstPixel], m_gbcBGColors, &buffer[firstPixel], FRAMEBUFFER_WIDTH - firstPixel);
+        } else if(platform == PLATFORM_GBC_BC){
+            //Background indices are already DMG shades
+            m_kernels->applyPalette4(&m_lineColorIndices[firstPixel], m_gbcBGColors, &buffer[firstPixel], FRAMEBUFFER_WIDTH - firstPixel);
+        } else {
+            m_kernels->applyPalette4(&m_lineColorIndices[firstPixel], m_dmgBGColors, &buffer[firstPixel], FRAMEBUFFER_WIDTH - firstPixel);
+        }
     }
     
     //Check if sprites are enabled and render if so
     if(getLCDC() & LCDC_SPRITE_DISPLAY_ENABLE){
         //Render sprites.
-        updateLineSprites(buffer);
+        updateLineSprites<platform>(buffer);
     }
 }
 
-//Gets an 8 pixel line of tiles for the given tile index as an array of palette indicies
-//tileIndex is a value from 0 to 255 or -128 to 127. 
-void GBLCD::getTileLine(uint8_t* out, uint8_t vramBank, uint16_t tilePatternAddress, int tileIndex, int line){ 
-
-    //Calculate the address of the tile's starting byte + offset for the current line.
-    int tileAddress = tilePatternAddress;  //TILE_PATTERN_TABLE_0;
-    tileAddress += (tileIndex * TILE_BYTES);
-    tileAddress += (line * 2);
-	
-	//Translate from system memory address to direct vram bank address
-	uint16_t vramAddress = (tileAddress - VRAM_START);
-
-	//The first byte contains the least significant bits of the color palette index.
-	//Second contains most significant.
-	uint8_t leastSignificantColors = m_gbmemory->direct_vram_read(vramAddress, vramBank);
-	uint8_t mostSignificantColors = m_gbmemory->direct_vram_read(vramAddress + 1, vramBank);
-
-    //Combine the two bits for each pixel in the output
-    for(int colorIndex = 0; colorIndex < TILE_WIDTH; colorIndex++){
-        //Bit 7 is leftmost pixel in the color bytes
-        out[colorIndex] = ((leastSignificantColors >> (TILE_WIDTH - colorIndex - 1)) & 1);
-        out[colorIndex] |= ((mostSignificantColors >> (TILE_WIDTH - colorIndex - 1)) & 1) << 1;
-        if(out[colorIndex] > 3){
-            if(CONSOLE_OUTPUT_ENABLED) std::cout << "Warning - tile at " << +tileAddress << " has a color index greater than 3!" << std::endl;
-        }        
+//Decodes the tile lines covering length bytes of vram from index, in the given bank.
+//Called whenever tile data is written, so the cache always matches vram.
+void GBLCD::updateTileCache(uint8_t vramBank, uint16_t index, uint16_t length){
+    if(length == 0 || index >= TILE_DATA_SIZE){
+        return;
     }
+    
+    uint32_t end = (uint32_t)index + length;
+    if(end > TILE_DATA_SIZE){
+        end = TILE_DATA_SIZE;
+    }
+    
+    //Each line is two bytes, so decode every line with a byte in the range
+    uint32_t firstLine = index / 2;
+    uint32_t lastLine = (end + 1) / 2;
+    uint8_t* decoded = (uint8_t*)m_tileCache[vramBank];
+    m_kernels->decodeTileLines(&m_gbmemory->getVRamBankData(vramBank)[firstLine * 2], lastLine - firstLine, &decoded[firstLine * DECODED_TILE_LINE_SIZE]);
 }
         
 //Swaps buffers and clears the active buffer
@@ -630,6 +708,7 @@ void GBLCD::swapBuffers(){
     
     //Increment frame count
     m_Frames++;
+    m_bNewFrame = true;
 }
 
 void GBLCD::setMainRenderer(IRenderer* renderer){
@@ -648,13 +727,12 @@ void GBLCD::setLCDC(uint8_t val){
         if (CONSOLE_OUTPUT_ENABLED) std::cout << "LCD Off" << std::endl;
         
         //Clear screen
-        RGBColor** buffer = getCompleteFrame();
+        uint32_t* buffer = getCompleteFrame();
         if(buffer != NULL){
-            for(uint8_t pixelX = 0; pixelX < FRAMEBUFFER_WIDTH; pixelX++){
-                for(uint8_t pixelY = 0; pixelY < FRAMEBUFFER_HEIGHT; pixelY++){
-                    buffer[pixelX][pixelY] = COLOR_WHITE;
-                }
+            for(int pixel = 0; pixel < FRAMEBUFFER_SIZE; pixel++){
+                buffer[pixel] = COLOR_WHITE;
             }
+            m_bNewFrame = true;
         }
     } else {
         if (CONSOLE_OUTPUT_ENABLED) std::cout << "LCD On" << std::endl;
@@ -743,6 +821,7 @@ uint8_t GBLCD::getWindowX(){
         
 void GBLCD::setBGPalette(uint8_t val){
     m_gbmemory->direct_write(ADDRESS_BGP, val);
+    updateBGColors();
 }
 
 uint8_t GBLCD::getBGPalette(){
@@ -751,6 +830,7 @@ uint8_t GBLCD::getBGPalette(){
 
 void GBLCD::setSpritePalette0(uint8_t val){
     m_gbmemory->direct_write(ADDRESS_OBP0, val);
+    updateSpriteColors(0);
 }
 
 uint8_t GBLCD::getSpritePalette0(){
@@ -759,6 +839,7 @@ uint8_t GBLCD::getSpritePalette0(){
 
 void GBLCD::setSpritePalette1(uint8_t val){
     m_gbmemory->direct_write(ADDRESS_OBP1, val);
+    updateSpriteColors(1);
 }
 
 uint8_t GBLCD::getSpritePalette1(){
@@ -778,9 +859,7 @@ void GBLCD::startDMATransfer(uint8_t address){
     uint16_t source = address * 0x100;
     
     //Copy from address to sprite attribute table
-    for(uint8_t offset = 0; offset <= (OAM_END - OAM_START); offset++){
-        m_gbmemory->direct_write(OAM_START + offset, m_gbmemory->read(source + offset));
-    }
+    m_gbmemory->dma_copy(OAM_START, source, (OAM_END - OAM_START) + 1);
 }
      
 void GBLCD::startDMATransferGBC(uint8_t val) {
@@ -825,9 +904,7 @@ void GBLCD::performDMATransferGBC(){
 	uint16_t length = (isHBlankDMATransferActive() ? 0x10 : m_hdmaLength);
 
 	//Copy bytes
-	for (uint16_t currentByte = 0; currentByte < length; currentByte++) {
-		m_gbmemory->direct_write(m_hdmaDestinationAddress + currentByte, m_gbmemory->read(m_hdmaSourceAddress + currentByte));
-	}
+	m_gbmemory->dma_copy(m_hdmaDestinationAddress, m_hdmaSourceAddress, length);
 
 	//If this is an HBlank transfer, need to save current progress or set done flag.
 	if (isHBlankDMATransferActive()) {
@@ -866,6 +943,7 @@ void GBLCD::writeVRam(uint16_t address, uint8_t val){
     
     //Allow direct writes, this fixes tetris sprites
     m_gbmemory->direct_write(address, val);
+    updateTileCache(m_gbmemory->getVRamBank(), address - VRAM_START, 1);
 }
 
 uint8_t GBLCD::readVRam(uint16_t address){
@@ -922,6 +1000,7 @@ void GBLCD::writeBGPaletteGBC(uint8_t val) {
 	//Get index for this byte and write.
 	uint8_t byteIndex = bcps & 0x3F;
 	m_gbcBGPalettes[byteIndex] = val;
+	m_gbcBGColors[byteIndex / 2] = getColorGBC(m_gbcBGPalettes, byteIndex / 8, (byteIndex % 8) / 2);
 
 	//Check if the index should auto increment
 	if (bcps & 0x80) {
@@ -945,6 +1024,13 @@ void GBLCD::writeOAMPaletteGBC(uint8_t val) {
 	//Get index for this byte and write
 	uint8_t byteIndex = ocps & 0x3F;
 	m_gbcOAMPalettes[byteIndex] = val;
+	m_gbcOAMColors[byteIndex / 2] = getColorGBC(m_gbcOAMPalettes, byteIndex / 8, (byteIndex % 8) / 2);
+
+	//Backwards compatibility sprite colors come from the first palette
+	if (byteIndex < 8) {
+		updateSpriteColors(0);
+		updateSpriteColors(1);
+	}
 
 	//Check if the index should auto increment
 	if (ocps & 0x80) {
@@ -962,12 +1048,12 @@ uint8_t GBLCD::readOAMPaletteGBC() {
 }
 
 //Gets the completed frame
-RGBColor** GBLCD::getCompleteFrame(){
+uint32_t* GBLCD::getCompleteFrame(){
     return (m_bSwapBuffers ? m_Framebuffer0 : m_Framebuffer1);
 }
         
 //Gets the frame currently being rendered
-RGBColor** GBLCD::getNextUnfinishedFrame(){
+uint32_t* GBLCD::getNextUnfinishedFrame(){
     return (m_bSwapBuffers ? m_Framebuffer1 : m_Framebuffer0);
 }
 
@@ -975,3 +1061,9 @@ RGBColor** GBLCD::getNextUnfinishedFrame(){
 long GBLCD::getFrames(){
     return m_Frames;
 }
+
+bool GBLCD::takeNewFrame(){
+    bool bNewFrame = m_bNewFrame;
+    m_bNewFrame = false;
+    return bNewFrame;
+}
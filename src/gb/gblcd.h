@@ -3,6 +3,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include "../IRenderer.h"
+#include "gbplatform.h"
+#include "gblinekernels.h"
 #include "../constants.h"
 
 //LCDC Bits
@@ -63,19 +65,33 @@
 #define PALETTE_BW_DARKGRAY 2
 #define PALETTE_BW_BLACK 3
 
+//Frame pixels are packed 32 bit ARGB, the format the display texture uses
+#define PIXEL_PACK(r, g, b) (0xFF000000u | ((uint32_t)(r) << 16) | ((uint32_t)(g) << 8) | (uint32_t)(b))
+#define PIXEL_RED(pixel)   (((pixel) >> 16) & 0xFF)
+#define PIXEL_GREEN(pixel) (((pixel) >> 8) & 0xFF)
+#define PIXEL_BLUE(pixel)  ((pixel) & 0xFF)
+
 //B&W Colors in RGB format
-#define COLOR_WHITE     RGBColor(0xFF, 0xFF, 0xFF)
-#define COLOR_DARKGRAY  RGBColor(0xA9, 0xA9, 0xA9)
-#define COLOR_LIGHTGRAY RGBColor(0xD3, 0xD3, 0xD3)
-#define COLOR_BLACK     RGBColor(0x00, 0x00, 0x00)
+#define COLOR_WHITE     PIXEL_PACK(0xFF, 0xFF, 0xFF)
+#define COLOR_DARKGRAY  PIXEL_PACK(0xA9, 0xA9, 0xA9)
+#define COLOR_LIGHTGRAY PIXEL_PACK(0xD3, 0xD3, 0xD3)
+#define COLOR_BLACK     PIXEL_PACK(0x00, 0x00, 0x00)
 
 //The maximum any r, g or b value can be for a GBC color 
 #define GBC_RGB_MAX_VALUE 0x1F
+
+//Bytes in each set of GBC palettes. 8 palettes of 4 colors, 2 bytes per color.
+#define GBC_PALETTE_BYTES 0x40
+
 #define RETURN_VRAM_INACCESSABLE 0xFF
 
 #define FRAMEBUFFER_WIDTH 160
 #define FRAMEBUFFER_HEIGHT 144
 #define FRAMEBUFFER_SIZE FRAMEBUFFER_WIDTH * FRAMEBUFFER_HEIGHT
+//Pixels from the start of one frame row to the next. A 160 pixel row is already a whole number of cache lines, so rows aren't padded.
+#define FRAMEBUFFER_PITCH FRAMEBUFFER_WIDTH
+//Frames are aligned to a cache line so rows can be copied and filled with wide stores
+#define FRAMEBUFFER_ALIGNMENT 64
 #define BACKGROUND_BUFFER_WIDTH 256
 #define BACKGROUND_BUFFER_HEIGHT 256
 #define BACKGROUND_BUFFER_SIZE BACKGROUND_BUFFER_WIDTH * BACKGROUND_BUFFER_HEIGHT
@@ -96,34 +112,12 @@
 #define TILE_WIDTH 8
 #define TILE_HEIGHT 8
 #define TILE_BYTES 16
+#define TILE_COUNT 384 //Tiles in the pattern tables of one vram bank
+#define TILE_DATA_SIZE TILE_COUNT * TILE_BYTES
+#define VRAM_BANK_COUNT 2
 
 class GBMem;
 
-struct RGBColor{
-    uint8_t r;
-    uint8_t g;
-    uint8_t b;
-    bool transparent;
-    
-    RGBColor(){
-        r = 0;
-        g = 0;
-        b = 0;
-        transparent = false;
-    }
-    
-    RGBColor(uint8_t red, uint8_t green, uint8_t blue){
-        r = red;
-        g = green;
-        b = blue;
-        transparent = false;
-    }
-    
-    bool equals(RGBColor other){
-        return (r == other.r && g == other.g && b == other.b);
-    }
-};
-
 class GBLCD{
     private:
         GBMem* m_gbmemory;
@@ -132,23 +126,41 @@ class GBLCD{
         IRenderer* m_displayRenderer;
         
         //Double buffer frames so that we can always get a completly drawn frame
-        //Store frames as an aray of directly usable colors
-        RGBColor** m_Framebuffer0;
-        RGBColor** m_Framebuffer1;
+        //Each frame is one row-major block of packed pixels, FRAMEBUFFER_WIDTH pixels per row
+        uint32_t* m_Framebuffer0;
+        uint32_t* m_Framebuffer1;
         
 		//GBC Color palettes
-		//Stored as uint8_t pointers intead of RGBColor pointers due to how GBC sets color values.
+		//Stored as uint8_t pointers intead of packed pixels due to how GBC sets color values.
 		uint8_t* m_gbcBGPalettes;
 		uint8_t* m_gbcOAMPalettes;
 
-        //GBC BG/Window priorities.
+        //Colors ready to store for every palette, rebuilt whenever a palette register is written
+        uint32_t m_dmgBGColors[4];
+        uint32_t m_dmgSpriteColors[2][4];
+        uint32_t m_gbcBGColors[LINE_PALETTE_COLORS];
+        uint32_t m_gbcOAMColors[LINE_PALETTE_COLORS];
+        
+        //GBC backwards compatibility. Background indices map to the DMG shade from BGP, which picks a color from the first GBC palette.
+        //Sprite colors are the DMG shade from OBP0 or OBP1 looked up in the first GBC sprite palette.
+        uint8_t m_bgShades[4];
+        uint32_t m_bcSpriteColors[2][4];
+
+        //BG/Window transparency and GBC priorities, as LINE_PRIORITY flags.
         //Because we can't reference background map tiles when rendering sprites, keep track
         //of each pixel in current line here.
-        bool m_gbcBGOverridesOAM[FRAMEBUFFER_WIDTH];
+        uint8_t m_linePriority[FRAMEBUFFER_WIDTH];
+        
+        //Color index of each background and window pixel on the current line. On GBC these are offset by the palette number * 4.
+        //Turned into colors once the line is done.
+        uint8_t m_lineColorIndices[FRAMEBUFFER_WIDTH];
         
-        //Used as a temporary buffer to hold a current working tile.
-        //Global so we don't waste speed constantly destroying and recreating the buffer
-        uint8_t m_TempTile[TILE_WIDTH];
+        //Line rendering kernels for the host's instruction set
+        const GBLineKernels* m_kernels;
+        
+        //Every line of every tile in both vram banks, decoded to palette indices.
+        //Each line is stored as is and flipped horizontally, so rendering only has to look lines up.
+        uint8_t m_tileCache[VRAM_BANK_COUNT][TILE_COUNT][TILE_HEIGHT][DECODED_TILE_LINE_SIZE];
         
         //Control for which buffer is currently the completed frame
         bool m_bSwapBuffers;
@@ -156,12 +168,22 @@ class GBLCD{
         //Number of frames rendered
         long m_Frames;
         
+        //Whether the completed frame has changed since it was last taken by takeNewFrame
+        bool m_bNewFrame;
+        
 		//Addresses and length for GBC HDMA transfer
 		uint16_t m_hdmaSourceAddress;
 		uint16_t m_hdmaDestinationAddress;
 		uint16_t m_hdmaLength;
 		bool m_bHBlankDMAInProgress;
 
+        //Clock left over from the last tick, and how far through VBlank we are
+        long long m_timeRollover;
+        int m_LYIncrementCount;
+
+        //Gets the number of clock cycles the given mode lasts
+        int getModeLength(uint8_t mode);
+
         //Mode functions
         void performHBlank();
         void performVBlank();
@@ -171,30 +193,51 @@ class GBLCD{
         //Increments LY
         void incrementLY();
         
+        //Sets whether the background or window pixel at x on the current line uses color index 0
+        void setLineTransparent(int x, bool bTransparent){
+            if(bTransparent){
+                m_linePriority[x] |= LINE_PRIORITY_BG_TRANSPARENT;
+            } else {
+                m_linePriority[x] &= ~LINE_PRIORITY_BG_TRANSPARENT;
+            }
+        }
+        
+        //Allocates and frees frames aligned to FRAMEBUFFER_ALIGNMENT
+        static uint32_t* allocateFrame();
+        static void freeFrame(uint32_t* frame);
+        
 		//Gets DMG color from the given palette
-        RGBColor getColor(uint8_t palette, uint8_t colorIndex);
+        uint32_t getColor(uint8_t palette, uint8_t colorIndex);
  
 		//Gets GBC color from the given color index within the given palette index of the palette buffer.
-		RGBColor getColorGBC(uint8_t* paletteBuffer, uint8_t paletteIndex, uint8_t colorIndex);
+		uint32_t getColorGBC(uint8_t* paletteBuffer, uint8_t paletteIndex, uint8_t colorIndex);
     
-        //Gets the default palette index for a given B&W RGB color
-        int getDefaultIndexFromColor(RGBColor color);
+        //Rebuild the color lookup tables after a DMG palette register changes
+        void updateBGColors();
+        void updateSpriteColors(int palette);
     
-        //Updates the line indicated by LY and ScrollY in the background buffer
-        void updateBackgroundLine(RGBColor** frameBuffer);
+        //Line rendering is built once per platform, so DMG games don't check for GBC features on every pixel.
+        //m_renderLine points at the version for the current platform.
         
-        //Updates the line indicated by LY in the window
-        void updateWindowLine(RGBColor** frameBuffer);
+        //Updates the color indices of the line indicated by LY and ScrollY in the background
+        template<Platform platform> void updateBackgroundLine();
+        
+        //Updates the color indices of the line indicated by LY in the window. Returns the leftmost pixel drawn, or FRAMEBUFFER_WIDTH if none were.
+        template<Platform platform> int updateWindowLine();
         
         //Updates the sprites for the line indicated by LY
-        void updateLineSprites(RGBColor** frameBuffer);
+        template<Platform platform> void updateLineSprites(uint32_t* line);
         
         //Renders the current line indicated by LY
-        void renderLine();
+        template<Platform platform> void renderLine();
+        void (GBLCD::*m_renderLine)();
         
-        //Gets an 8 pixel line of tiles for the given tile index as an array of palette indicies
+        //Gets an 8 pixel line of tiles for the given tile index as an array of palette indicies, flipped horizontally if bXFlip is set
         //tileIndex is a value from 0 to 255 or -128 to 127. 
-        void getTileLine(uint8_t* out, uint8_t vramBank, uint16_t tilePatternAddress, int tileIndex, int line);
+        const uint8_t* getTileLine(uint8_t vramBank, uint16_t tilePatternAddress, int tileIndex, int line, bool bXFlip){
+            int tile = ((tilePatternAddress - TILE_PATTERN_TABLE_1) / TILE_BYTES) + tileIndex;
+            return &m_tileCache[vramBank][tile][line][bXFlip ? TILE_WIDTH : 0];
+        }
         
         //Swaps buffers and clears the active buffer
         void swapBuffers();
@@ -211,8 +254,14 @@ class GBLCD{
 
         void tick(long long hz);
         
+        //Gets the number of clock cycles tick needs before the current mode ends. Used by the scheduler.
+        long long getCyclesUntilModeChange();
+        
         void setMainRenderer(IRenderer* renderer);
         
+        //Picks the line renderer for the platform. Called by memory whenever the platform changes.
+        void setPlatform(Platform platform);
+        
         //void write();
         void setLCDC(uint8_t val);
         uint8_t getLCDC();
@@ -247,6 +296,9 @@ class GBLCD{
 		void startDMATransferGBC(uint8_t val);
 
         void writeVRam(uint16_t address, uint8_t val);
+        
+        //Decodes tile data written to vram by anything other than writeVRam
+        void updateTileCache(uint8_t vramBank, uint16_t index, uint16_t length);
         uint8_t readVRam(uint16_t address);
         void writeVRamSpriteAttribute(uint16_t address, uint8_t val);
         uint8_t readVRamSpriteAttribute(uint16_t address);
@@ -260,12 +312,15 @@ class GBLCD{
 		uint8_t readOAMPaletteGBC();
 
         //Gets the completed frame
-        RGBColor** getCompleteFrame();
+        uint32_t* getCompleteFrame();
         
         //Gets the frame currently being rendered
-        RGBColor** getNextUnfinishedFrame();
+        uint32_t* getNextUnfinishedFrame();
         
         //Returns the number of frames since the last call to getFrames();
         long getFrames();
         
+        //Returns true if the completed frame has changed since the last call, so displays only upload frames once
+        bool takeNewFrame();
+        
 };
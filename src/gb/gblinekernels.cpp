@@ -0,0 +1,248 @@
+#include "gblinekernels.h"
+
+#if LINE_KERNELS_SIMD_SUPPORTED
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+//Lets SIMD kernels be built without raising the instruction set of the whole program. MSVC allows any intrinsic anywhere.
+#ifdef _MSC_VER
+#define LINE_KERNEL_TARGET(isa)
+#else
+#define LINE_KERNEL_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+//Scalar kernels
+
+static void decodeTileLinesScalar(const uint8_t* tileData, int lineCount, uint8_t* out){
+    for(int line = 0; line < lineCount; line++){
+        //The first byte contains the least significant bits of the color palette index.
+        //Second contains most significant.
+        uint8_t leastSignificantColors = tileData[line * 2];
+        uint8_t mostSignificantColors = tileData[line * 2 + 1];
+        uint8_t* decoded = &out[line * DECODED_TILE_LINE_SIZE];
+        uint8_t* flipped = &decoded[8];
+
+        //Bit 7 is leftmost pixel in the color bytes
+        for(int pixel = 0; pixel < 8; pixel++){
+            decoded[pixel] = ((leastSignificantColors >> (7 - pixel)) & 1);
+            decoded[pixel] |= ((mostSignificantColors >> (7 - pixel)) & 1) << 1;
+            flipped[7 - pixel] = decoded[pixel];
+        }
+    }
+}
+
+static void applyPaletteScalar(const uint8_t* colorIndices, const uint32_t* colors, uint32_t* out, int count){
+    for(int pixel = 0; pixel < count; pixel++){
+        out[pixel] = colors[colorIndices[pixel]];
+    }
+}
+
+static void mergeSpriteScalar(const uint8_t* tileLine, const uint32_t* colors, bool bBehindBackground, uint32_t* line, uint8_t* priority){
+    for(int pixel = 0; pixel < 8; pixel++){
+        GBLineKernels::mergeSpritePixel(tileLine[pixel], colors, bBehindBackground, &line[pixel], &priority[pixel]);
+    }
+}
+
+#if LINE_KERNELS_SIMD_SUPPORTED
+
+//SSE2 kernels
+
+//Bit of each bitplane byte that holds each pixel. First 8 lanes are left to right, last 8 are the line flipped.
+#define DECODE_BIT_MASKS 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80
+
+LINE_KERNEL_TARGET("sse2")
+static void decodeTileLinesSSE2(const uint8_t* tileData, int lineCount, uint8_t* out){
+    const __m128i masks = _mm_setr_epi8(DECODE_BIT_MASKS);
+    const __m128i lowBit = _mm_set1_epi8(1);
+    const __m128i highBit = _mm_set1_epi8(2);
+
+    for(int line = 0; line < lineCount; line++){
+        //Spread each bitplane byte across the line, then pick out one bit per pixel
+        __m128i least = _mm_and_si128(_mm_set1_epi8((char)tileData[line * 2]), masks);
+        __m128i most = _mm_and_si128(_mm_set1_epi8((char)tileData[line * 2 + 1]), masks);
+        __m128i decoded = _mm_or_si128(_mm_and_si128(_mm_cmpeq_epi8(least, masks), lowBit), _mm_and_si128(_mm_cmpeq_epi8(most, masks), highBit));
+        _mm_storeu_si128((__m128i*)&out[line * DECODED_TILE_LINE_SIZE], decoded);
+    }
+}
+
+//Picks one of four colors for each 32 bit lane of indices
+LINE_KERNEL_TARGET("sse2")
+static inline __m128i selectColorsSSE2(__m128i indices, const uint32_t* colors){
+    __m128i result = _mm_set1_epi32((int)colors[0]);
+    for(int colorIndex = 1; colorIndex < 4; colorIndex++){
+        __m128i match = _mm_cmpeq_epi32(indices, _mm_set1_epi32(colorIndex));
+        result = _mm_or_si128(_mm_andnot_si128(match, result), _mm_and_si128(match, _mm_set1_epi32((int)colors[colorIndex])));
+    }
+    return result;
+}
+
+LINE_KERNEL_TARGET("sse2")
+static void applyPalette4SSE2(const uint8_t* colorIndices, const uint32_t* colors, uint32_t* out, int count){
+    const __m128i zero = _mm_setzero_si128();
+    int pixel = 0;
+    for(; pixel + 8 <= count; pixel += 8){
+        __m128i indices = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)&colorIndices[pixel]), zero);
+        _mm_storeu_si128((__m128i*)&out[pixel], selectColorsSSE2(_mm_unpacklo_epi16(indices, zero), colors));
+        _mm_storeu_si128((__m128i*)&out[pixel + 4], selectColorsSSE2(_mm_unpackhi_epi16(indices, zero), colors));
+    }
+
+    applyPaletteScalar(&colorIndices[pixel], colors, &out[pixel], count - pixel);
+}
+
+LINE_KERNEL_TARGET("sse2")
+static void mergeSpriteSSE2(const uint8_t* tileLine, const uint32_t* colors, bool bBehindBackground, uint32_t* line, uint8_t* priority){
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i transparentFlag = _mm_set1_epi8(LINE_PRIORITY_BG_TRANSPARENT);
+    const __m128i overFlag = _mm_set1_epi8(LINE_PRIORITY_BG_OVER_OAM);
+
+    //Work out which pixels are drawn a byte per pixel, the same way as mergeSpritePixel
+    __m128i indices = _mm_loadl_epi64((const __m128i*)tileLine);
+    __m128i flags = _mm_loadl_epi64((const __m128i*)priority);
+    __m128i draw = _mm_andnot_si128(_mm_cmpeq_epi8(indices, zero), _mm_cmpeq_epi8(_mm_and_si128(flags, overFlag), zero));
+    if(bBehindBackground){
+        draw = _mm_and_si128(draw, _mm_cmpeq_epi8(_mm_and_si128(flags, transparentFlag), transparentFlag));
+    }
+    _mm_storel_epi64((__m128i*)priority, _mm_andnot_si128(_mm_and_si128(draw, transparentFlag), flags));
+
+    //Widen the indices and the draw mask to a lane per pixel and blend the colors in
+    __m128i indices16 = _mm_unpacklo_epi8(indices, zero);
+    __m128i draw16 = _mm_unpacklo_epi8(draw, draw);
+    for(int half = 0; half < 2; half++){
+        __m128i halfIndices = half ? _mm_unpackhi_epi16(indices16, zero) : _mm_unpacklo_epi16(indices16, zero);
+        __m128i halfDraw = half ? _mm_unpackhi_epi16(draw16, draw16) : _mm_unpacklo_epi16(draw16, draw16);
+        __m128i pixels = _mm_loadu_si128((const __m128i*)&line[half * 4]);
+        pixels = _mm_or_si128(_mm_andnot_si128(halfDraw, pixels), _mm_and_si128(halfDraw, selectColorsSSE2(halfIndices, colors)));
+        _mm_storeu_si128((__m128i*)&line[half * 4], pixels);
+    }
+}
+
+//AVX2 kernels
+
+LINE_KERNEL_TARGET("avx2")
+static void decodeTileLinesAVX2(const uint8_t* tileData, int lineCount, uint8_t* out){
+    const __m256i masks = _mm256_setr_epi8(DECODE_BIT_MASKS, DECODE_BIT_MASKS);
+    const __m256i lowBit = _mm256_set1_epi8(1);
+    const __m256i highBit = _mm256_set1_epi8(2);
+
+    //Two lines at a time, one per 128 bit half
+    int line = 0;
+    for(; line + 2 <= lineCount; line += 2){
+        __m256i least = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_set1_epi8((char)tileData[line * 2])), _mm_set1_epi8((char)tileData[line * 2 + 2]), 1);
+        __m256i most = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_set1_epi8((char)tileData[line * 2 + 1])), _mm_set1_epi8((char)tileData[line * 2 + 3]), 1);
+        least = _mm256_and_si256(least, masks);
+        most = _mm256_and_si256(most, masks);
+        __m256i decoded = _mm256_or_si256(_mm256_and_si256(_mm256_cmpeq_epi8(least, masks), lowBit), _mm256_and_si256(_mm256_cmpeq_epi8(most, masks), highBit));
+        _mm256_storeu_si256((__m256i*)&out[line * DECODED_TILE_LINE_SIZE], decoded);
+    }
+
+    decodeTileLinesSSE2(&tileData[line * 2], lineCount - line, &out[line * DECODED_TILE_LINE_SIZE]);
+}
+
+LINE_KERNEL_TARGET("avx2")
+static void applyPalette4AVX2(const uint8_t* colorIndices, const uint32_t* colors, uint32_t* out, int count){
+    //Permute picks from 8 lanes, of which the indices only reach the first 4
+    const __m256i table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)colors));
+    int pixel = 0;
+    for(; pixel + 8 <= count; pixel += 8){
+        __m256i indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)&colorIndices[pixel]));
+        _mm256_storeu_si256((__m256i*)&out[pixel], _mm256_permutevar8x32_epi32(table, indices));
+    }
+
+    applyPaletteScalar(&colorIndices[pixel], colors, &out[pixel], count - pixel);
+}
+
+LINE_KERNEL_TARGET("avx2")
+static void applyPalette32AVX2(const uint8_t* colorIndices, const uint32_t* colors, uint32_t* out, int count){
+    int pixel = 0;
+    for(; pixel + 8 <= count; pixel += 8){
+        __m256i indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)&colorIndices[pixel]));
+        _mm256_storeu_si256((__m256i*)&out[pixel], _mm256_i32gather_epi32((const int*)colors, indices, 4));
+    }
+
+    applyPaletteScalar(&colorIndices[pixel], colors, &out[pixel], count - pixel);
+}
+
+LINE_KERNEL_TARGET("avx2")
+static void mergeSpriteAVX2(const uint8_t* tileLine, const uint32_t* colors, bool bBehindBackground, uint32_t* line, uint8_t* priority){
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i transparentFlag = _mm_set1_epi8(LINE_PRIORITY_BG_TRANSPARENT);
+    const __m128i overFlag = _mm_set1_epi8(LINE_PRIORITY_BG_OVER_OAM);
+
+    __m128i indices = _mm_loadl_epi64((const __m128i*)tileLine);
+    __m128i flags = _mm_loadl_epi64((const __m128i*)priority);
+    __m128i draw = _mm_andnot_si128(_mm_cmpeq_epi8(indices, zero), _mm_cmpeq_epi8(_mm_and_si128(flags, overFlag), zero));
+    if(bBehindBackground){
+        draw = _mm_and_si128(draw, _mm_cmpeq_epi8(_mm_and_si128(flags, transparentFlag), transparentFlag));
+    }
+    _mm_storel_epi64((__m128i*)priority, _mm_andnot_si128(_mm_and_si128(draw, transparentFlag), flags));
+
+    //All 8 pixels fit in one register, so the colors are a single permute
+    const __m256i table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)colors));
+    __m256i spriteColors = _mm256_permutevar8x32_epi32(table, _mm256_cvtepu8_epi32(indices));
+    __m256i pixels = _mm256_loadu_si256((const __m256i*)line);
+    _mm256_storeu_si256((__m256i*)line, _mm256_blendv_epi8(pixels, spriteColors, _mm256_cvtepi8_epi32(draw)));
+}
+
+//Host support for each instruction set
+
+static bool hostSupportsSSE2(){
+#if defined(__x86_64__) || defined(_M_X64)
+    //Part of x86-64
+    return true;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+
+static bool hostSupportsAVX2(){
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if(info[0] < 7){
+        return false;
+    }
+
+    //The OS has to save the upper halves of the ymm registers
+    __cpuid(info, 1);
+    if(!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || ((_xgetbv(0) & 0x6) != 0x6)){
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+static const GBLineKernels s_scalarKernels = {"scalar", decodeTileLinesScalar, applyPaletteScalar, applyPaletteScalar, mergeSpriteScalar};
+
+#if LINE_KERNELS_SIMD_SUPPORTED
+//SSE2 has no gather, so lookups across all 32 colors stay scalar
+static const GBLineKernels s_sse2Kernels = {"SSE2", decodeTileLinesSSE2, applyPalette4SSE2, applyPaletteScalar, mergeSpriteSSE2};
+static const GBLineKernels s_avx2Kernels = {"AVX2", decodeTileLinesAVX2, applyPalette4AVX2, applyPalette32AVX2, mergeSpriteAVX2};
+#endif
+
+const GBLineKernels& GBLineKernels::getScalar(){
+    return s_scalarKernels;
+}
+
+const GBLineKernels& GBLineKernels::getBest(){
+#if LINE_KERNELS_SIMD_SUPPORTED
+    static const GBLineKernels& best = hostSupportsAVX2() ? s_avx2Kernels : (hostSupportsSSE2() ? s_sse2Kernels : s_scalarKernels);
+    return best;
+#else
+    return s_scalarKernels;
+#endif
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include "../constants.h"
+
+//SIMD kernels are only built for x86. Other hosts always use the scalar kernels.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define LINE_KERNELS_SIMD_SUPPORTED true
+#else
+#define LINE_KERNELS_SIMD_SUPPORTED false
+#endif
+
+//Per pixel flags for the line being rendered, used to decide whether sprites are drawn over the background
+#define LINE_PRIORITY_BG_TRANSPARENT 0x01 //Background or window used color index 0
+#define LINE_PRIORITY_BG_OVER_OAM 0x02 //GBC background map attribute gives the background priority over sprites
+
+//Size of a decoded tile line. 8 palette indices, then the same 8 flipped horizontally.
+#define DECODED_TILE_LINE_SIZE 16
+
+//Colors a line can use. 8 GBC palettes of 4 colors, indexed by palette * 4 + color index.
+#define LINE_PALETTE_COLORS 32
+
+//The per line work of GBLCD, in versions for each instruction set.
+//The versions are picked once at startup from what the host CPU supports, and all produce identical output.
+class GBLineKernels{
+    public:
+        //Name of the instruction set the kernels use
+        const char* name;
+
+        //Decodes lineCount tile lines, each a pair of bitplane bytes, into DECODED_TILE_LINE_SIZE bytes each
+        void (*decodeTileLines)(const uint8_t* tileData, int lineCount, uint8_t* out);
+
+        //Looks up the color of count pixels from one palette of 4 colors
+        void (*applyPalette4)(const uint8_t* colorIndices, const uint32_t* colors, uint32_t* out, int count);
+
+        //Looks up the color of count pixels from LINE_PALETTE_COLORS colors
+        void (*applyPalette32)(const uint8_t* colorIndices, const uint32_t* colors, uint32_t* out, int count);
+
+        //Draws the 8 pixels of a sprite line over the line, where the priority flags allow it.
+        //line and priority point at the sprite's leftmost pixel, which must be fully on screen.
+        void (*mergeSprite)(const uint8_t* tileLine, const uint32_t* colors, bool bBehindBackground, uint32_t* line, uint8_t* priority);
+
+        //Draws a single sprite pixel, for sprites partly off screen
+        static void mergeSpritePixel(uint8_t colorIndex, const uint32_t* colors, bool bBehindBackground, uint32_t* pixel, uint8_t* priority){
+            //The 0th color index is a transparent sprite color
+            if(colorIndex == 0 || (*priority & LINE_PRIORITY_BG_OVER_OAM)){
+                return;
+            }
+
+            //Sprites behind the background only show through color index 0
+            if(bBehindBackground && !(*priority & LINE_PRIORITY_BG_TRANSPARENT)){
+                return;
+            }
+
+            *pixel = colors[colorIndex];
+
+            //Sprites further back in OAM can't be drawn behind the background here any more
+            *priority &= ~LINE_PRIORITY_BG_TRANSPARENT;
+        }
+
+        //Kernels without SIMD, which work on any host
+        static const GBLineKernels& getScalar();
+
+        //Fastest kernels the host supports
+        static const GBLineKernels& getBest();
+};
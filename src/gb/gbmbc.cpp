@@ -0,0 +1,133 @@
+#include <iostream>
+#include "gbmbc.h"
+#include "gbmem.h"
+
+GBMBC::GBMBC(uint8_t* cartRom, uint32_t cartRomLength, uint8_t* cartRam){
+    m_cartRom = cartRom;
+    m_cartRomBankCount = cartRomLength / ROM_BANK_N_START;
+    m_cartRam = cartRam;
+
+    m_cartRomBank = 1;
+    m_cartRamBank = 0;
+    m_bCartRamEnabled = false;
+    m_cartRamAddressMask = CART_RAM_ADDRESS_MASK;
+
+    m_mappedRomBank = 1;
+    m_romBankData = NULL;
+    m_ramReadData = NULL;
+    m_ramWriteData = NULL;
+}
+
+GBMBC::~GBMBC(){
+}
+
+void GBMBC::init(){
+    updateBanks();
+}
+
+uint8_t GBMBC::readRam(uint16_t address){
+    if(m_ramReadData != NULL){
+        return m_ramReadData[(address - EXTRAM_START) & m_cartRamAddressMask];
+    }
+
+    return readRamRegister(address);
+}
+
+void GBMBC::write(uint16_t address, uint8_t val){
+    if (CONSOLE_OUTPUT_CART) std::cout << "Cart write. Address: " << +address << ", value: " << +val << std::endl;
+
+    if(address >= EXTRAM_START && address <= EXTRAM_END){
+        if (CONSOLE_OUTPUT_CART) std::cout << "Writing to cart ram!" << std::endl;
+        if(m_ramWriteData != NULL){
+            m_ramWriteData[(address - EXTRAM_START) & m_cartRamAddressMask] = val;
+        } else {
+            writeRamRegister(address, val);
+        }
+        return;
+    }
+
+    writeControl(address, val);
+    updateBanks();
+}
+
+//Gets the rom bank currently mapped to 0x4000-0x7FFF
+uint16_t GBMBC::getRomBank(){
+    return m_mappedRomBank;
+}
+
+//Gets the start of the rom bank mapped to 0x4000-0x7FFF
+uint8_t* GBMBC::getRomBankData(){
+    return m_romBankData;
+}
+
+//Gets the start of the cart ram bank mapped for reads, or NULL if reads need to go through readRam
+uint8_t* GBMBC::getRamReadData(){
+    return m_ramReadData;
+}
+
+//Gets the start of the cart ram bank mapped for writes, or NULL if writes need to go through write
+uint8_t* GBMBC::getRamWriteData(){
+    return m_ramWriteData;
+}
+
+//Gets the offset into cart ram a write to address would change, or -1 if the write doesn't reach cart ram
+int32_t GBMBC::getRamWriteOffset(uint16_t address){
+    if((m_ramWriteData == NULL) || (address < EXTRAM_START) || (address > EXTRAM_END)){
+        return -1;
+    }
+
+    return (int32_t)(m_ramWriteData - m_cartRam) + ((address - EXTRAM_START) & m_cartRamAddressMask);
+}
+
+void GBMBC::writeControl(uint16_t address, uint8_t val){
+    if(address >= ADDRESS_CART_RAM_ENABLE_START && address <= ADDRESS_CART_RAM_ENABLE_END){
+        m_bCartRamEnabled = ((val & 0x0F) == CART_RAM_VALUE_ENABLED);
+        if (CONSOLE_OUTPUT_CART) std::cout << "Cart ram is now: " << (m_bCartRamEnabled ? "enabled" : "disabled") << std::endl;
+    }
+}
+
+uint16_t GBMBC::calculateRomBank(){
+    //Largest possible bank value is 9-bit from MBC5
+    uint16_t realRomBank = m_cartRomBank & 0x01FF;
+
+    //If entire rom bank is 0, increment
+    if(realRomBank == 0){
+        realRomBank |= 1;
+    }
+
+    return realRomBank;
+}
+
+uint8_t* GBMBC::calculateRamReadData(){
+    return calculateRamWriteData();
+}
+
+uint8_t* GBMBC::calculateRamWriteData(){
+    if(!m_bCartRamEnabled){
+        return NULL;
+    }
+
+    return &m_cartRam[CART_RAM_BANK_SIZE * m_cartRamBank];
+}
+
+uint8_t GBMBC::readRamRegister(uint16_t address){
+    //Disabled ram reads as 0xFF
+    return 0xFF;
+}
+
+void GBMBC::writeRamRegister(uint16_t address, uint8_t val){
+    //Writes to disabled ram are ignored
+}
+
+void GBMBC::updateBanks(){
+    m_mappedRomBank = calculateRomBank();
+
+    //Banks past the end of the rom wrap around, as unconnected bank lines are ignored on hardware
+    //https://github.com/Gekkio/mooneye-gb/blob/master/docs/accuracy.markdown
+    m_mappedRomBank %= m_cartRomBankCount;
+    m_romBankData = &m_cartRom[m_mappedRomBank * ROM_BANK_N_START];
+    m_ramReadData = calculateRamReadData();
+    m_ramWriteData = calculateRamWriteData();
+
+    if (CONSOLE_OUTPUT_CART) std::cout << "Rom bank is now " << +m_mappedRomBank << std::endl;
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include "../constants.h"
+
+#define ADDRESS_CART_RAM_ENABLE_START   0x0000
+#define ADDRESS_CART_RAM_ENABLE_END     0x1FFF
+#define ADDRESS_MBC1_ROM_BANK_NUM_START 0x2000
+#define ADDRESS_MBC1_ROM_BANK_NUM_END   0x3FFF
+#define ADDRESS_MBC1_RAM_BANK_NUMBER_START 0x4000
+#define ADDRESS_MBC1_RAM_BANK_NUMBER_END   0x5FFF
+#define ADDRESS_MBC1_MODE_SELECT_START     0x6000
+#define ADDRESS_MBC1_MODE_SELECT_END       0x7FFF
+
+#define CART_RAM_VALUE_ENABLED        0x0A
+#define CART_MBC1_ROM_RAM_MODE_SELECT 0x01
+
+//Size of a cart ram bank, as used to find the start of a bank
+#define CART_RAM_BANK_SIZE 0x1FFF
+
+//Address lines of 0xA000-0xBFFF that reach cart ram
+#define CART_RAM_ADDRESS_MASK 0x1FFF
+
+//Memory bank controller for carts without one. Also the base for the other controllers.
+//Bank registers only change on writes, so the host pointers to the mapped banks are worked out then.
+//Reads from a mapped bank are a single indexed load.
+class GBMBC{
+    protected:
+        uint8_t* m_cartRom;
+        uint8_t* m_cartRam;
+
+        //Number of whole 0x4000 byte banks in the rom
+        uint16_t m_cartRomBankCount;
+
+        //Bank registers as written by the game
+        uint16_t m_cartRomBank;
+        uint8_t m_cartRamBank;
+        bool m_bCartRamEnabled;
+
+        //Controllers with less than a bank of ram ignore the upper address lines, so the ram repeats through 0xA000-0xBFFF
+        uint16_t m_cartRamAddressMask;
+
+        //Rom bank mapped to 0x4000-0x7FFF, and pointers to the banks currently mapped.
+        //Ram pointers are NULL when accesses need the controller, such as when ram is disabled.
+        uint16_t m_mappedRomBank;
+        uint8_t* m_romBankData;
+        uint8_t* m_ramReadData;
+        uint8_t* m_ramWriteData;
+
+        //Handles writes to 0x0000-0x7FFF. Bank pointers are updated afterwards.
+        virtual void writeControl(uint16_t address, uint8_t val);
+
+        //Gets the rom bank mapped to 0x4000-0x7FFF for the current bank registers
+        virtual uint16_t calculateRomBank();
+
+        //Gets the cart ram to read or write for the current bank registers, or NULL if accesses need the controller
+        virtual uint8_t* calculateRamReadData();
+        virtual uint8_t* calculateRamWriteData();
+
+        //Cart ram accesses that can't use the bank pointers
+        virtual uint8_t readRamRegister(uint16_t address);
+        virtual void writeRamRegister(uint16_t address, uint8_t val);
+
+        //Recalculates the bank pointers
+        void updateBanks();
+
+    public:
+        GBMBC(uint8_t* cartRom, uint32_t cartRomLength, uint8_t* cartRam);
+        virtual ~GBMBC();
+
+        //Must be called once the controller is constructed, to map the initial banks
+        void init();
+
+        //Reads from the switchable rom bank at 0x4000-0x7FFF
+        uint8_t readRom(uint16_t address){
+            return m_romBankData[address - 0x4000];
+        }
+
+        //Reads from cart ram at 0xA000-0xBFFF
+        uint8_t readRam(uint16_t address);
+
+        //Writes to the bank registers or cart ram
+        void write(uint16_t address, uint8_t val);
+
+        //Gets the rom bank currently mapped to 0x4000-0x7FFF
+        uint16_t getRomBank();
+
+        //Gets the start of the rom bank mapped to 0x4000-0x7FFF
+        uint8_t* getRomBankData();
+
+        //Gets the start of the cart ram bank mapped for reads or writes, or NULL if accesses need to go through readRam or write
+        uint8_t* getRamReadData();
+        uint8_t* getRamWriteData();
+
+        //Gets the offset into cart ram a write to address would change, or -1 if the write doesn't reach cart ram
+        int32_t getRamWriteOffset(uint16_t address);
+};
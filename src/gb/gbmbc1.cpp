@@ -0,0 +1,50 @@
+#include <iostream>
+#include "gbmbc1.h"
+
+GBMBC1::GBMBC1(uint8_t* cartRom, uint32_t cartRomLength, uint8_t* cartRam) : GBMBC(cartRom, cartRomLength, cartRam){
+    m_bMBC1RomRamSelect = false;
+}
+
+void GBMBC1::writeControl(uint16_t address, uint8_t val){
+    if((address >= ADDRESS_MBC1_ROM_BANK_NUM_START) && (address <= ADDRESS_MBC1_ROM_BANK_NUM_END)){
+        //Lower 5 bits only
+        m_cartRomBank = (m_cartRomBank & 0x60) | (val & 0x1F);
+    } else if(address >= ADDRESS_MBC1_RAM_BANK_NUMBER_START && address <= ADDRESS_MBC1_RAM_BANK_NUMBER_END){
+        //In MBC1, this can set both the rom or ram bank
+        if(m_bMBC1RomRamSelect){
+            m_cartRamBank = val & 0x03;
+        } else {
+            m_cartRomBank = (m_cartRomBank & 0x1F) | (0x03 & (val << 5));
+        }
+    } else if (address >= ADDRESS_MBC1_MODE_SELECT_START && address <= ADDRESS_MBC1_MODE_SELECT_END){
+        m_bMBC1RomRamSelect = (val & 0x01) > 0;
+        if (CONSOLE_OUTPUT_CART) std::cout << "Attempt to set ROM or RAM write mode! Current mode: " << (m_bMBC1RomRamSelect ? "RAM" : "ROM")  << std::endl;
+    } else {
+        GBMBC::writeControl(address, val);
+    }
+}
+
+uint16_t GBMBC1::calculateRomBank(){
+    uint16_t realRomBank = m_cartRomBank & 0x01FF;
+    if(m_bMBC1RomRamSelect){
+        realRomBank &= 0x1F;
+    } else {
+        realRomBank &= 0x3F;
+    }
+
+    //If the lower bits are 0, increment.
+    if((realRomBank & 0x1F) == 0){
+        realRomBank |= 1;
+    }
+
+    return realRomBank;
+}
+
+uint8_t* GBMBC1::calculateRamReadData(){
+    if(!m_bCartRamEnabled){
+        return NULL;
+    }
+
+    //Bank switching only occurs in ram mode
+    return &m_cartRam[CART_RAM_BANK_SIZE * (m_bMBC1RomRamSelect ? m_cartRamBank : 0)];
+}
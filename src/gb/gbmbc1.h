@@ -0,0 +1,15 @@
+#pragma once
+#include "gbmbc.h"
+
+//MBC1. The ram bank register doubles as the upper rom bank bits, depending on the mode select register.
+class GBMBC1 : public GBMBC{
+    protected:
+        bool m_bMBC1RomRamSelect;
+
+        void writeControl(uint16_t address, uint8_t val);
+        uint16_t calculateRomBank();
+        uint8_t* calculateRamReadData();
+
+    public:
+        GBMBC1(uint8_t* cartRom, uint32_t cartRomLength, uint8_t* cartRam);
+};
@@ -0,0 +1,35 @@
+#include <iostream>
+#include "gbmbc2.h"
+#include "gbmem.h"
+
+GBMBC2::GBMBC2(uint8_t* cartRom, uint32_t cartRomLength, uint8_t* cartRam) : GBMBC(cartRom, cartRomLength, cartRam){
+    m_cartRamAddressMask = MBC2_RAM_ADDRESS_MASK;
+}
+
+void GBMBC2::writeControl(uint16_t address, uint8_t val){
+    if(address >= ADDRESS_CART_RAM_ENABLE_START && address <= ADDRESS_CART_RAM_ENABLE_END){
+        //Ram can only be toggled when the lowest bit of the upper address byte is clear
+        if(!(address & 0x0100)){
+            GBMBC::writeControl(address, val);
+        }
+    } else if((address >= ADDRESS_MBC1_ROM_BANK_NUM_START) && (address <= ADDRESS_MBC1_ROM_BANK_NUM_END)){
+        //4-bit only
+        m_cartRomBank = val & 0x0F;
+    } else if(address >= ADDRESS_MBC1_RAM_BANK_NUMBER_START && address <= ADDRESS_MBC1_RAM_BANK_NUMBER_END){
+        std::cout << "Attempt to set ram bank on MBC2!" << std::endl;
+    }
+}
+
+uint8_t* GBMBC2::calculateRamReadData(){
+    //Reads are masked to 4 bits, so always go through readRamRegister
+    return NULL;
+}
+
+uint8_t GBMBC2::readRamRegister(uint16_t address){
+    if(!m_bCartRamEnabled){
+        return 0xFF;
+    }
+
+    //MBC2 uses 4 bit values. Need to mask off upper bits
+    return m_cartRam[(address - EXTRAM_START) & m_cartRamAddressMask] & 0x0F;
+}
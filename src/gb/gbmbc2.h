@@ -0,0 +1,16 @@
+#pragma once
+#include "gbmbc.h"
+
+//MBC2. Has 512 4-bit values of built in ram, and no ram banks.
+//Only the lower 9 address lines reach the ram, so it repeats through 0xA000-0xBFFF.
+#define MBC2_RAM_ADDRESS_MASK 0x01FF
+
+class GBMBC2 : public GBMBC{
+    protected:
+        void writeControl(uint16_t address, uint8_t val);
+        uint8_t* calculateRamReadData();
+        uint8_t readRamRegister(uint16_t address);
+
+    public:
+        GBMBC2(uint8_t* cartRom, uint32_t cartRomLength, uint8_t* cartRam);
+};
@@ -0,0 +1,119 @@
+#include <iostream>
+#include <ctime>
+#include "gbmbc3.h"
+
+GBMBC3::GBMBC3(uint8_t* cartRom, uint32_t cartRomLength, uint8_t* cartRam) : GBMBC(cartRom, cartRomLength, cartRam){
+    m_rtcSeconds = 0;
+    m_rtcMinutes = 0;
+    m_rtcHours = 0;
+    m_rtcLowerDayCounter = 0;
+    m_rtcFlags = 0;
+    m_bRTCLatched = false;
+    m_rtcLatchValue = 0xFF;
+}
+
+void GBMBC3::updateRTC(){
+    //TODO - figure out how to calculate day counter from system time. Possible?
+    if(m_bRTCLatched){
+        //RTC is latched, don't update. 
+        return;
+    }
+
+    //Get the current time since epoch
+    std::time_t unixTime = std::time(NULL);
+    std::tm* localTime = std::localtime(&unixTime);
+    m_rtcSeconds = localTime->tm_sec;
+    m_rtcMinutes = localTime->tm_min;
+    m_rtcHours = localTime->tm_hour;
+}
+
+void GBMBC3::writeControl(uint16_t address, uint8_t val){
+    if((address >= ADDRESS_MBC1_ROM_BANK_NUM_START) && (address <= ADDRESS_MBC1_ROM_BANK_NUM_END)){
+        //7-bit only
+        m_cartRomBank = val & 0x7F;
+    } else if(address >= ADDRESS_MBC1_RAM_BANK_NUMBER_START && address <= ADDRESS_MBC1_RAM_BANK_NUMBER_END){
+        //MBC3 only has banks 0-3, but also can be set to values 08-0C for RTC access
+        m_cartRamBank = val & 0x0F;
+    } else if (address >= ADDRESS_MBC1_MODE_SELECT_START && address <= ADDRESS_MBC1_MODE_SELECT_END){
+        //RTC Latch is toggled in this register if a write of 0 is followed by a write of 1.
+        if((m_rtcLatchValue == 0x00) && (val == 0x01)){
+            //Since RTC is latched on access, need to update value first.
+            updateRTC();
+            m_bRTCLatched = !m_bRTCLatched;
+        }
+        m_rtcLatchValue = val;
+    } else {
+        GBMBC::writeControl(address, val);
+    }
+}
+
+uint16_t GBMBC3::calculateRomBank(){
+    uint16_t realRomBank = m_cartRomBank & 0x7F;
+    if(realRomBank == 0){
+        realRomBank |= 1;
+    }
+
+    return realRomBank;
+}
+
+uint8_t* GBMBC3::calculateRamWriteData(){
+    //RTC registers aren't backed by ram
+    if(m_cartRamBank >= RTC_BANK_SECONDS){
+        return NULL;
+    }
+
+    return GBMBC::calculateRamWriteData();
+}
+
+uint8_t GBMBC3::readRamRegister(uint16_t address){
+    if(!m_bCartRamEnabled || (m_cartRamBank < RTC_BANK_SECONDS)){
+        return 0xFF;
+    }
+
+    //Update real time clock registers
+    updateRTC();
+
+    //Fetch the appropriate value
+    switch(m_cartRamBank){
+        case RTC_BANK_SECONDS:
+            return m_rtcSeconds;
+        case RTC_BANK_MINUTES:
+            return m_rtcMinutes;
+        case RTC_BANK_HOURS:
+            return m_rtcHours;
+        case RTC_BANK_DAYCOUNTER:
+            return m_rtcLowerDayCounter;
+        case RTC_BANK_FLAGS:
+            return m_rtcFlags;
+        default:
+            std::cout << "Unrecognized MBC3 RTC register " << +m_cartRamBank << std::endl;
+            return 0xFF;
+    }
+}
+
+void GBMBC3::writeRamRegister(uint16_t address, uint8_t val){
+    if(!m_bCartRamEnabled || (m_cartRamBank < RTC_BANK_SECONDS)){
+        return;
+    }
+
+    switch(m_cartRamBank){
+        case RTC_BANK_SECONDS:
+            m_rtcSeconds = val;
+            break;
+        case RTC_BANK_MINUTES:
+            m_rtcMinutes = val;
+            break;
+        case RTC_BANK_HOURS:
+            m_rtcHours = val;
+            break;
+        case RTC_BANK_DAYCOUNTER:
+            m_rtcLowerDayCounter = val;
+            break;
+        case RTC_BANK_FLAGS:
+            m_rtcFlags = val;
+            break;
+        default:
+            std::cout << "Unrecognized MBC3 RTC register " << +m_cartRamBank << std::endl;
+            break;
+    }
+}
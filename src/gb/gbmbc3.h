@@ -0,0 +1,38 @@
+#pragma once
+#include "gbmbc.h"
+
+#define RTC_FLAG_UPPER_DAY 0x00
+#define RTC_FLAG_HALT      0x20
+#define RTC_FLAG_DAY_CARRY 0x40
+
+#define RTC_BANK_SECONDS    0x08
+#define RTC_BANK_MINUTES    0x09
+#define RTC_BANK_HOURS      0x0A
+#define RTC_BANK_DAYCOUNTER 0x0B
+#define RTC_BANK_FLAGS      0x0C
+
+//MBC3. Ram banks 0x08-0x0C select the real time clock registers instead of ram.
+class GBMBC3 : public GBMBC{
+    protected:
+        //RTC Registers
+        uint8_t m_rtcSeconds;
+        uint8_t m_rtcMinutes;
+        uint8_t m_rtcHours;
+        uint8_t m_rtcLowerDayCounter;
+        uint8_t m_rtcFlags;
+        bool m_bRTCLatched;
+
+        //Last value written to the latch register. Latch toggles when 0 is followed by 1.
+        uint8_t m_rtcLatchValue;
+
+        void updateRTC();
+
+        void writeControl(uint16_t address, uint8_t val);
+        uint16_t calculateRomBank();
+        uint8_t* calculateRamWriteData();
+        uint8_t readRamRegister(uint16_t address);
+        void writeRamRegister(uint16_t address, uint8_t val);
+
+    public:
+        GBMBC3(uint8_t* cartRom, uint32_t cartRomLength, uint8_t* cartRam);
+};
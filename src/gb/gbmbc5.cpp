@@ -0,0 +1,28 @@
+#include "gbmbc5.h"
+
+#define ADDRESS_MBC5_ROM_BANK_HIGH_START 0x3000
+
+GBMBC5::GBMBC5(uint8_t* cartRom, uint32_t cartRomLength, uint8_t* cartRam) : GBMBC(cartRom, cartRomLength, cartRam){
+}
+
+void GBMBC5::writeControl(uint16_t address, uint8_t val){
+    if((address >= ADDRESS_MBC1_ROM_BANK_NUM_START) && (address <= ADDRESS_MBC1_ROM_BANK_NUM_END)){
+        if(address < ADDRESS_MBC5_ROM_BANK_HIGH_START){
+            //Set lower 8 bits
+            m_cartRomBank = (m_cartRomBank & 0x0100) | val;
+        } else {
+            //Set 9th bit
+            m_cartRomBank = (m_cartRomBank & 0x0FF) | ((val & 0x01) << 8);
+        }
+    } else if(address >= ADDRESS_MBC1_RAM_BANK_NUMBER_START && address <= ADDRESS_MBC1_RAM_BANK_NUMBER_END){
+        //MBC5 uses the full 4 bit value of the bank.
+        m_cartRamBank = val & 0x0F;
+    } else {
+        GBMBC::writeControl(address, val);
+    }
+}
+
+uint16_t GBMBC5::calculateRomBank(){
+    //Bank 0 is allowed
+    return m_cartRomBank & 0x01FF;
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include "gbmbc.h"
+
+//MBC5. 9-bit rom bank and 4-bit ram bank registers. Rom bank 0 can be mapped to 0x4000-0x7FFF.
+class GBMBC5 : public GBMBC{
+    protected:
+        void writeControl(uint16_t address, uint8_t val);
+        uint16_t calculateRomBank();
+
+    public:
+        GBMBC5(uint8_t* cartRom, uint32_t cartRomLength, uint8_t* cartRam);
+};
@@ -8,6 +8,11 @@
 using namespace std;
 
 GBMem::GBMem(Platform systemType){
+    m_scheduler = NULL;
+    m_gbcart = NULL;
+    
+    //Start from a known state, so runs of the same game always match
+    memset(m_mem, 0, sizeof(m_mem));
     m_mem[ADDRESS_IF] = 0;
 	m_mem[ADDRESS_VBK] = 0;
 	m_wRamBank = 1;
@@ -18,6 +23,7 @@ GBMem::GBMem(Platform systemType){
 	
 	//Ensure VRam is empty to prevent crash in video code from uninitialized tile locations
 	memset(m_vRamBanks, 0, 0x4000);
+	memset(m_wRamBanks, 0, 0x7000);
 
 	m_systemType = systemType;
 	m_bDoubleClockSpeed = false;
@@ -25,397 +31,535 @@ GBMem::GBMem(Platform systemType){
     
     //Set default clock multiplier
     m_clockMultiplier = 1.0f; 
+    
+    m_codeMapVersion = 0;
+    memset(m_codePageVersions, 0, sizeof(m_codePageVersions));
+    
+    m_gbtimer = new GBTimer(this);
+    m_gblcd = NULL;
+    
+    initPages();
+    initIORegisters();
+    updatePlatform();
 }
 
 GBMem::~GBMem(){
 	delete m_wRamBanks;
 	delete m_vRamBanks;
+	delete m_gbtimer;
 }
 
-void GBMem::increment_RegisterDIV(long long hz){
-    //Store any unused Hz so that we can factor it into the next update
-static long long timeRollover = 0;
+//Sets up the page table. Work ram is always plain memory. Cart pages are filled in by updateCartPages.
+void GBMem::initPages() {
+	for (int page = 0; page < 0x100; page++) {
+		uint16_t address = page << 8;
+		MemoryPage& entry = m_pages[page];
+		entry.data = &m_mem[address];
+		entry.readData = NULL;
+		entry.writeData = NULL;
+
+		if (address <= ROM_BANK_N_END) {
+			entry.read = &GBMem::readCart;
+			entry.write = &GBMem::writeCartControl;
+		} else if (address <= VRAM_END) {
+			entry.read = &GBMem::readVRam;
+			entry.write = &GBMem::writeVRam;
+		} else if (address <= EXTRAM_END) {
+			entry.read = &GBMem::readCart;
+			entry.write = &GBMem::writeCartRam;
+		} else if (address <= WRAM_BANK_1_END) {
+			entry.readData = &m_mem[address];
+			entry.writeData = &m_mem[address];
+			entry.read = &GBMem::readDirect;
+			entry.write = &GBMem::writeDirect;
+		} else if (address <= ECHO_RAM_END) {
+			entry.read = &GBMem::readEcho;
+			entry.write = &GBMem::writeEcho;
+		} else if (address < IO_START) {
+			entry.read = &GBMem::readOAM;
+			entry.write = &GBMem::writeOAM;
+		} else {
+			entry.read = &GBMem::readIO;
+			entry.write = &GBMem::writeIO;
+		}
+	}
+
+	updateBankPages();
+}
+
+//Points the switchable vram and work ram pages at the current banks
+void GBMem::updateBankPages() {
+	uint8_t* vRam = &m_vRamBanks[m_vRamBank * 0x2000];
+	for (uint16_t address = VRAM_START; address <= VRAM_END; address += 0x100) {
+		m_pages[address >> 8].data = &vRam[address - VRAM_START];
+	}
+
+	uint8_t* wRam = &m_wRamBanks[(m_wRamBank - 1) * 0x1000];
+	for (uint16_t address = WRAM_BANK_1_START; address <= WRAM_BANK_1_END; address += 0x100) {
+		MemoryPage& entry = m_pages[address >> 8];
+		entry.data = &wRam[address - WRAM_BANK_1_START];
+		entry.readData = entry.data;
+		entry.writeData = entry.data;
+	}
+}
 
-//Include any previous clock unused from the last update
-hz += timeRollover;
+//Points the rom and cart ram pages at the cart's current banks. Must be called whenever the cart's mapping may have changed.
+void GBMem::updateCartPages() {
+	for (uint16_t address = ROM_BANK_0_START; address <= ROM_BANK_N_END; address += 0x100) {
+		m_pages[address >> 8].readData = (m_gbcart != NULL) ? m_gbcart->getReadPage(address) : NULL;
+	}
 
-//Increment the DIV register
-while (hz >= DIV_INCREMENT_CLOCK) {
-	m_mem[ADDRESS_DIV]++;
-	hz -= DIV_INCREMENT_CLOCK;
+	for (uint16_t address = EXTRAM_START; address <= EXTRAM_END; address += 0x100) {
+		m_pages[address >> 8].readData = (m_gbcart != NULL) ? m_gbcart->getReadPage(address) : NULL;
+		m_pages[address >> 8].writeData = (m_gbcart != NULL) ? m_gbcart->getWritePage(address) : NULL;
+	}
 }
 
-//Store leftover, unused clock
-if (hz >= 0) {
-	timeRollover = hz;
+uint8_t GBMem::readCart(uint16_t address) {
+	if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << std::hex << "Cartridge read " << +address << std::endl;
+	return m_gbcart->read(address);
 }
+
+void GBMem::writeCartControl(uint16_t address, uint8_t value) {
+	if (m_gbcart != NULL) {
+		m_gbcart->write(address, value);
+		
+		//May have switched rom banks
+		m_codeMapVersion++;
+		updateCartPages();
+	}
+	else {
+		if (CONSOLE_OUTPUT_ENABLED) std::cout << "Unable to write data to cartridge - cartridge object pointer is null!" << std::endl;
+	}
 }
 
-void GBMem::increment_RegisterTIMA(long long hz) {
-	//Store any unused Hz so that we can factor it into the next update
-	static long long timeRollover = 0;
+void GBMem::writeCartRam(uint16_t address, uint8_t value) {
+	m_gbcart->write(address, value);
+}
 
-	//Only increment register if timer is enabled.
-	if (!(m_mem[ADDRESS_TAC] & 0x04)) {
-		timeRollover = 0;
+uint8_t GBMem::readVRam(uint16_t address) {
+	if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "Reading VRam" << std::endl;
+	return m_gblcd->readVRam(address);
+}
+
+void GBMem::writeVRam(uint16_t address, uint8_t value) {
+	if(CONSOLE_OUTPUT_ENABLED) std::cout << "Writing VRam" << std::endl;
+	m_gblcd->writeVRam(address, value);
+}
+
+uint8_t GBMem::readEcho(uint16_t address) {
+	uint16_t echoAddress = address - (ECHO_RAM_START - WRAM_BANK_0_START);
+	if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << std::hex << "Attempting to read to echo ram address " << +address << ", redirecting to " << echoAddress << std::endl;
+	return direct_read(echoAddress);
+}
+
+void GBMem::writeEcho(uint16_t address, uint8_t value) {
+	uint16_t echoAddress = address - (ECHO_RAM_START - WRAM_BANK_0_START);
+	if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << std::hex << "Attempting to write to echo ram address " << +address << ", redirecting to " << echoAddress << std::endl;
+	direct_write(echoAddress, value);
+}
+
+uint8_t GBMem::readOAM(uint16_t address) {
+	if (address > OAM_END) {
+		if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << std::hex << "Attempt to read from unreadable ram! Address " << +address << std::endl;
+		return 0xFF;
+	}
+
+	if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "Reading Sprite Attribute Table" << std::endl;
+	return m_gblcd->readVRamSpriteAttribute(address);
+}
+
+void GBMem::writeOAM(uint16_t address, uint8_t value) {
+	if (address > OAM_END) {
+		writeDirect(address, value);
 		return;
 	}
 
-	//Include any previous clock unused from the last update
-	hz += timeRollover;
-
-	//Gets the clock used to increment the TIMA register
-	int TAC_Clock = 0;
-	uint8_t TAC_ClockSelect = m_mem[ADDRESS_TAC] & 3;
-	switch (TAC_ClockSelect) {
-	case TAC_CLOCK_4096:
-		TAC_Clock = 1024;
-		break;
-	case TAC_CLOCK_262144:
-		TAC_Clock = 16;
-		break;
-	case TAC_CLOCK_65536:
-		TAC_Clock = 64;
-		break;
-	case TAC_CLOCK_16384:
-		TAC_Clock = 256;
-		break;
-	default:
-		if (CONSOLE_OUTPUT_ENABLED) std::cout << "Invalid TAC Clock select " << TAC_ClockSelect << std::endl;
-		break;
-	}
-
-	//Increment the TIMA register
-	while (hz >= TAC_Clock) {
-		//Check if we need to fire the timer interrupt
-		if ((m_mem[ADDRESS_TIMA] + 1) > 0xFF) {
-			if (CONSOLE_OUTPUT_ENABLED) std::cout << "TIMA register rolled over. Setting interrupt flag" << std::endl;
-
-			//Set the timmer interrupt flag
-			write(ADDRESS_IF, m_mem[ADDRESS_IF] | INTERRUPT_FLAG_TIMER);
-
-			//TIMA is set to TMA on overflow
-			m_mem[ADDRESS_TIMA] = m_mem[ADDRESS_TMA];
-		}
-		else {
-			m_mem[ADDRESS_TIMA]++;
-		}
+	if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "Writing Sprite Attribute Table" << std::endl;
+	m_gblcd->writeVRamSpriteAttribute(address, value);
+}
+
+uint8_t GBMem::readDirect(uint16_t address) {
+	if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << std::hex << "Standard read address " << +address << std::endl;
+	return direct_read(address);
+}
 
-		hz -= TAC_Clock;
+void GBMem::writeDirect(uint16_t address, uint8_t value) {
+	if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << std::hex << "Standard write address " << address << ", val " << +value << std::endl;
+	direct_write(address, value);
+}
+
+//IO registers, high ram and the interrupt enable register
+uint8_t GBMem::readIO(uint16_t address) {
+	if (address > IO_END) {
+		return readDirect(address);
 	}
 
-	//Store leftover, unused clock
-	if (hz >= 0) {
-		timeRollover = hz;
+	return (this->*m_ioRegisters[address - IO_START].read)(address);
+}
+
+void GBMem::writeIO(uint16_t address, uint8_t value) {
+	if (address > IO_END) {
+		writeDirect(address, value);
+		return;
 	}
+
+	(this->*m_ioRegisters[address - IO_START].write)(address, value);
+}
+
+//Maps each IO register to its handler. Registers without one are plain memory.
+void GBMem::initIORegisters() {
+	for (int index = 0; index <= (IO_END - IO_START); index++) {
+		m_ioRegisters[index].read = &GBMem::readDirect;
+		m_ioRegisters[index].write = &GBMem::writeDirect;
+	}
+
+	//Audio registers without a handler still need audio brought up to date, since the wave table is read from memory
+	for (uint16_t address = ADDRESS_NR10; address <= ADDRESS_WAVE_TABLE_DATA_END; address++) {
+		m_ioRegisters[address - IO_START].write = &GBMem::writeAudioDirect;
+	}
+
+	setIORegister(ADDRESS_JOYP, &GBMem::readPad, &GBMem::writePad);
+	setIORegister(ADDRESS_SERIAL_CONTROL, &GBMem::readDirect, &GBMem::writeSerialControl);
+	setIORegister(ADDRESS_DIV, &GBMem::readTimer, &GBMem::writeTimer);
+	setIORegister(ADDRESS_TIMA, &GBMem::readTimer, &GBMem::writeTimer);
+	setIORegister(ADDRESS_TMA, &GBMem::readTimer, &GBMem::writeTimer);
+	setIORegister(ADDRESS_TAC, &GBMem::readTimer, &GBMem::writeTimer);
+	setIORegister(ADDRESS_IF, &GBMem::readDirect, &GBMem::writeIF);
+
+	setIORegister(ADDRESS_NR10, &GBMem::readAudio<&GBAudio::getNR10>, &GBMem::writeAudio<&GBAudio::setNR10>);
+	setIORegister(ADDRESS_NR11, &GBMem::readAudio<&GBAudio::getNR11>, &GBMem::writeAudio<&GBAudio::setNR11>);
+	setIORegister(ADDRESS_NR12, &GBMem::readAudio<&GBAudio::getNR12>, &GBMem::writeAudio<&GBAudio::setNR12>);
+	setIORegister(ADDRESS_NR13, &GBMem::readAudio<&GBAudio::getNR13>, &GBMem::writeAudio<&GBAudio::setNR13>);
+	setIORegister(ADDRESS_NR14, &GBMem::readAudio<&GBAudio::getNR14>, &GBMem::writeAudio<&GBAudio::setNR14>);
+	setIORegister(ADDRESS_NR21, &GBMem::readAudio<&GBAudio::getNR21>, &GBMem::writeAudio<&GBAudio::setNR21>);
+	setIORegister(ADDRESS_NR22, &GBMem::readAudio<&GBAudio::getNR22>, &GBMem::writeAudio<&GBAudio::setNR22>);
+	setIORegister(ADDRESS_NR23, &GBMem::readAudio<&GBAudio::getNR23>, &GBMem::writeAudio<&GBAudio::setNR23>);
+	setIORegister(ADDRESS_NR24, &GBMem::readAudio<&GBAudio::getNR24>, &GBMem::writeAudio<&GBAudio::setNR24>);
+	setIORegister(ADDRESS_NR30, &GBMem::readAudio<&GBAudio::getNR30>, &GBMem::writeAudio<&GBAudio::setNR30>);
+	setIORegister(ADDRESS_NR31, &GBMem::readAudio<&GBAudio::getNR31>, &GBMem::writeAudio<&GBAudio::setNR31>);
+	setIORegister(ADDRESS_NR32, &GBMem::readAudio<&GBAudio::getNR32>, &GBMem::writeAudio<&GBAudio::setNR32>);
+	setIORegister(ADDRESS_NR33, &GBMem::readAudio<&GBAudio::getNR33>, &GBMem::writeAudio<&GBAudio::setNR33>);
+	setIORegister(ADDRESS_NR34, &GBMem::readAudio<&GBAudio::getNR34>, &GBMem::writeAudio<&GBAudio::setNR34>);
+	setIORegister(ADDRESS_NR41, &GBMem::readAudio<&GBAudio::getNR41>, &GBMem::writeAudio<&GBAudio::setNR41>);
+	setIORegister(ADDRESS_NR42, &GBMem::readAudio<&GBAudio::getNR42>, &GBMem::writeAudio<&GBAudio::setNR42>);
+	setIORegister(ADDRESS_NR43, &GBMem::readAudio<&GBAudio::getNR43>, &GBMem::writeAudio<&GBAudio::setNR43>);
+	setIORegister(ADDRESS_NR44, &GBMem::readAudio<&GBAudio::getNR44>, &GBMem::writeAudio<&GBAudio::setNR44>);
+	setIORegister(ADDRESS_NR50, &GBMem::readAudio<&GBAudio::getNR50>, &GBMem::writeAudio<&GBAudio::setNR50>);
+	setIORegister(ADDRESS_NR51, &GBMem::readAudio<&GBAudio::getNR51>, &GBMem::writeAudio<&GBAudio::setNR51>);
+	setIORegister(ADDRESS_NR52, &GBMem::readAudio<&GBAudio::getNR52>, &GBMem::writeAudio<&GBAudio::setNR52>);
+
+	setIORegister(ADDRESS_LCDC, &GBMem::readDirect, &GBMem::writeLCD<&GBLCD::setLCDC>);
+	setIORegister(ADDRESS_STAT, &GBMem::readDirect, &GBMem::writeLCD<&GBLCD::setSTAT>);
+	setIORegister(ADDRESS_LY, &GBMem::readDirect, &GBMem::writeLCD<&GBLCD::setLY>);
+	setIORegister(ADDRESS_LYC, &GBMem::readDirect, &GBMem::writeLCD<&GBLCD::setLYC>);
+	setIORegister(ADDRESS_DMA, &GBMem::readDirect, &GBMem::writeLCD<&GBLCD::startDMATransfer>);
+	setIORegister(ADDRESS_BGP, &GBMem::readDirect, &GBMem::writeLCD<&GBLCD::setBGPalette>);
+	setIORegister(ADDRESS_OBP0, &GBMem::readDirect, &GBMem::writeLCD<&GBLCD::setSpritePalette0>);
+	setIORegister(ADDRESS_OBP1, &GBMem::readDirect, &GBMem::writeLCD<&GBLCD::setSpritePalette1>);
+
+	setIORegister(ADDRESS_KEY1, &GBMem::readKEY1, &GBMem::writeKEY1);
+	setIORegister(ADDRESS_BOOTROM, &GBMem::readDirect, &GBMem::writeBootRom);
+
+	//GBC only registers are mapped by updatePlatform
+}
+
+//Maps the GBC only registers for the current platform and tells the LCD. Called whenever the platform changes.
+//Other platforms read 0xFF and ignore writes, so the handlers themselves never need to check the platform.
+void GBMem::updatePlatform() {
+	if (getGBCMode()) {
+		setIORegister(ADDRESS_HDMA5, &GBMem::readDirect, &GBMem::writeLCDGBC<&GBLCD::startDMATransferGBC>);
+		setIORegister(ADDRESS_BCPD, &GBMem::readLCDGBC<&GBLCD::readBGPaletteGBC>, &GBMem::writeLCDGBC<&GBLCD::writeBGPaletteGBC>);
+		setIORegister(ADDRESS_OCPD, &GBMem::readLCDGBC<&GBLCD::readOAMPaletteGBC>, &GBMem::writeLCDGBC<&GBLCD::writeOAMPaletteGBC>);
+		setIORegister(ADDRESS_VBK, &GBMem::readVBK, &GBMem::writeVBK);
+		setIORegister(ADDRESS_SVBK, &GBMem::readSVBK, &GBMem::writeSVBK);
+	} else {
+		setIORegister(ADDRESS_HDMA5, &GBMem::readDirect, &GBMem::writeIgnored);
+		setIORegister(ADDRESS_BCPD, &GBMem::readUnmapped, &GBMem::writeIgnored);
+		setIORegister(ADDRESS_OCPD, &GBMem::readUnmapped, &GBMem::writeIgnored);
+		setIORegister(ADDRESS_VBK, &GBMem::readVBK, &GBMem::writeIgnored);
+		setIORegister(ADDRESS_SVBK, &GBMem::readSVBK, &GBMem::writeIgnored);
+	}
+
+	if (m_gblcd != NULL) {
+		m_gblcd->setPlatform(m_systemType);
+	}
+}
+
+uint8_t GBMem::readUnmapped(uint16_t address) {
+	return 0xFF;
+}
+
+void GBMem::writeIgnored(uint16_t address, uint8_t value) {
+}
+
+void GBMem::setIORegister(uint16_t address, PageReadHandler read, PageWriteHandler write) {
+	m_ioRegisters[address - IO_START].read = read;
+	m_ioRegisters[address - IO_START].write = write;
+}
+
+uint8_t GBMem::readPad(uint16_t address) {
+	if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "Reading gamepad buttons" << std::endl;
+	return m_gbpad->read();
 }
 
-void GBMem::write(uint16_t address, uint8_t value) {
+void GBMem::writePad(uint16_t address, uint8_t value) {
+	m_gbpad->write(value);
+}
 
+void GBMem::writeSerialControl(uint16_t address, uint8_t value) {
 	//Output results of Blaarg test roms on console if LCD isn't working properly.
-	if (BLAARG_TEST_OUTPUT && (address == 0xFF02) && (value == 0x81)) {
-	std::cout << read(0xFF01);
+	if (BLAARG_TEST_OUTPUT && (value == 0x81)) {
+		std::cout << read(ADDRESS_SERIAL_DATA);
 	}
 
-	if (((address >= ROM_BANK_0_START) && (address <= ROM_BANK_N_END))) {
-		if (m_gbcart != NULL) {
-			m_gbcart->write(address, value);
-		}
-		else {
-			if (CONSOLE_OUTPUT_ENABLED) std::cout << "Unable to write data to cartridge - cartridge object pointer is null!" << std::endl;
-		}
+	if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "Writing to serial control\n" << std::endl;
+	m_gbserial->write_control(value);
+	if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "\n"; //Write a new line so we can clearly see the serial output
+}
+
+uint8_t GBMem::readTimer(uint16_t address) {
+	//DIV and TIMA only catch up when something looks at them
+	if (m_scheduler != NULL) {
+		m_scheduler->sync(EVENT_TIMER);
 	}
-	else if ((address >= EXTRAM_START) && (address <= EXTRAM_END)) {
-  		m_gbcart->write(address, value);
-	}
-	else if (address == ADDRESS_BOOTROM) {
-		//Disable bootrom access
-		if (value & 0x1) {
-			m_gbcart->setBootRomEnabled(false);
-            
-            //Switch platform to backwards compatibility mode
-            if(!m_gbcart->cartSupportsGBC() && m_systemType == PLATFORM_GBC){
-                m_systemType = PLATFORM_GBC_BC;
-                std::cout << "Switched to GBC Backwards Compatility platform" << std::endl;
-            }
-		}
-	} else if (address == ADDRESS_SVBK) {
-		//Only allow ram bank switching in GBC mode
-		if (getGBCMode()) {
-			//Bank switching uses a backup and restore approach, to preserve functionality of direct access functions.
-			
-			//Back up current bank
-			memcpy(&m_wRamBanks[(m_wRamBank - 1) * 0x1000], &m_mem[WRAM_BANK_1_START], sizeof(uint8_t) * (0x1000));
-
-			//Work ram bank is only 3 bits
-			m_wRamBank = value & 0x7;
-
-			//Ensure that work ram bank is never set to 0.
-			if (m_wRamBank == 0) {
-				m_wRamBank = 1;
-			}
 
-			//Store register content so that direct access still works
-			m_mem[ADDRESS_SVBK] = m_wRamBank;
+	return m_gbtimer->read(address);
+}
 
-			//Restore current ram bank
-			memcpy(&m_mem[WRAM_BANK_1_START], &m_wRamBanks[(m_wRamBank - 1) * 0x1000], sizeof(uint8_t) * 0x1000);
+void GBMem::writeTimer(uint16_t address, uint8_t value) {
+	//Timer runs behind the CPU, so bring it up to date before its registers change
+	if (m_scheduler != NULL) {
+		m_scheduler->sync(EVENT_TIMER);
+		m_scheduler->reschedule(EVENT_TIMER);
+	}
 
-			if (CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "Bank switch to " << +m_wRamBank << std::endl;
-		}
-		
-	} else if (address == ADDRESS_KEY1) {
-		//Only bit 0 is writeable, indicates that the CPU is about to switch clock speeds
-		m_bPrepareForSpeedSwitch = value & 1;
-	} else if (address == ADDRESS_DIV) {
-		  //Writing to the DIV register resets it
-		m_mem[ADDRESS_DIV] = 0;
-	} else if (address == ADDRESS_JOYP){
-		  m_gbpad->write(value);
-	} else if (address == ADDRESS_SERIAL_CONTROL){
-		  if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "Writing to serial control\n" << std::endl;
-		m_gbserial->write_control(value);
-		if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "\n"; //Write a new line so we can clearly see the serial output
-	} else if((address >= ECHO_RAM_START) && (address <= ECHO_RAM_END)){
-	   uint16_t echoAddress = address - (ECHO_RAM_START - WRAM_BANK_0_START);
-	   if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "Attempting to write to echo ram address " << +address << ", redirecting to " << echoAddress << std::endl;
-	   m_mem[echoAddress] = value;
-	} else if (address == ADDRESS_VBK) {
-		//Only allow vram bank switching in GBC mode
-		if (getGBCMode()) {
-			//Bank switching uses a backup and restore approach, to preserve functionality of direct access functions.
-
-			//Back up current bank
-			memcpy(&m_vRamBanks[m_vRamBank * 0x2000], &m_mem[VRAM_START], sizeof(uint8_t) * (0x2000));
-
-			//VRam bank is the first bit of the value.
-			m_vRamBank = value & 0x1;
-
-			//Store register content so that direct access still works
-			m_mem[ADDRESS_VBK] = m_vRamBank;
-
-			//Restore current ram bank
-			memcpy(&m_mem[VRAM_START], &m_vRamBanks[m_vRamBank * 0x2000], sizeof(uint8_t) * 0x2000);
-
-			if (CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "VRam Bank switch to " << +m_vRamBank << std::endl;		
-		}
-	} else if ((address >= VRAM_START) && (address <= VRAM_END)) {
-	    if(CONSOLE_OUTPUT_ENABLED) std::cout << "Writing VRam" << std::endl;
-	   m_gblcd->writeVRam(address, value);
-	} else if ((address >= OAM_START) && (address <= OAM_END)){
-		if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "Writing Sprite Attribute Table" << std::endl;
-		m_gblcd->writeVRamSpriteAttribute(address, value);
-	} else if (address == ADDRESS_LCDC){
-		if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "Writing LCDC" << std::endl;
-		m_gblcd->setLCDC(value);
-	} else if (address == ADDRESS_STAT){
-		if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "Writing STAT" << std::endl;
-		m_gblcd->setSTAT(value);
-	} else if (address == ADDRESS_LY){
-		m_gblcd->setLY(value);
-	} else if (address == ADDRESS_LYC){
-		if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "Writing LYC-LY Compare" << std::endl;
-		m_gblcd->setLYC(value);
-	} else if(address == ADDRESS_DMA){
-		if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "Writing address for OAM DMA Transfer" << std::endl;
-		m_gblcd->startDMATransfer(value);
-	} else if (address == ADDRESS_HDMA5) {
-		//HDMA5 is a trigger for GBC mode VRam DMA transfer.
-		if (getGBCMode()) {
-			m_gblcd->startDMATransferGBC(value);
-		}
-	} else if (address == ADDRESS_BCPD) {
-		if (getGBCMode()) {
-			m_gblcd->writeBGPaletteGBC(value);
-		}
-	} else if (address == ADDRESS_OCPD) {
-		if (getGBCMode()) {
-			m_gblcd->writeOAMPaletteGBC(value);
-		}
-	} else if (address == ADDRESS_NR10) {
-		m_gbaudio->setNR10(value);
-	} else if (address == ADDRESS_NR11){
-		m_gbaudio->setNR11(value);
-	} else if (address == ADDRESS_NR12){
-	    m_gbaudio->setNR12(value);
-	} else if (address == ADDRESS_NR13){
-		m_gbaudio->setNR13(value);
-	} else if (address == ADDRESS_NR14){
-		m_gbaudio->setNR14(value);
-	} else if (address == ADDRESS_NR21){
-		m_gbaudio->setNR21(value);
-	} else if (address == ADDRESS_NR22){
-		m_gbaudio->setNR22(value);
-	} else if (address == ADDRESS_NR23){
-		m_gbaudio->setNR23(value);
-	} else if (address == ADDRESS_NR24){
-		m_gbaudio->setNR24(value);
-	} else if (address == ADDRESS_NR30){
-		m_gbaudio->setNR30(value);
-	} else if (address == ADDRESS_NR31){
-		m_gbaudio->setNR31(value);
-	} else if (address == ADDRESS_NR32){
-		m_gbaudio->setNR32(value);
-	} else if (address == ADDRESS_NR33){
-		m_gbaudio->setNR33(value);
-	} else if (address == ADDRESS_NR34){
-		m_gbaudio->setNR34(value);
-	} else if (address == ADDRESS_NR41){
-		m_gbaudio->setNR41(value);
-	} else if (address == ADDRESS_NR42){
-		m_gbaudio->setNR42(value);
-	} else if (address == ADDRESS_NR43){
-		m_gbaudio->setNR43(value);
-	} else if (address == ADDRESS_NR44){
-		m_gbaudio->setNR44(value);
-	} else if (address == ADDRESS_NR50){
-		m_gbaudio->setNR50(value);
-	} else if (address == ADDRESS_NR51){
-		m_gbaudio->setNR51(value);
-	} else if (address == ADDRESS_NR52){
-		m_gbaudio->setNR52(value);
-	} else if (address == ADDRESS_IF){
-		if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "Writing interrupt flags";
-		m_mem[ADDRESS_IF] = value;
-	}else {
-		if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << std::hex << "Standard write address " << address << ", val " << +value << std::endl;
-		m_mem[address] = value;
-	}
-}
-
-uint8_t GBMem::read(uint16_t address){  
-  uint8_t toReturn = 0xFF;
-  bool bDirectReadAddress = false;
-  if(CONSOLE_OUTPUT_ENABLED) std::cout << std::hex;
-  
-  if((address >= ROM_BANK_0_START) && (address <= ROM_BANK_N_END)){
-      if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "Cartridge read " << +address << std::endl;
-      toReturn = m_gbcart->read(address);
-  } else if ((address >= EXTRAM_START) && (address <= EXTRAM_END)){
-      toReturn = m_gbcart->read(address);
-  } else if (address == ADDRESS_SVBK) {
-	  toReturn = m_wRamBank;
-  } else if (address == ADDRESS_VBK) {
-	  toReturn = m_vRamBank;
-  } else if (address == ADDRESS_KEY1) {
-	  //Bit 7 is the current CPU speed. Bit 0 is whether or not the CPU will switch speeds when executing STOP
-	  toReturn = 0;
-	  toReturn |= m_bPrepareForSpeedSwitch;
-	  toReturn |= m_bDoubleClockSpeed << 7;
-
-  } else if((address >= ECHO_RAM_START) && (address <= ECHO_RAM_END)){
-      uint16_t echoAddress = address - (ECHO_RAM_START - WRAM_BANK_0_START);
-      if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "Attempting to read to echo ram address " << +address << ", redirecting to " << echoAddress << std::endl;
-      toReturn = m_mem[echoAddress];
-  } else if ((address >= UNUSABLE_START) && (address <= UNUSABLE_END)){
-      if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "Attempt to read from unreadable ram! Address " << +address << std::endl;
-  } else if (address == ADDRESS_JOYP){
-      if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "Reading gamepad buttons" << std::endl;
-      toReturn = m_gbpad->read();
-  } else if ((address >= VRAM_START) && (address <= VRAM_END)){
-      if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "Reading VRam" << std::endl;
-      toReturn = m_gblcd->readVRam(address);
-  } else if ((address >= OAM_START) && (address <= OAM_END)){
-      if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "Reading Sprite Attribute Table" << std::endl;
-      toReturn = m_gblcd->readVRamSpriteAttribute(address);
-  } else if (address == ADDRESS_BCPD) {
-	  if (getGBCMode()) {
-		  toReturn = m_gblcd->readBGPaletteGBC();
-	  }
-  } else if (address == ADDRESS_OCPD) {
-	  if (getGBCMode()) {
-		  toReturn = m_gblcd->readOAMPaletteGBC();
-	  }
-  }
-  else if (address == ADDRESS_NR10) {
-      toReturn = m_gbaudio->getNR10();
-  } else if (address == ADDRESS_NR11) {
-      toReturn = m_gbaudio->getNR11();
-  } else if (address == ADDRESS_NR12) {
-      toReturn = m_gbaudio->getNR12();
-  } else if (address == ADDRESS_NR13) {
-      toReturn = m_gbaudio->getNR13();
-  } else if (address == ADDRESS_NR14) {
-      toReturn = m_gbaudio->getNR14();
-  } else if (address == ADDRESS_NR21) {
-      toReturn = m_gbaudio->getNR21();
-  } else if (address == ADDRESS_NR22) {
-      toReturn = m_gbaudio->getNR22();
-  } else if (address == ADDRESS_NR23) {
-      toReturn = m_gbaudio->getNR23();
-  } else if (address == ADDRESS_NR24) {
-      toReturn = m_gbaudio->getNR24();
-  } else if (address == ADDRESS_NR30) {
-      toReturn = m_gbaudio->getNR30();
-  } else if (address == ADDRESS_NR31) {
-      toReturn = m_gbaudio->getNR31();
-  } else if (address == ADDRESS_NR32) {
-      toReturn = m_gbaudio->getNR32();
-  } else if (address == ADDRESS_NR33) {
-      toReturn = m_gbaudio->getNR33();
-  } else if (address == ADDRESS_NR34) {
-      toReturn = m_gbaudio->getNR34();
-  } else if (address == ADDRESS_NR41) {
-      toReturn = m_gbaudio->getNR41();
-  } else if (address == ADDRESS_NR42) {
-      toReturn = m_gbaudio->getNR42();
-  } else if (address == ADDRESS_NR43) {
-      toReturn = m_gbaudio->getNR43();
-  } else if (address == ADDRESS_NR44) {
-      toReturn = m_gbaudio->getNR44();
-  } else if (address == ADDRESS_NR50) {
-      toReturn = m_gbaudio->getNR50();
-  } else if (address == ADDRESS_NR51) {
-      toReturn = m_gbaudio->getNR51();
-  } else if (address == ADDRESS_NR52) {
-      toReturn = m_gbaudio->getNR52();
-  } else {
-      if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "Standard read address " << +address << std::endl;
-      bDirectReadAddress = true;
-  }
-  
-  if(bDirectReadAddress){
-      toReturn = m_mem[address];
-  }
-  
-  return toReturn;
+	m_gbtimer->write(address, value);
+}
+
+void GBMem::writeIF(uint16_t address, uint8_t value) {
+	if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "Writing interrupt flags";
+	m_mem[ADDRESS_IF] = value;
+}
+
+template<uint8_t (GBAudio::*getter)()>
+uint8_t GBMem::readAudio(uint16_t address) {
+	return (m_gbaudio->*getter)();
+}
+
+template<void (GBAudio::*setter)(uint8_t)>
+void GBMem::writeAudio(uint16_t address, uint8_t value) {
+	//Audio runs behind the CPU, so bring it up to date before its registers change
+	if (m_scheduler != NULL) {
+		m_scheduler->sync(EVENT_AUDIO);
+	}
+
+	(m_gbaudio->*setter)(value);
+}
+
+void GBMem::writeAudioDirect(uint16_t address, uint8_t value) {
+	if (m_scheduler != NULL) {
+		m_scheduler->sync(EVENT_AUDIO);
+	}
+
+	writeDirect(address, value);
+}
+
+template<void (GBLCD::*setter)(uint8_t)>
+void GBMem::writeLCD(uint16_t address, uint8_t value) {
+	if(CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << std::hex << "Writing LCD register " << address << std::endl;
+
+	//LCD runs behind the CPU, so bring it up to date before its registers change.
+	//Writes can change the mode or line, so the queued mode change is worked out again afterwards.
+	if (m_scheduler != NULL) {
+		m_scheduler->sync(EVENT_LCD);
+		m_scheduler->reschedule(EVENT_LCD);
+	}
+
+	(m_gblcd->*setter)(value);
+}
+
+//GBC only LCD registers. Only mapped in GBC mode.
+template<uint8_t (GBLCD::*getter)()>
+uint8_t GBMem::readLCDGBC(uint16_t address) {
+	return (m_gblcd->*getter)();
+}
+
+template<void (GBLCD::*setter)(uint8_t)>
+void GBMem::writeLCDGBC(uint16_t address, uint8_t value) {
+	if (m_scheduler != NULL) {
+		m_scheduler->sync(EVENT_LCD);
+		m_scheduler->reschedule(EVENT_LCD);
+	}
+
+	(m_gblcd->*setter)(value);
+}
+
+uint8_t GBMem::readKEY1(uint16_t address) {
+	//Bit 7 is the current CPU speed. Bit 0 is whether or not the CPU will switch speeds when executing STOP
+	uint8_t toReturn = 0;
+	toReturn |= m_bPrepareForSpeedSwitch;
+	toReturn |= m_bDoubleClockSpeed << 7;
+	return toReturn;
+}
+
+void GBMem::writeKEY1(uint16_t address, uint8_t value) {
+	//Only bit 0 is writeable, indicates that the CPU is about to switch clock speeds
+	m_bPrepareForSpeedSwitch = value & 1;
+}
+
+uint8_t GBMem::readVBK(uint16_t address) {
+	return m_vRamBank;
+}
+
+void GBMem::writeVBK(uint16_t address, uint8_t value) {
+	//Only mapped in GBC mode
+	//VRam bank is the first bit of the value.
+	m_vRamBank = value & 0x1;
+
+	//Store register content so that direct access still works
+	m_mem[ADDRESS_VBK] = m_vRamBank;
+
+	//Switching banks only moves the page pointers
+	updateBankPages();
+
+	if (CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "VRam Bank switch to " << +m_vRamBank << std::endl;
+}
+
+void GBMem::writeBootRom(uint16_t address, uint8_t value) {
+	//Disable bootrom access
+	if (value & 0x1) {
+		m_gbcart->setBootRomEnabled(false);
+		m_codeMapVersion++;
+		updateCartPages();
+        
+        //Switch platform to backwards compatibility mode
+        if(!m_gbcart->cartSupportsGBC() && m_systemType == PLATFORM_GBC){
+            m_systemType = PLATFORM_GBC_BC;
+            updatePlatform();
+            std::cout << "Switched to GBC Backwards Compatility platform" << std::endl;
+        }
+	}
+}
+
+uint8_t GBMem::readSVBK(uint16_t address) {
+	return m_wRamBank;
+}
+
+void GBMem::writeSVBK(uint16_t address, uint8_t value) {
+	//Only mapped in GBC mode
+	//Work ram bank is only 3 bits
+	m_wRamBank = value & 0x7;
+
+	//Ensure that work ram bank is never set to 0.
+	if (m_wRamBank == 0) {
+		m_wRamBank = 1;
+	}
+
+	//Store register content so that direct access still works
+	m_mem[ADDRESS_SVBK] = m_wRamBank;
+
+	//Switching banks only moves the page pointers
+	updateBankPages();
+	m_codeMapVersion++;
+
+	if (CONSOLE_OUTPUT_ENABLED && CONSOLE_OUTPUT_IO) std::cout << "Bank switch to " << +m_wRamBank << std::endl;
 }
 
 //Direct read and write, to bypass logic for hardware reads and writes
 //Ex. to better implement display
 void GBMem::direct_write(uint16_t address, uint8_t value){
-    m_mem[address] = value;
+    m_pages[address >> 8].data[address & 0xFF] = value;
+    
+    //Only high ram in the IO page can hold cached code, so IO register writes leave its version alone
+    if((address < IO_START) || ((address >= HRAM_START) && (address <= HRAM_END))){
+        m_codePageVersions[address >> 8]++;
+    }
 }
 
 uint8_t GBMem::direct_read(uint16_t address){
-    return m_mem[address];
+    return m_pages[address >> 8].data[address & 0xFF];
 }
     
+//Copies a block as a DMA transfer would. Source is read as the CPU sees it and the destination is written directly.
+//Works a page at a time, copying straight between host memory unless the source page has side effects.
+void GBMem::dma_copy(uint16_t destination, uint16_t source, uint16_t length){
+	uint16_t start = destination;
+	uint16_t total = length;
+
+	while (length > 0) {
+		//Largest run that stays within one source and one destination page
+		uint16_t run = 0x100 - (source & 0xFF);
+		if (run > 0x100 - (destination & 0xFF)) {
+			run = 0x100 - (destination & 0xFF);
+		}
+		if (run > length) {
+			run = length;
+		}
+
+		uint8_t* sourceData = getDMASource(source);
+		if (sourceData != NULL) {
+			memmove(&m_pages[destination >> 8].data[destination & 0xFF], &sourceData[source & 0xFF], run);
+			m_codePageVersions[destination >> 8]++;
+		} else {
+			for (uint16_t offset = 0; offset < run; offset++) {
+				direct_write(destination + offset, read(source + offset));
+			}
+		}
+
+		source += run;
+		destination += run;
+		length -= run;
+	}
+
+	//Tiles copied into vram need decoding again
+	if (m_gblcd != NULL && start <= VRAM_END && start + total > VRAM_START) {
+		uint16_t vramStart = (start < VRAM_START) ? VRAM_START : start;
+		m_gblcd->updateTileCache(m_vRamBank, vramStart - VRAM_START, start + total - vramStart);
+	}
+}
+
+uint8_t* GBMem::getDMASource(uint16_t address){
+	const MemoryPage& page = m_pages[address >> 8];
+
+	//Rom, enabled cart ram and work ram
+	if (page.readData != NULL) {
+		return page.readData;
+	}
+
+	//VRam reads aren't restricted by mode, so they read the mapped bank
+	if (address >= VRAM_START && address <= VRAM_END) {
+		return page.data;
+	}
+
+	if (address >= ECHO_RAM_START && address <= ECHO_RAM_END) {
+		return m_pages[(address - (ECHO_RAM_START - WRAM_BANK_0_START)) >> 8].data;
+	}
+
+	return NULL;
+}
+
 //Direct read and write for VRam banks. Needed for some LCD operations.
 void GBMem::direct_vram_write(uint16_t index, uint8_t vramBank, uint8_t value) {
-	//If the value is in the current ram bank, set in actual ram
-	if (vramBank == m_vRamBank) {
-		m_mem[index + VRAM_START] = value;
-	} else {
-		m_vRamBanks[index + (vramBank * 0x2000)] = value;
+	//Both banks live in m_vRamBanks, whichever one is mapped
+	m_vRamBanks[index + (vramBank * 0x2000)] = value;
+
+	if (m_gblcd != NULL) {
+		m_gblcd->updateTileCache(vramBank, index, 1);
 	}
 }
 
 uint8_t GBMem::direct_vram_read(uint16_t index, uint8_t vramBank) {
-	uint8_t val = 0;
-	//If the value is in the current ram bank, fetch from actual ram
-	if (vramBank == m_vRamBank) {
-		val = m_mem[index + VRAM_START];
-	}
-	else {
-		val = m_vRamBanks[index + (vramBank * 0x2000)];
-	}
+	return m_vRamBanks[index + (vramBank * 0x2000)];
+}
 
-	return val;
+uint8_t* GBMem::getVRamBankData(uint8_t vramBank) {
+	return &m_vRamBanks[vramBank * 0x2000];
 }
 
 void GBMem::loadCart(GBCart* cart) {
 	m_gbcart = cart;
+	updateCartPages();
 
 	//If platform is set to auto, need to determine actual system type
 	if (m_systemType == Platform::PLATFORM_AUTO) {
@@ -440,10 +584,13 @@ void GBMem::loadCart(GBCart* cart) {
         }
 	}
 
+	updatePlatform();
+
 }
 
 void GBMem::setLCD(GBLCD* lcd){
     m_gblcd = lcd;
+    m_gblcd->setPlatform(m_systemType);
 }
 
 void GBMem::setAudio(GBAudio* audio){
@@ -458,8 +605,17 @@ void GBMem::setSerial(GBSerial* serial){
     m_gbserial = serial;
 }
 
+void GBMem::setScheduler(GBScheduler* scheduler){
+    m_scheduler = scheduler;
+}
+
 //Sets the clock speed multiplier
 void GBMem::setClockMultiplier(float multiplier){
+    //Changes the audio sample rate
+    if (m_scheduler != NULL) {
+        m_scheduler->sync(EVENT_AUDIO);
+    }
+    
     m_clockMultiplier = multiplier;
 }
 
@@ -483,6 +639,26 @@ uint8_t GBMem::getVRamBank() {
 	return m_vRamBank;
 }
 
+//Gets the current work ram bank
+uint8_t GBMem::getWRamBank() {
+	return m_wRamBank;
+}
+
+//Gets the cartridge rom bank mapped to 0x4000-0x7FFF
+uint16_t GBMem::getRomBank() {
+	return m_gbcart->getRomBank();
+}
+
+//Gets the version of the memory map, for the CPU block cache
+uint32_t GBMem::getCodeMapVersion() {
+	return m_codeMapVersion;
+}
+
+//Gets the version of the 256 byte page containing address, for the CPU block cache
+uint32_t GBMem::getCodePageVersion(uint16_t address) {
+	return m_codePageVersions[address >> 8];
+}
+
 //Get whether or not we are reading from boot rom instead of cartridge
 //Allows other components to check without having direct rom access.
 bool GBMem::getBootRomEnabled(){
@@ -504,12 +680,17 @@ void GBMem::toggleDouleSpeedMode() {
 	//Clear speed switch flag.
 	m_bPrepareForSpeedSwitch = false;
 
+	//LCD and audio time is counted differently at each speed, so settle everything at the old speed first
+	if (m_scheduler != NULL) {
+		m_scheduler->syncAll();
+		m_scheduler->reschedule(EVENT_LCD);
+	}
+
 	//toggle speed
 	m_bDoubleClockSpeed = !m_bDoubleClockSpeed;
 }
 
-//Used to update timer registers
-void GBMem::tick(long long hz){
-    increment_RegisterDIV(hz);
-    increment_RegisterTIMA(hz);
+//Gets the DIV and TIMA timer
+GBTimer* GBMem::getTimer(){
+    return m_gbtimer;
 }
@@ -7,6 +7,9 @@
 #include "gbaudio.h"
 #include "gbpad.h"
 #include "gbserial.h"
+#include "gbscheduler.h"
+#include "gbtimer.h"
+#include "gbplatform.h"
 #include "../constants.h"
 
 //RAM regions
@@ -110,29 +113,42 @@
 //IR register skipped
 #define ADDRESS_SVBK   0xFF70 //GBC WRAM bank
 
-#define DIV_INCREMENT_CLOCK 16384 //Increment speed of DIV register
-//TIMA Increment speeds in Hz. 
-#define TAC_CLOCK_4096   0x00
-#define TAC_CLOCK_262144 0x01
-#define TAC_CLOCK_65536  0x02
-#define TAC_CLOCK_16384  0x03
-
 #define INTERRUPT_FLAG_VBLANK 0x1 //Bit 0
 #define INTERRUPT_FLAG_STAT   0x2 //Bit 1
 #define INTERRUPT_FLAG_TIMER  0x4 //Bit 2
 #define INTERRUPT_FLAG_SERIAL 0x8 //Bit 3
 #define INTERRUPT_FLAG_JOYPAD 0x10 //Bit 4
 
-enum Platform {
-	PLATFORM_DMG = 0,
-	PLATFORM_SGB = 1,
-	PLATFORM_GBC = 2,
-    PLATFORM_GBC_BC = 3, //DMG games in GBC Backwards Compatibilty mode. Affects color palettes.
-	PLATFORM_AUTO
+class GBMem;
+
+//Handlers for memory pages that can't be accessed directly
+typedef uint8_t (GBMem::*PageReadHandler)(uint16_t address);
+typedef void (GBMem::*PageWriteHandler)(uint16_t address, uint8_t value);
+
+//One entry per 256 byte page of the memory map.
+//Pages with a host pointer are read or written directly, the rest go through their handler.
+struct MemoryPage{
+    uint8_t* data; //Memory behind the page for direct_read and direct_write. Switchable vram and work ram point at the current bank.
+    uint8_t* readData;
+    uint8_t* writeData;
+    PageReadHandler read;
+    PageWriteHandler write;
+};
+
+//Handlers for a single IO register
+struct IORegister{
+    PageReadHandler read;
+    PageWriteHandler write;
 };
 
+class GBJit;
+
 class GBMem{
+  //Compiled code reads and writes plain memory through the page table
+  friend class GBJit;
+  
   private:
+    GBScheduler* m_scheduler;
     GBCart* m_gbcart;
     GBLCD* m_gblcd;
     GBAudio* m_gbaudio;
@@ -149,43 +165,123 @@ class GBMem{
 	bool m_bDoubleClockSpeed;
 	bool m_bPrepareForSpeedSwitch;
 
-    //Timer and Divider "registers"
-    uint8_t m_RegisterDIV;
-    uint8_t m_RegisterTIMA;
-    uint8_t m_RegisterTMA;
-    uint8_t m_RegisterTAC;
+    //Timer and Divider registers
+    GBTimer* m_gbtimer;
     
-    uint8_t m_mem[0xFFFF]; //Entire memory map.
-    uint8_t *m_wRamBanks; //Stores ram banks 1 through 7. 4KB each, 28kb total.
-	uint8_t *m_vRamBanks; //Stores both 8kb VRam banks.
+    uint8_t m_mem[0x10000]; //Entire memory map, up to and including IE at 0xFFFF.
+    uint8_t *m_wRamBanks; //Stores ram banks 1 through 7. 4KB each, 28kb total. The current bank is mapped through the page table.
+	uint8_t *m_vRamBanks; //Stores both 8kb VRam banks. The current bank is mapped through the page table.
 
     //Clock speed multiplier. In GBMem so other timing sensitive code can reach it
     float m_clockMultiplier;
     
-    void increment_RegisterDIV(long long hz);
-    void increment_RegisterTIMA(long long hz);
+    //Versions used by the CPU block cache to tell when cached code is stale.
+    //Map version changes whenever bank switching or the boot rom changes what code is visible.
+    //Page versions change whenever a 256 byte page of memory is written.
+    uint32_t m_codeMapVersion;
+    uint32_t m_codePageVersions[0x100];
+    
+    //Memory map, indexed by the upper byte of the address
+    MemoryPage m_pages[0x100];
+    
+    void initPages();
+    void updateCartPages();
+    void updateBankPages();
+    
+    //Page handlers
+    uint8_t readCart(uint16_t address);
+    void writeCartControl(uint16_t address, uint8_t value);
+    void writeCartRam(uint16_t address, uint8_t value);
+    uint8_t readVRam(uint16_t address);
+    void writeVRam(uint16_t address, uint8_t value);
+    uint8_t readEcho(uint16_t address);
+    void writeEcho(uint16_t address, uint8_t value);
+    uint8_t readOAM(uint16_t address);
+    void writeOAM(uint16_t address, uint8_t value);
+    uint8_t readDirect(uint16_t address);
+    void writeDirect(uint16_t address, uint8_t value);
+    uint8_t readIO(uint16_t address);
+    void writeIO(uint16_t address, uint8_t value);
+    
+    //IO registers 0xFF00-0xFF7F, indexed by address - IO_START
+    IORegister m_ioRegisters[IO_END - IO_START + 1];
+    
+    void initIORegisters();
+    void setIORegister(uint16_t address, PageReadHandler read, PageWriteHandler write);
+    
+    //Maps the GBC only registers for the current platform and tells the LCD. Called whenever the platform changes.
+    void updatePlatform();
+    uint8_t readUnmapped(uint16_t address);
+    void writeIgnored(uint16_t address, uint8_t value);
+    
+    //IO register handlers
+    uint8_t readPad(uint16_t address);
+    void writePad(uint16_t address, uint8_t value);
+    void writeSerialControl(uint16_t address, uint8_t value);
+    uint8_t readTimer(uint16_t address);
+    void writeTimer(uint16_t address, uint8_t value);
+    void writeIF(uint16_t address, uint8_t value);
+    template<uint8_t (GBAudio::*getter)()> uint8_t readAudio(uint16_t address);
+    template<void (GBAudio::*setter)(uint8_t)> void writeAudio(uint16_t address, uint8_t value);
+    void writeAudioDirect(uint16_t address, uint8_t value);
+    template<void (GBLCD::*setter)(uint8_t)> void writeLCD(uint16_t address, uint8_t value);
+    template<uint8_t (GBLCD::*getter)()> uint8_t readLCDGBC(uint16_t address);
+    template<void (GBLCD::*setter)(uint8_t)> void writeLCDGBC(uint16_t address, uint8_t value);
+    uint8_t readKEY1(uint16_t address);
+    void writeKEY1(uint16_t address, uint8_t value);
+    uint8_t readVBK(uint16_t address);
+    void writeVBK(uint16_t address, uint8_t value);
+    void writeBootRom(uint16_t address, uint8_t value);
+    uint8_t readSVBK(uint16_t address);
+    void writeSVBK(uint16_t address, uint8_t value);
+    
+    //Gets the memory a DMA transfer can copy the page containing address from, or NULL if the page needs its read handler
+    uint8_t* getDMASource(uint16_t address);
     
   public:
     GBMem(Platform systemType = Platform::PLATFORM_AUTO);
     ~GBMem();
     
-    void write(uint16_t address, uint8_t value);
-    uint8_t read(uint16_t address);
+    //Plain memory is read and written straight through the page table. Defined here so the lookup inlines into callers.
+    void write(uint16_t address, uint8_t value){
+        const MemoryPage& page = m_pages[address >> 8];
+        if(page.writeData != NULL){
+            page.writeData[address & 0xFF] = value;
+            m_codePageVersions[address >> 8]++;
+            return;
+        }
+        
+        (this->*page.write)(address, value);
+    }
+    
+    uint8_t read(uint16_t address){
+        const MemoryPage& page = m_pages[address >> 8];
+        if(page.readData != NULL){
+            return page.readData[address & 0xFF];
+        }
+        
+        return (this->*page.read)(address);
+    }
     
     //Direct read and write, to bypass logic for hardware reads and writes
     //Ex. to better implement display
     void direct_write(uint16_t address, uint8_t value);
     uint8_t direct_read(uint16_t address);
     
+	//Copies a block as a DMA transfer would. Source is read as the CPU sees it and the destination is written directly.
+	void dma_copy(uint16_t destination, uint16_t source, uint16_t length);
+	
 	//Direct read and write for VRam banks. Needed for some LCD operations.
 	void direct_vram_write(uint16_t index, uint8_t vramBank, uint8_t value);
 	uint8_t direct_vram_read(uint16_t index, uint8_t vramBank);
+	uint8_t* getVRamBankData(uint8_t vramBank);
 
     void loadCart(GBCart* cart);
     void setLCD(GBLCD* lcd);
     void setAudio(GBAudio* audio);
     void setPad(GBPad* pad);
     void setSerial(GBSerial* serial);
+    void setScheduler(GBScheduler* scheduler);
     
     //Sets the clock speed multiplier
     void setClockMultiplier(float multiplier);
@@ -202,6 +298,18 @@ class GBMem{
 	//Gets the current video ram bank
 	uint8_t getVRamBank();
 
+    //Gets the current work ram bank
+    uint8_t getWRamBank();
+
+    //Gets the cartridge rom bank mapped to 0x4000-0x7FFF
+    uint16_t getRomBank();
+
+    //Gets the version of the memory map, for the CPU block cache
+    uint32_t getCodeMapVersion();
+
+    //Gets the version of the 256 byte page containing address, for the CPU block cache
+    uint32_t getCodePageVersion(uint16_t address);
+
     //Get whether or not we are reading from boot rom instead of cartridge
     bool getBootRomEnabled();
     
@@ -214,6 +322,6 @@ class GBMem{
 	//Toggles the current speed
 	void toggleDouleSpeedMode();
 
-    //Used to update timer registers
-    void tick(long long hz);
+    //Gets the DIV and TIMA timer
+    GBTimer* getTimer();
 };
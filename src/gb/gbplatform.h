@@ -0,0 +1,9 @@
+#pragma once
+
+enum Platform {
+	PLATFORM_DMG = 0,
+	PLATFORM_SGB = 1,
+	PLATFORM_GBC = 2,
+    PLATFORM_GBC_BC = 3, //DMG games in GBC Backwards Compatibilty mode. Affects color palettes.
+	PLATFORM_AUTO
+};
@@ -0,0 +1,210 @@
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <climits>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "gbromimage.h"
+
+std::map<std::string, GBRomImage*> GBRomImage::s_images;
+std::mutex GBRomImage::s_imagesMutex;
+
+GBRomImage::GBRomImage(const std::string& path){
+    m_data = NULL;
+    m_length = 0;
+    m_bMapped = false;
+    m_refCount = 0;
+    m_path = path;
+
+#ifdef _WIN32
+    m_fileHandle = INVALID_HANDLE_VALUE;
+    m_mappingHandle = NULL;
+#endif
+}
+
+GBRomImage::~GBRomImage(){
+    if(m_data == NULL){
+        return;
+    }
+
+    if(m_bMapped){
+#ifdef _WIN32
+        UnmapViewOfFile(m_data);
+        CloseHandle((HANDLE)m_mappingHandle);
+        CloseHandle((HANDLE)m_fileHandle);
+#else
+        munmap(m_data, m_length);
+#endif
+    } else {
+        delete[] m_data;
+    }
+}
+
+GBRomImage* GBRomImage::acquire(const char* filename){
+    //Key on the full path, so different relative paths to the same rom share an image
+    std::string path = filename;
+#ifdef _WIN32
+    char fullPath[_MAX_PATH];
+    if(_fullpath(fullPath, filename, _MAX_PATH) != NULL){
+        path = fullPath;
+    }
+#else
+    char fullPath[PATH_MAX];
+    if(realpath(filename, fullPath) != NULL){
+        path = fullPath;
+    }
+#endif
+
+    std::lock_guard<std::mutex> lock(s_imagesMutex);
+
+    std::map<std::string, GBRomImage*>::iterator existing = s_images.find(path);
+    if(existing != s_images.end()){
+        if(CONSOLE_OUTPUT_ENABLED) std::cout << "Sharing already loaded rom image " << path << std::endl;
+        existing->second->m_refCount++;
+        return existing->second;
+    }
+
+    GBRomImage* image = new GBRomImage(path);
+    if(!image->load()){
+        delete image;
+        return NULL;
+    }
+
+    image->m_refCount = 1;
+    s_images[path] = image;
+    return image;
+}
+
+void GBRomImage::release(GBRomImage* image){
+    if(image == NULL){
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(s_imagesMutex);
+
+    image->m_refCount--;
+    if(image->m_refCount > 0){
+        return;
+    }
+
+    s_images.erase(image->m_path);
+    delete image;
+}
+
+uint8_t* GBRomImage::getData(){
+    return m_data;
+}
+
+uint32_t GBRomImage::getLength(){
+    return m_length;
+}
+
+bool GBRomImage::load(){
+    std::ifstream rom (m_path.c_str(), std::ios_base::binary);
+    if(!rom.is_open()){
+        return false;
+    }
+
+    rom.seekg(0, std::ios_base::end);
+    std::streamsize size = rom.tellg();
+    rom.close();
+
+    if(size <= 0 || size > UINT32_MAX){
+        return false;
+    }
+
+    if(CONSOLE_OUTPUT_ENABLED) std::cout << "Size of cartridge: " << size << std::endl;
+
+    //Banks past the end of the file must read as something, so only whole-bank files can be used as is
+    if((size >= ROM_IMAGE_BANK_SIZE * 2) && (size % ROM_IMAGE_BANK_SIZE == 0) && map((uint32_t)size)){
+        if(CONSOLE_OUTPUT_ENABLED) std::cout << "Mapped cart into memory" << std::endl;
+        return true;
+    }
+
+    return copy((uint32_t)size);
+}
+
+//Maps the file read-only
+bool GBRomImage::map(uint32_t length){
+#ifdef _WIN32
+    HANDLE file = CreateFileA(m_path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE){
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(mapping == NULL){
+        CloseHandle(file);
+        return false;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, length);
+    if(data == NULL){
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_fileHandle = file;
+    m_mappingHandle = mapping;
+#else
+    int file = open(m_path.c_str(), O_RDONLY);
+    if(file < 0){
+        return false;
+    }
+
+    void* data = mmap(NULL, length, PROT_READ, MAP_SHARED, file, 0);
+
+    //Mapping stays valid after the descriptor is closed
+    close(file);
+
+    if(data == MAP_FAILED){
+        return false;
+    }
+#endif
+
+    m_data = (uint8_t*)data;
+    m_length = length;
+    m_bMapped = true;
+    return true;
+}
+
+//Reads the file into a buffer padded with zeroes up to a whole number of banks
+bool GBRomImage::copy(uint32_t length){
+    uint32_t paddedLength = ((length + ROM_IMAGE_BANK_SIZE - 1) / ROM_IMAGE_BANK_SIZE) * ROM_IMAGE_BANK_SIZE;
+    if(paddedLength < ROM_IMAGE_BANK_SIZE * 2){
+        paddedLength = ROM_IMAGE_BANK_SIZE * 2;
+    }
+
+    std::ifstream rom (m_path.c_str(), std::ios_base::binary);
+    if(!rom.is_open()){
+        return false;
+    }
+
+    uint8_t* data = new uint8_t[paddedLength];
+    memset(data, 0, paddedLength);
+
+    rom.read((char*)data, length);
+
+    if(CONSOLE_OUTPUT_ENABLED) std::cout << "Finished reading cart into cart buffer" << std::endl;
+
+    std::streamsize readBytes = rom.gcount();
+    if(readBytes != length){
+        std::cout << "WARNING - only " << readBytes << " read!" << std::endl;
+    }
+
+    rom.close();
+
+    m_data = data;
+    m_length = paddedLength;
+    m_bMapped = false;
+    return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+#include <map>
+#include <mutex>
+#include "../constants.h"
+
+//Size of a rom bank. Images are always a whole number of banks, and at least two.
+#define ROM_IMAGE_BANK_SIZE 0x4000
+
+//Read-only rom file contents, shared by every cart in the process that loads the same file.
+//Files are memory mapped where possible, so the OS page cache is shared between processes too.
+//Files that aren't a whole number of banks are copied into a padded buffer instead, so reads never run off the end.
+class GBRomImage{
+    private:
+        uint8_t* m_data;
+        uint32_t m_length;
+        bool m_bMapped;
+
+        //Carts using the image
+        int m_refCount;
+
+        //Key in the registry, the full path of the file
+        std::string m_path;
+
+#ifdef _WIN32
+        void* m_fileHandle;
+        void* m_mappingHandle;
+#endif
+
+        //Images currently loaded, keyed by full path
+        static std::map<std::string, GBRomImage*> s_images;
+        static std::mutex s_imagesMutex;
+
+        GBRomImage(const std::string& path);
+        ~GBRomImage();
+
+        bool load();
+        bool map(uint32_t length);
+        bool copy(uint32_t length);
+
+    public:
+        //Gets the image for a rom file, loading it if no other cart has it open. Returns NULL if the file can't be read.
+        static GBRomImage* acquire(const char* filename);
+
+        //Drops a cart's reference to an image. The image is unloaded once nothing uses it.
+        static void release(GBRomImage* image);
+
+        //Rom contents. Must not be written to.
+        uint8_t* getData();
+        uint32_t getLength();
+};
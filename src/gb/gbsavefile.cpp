@@ -0,0 +1,275 @@
+#include <iostream>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "gbsavefile.h"
+
+GBSaveFile::GBSaveFile(const char* fileName, uint32_t length){
+    m_fileName = fileName;
+    m_journalName = m_fileName + ".journal";
+    m_length = length;
+    m_pageCount = (length + SAVE_PAGE_SIZE - 1) / SAVE_PAGE_SIZE;
+
+    m_dirtyPages = new bool[m_pageCount];
+    memset(m_dirtyPages, 0, m_pageCount * sizeof(bool));
+    m_bDirty = false;
+    m_lastFlush = std::chrono::steady_clock::now();
+
+    //Pending and saved copies are whole pages, so the last page can always be copied in full
+    m_pendingData = new uint8_t[m_pageCount * SAVE_PAGE_SIZE];
+    memset(m_pendingData, 0xFF, m_pageCount * SAVE_PAGE_SIZE);
+    m_pendingPages = new bool[m_pageCount];
+    memset(m_pendingPages, 0, m_pageCount * sizeof(bool));
+    m_bPending = false;
+    m_bStop = false;
+    m_thread = NULL;
+
+    m_savedData = new uint8_t[m_pageCount * SAVE_PAGE_SIZE];
+    memset(m_savedData, 0xFF, m_pageCount * SAVE_PAGE_SIZE);
+    m_journal = NULL;
+    m_journalRecords = 0;
+}
+
+GBSaveFile::~GBSaveFile(){
+    if(m_thread != NULL){
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_bStop = true;
+        }
+        m_condition.notify_one();
+        m_thread->join();
+        delete m_thread;
+    }
+
+    if(m_journal != NULL){
+        fclose(m_journal);
+    }
+
+    delete[] m_dirtyPages;
+    delete[] m_pendingData;
+    delete[] m_pendingPages;
+    delete[] m_savedData;
+}
+
+void GBSaveFile::load(uint8_t* ram){
+    uint32_t replayed = replayJournal(ram);
+    memcpy(m_savedData, ram, m_length);
+
+    //Fold a journal left by a crash into the save file. Either way start with an empty journal, so a torn record can't hide new ones.
+    if(replayed > 0){
+        std::cout << "Recovered " << replayed << " cart ram pages from " << m_journalName << std::endl;
+        compact();
+    } else {
+        openJournal(true);
+    }
+
+    m_thread = new std::thread(&GBSaveFile::threadLoop, this);
+}
+
+void GBSaveFile::flush(uint8_t* ram, bool force){
+    if(!m_bDirty){
+        return;
+    }
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if(!force && (now - m_lastFlush) < std::chrono::milliseconds(SAVE_FLUSH_INTERVAL_MS)){
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for(uint32_t page = 0; page < m_pageCount; page++){
+            if(m_dirtyPages[page]){
+                uint32_t start = page * SAVE_PAGE_SIZE;
+                uint32_t size = (start + SAVE_PAGE_SIZE > m_length) ? (m_length - start) : SAVE_PAGE_SIZE;
+                memcpy(&m_pendingData[start], &ram[start], size);
+                m_pendingPages[page] = true;
+                m_dirtyPages[page] = false;
+            }
+        }
+        m_bPending = true;
+    }
+    m_condition.notify_one();
+
+    m_bDirty = false;
+    m_lastFlush = now;
+}
+
+void GBSaveFile::close(uint8_t* ram){
+    if(m_thread == NULL){
+        return;
+    }
+
+    flush(ram, true);
+
+    //Save thread writes anything still pending before it stops
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_bStop = true;
+    }
+    m_condition.notify_one();
+    m_thread->join();
+    delete m_thread;
+    m_thread = NULL;
+
+    //Leave a plain save file behind for other emulators
+    if(compact()){
+        fclose(m_journal);
+        m_journal = NULL;
+        std::remove(m_journalName.c_str());
+    }
+}
+
+void GBSaveFile::threadLoop(){
+    bool* pages = new bool[m_pageCount];
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(true){
+        m_condition.wait(lock, [this]{ return m_bPending || m_bStop; });
+
+        if(!m_bPending){
+            break;
+        }
+
+        //Take the pending pages, then write them without holding the lock
+        for(uint32_t page = 0; page < m_pageCount; page++){
+            pages[page] = m_pendingPages[page];
+            if(pages[page]){
+                memcpy(&m_savedData[page * SAVE_PAGE_SIZE], &m_pendingData[page * SAVE_PAGE_SIZE], SAVE_PAGE_SIZE);
+                m_pendingPages[page] = false;
+            }
+        }
+        m_bPending = false;
+
+        lock.unlock();
+        writePages(pages);
+        lock.lock();
+    }
+
+    delete[] pages;
+}
+
+//Appends a record for each page to the journal. Records are the page index, the page, and a checksum of both.
+void GBSaveFile::writePages(bool* pages){
+    if(m_journal == NULL){
+        return;
+    }
+
+    for(uint32_t page = 0; page < m_pageCount; page++){
+        if(!pages[page]){
+            continue;
+        }
+
+        uint8_t* data = &m_savedData[page * SAVE_PAGE_SIZE];
+        uint32_t sum = checksum(page, data);
+        fwrite(&page, sizeof(page), 1, m_journal);
+        fwrite(data, SAVE_PAGE_SIZE, 1, m_journal);
+        fwrite(&sum, sizeof(sum), 1, m_journal);
+        m_journalRecords++;
+    }
+
+    syncFile(m_journal);
+
+    if(m_journalRecords >= m_pageCount * SAVE_JOURNAL_COMPACT_RATIO){
+        compact();
+    }
+}
+
+//Writes the saved data to a new file and renames it over the save file, then empties the journal
+bool GBSaveFile::compact(){
+    std::string tempName = m_fileName + ".tmp";
+    FILE* file = fopen(tempName.c_str(), "wb");
+    if(file == NULL){
+        std::cout << "Failed to save file" << std::endl;
+        return false;
+    }
+
+    bool bWritten = (fwrite(m_savedData, 1, m_length, file) == m_length);
+    syncFile(file);
+    fclose(file);
+
+#ifdef _WIN32
+    bWritten = bWritten && MoveFileExA(tempName.c_str(), m_fileName.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+    bWritten = bWritten && (rename(tempName.c_str(), m_fileName.c_str()) == 0);
+#endif
+
+    //Journal is still needed if the save file couldn't be replaced
+    if(!bWritten){
+        std::cout << "Failed to save file" << std::endl;
+        std::remove(tempName.c_str());
+        return false;
+    }
+
+    return openJournal(true);
+}
+
+bool GBSaveFile::openJournal(bool truncate){
+    if(m_journal != NULL){
+        fclose(m_journal);
+    }
+
+    m_journal = fopen(m_journalName.c_str(), truncate ? "wb" : "ab");
+    m_journalRecords = 0;
+
+    if(m_journal == NULL){
+        std::cout << "Failed to open save journal " << m_journalName << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+//Applies journal records to ram. Stops at the first incomplete or corrupt record, which is where an earlier run stopped writing.
+uint32_t GBSaveFile::replayJournal(uint8_t* ram){
+    FILE* journal = fopen(m_journalName.c_str(), "rb");
+    if(journal == NULL){
+        return 0;
+    }
+
+    uint8_t data[SAVE_PAGE_SIZE];
+    uint32_t page = 0;
+    uint32_t sum = 0;
+    uint32_t replayed = 0;
+    while((fread(&page, sizeof(page), 1, journal) == 1) && (fread(data, SAVE_PAGE_SIZE, 1, journal) == 1) && (fread(&sum, sizeof(sum), 1, journal) == 1)){
+        if((page >= m_pageCount) || (sum != checksum(page, data))){
+            break;
+        }
+
+        uint32_t start = page * SAVE_PAGE_SIZE;
+        uint32_t size = (start + SAVE_PAGE_SIZE > m_length) ? (m_length - start) : SAVE_PAGE_SIZE;
+        memcpy(&ram[start], data, size);
+        replayed++;
+    }
+
+    fclose(journal);
+    return replayed;
+}
+
+//FNV-1a over the page index and contents
+uint32_t GBSaveFile::checksum(uint32_t page, const uint8_t* data){
+    uint32_t hash = 2166136261u;
+    for(int i = 0; i < 4; i++){
+        hash = (hash ^ ((page >> (i * 8)) & 0xFF)) * 16777619u;
+    }
+    for(int i = 0; i < SAVE_PAGE_SIZE; i++){
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+//Pushes a file's writes through to disk
+void GBSaveFile::syncFile(FILE* file){
+    fflush(file);
+#ifdef _WIN32
+    _commit(_fileno(file));
+#else
+    fsync(fileno(file));
+#endif
+}
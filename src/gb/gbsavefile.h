@@ -0,0 +1,82 @@
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "../constants.h"
+
+//Size of the blocks cart ram is tracked and saved in
+#define SAVE_PAGE_SIZE 0x100
+
+//Minimum time between handing written pages to the save thread
+#define SAVE_FLUSH_INTERVAL_MS 1000
+
+//Journal is folded back into the save file once it holds this many times the pages in cart ram
+#define SAVE_JOURNAL_COMPACT_RATIO 4
+
+//Battery save file that is kept up to date while the game runs.
+//Cart ram pages written by the game are handed to a background thread, which appends them to a journal next to the save file.
+//The journal is replayed over the save file on load, and folded back into it by writing a new file and renaming it over the old one.
+//A crash loses at most the last flush interval, and the emulation thread only ever copies the pages that changed.
+class GBSaveFile{
+    private:
+        std::string m_fileName;
+        std::string m_journalName;
+        uint32_t m_length;
+        uint32_t m_pageCount;
+
+        //Pages written since the last flush. Emulation thread only.
+        bool* m_dirtyPages;
+        bool m_bDirty;
+        std::chrono::steady_clock::time_point m_lastFlush;
+
+        //Pages waiting for the save thread, guarded by m_mutex
+        uint8_t* m_pendingData;
+        bool* m_pendingPages;
+        bool m_bPending;
+        bool m_bStop;
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        std::thread* m_thread;
+
+        //Contents of the save file with the journal applied. Save thread only once it is running.
+        uint8_t* m_savedData;
+        FILE* m_journal;
+        uint32_t m_journalRecords;
+
+        void threadLoop();
+        void writePages(bool* pages);
+        bool compact();
+        bool openJournal(bool truncate);
+        uint32_t replayJournal(uint8_t* ram);
+        static uint32_t checksum(uint32_t page, const uint8_t* data);
+        static void syncFile(FILE* file);
+
+    public:
+        GBSaveFile(const char* fileName, uint32_t length);
+        ~GBSaveFile();
+
+        //Applies any journal left by an earlier run to ram, which should already hold the save file, then starts the save thread
+        void load(uint8_t* ram);
+
+        //Records a write to cart ram, as an offset from the start of cart ram. Offsets past the end of cart ram are ignored.
+        void markDirty(uint32_t offset){
+            if(offset >= m_length){
+                return;
+            }
+
+            m_dirtyPages[offset / SAVE_PAGE_SIZE] = true;
+            m_bDirty = true;
+        }
+
+        //Hands pages written since the last flush to the save thread, if the flush interval has passed.
+        //Called regularly from the emulation thread.
+        void flush(uint8_t* ram, bool force = false);
+
+        //Flushes everything, stops the save thread and rewrites the save file without a journal
+        void close(uint8_t* ram);
+};
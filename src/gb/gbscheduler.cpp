@@ -0,0 +1,130 @@
+#include "gbscheduler.h"
+#include "gbmem.h"
+#include "gblcd.h"
+#include "gbaudio.h"
+
+GBScheduler::GBScheduler(GBMem* memory, GBLCD* lcd, GBAudio* audio){
+    m_gbmemory = memory;
+    m_gblcd = lcd;
+    m_gbaudio = audio;
+
+    m_cycles = 0;
+
+    //Nothing is queued yet. Schedule everything on the first tick, once all components have been set up.
+    m_nextDeadline = 0;
+    for(int event = 0; event < EVENT_COUNT; event++){
+        m_lastSync[event] = 0;
+        m_generation[event] = 0;
+        m_bReschedule[event] = true;
+    }
+}
+
+void GBScheduler::sync(SchedulerEvent event){
+    uint64_t elapsed = m_cycles - m_lastSync[event];
+    m_lastSync[event] = m_cycles;
+
+    if(elapsed == 0){
+        return;
+    }
+
+    switch(event){
+        case EVENT_LCD:
+            //LCD is unaffected by double speed mode, so need to cut length in half if necessary.
+            m_gblcd->tick(elapsed / (m_gbmemory->getDoubleSpeedMode() ? 2 : 1));
+            break;
+        case EVENT_TIMER:
+            m_gbmemory->getTimer()->tick(elapsed);
+            break;
+        case EVENT_AUDIO:
+            //Audio is unaffected by double speed mode, so need to cut length in half if necessary
+            m_gbaudio->tick(elapsed / (m_gbmemory->getDoubleSpeedMode() ? 2 : 1));
+            break;
+        default:
+            break;
+    }
+}
+
+void GBScheduler::syncAll(){
+    for(int event = 0; event < EVENT_COUNT; event++){
+        sync((SchedulerEvent)event);
+    }
+}
+
+uint64_t GBScheduler::getCycles(){
+    return m_cycles;
+}
+
+uint64_t GBScheduler::getCyclesUntilNextEvent(){
+    return (m_nextDeadline > m_cycles) ? (m_nextDeadline - m_cycles) : 0;
+}
+
+void GBScheduler::reschedule(SchedulerEvent event){
+    //Stale entries are skipped when they reach the top of the queue
+    m_generation[event]++;
+    m_bReschedule[event] = true;
+    m_nextDeadline = m_cycles;
+}
+
+void GBScheduler::schedule(SchedulerEvent event){
+    long long remaining = -1;
+
+    switch(event){
+        case EVENT_LCD:
+            remaining = m_gblcd->getCyclesUntilModeChange() * (m_gbmemory->getDoubleSpeedMode() ? 2 : 1);
+            break;
+        case EVENT_TIMER:
+            remaining = m_gbmemory->getTimer()->getCyclesUntilInterrupt();
+            break;
+        default:
+            break;
+    }
+
+    //Nothing due until the component is rescheduled
+    if(remaining < 0){
+        return;
+    }
+
+    ScheduledEvent next;
+    next.deadline = m_lastSync[event] + remaining;
+    next.event = event;
+    next.generation = ++m_generation[event];
+    m_events.push(next);
+}
+
+void GBScheduler::run_events(){
+    //Events synced since the last tick need a fresh deadline
+    for(int event = 0; event < EVENT_COUNT; event++){
+        if(m_bReschedule[event]){
+            m_bReschedule[event] = false;
+            sync((SchedulerEvent)event);
+            schedule((SchedulerEvent)event);
+        }
+    }
+
+    while(!m_events.empty()){
+        ScheduledEvent next = m_events.top();
+
+        //Skip entries that were replaced by a sync
+        if(next.generation != m_generation[next.event]){
+            m_events.pop();
+            continue;
+        }
+
+        if(next.deadline > m_cycles){
+            break;
+        }
+
+        m_events.pop();
+        sync(next.event);
+        schedule(next.event);
+    }
+
+    m_nextDeadline = m_events.empty() ? UINT64_MAX : m_events.top().deadline;
+
+    //A component may have rescheduled another while it ran
+    for(int event = 0; event < EVENT_COUNT; event++){
+        if(m_bReschedule[event]){
+            m_nextDeadline = m_cycles;
+        }
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include <queue>
+#include <vector>
+#include "../constants.h"
+
+class GBMem;
+class GBLCD;
+class GBAudio;
+
+//Hardware that runs on its own clock. Each has at most one live event in the queue.
+//Components only get an event when something has to happen on time. Otherwise they stay behind the CPU
+//and are synced when their registers are accessed.
+//HDMA runs as part of the LCD HBlank and serial transfers complete instantly, so neither needs its own event.
+enum SchedulerEvent {
+    EVENT_LCD = 0,   //LCD mode change. Lines are rendered and LCD interrupts raised as modes change.
+    EVENT_TIMER = 1, //TIMA overflow, which raises the timer interrupt. DIV and TIMA catch up when accessed.
+    EVENT_AUDIO = 2, //Never queued. Audio catches up when its registers are written and at the end of every CPU tick.
+    EVENT_COUNT
+};
+
+struct ScheduledEvent {
+    uint64_t deadline;
+    SchedulerEvent event;
+
+    //Compared against the event's current generation to skip entries that were replaced
+    uint32_t generation;
+
+    bool operator>(const ScheduledEvent& other) const {
+        return deadline > other.deadline;
+    }
+};
+
+//Keeps the LCD, timer and audio behind the CPU and only runs them when they have something to do.
+//Each component is told how many clock cycles have passed since it last ran, so it ends up in the same
+//state as if it had been ticked after every instruction.
+class GBScheduler{
+    private:
+        //Clock cycles since power on
+        uint64_t m_cycles;
+
+        //Earliest deadline in the queue. Cached so tick only has to do a compare.
+        uint64_t m_nextDeadline;
+
+        GBMem* m_gbmemory;
+        GBLCD* m_gblcd;
+        GBAudio* m_gbaudio;
+
+        //Cycle count each component was last brought up to date at
+        uint64_t m_lastSync[EVENT_COUNT];
+
+        uint32_t m_generation[EVENT_COUNT];
+
+        //Events that need a new deadline, worked out on the next tick
+        bool m_bReschedule[EVENT_COUNT];
+
+        //Min-heap of pending events, ordered by deadline
+        std::priority_queue<ScheduledEvent, std::vector<ScheduledEvent>, std::greater<ScheduledEvent> > m_events;
+
+        //Queues the next deadline for an event
+        void schedule(SchedulerEvent event);
+
+        //Runs due events and updates the next deadline
+        void run_events();
+
+    public:
+        GBScheduler(GBMem* memory, GBLCD* lcd, GBAudio* audio);
+
+        //Advances the master clock by the given number of CPU cycles. Called for every instruction, so kept inline.
+        void tick(long long cycles){
+            m_cycles += cycles;
+            
+            if(m_cycles >= m_nextDeadline){
+                run_events();
+            }
+        }
+
+        //Brings a component up to the current cycle. Must be called before reading or changing its state.
+        void sync(SchedulerEvent event);
+
+        //Brings every component up to the current cycle
+        void syncAll();
+
+        //Gets the number of CPU cycles since power on
+        uint64_t getCycles();
+
+        //Gets the number of CPU cycles until the next event is due. Nothing can raise an interrupt before then.
+        uint64_t getCyclesUntilNextEvent();
+
+        //Drops the queued deadline for a component. Must be called after changing state its timing depends on.
+        void reschedule(SchedulerEvent event);
+};
@@ -0,0 +1,156 @@
+#include <iostream>
+#include "gbtimer.h"
+#include "gbmem.h"
+
+GBTimer::GBTimer(GBMem* mem){
+    m_gbmemory = mem;
+
+    m_cycles = 0;
+    m_registerDIV = 0;
+    m_divStartCycle = 0;
+    m_registerTIMA = 0;
+    m_timaStartCycle = 0;
+    m_registerTMA = 0;
+    m_registerTAC = 0;
+}
+
+void GBTimer::tick(long long hz){
+    m_cycles += hz;
+
+    update();
+    updateMemory();
+}
+
+uint8_t GBTimer::read(uint16_t address){
+    switch(address){
+        case ADDRESS_DIV:
+            return m_registerDIV;
+        case ADDRESS_TIMA:
+            return m_registerTIMA;
+        case ADDRESS_TMA:
+            return m_registerTMA;
+        case ADDRESS_TAC:
+            return m_registerTAC;
+        default:
+            return 0xFF;
+    }
+}
+
+void GBTimer::write(uint16_t address, uint8_t value){
+    update();
+
+    switch(address){
+        case ADDRESS_DIV:
+            //Writing to the DIV register resets it
+            m_registerDIV = 0;
+            break;
+        case ADDRESS_TIMA:
+            m_registerTIMA = value;
+            break;
+        case ADDRESS_TMA:
+            m_registerTMA = value;
+            break;
+        case ADDRESS_TAC:
+            //TIMA starts counting from nothing when the timer is turned on
+            if(!(m_registerTAC & TAC_ENABLE)){
+                m_timaStartCycle = m_cycles;
+            }
+
+            m_registerTAC = value;
+            break;
+        default:
+            break;
+    }
+
+    updateMemory();
+}
+
+//Gets the number of clock cycles tick needs before TIMA overflows, or -1 if the timer is stopped
+long long GBTimer::getCyclesUntilInterrupt(){
+    if(!(m_registerTAC & TAC_ENABLE)){
+        return -1;
+    }
+
+    //TIMA overflows on the increment after it reaches 0xFF
+    uint64_t overflowCycle = m_timaStartCycle + (0x100 - m_registerTIMA) * (uint64_t)getTIMAClock();
+    return overflowCycle - m_cycles;
+}
+
+//Gets the number of clock cycles tick needs before DIV or TIMA next changes, or -1 if it won't change
+long long GBTimer::getCyclesUntilChange(uint16_t address){
+    switch(address){
+        case ADDRESS_DIV:
+            return m_divStartCycle + DIV_INCREMENT_CLOCK - m_cycles;
+        case ADDRESS_TIMA:
+            if(!(m_registerTAC & TAC_ENABLE)){
+                return -1;
+            }
+            return m_timaStartCycle + getTIMAClock() - m_cycles;
+        default:
+            return -1;
+    }
+}
+
+//Gets the number of clock cycles between TIMA increments for the current TAC setting
+int GBTimer::getTIMAClock(){
+    int TAC_Clock = 0;
+    uint8_t TAC_ClockSelect = m_registerTAC & TAC_CLOCK_SELECT;
+    switch (TAC_ClockSelect) {
+    case TAC_CLOCK_4096:
+        TAC_Clock = 1024;
+        break;
+    case TAC_CLOCK_262144:
+        TAC_Clock = 16;
+        break;
+    case TAC_CLOCK_65536:
+        TAC_Clock = 64;
+        break;
+    case TAC_CLOCK_16384:
+        TAC_Clock = 256;
+        break;
+    default:
+        if (CONSOLE_OUTPUT_ENABLED) std::cout << "Invalid TAC Clock select " << TAC_ClockSelect << std::endl;
+        break;
+    }
+
+    return TAC_Clock;
+}
+
+void GBTimer::update(){
+    //DIV always counts
+    uint64_t divIncrements = (m_cycles - m_divStartCycle) / DIV_INCREMENT_CLOCK;
+    m_registerDIV = (uint8_t)(m_registerDIV + divIncrements);
+    m_divStartCycle += divIncrements * DIV_INCREMENT_CLOCK;
+
+    //Only increment TIMA if timer is enabled. Partial increments are lost while it's off.
+    if(!(m_registerTAC & TAC_ENABLE)){
+        m_timaStartCycle = m_cycles;
+        return;
+    }
+
+    uint64_t TAC_Clock = getTIMAClock();
+    uint64_t timaIncrements = (m_cycles - m_timaStartCycle) / TAC_Clock;
+    m_timaStartCycle += timaIncrements * TAC_Clock;
+
+    uint64_t incrementsToOverflow = 0x100 - m_registerTIMA;
+    if(timaIncrements < incrementsToOverflow){
+        m_registerTIMA += timaIncrements;
+        return;
+    }
+
+    //TIMA is set to TMA on every overflow
+    timaIncrements -= incrementsToOverflow;
+    m_registerTIMA = m_registerTMA + (timaIncrements % (0x100 - m_registerTMA));
+
+    if (CONSOLE_OUTPUT_ENABLED) std::cout << "TIMA register rolled over. Setting interrupt flag" << std::endl;
+
+    //Set the timer interrupt flag
+    m_gbmemory->direct_write(ADDRESS_IF, m_gbmemory->direct_read(ADDRESS_IF) | INTERRUPT_FLAG_TIMER);
+}
+
+void GBTimer::updateMemory(){
+    m_gbmemory->direct_write(ADDRESS_DIV, m_registerDIV);
+    m_gbmemory->direct_write(ADDRESS_TIMA, m_registerTIMA);
+    m_gbmemory->direct_write(ADDRESS_TMA, m_registerTMA);
+    m_gbmemory->direct_write(ADDRESS_TAC, m_registerTAC);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include "../constants.h"
+
+#define DIV_INCREMENT_CLOCK 16384 //Increment speed of DIV register
+//TIMA Increment speeds in Hz.
+#define TAC_CLOCK_4096   0x00
+#define TAC_CLOCK_262144 0x01
+#define TAC_CLOCK_65536  0x02
+#define TAC_CLOCK_16384  0x03
+
+#define TAC_ENABLE 0x04
+#define TAC_CLOCK_SELECT 0x03
+
+class GBMem;
+
+//DIV and TIMA timer registers.
+//Register values aren't stepped one increment at a time. They are worked out from how many clock cycles
+//have passed since they last changed, so ticking and reading are constant time however far behind the timer is.
+class GBTimer{
+    private:
+        GBMem* m_gbmemory;
+
+        //Clock cycles the timer has been ticked for
+        uint64_t m_cycles;
+
+        //Register values as of the start cycles below.
+        //Start cycles keep any partial increment, so writing DIV or changing the TIMA clock doesn't lose time.
+        uint8_t m_registerDIV;
+        uint64_t m_divStartCycle;
+        uint8_t m_registerTIMA;
+        uint64_t m_timaStartCycle;
+
+        uint8_t m_registerTMA;
+        uint8_t m_registerTAC;
+
+        //Gets the number of clock cycles between TIMA increments for the current TAC setting
+        int getTIMAClock();
+
+        //Brings the stored DIV and TIMA values up to the current cycle. Raises the timer interrupt if TIMA overflowed.
+        void update();
+
+        //Copies the registers into memory so direct reads see them
+        void updateMemory();
+
+    public:
+        GBTimer(GBMem* mem);
+
+        //Advances the timer by the given number of clock cycles
+        void tick(long long hz);
+
+        uint8_t read(uint16_t address);
+        void write(uint16_t address, uint8_t value);
+
+        //Gets the number of clock cycles tick needs before TIMA overflows, or -1 if the timer is stopped
+        long long getCyclesUntilInterrupt();
+
+        //Gets the number of clock cycles tick needs before DIV or TIMA next changes, or -1 if it won't change
+        long long getCyclesUntilChange(uint16_t address);
+};
@@ -1,20 +1,79 @@
 #include <iostream>
+#include <new>
 #include "gbz80cpu.h"
 #include "opcodes.h"
 #include "opcycles.h"
 #include "gbmem.h"
 #include "gblcd.h"
+#include "gbjit.h"
 #include "bytehelpers.h"
 
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
 GBZ80::GBZ80(GBMem* memory, GBLCD* lcd, GBAudio* audio){
     m_gbmemory = memory;
     m_gblcd = lcd;
     m_gbaudio = audio;
     m_bSingleStep = SINGLE_STEP;
+    m_hot.currentBlock = NULL;
+    m_hot.currentBlockIndex = 0;
+    m_hot.currentBlockMapVersion = 0;
+    m_hot.operand = 0;
+    m_hot.cycles = 0;
+    m_timeRollover = 0;
+    m_bIdleLoopSkip = USE_IDLE_LOOP_DETECTION;
+    m_idleLoopBlock = NULL;
+    m_idleLoopArrival = 0;
+    m_idleLoopValue = 0;
+    
+    //Only allocate the code cache in builds that can use it
+#if USE_JIT && JIT_SUPPORTED
+    m_jit = new GBJit(this);
+#else
+    m_jit = NULL;
+#endif
+    m_jitCyclesTicked = 0;
+    
+    m_scheduler = new GBScheduler(memory, lcd, audio);
+    m_gbmemory->setScheduler(m_scheduler);
+    
     init();
 }
 
 GBZ80::~GBZ80(){
+    clear_block_cache();
+    delete m_jit;
+    
+    m_gbmemory->setScheduler(NULL);
+    delete m_scheduler;
+}
+
+//GBZ80 is over-aligned for the hot state, which plain new doesn't honour before C++17
+void* GBZ80::operator new(size_t size){
+    void* pointer = NULL;
+#ifdef _WIN32
+    pointer = _aligned_malloc(size, alignof(GBZ80));
+#else
+    if(posix_memalign(&pointer, alignof(GBZ80), size) != 0){
+        pointer = NULL;
+    }
+#endif
+    
+    if(pointer == NULL){
+        throw std::bad_alloc();
+    }
+    
+    return pointer;
+}
+
+void GBZ80::operator delete(void* pointer){
+#ifdef _WIN32
+    _aligned_free(pointer);
+#else
+    free(pointer);
+#endif
 }
 
 void GBZ80::init(){
@@ -23,54 +82,59 @@ void GBZ80::init(){
     //Set clock speed
     m_Clock = CLOCK_GB;
     
-    m_bInterruptsEnabled = false;
-    m_bInterruptsEnabledNext = false;
-    m_bHalt = false;
-    m_bStop = false;
+    m_hot.bInterruptsEnabled = false;
+    m_hot.bInterruptsEnabledNext = false;
+    m_hot.bHalt = false;
+    m_hot.bStop = false;
+    
+    m_hot.lazyFlagsOp = LAZY_FLAGS_NONE;
+    m_hot.lazyFlagsOperand1 = 0;
+    m_hot.lazyFlagsOperand2 = 0;
+    m_hot.lazyFlagsCarry = 0;
     
     //If we have a boot rom loaded and enabled, don't worry about manually setting memory
     if(m_gbmemory->getBootRomEnabled()){
         std::cout << "Boot rom is enabled." << std::endl;
-        AF = 0x0000;
-        BC = 0x0000;
-        DE = 0x0000;
-        HL = 0x0000;
-        SP = 0x0000;
-        PC = 0x00;
+        m_hot.AF = 0x0000;
+        m_hot.BC = 0x0000;
+        m_hot.DE = 0x0000;
+        m_hot.HL = 0x0000;
+        m_hot.SP = 0x0000;
+        m_hot.PC = 0x00;
         return;
     } 
     
     std::cout << "No boot rom. Using predetermined init values" << std::endl;
     
     //Startup values from pandoc
-    AF = 0x01B0;
-    BC = 0x0013;
-    DE = 0x00D8;
-    HL = 0x014D;
-    SP = 0xFFFE;
-    PC = 0x100;
-    
-    m_gbmemory->write(0xFF05, 0x00);
-    m_gbmemory->write(0xFF06, 0x00);
-    m_gbmemory->write(0xFF07, 0x00);
-    m_gbmemory->write(0xFF10, 0x80);
-    m_gbmemory->write(0xFF11, 0xBF);
-    m_gbmemory->write(0xFF12, 0xF3);
-    m_gbmemory->write(0xFF14, 0xBF);
-    m_gbmemory->write(0xFF16, 0x3F);
-    m_gbmemory->write(0xFF17, 0x00);
-    m_gbmemory->write(0xFF1A, 0x7F);
-    m_gbmemory->write(0xFF1B, 0xFF);
-    m_gbmemory->write(0xFF1C, 0x9F);
-    m_gbmemory->write(0xFF1E, 0xFB);
-    m_gbmemory->write(0xFF20, 0xFF);
-    m_gbmemory->write(0xFF21, 0x00);
-    m_gbmemory->write(0xFF22, 0x00);
-    m_gbmemory->write(0xFF23, 0xBF);
-    m_gbmemory->write(0xFF24, 0x77);
-    m_gbmemory->write(0xFF25, 0xF3);
-    m_gbmemory->write(0xFF26, 0xF1); //0xF0 for super gameboy
-    m_gbmemory->write(0xFFFF, 0x00);
+    m_hot.AF = 0x01B0;
+    m_hot.BC = 0x0013;
+    m_hot.DE = 0x00D8;
+    m_hot.HL = 0x014D;
+    m_hot.SP = 0xFFFE;
+    m_hot.PC = 0x100;
+    
+    writeMemory(0xFF05, 0x00);
+    writeMemory(0xFF06, 0x00);
+    writeMemory(0xFF07, 0x00);
+    writeMemory(0xFF10, 0x80);
+    writeMemory(0xFF11, 0xBF);
+    writeMemory(0xFF12, 0xF3);
+    writeMemory(0xFF14, 0xBF);
+    writeMemory(0xFF16, 0x3F);
+    writeMemory(0xFF17, 0x00);
+    writeMemory(0xFF1A, 0x7F);
+    writeMemory(0xFF1B, 0xFF);
+    writeMemory(0xFF1C, 0x9F);
+    writeMemory(0xFF1E, 0xFB);
+    writeMemory(0xFF20, 0xFF);
+    writeMemory(0xFF21, 0x00);
+    writeMemory(0xFF22, 0x00);
+    writeMemory(0xFF23, 0xBF);
+    writeMemory(0xFF24, 0x77);
+    writeMemory(0xFF25, 0xF3);
+    writeMemory(0xFF26, 0xF1); //0xF0 for super gameboy
+    writeMemory(0xFFFF, 0x00);
 
 	//If we are in GBC mode, register A must contain 0x11 on startup.
 	if (m_gbmemory->getGBCMode()) {
@@ -84,93 +148,189 @@ void GBZ80::init(){
 }
 
 void GBZ80::tick(float deltaTime){    
-    //Get the next instruction and its cycle length
-    uint8_t nextInstruction = m_gbmemory->read(PC);
-    uint8_t nextCycleLength = get_cycle_length(nextInstruction);
+    //Fetch the next instruction. Its micro-op carries the handler, operand and cycle length
+    const MicroOp* nextOp = fetch_micro_op();
+    uint8_t nextCycleLength = nextOp->entry->cycles;
     
     //Determine the amount of cycles to run this tick.
-    static long long timeRollover = 0;
-    long long cycles = 0;
+    m_hot.cycles = 0;
     if(m_bSingleStep){
         //Set cycles based on the next instruction
-        cycles = nextCycleLength;
+        m_hot.cycles = nextCycleLength;
     } else {
         //Set cycles based on the given deltaTime and existing rollover
 		//If in double speed mode, double the deltaTime to double the cycles. we can run.
-        cycles = (deltaTime * m_Clock * MHZ_TO_HZ * m_gbmemory->getClockMultiplier()) + timeRollover;
+        m_hot.cycles = (deltaTime * m_Clock * MHZ_TO_HZ * m_gbmemory->getClockMultiplier()) + m_timeRollover;
     }
     
     //Hacky workaround to broken SDL when not rendering due to halted CPU
     if(deltaTime == 0){
-        cycles = 4; 
+        m_hot.cycles = 4; 
     }
     
-    if(CONSOLE_OUTPUT_ENABLED) std::cout << "GBZ80 - Clock cycles this tick: " << cycles << std::endl;
+    if(CONSOLE_OUTPUT_ENABLED) std::cout << "GBZ80 - Clock cycles this tick: " << m_hot.cycles << std::endl;
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "GBZ80 - input delta time: " << deltaTime << std::endl;
     
+#if THREADED_DISPATCH_ENABLED
+    //Threaded dispatch runs until out of cycles. Single stepping stays on the normal loop below.
+    nextOp = run_threaded(nextOp);
+    nextCycleLength = nextOp->entry->cycles;
+#endif
+    
     //Run until we hit an instruction requiring more cycles than we have time for
-    while(cycles >= nextCycleLength){
+    while(m_hot.cycles >= nextCycleLength){
         
-        //Run next instruction if CPU is active
-        if(!(m_bStop || (m_bHalt && !IGNORE_HALT))){
-            //Run the next instruction
-            uint8_t directRead = m_gbmemory->read(PC);
-            uint8_t nextInstr = read_next_byte();
-            process_opcode(nextInstr);
+        if(USE_IDLE_LOOP_DETECTION && (m_hot.currentBlock != NULL) && (m_hot.currentBlock->idleLoopRegister != 0) && (nextOp == &m_hot.currentBlock->ops[0])){
+            skip_idle_loop();
         }
         
-        //Update LCD even in stop state. Suspect that suspending LCD doesn't actually entierly disable it.
-		//LCD is unaffected by double speed mode, so need to cut length in half if necessary.
-        m_gblcd->tick(nextCycleLength / (m_gbmemory->getDoubleSpeedMode() ? 2 : 1));
-        
-        //Memory tick is for system timer functionality.
-        //TODO - move timer stuff into its own class!
-        m_gbmemory->tick(nextCycleLength);
-        
-        
-		//Audio is unaffected by double speed mode, so need to cut length in half if necessary
-        m_gbaudio->tick(nextCycleLength / (m_gbmemory->getDoubleSpeedMode() ? 2 : 1));
-        
-        if(m_bStop){
-            if(CONSOLE_OUTPUT_ENABLED) std::cout << "Processor is stopped" << std::endl;
-            
-            //Stop typically indicates we've hit an unimplemented opcode
-            if(STOP_ON_STOP){
-                exit(0);
-            }
+        //Hot blocks run as native code. Every instruction they run has already been retired when they return.
+        if(USE_JIT && run_jit_block(nextOp)){
+            nextOp = fetch_micro_op();
+            nextCycleLength = nextOp->entry->cycles;
+            continue;
         }
         
-        if(m_bHalt){
-            if(CONSOLE_OUTPUT_ENABLED) std::cout << "Processor is halted" << std::endl;
-            
-            if(STOP_ON_HALT){
-                exit(0);
-            }
+        //Run next instruction if CPU is active
+        if(!(m_hot.bStop || (m_hot.bHalt && !IGNORE_HALT))){
+            //Run the next instruction
+            execute_micro_op(nextOp);
+        } else if(USE_HALT_FAST_FORWARD){
+            fast_forward_halt(nextCycleLength);
         }
         
-        if(CONSOLE_OUTPUT_REGISTERS){
-            showRegisters();
-        }
+        retire_instruction(nextCycleLength);
         
-        //Handle any interrupts
-        process_interrupts();
+        //Decrement cycles
+        m_hot.cycles -= nextCycleLength;
         
-        //Turn on interrupts from EI instruction
-        if(m_bInterruptsEnabledNext){
-            m_bInterruptsEnabled = true;
-            m_bInterruptsEnabledNext = false;
+        //Fetch the next instruction and set its cycle length
+        nextOp = fetch_micro_op();
+        nextCycleLength = nextOp->entry->cycles;
+    }
+    
+    //Store any unused cycles for next tick
+    m_timeRollover = (m_hot.cycles > 0) ? m_hot.cycles : 0;
+    
+    //Bring the timer and audio up to date, so the audio player gets this tick's samples
+    m_scheduler->syncAll();
+}
+
+//While halted or stopped, every step adds the same cycles and checks for interrupts.
+//Interrupts can only be raised by a scheduler event, so the steps before the next event can't end the halt.
+//Runs all of those at once, leaving the step that reaches the event to retire_instruction.
+void GBZ80::fast_forward_halt(uint8_t cycleLength){
+    //Steps that would print or turn on interrupts need to run one at a time
+    if(CONSOLE_OUTPUT_ENABLED || CONSOLE_OUTPUT_REGISTERS || STOP_ON_HALT || STOP_ON_STOP || m_hot.bInterruptsEnabledNext){
+        return;
+    }
+    
+    //An interrupt is already waiting, so this step ends the halt
+    if(m_gbmemory->direct_read(INTERRUPT_ENABLE) & m_gbmemory->direct_read(ADDRESS_IF)){
+        return;
+    }
+    
+    //Steps that finish before the next event, keeping one step back for the caller
+    uint64_t untilEvent = m_scheduler->getCyclesUntilNextEvent();
+    uint64_t steps = (untilEvent > 0) ? ((untilEvent - 1) / cycleLength) : 0;
+    uint64_t budgetSteps = m_hot.cycles / cycleLength;
+    if(steps >= budgetSteps){
+        steps = (budgetSteps > 0) ? (budgetSteps - 1) : 0;
+    }
+    
+    if(steps > 0){
+        m_scheduler->tick(steps * cycleLength);
+        m_hot.cycles -= steps * cycleLength;
+    }
+}
+
+//Games often wait for LY, STAT, IF or the timer by reading the register in a tight loop.
+//A pass through the loop only reads the register and compares it, so if the register reads the same as it did
+//one pass ago, every pass until something changes it will go exactly the same way.
+//Skips those passes, leaving the pass that reaches the next event or timer change to the interpreter.
+void GBZ80::skip_idle_loop(){
+    const CodeBlock* block = m_hot.currentBlock;
+    
+    //Passes that would print or turn on interrupts need to run one at a time
+    if(CONSOLE_OUTPUT_ENABLED || CONSOLE_OUTPUT_REGISTERS || m_hot.bInterruptsEnabledNext || m_hot.bStop || m_hot.bHalt || m_bSingleStep){
+        m_idleLoopBlock = NULL;
+        return;
+    }
+    
+    //Reading brings the timer up to date, so its registers and next change are current
+    uint8_t value = readMemory(block->idleLoopRegister);
+    uint64_t now = m_scheduler->getCycles();
+    
+    //Only skip once the last pass has read the same value and come straight back.
+    //An interrupt taken during the pass would have made it take longer.
+    bool bRepeated = (m_idleLoopBlock == block) && (m_idleLoopValue == value) && (m_idleLoopArrival + block->idleLoopCycles == now);
+    
+    m_idleLoopBlock = block;
+    m_idleLoopArrival = now;
+    m_idleLoopValue = value;
+    
+    if(!bRepeated){
+        return;
+    }
+    
+    //DIV and TIMA change without an event
+    uint64_t untilChange = m_scheduler->getCyclesUntilNextEvent();
+    if((block->idleLoopRegister == ADDRESS_DIV) || (block->idleLoopRegister == ADDRESS_TIMA)){
+        long long timerChange = m_gbmemory->getTimer()->getCyclesUntilChange(block->idleLoopRegister);
+        if((timerChange >= 0) && ((uint64_t)timerChange < untilChange)){
+            untilChange = timerChange;
         }
+    }
+    
+    //Passes that finish before anything changes, keeping enough cycles to run the pass after them
+    uint64_t passes = (untilChange > 0) ? ((untilChange - 1) / block->idleLoopCycles) : 0;
+    uint64_t budgetPasses = (m_hot.cycles - block->ops[0].entry->cycles) / block->idleLoopCycles;
+    if(passes > budgetPasses){
+        passes = budgetPasses;
+    }
+    
+    if(passes > 0){
+        m_scheduler->tick(passes * block->idleLoopCycles);
+        m_hot.cycles -= passes * block->idleLoopCycles;
+        m_idleLoopArrival += passes * block->idleLoopCycles;
+    }
+}
+
+//Ticks the LCD, timers and audio for the length of an instruction, then handles interrupts
+void GBZ80::retire_instruction(uint8_t cycleLength){
+    //Advance the LCD, timer and audio. They only run when one of their events is due or their registers are accessed.
+    //Update LCD even in stop state. Suspect that suspending LCD doesn't actually entierly disable it.
+    m_scheduler->tick(cycleLength);
+    
+    if(m_hot.bStop){
+        if(CONSOLE_OUTPUT_ENABLED) std::cout << "Processor is stopped" << std::endl;
         
-        //Decrement cycles
-        cycles -= nextCycleLength;
+        //Stop typically indicates we've hit an unimplemented opcode
+        if(STOP_ON_STOP){
+            exit(0);
+        }
+    }
+    
+    if(m_hot.bHalt){
+        if(CONSOLE_OUTPUT_ENABLED) std::cout << "Processor is halted" << std::endl;
         
-        //Set the cycle length for the next instruction
-        nextInstruction = m_gbmemory->read(PC);
-        nextCycleLength = get_cycle_length(nextInstruction);
+        if(STOP_ON_HALT){
+            exit(0);
+        }
     }
     
-    //Store any unused cycles for next tick
-    timeRollover = (cycles > 0) ? cycles : 0;
+    if(CONSOLE_OUTPUT_REGISTERS){
+        showRegisters();
+    }
+    
+    //Handle any interrupts
+    process_interrupts();
+    
+    //Turn on interrupts from EI instruction
+    if(m_hot.bInterruptsEnabledNext){
+        m_hot.bInterruptsEnabled = true;
+        m_hot.bInterruptsEnabledNext = false;
+    }
 }
 
 void GBZ80::setInputChecker(IInputChecker* checker){
@@ -181,7 +341,7 @@ void GBZ80::setInputChecker(IInputChecker* checker){
 void GBZ80::showDebugPrompt(){
     bool bShowPrompt = true;
     char* input = new char[80];
-    if(CONSOLE_OUTPUT_ENABLED) std::cout << "Next instruction: " << +m_gbmemory->read(PC);
+    if(CONSOLE_OUTPUT_ENABLED) std::cout << "Next instruction: " << +readMemory(m_hot.PC);
     
     do{
         if(CONSOLE_OUTPUT_ENABLED) std::cout << "\n>";
@@ -216,6 +376,35 @@ void GBZ80::showDebugPrompt(){
     delete input;
 }
 
+//Gets the bus the CPU accesses memory through, for setting watchpoints or reading stats in instrumented builds
+GBCPUBus* GBZ80::getBus(){
+    return &m_bus;
+}
+
+//Turns skipping of idle loop passes on or off. Blocks are only checked for idle loops when decoded, so the cache is cleared.
+void GBZ80::setIdleLoopSkipEnabled(bool enabled){
+    m_bIdleLoopSkip = enabled;
+    clear_block_cache();
+}
+
+//FNV-1a over the registers, interrupt and halt state, and the cycles run since power on.
+//Used to check that shortcuts like idle loop skipping end up in the same state as running every instruction.
+uint32_t GBZ80::getStateChecksum(){
+    uint64_t cycles = m_scheduler->getCycles();
+    uint16_t state[] = {
+        getRegisterAF(), m_hot.BC, m_hot.DE, m_hot.HL, m_hot.SP, m_hot.PC,
+        (uint16_t)((m_hot.bInterruptsEnabled << 3) | (m_hot.bInterruptsEnabledNext << 2) | (m_hot.bHalt << 1) | m_hot.bStop),
+        (uint16_t)cycles, (uint16_t)(cycles >> 16), (uint16_t)(cycles >> 32), (uint16_t)(cycles >> 48)
+    };
+    
+    uint32_t hash = 2166136261u;
+    for(size_t i = 0; i < sizeof(state) / sizeof(state[0]); i++){
+        hash = (hash ^ (state[i] & 0xFF)) * 16777619u;
+        hash = (hash ^ (state[i] >> 8)) * 16777619u;
+    }
+    return hash;
+}
+
 void GBZ80::showHelp(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "Debugger help:\n";
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "Set breakpoint: >b hex_address\n";
@@ -250,21 +439,21 @@ void GBZ80::showMem(uint16_t addr, uint16_t count){
 void GBZ80::showRegisters(){
     //Display registers and flags
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "Registers:\n";
-    if(CONSOLE_OUTPUT_ENABLED) std::cout << "AF: " << AF << " A: " << +getRegisterA() << " F: " << +getRegisterF() << "\n";
-    if(CONSOLE_OUTPUT_ENABLED) std::cout << "BC: " << BC << " B: " << +getRegisterB() << " C: " << +getRegisterC() << "\n";
-    if(CONSOLE_OUTPUT_ENABLED) std::cout << "DE: " << DE << " D: " << +getRegisterD() << " E: " << +getRegisterE() << "\n";
-    if(CONSOLE_OUTPUT_ENABLED) std::cout << "HL: " << HL << " H: " << +getRegisterH() << " L: " << +getRegisterL() << "\n";
-    if(CONSOLE_OUTPUT_ENABLED) std::cout << "SP: " << SP << "\n";
-    if(CONSOLE_OUTPUT_ENABLED) std::cout << "PC: " << PC << "\n";
+    if(CONSOLE_OUTPUT_ENABLED) std::cout << "AF: " << getRegisterAF() << " A: " << +getRegisterA() << " F: " << +getRegisterF() << "\n";
+    if(CONSOLE_OUTPUT_ENABLED) std::cout << "BC: " << m_hot.BC << " B: " << +getRegisterB() << " C: " << +getRegisterC() << "\n";
+    if(CONSOLE_OUTPUT_ENABLED) std::cout << "DE: " << m_hot.DE << " D: " << +getRegisterD() << " E: " << +getRegisterE() << "\n";
+    if(CONSOLE_OUTPUT_ENABLED) std::cout << "HL: " << m_hot.HL << " H: " << +getRegisterH() << " L: " << +getRegisterL() << "\n";
+    if(CONSOLE_OUTPUT_ENABLED) std::cout << "SP: " << m_hot.SP << "\n";
+    if(CONSOLE_OUTPUT_ENABLED) std::cout << "PC: " << m_hot.PC << "\n";
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "Flags:\n";
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "Z: " << getFlag_Z() << "\n";
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "N: " << getFlag_N() << "\n";
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "H: " << getFlag_H() << "\n";
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "C: " << getFlag_C() << "\n";
-    if(CONSOLE_OUTPUT_ENABLED) std::cout << "Interrupts enabled: " << m_bInterruptsEnabled << ", next: " << m_bInterruptsEnabledNext << "\n";
+    if(CONSOLE_OUTPUT_ENABLED) std::cout << "Interrupts enabled: " << m_hot.bInterruptsEnabled << ", next: " << m_hot.bInterruptsEnabledNext << "\n";
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "IE: " << +m_gbmemory->direct_read(INTERRUPT_ENABLE) << "\n";
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "IF: " << +m_gbmemory->direct_read(ADDRESS_IF) << "\n";
-    if(CONSOLE_OUTPUT_ENABLED) std::cout << "Halt: " << m_bHalt << ", Stop: " << m_bStop << "\n";
+    if(CONSOLE_OUTPUT_ENABLED) std::cout << "Halt: " << m_hot.bHalt << ", Stop: " << m_hot.bStop << "\n";
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "LCDC: " << +m_gblcd->getLCDC() << "\n";
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "STAT: " << +m_gblcd->getSTAT() << "\n";
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "LY:   " << +m_gblcd->getLY() << "\n";
@@ -277,124 +466,133 @@ void GBZ80::step(){
 
 //Register access funcs
 uint16_t GBZ80::getRegisterAF(){
-    return AF;
+    getRegisterF();
+    return m_hot.AF;
 }
 
 void GBZ80::setRegisterAF(uint16_t val){
     //Bottom four bits of F are always 0
-    AF = val & 0xFFF0;
+    m_hot.AF = val & 0xFFF0;
+    m_hot.lazyFlagsOp = LAZY_FLAGS_NONE;
 }
 
 uint8_t GBZ80::getRegisterA(){
     //return (AF >> 8);
-    return getMSB(AF);
+    return getMSB(m_hot.AF);
 }
 
 void GBZ80::setRegisterA(uint8_t val){
-    AF = setMSB(AF, val);
+    m_hot.AF = setMSB(m_hot.AF, val);
 }
 
 uint8_t GBZ80::getRegisterF(){
-    return getLSB(AF);
+    //Work out flags from the last ALU op if needed
+    if(m_hot.lazyFlagsOp != LAZY_FLAGS_NONE){
+        m_hot.AF = setLSB(m_hot.AF, get_lazy_flags());
+        m_hot.lazyFlagsOp = LAZY_FLAGS_NONE;
+    }
+    
+    return getLSB(m_hot.AF);
 }
 
 void GBZ80::setRegisterF(uint8_t val){
     //Bottom four bits of F are always 0
-    AF = setLSB(AF, val & 0xF0);
+    m_hot.AF = setLSB(m_hot.AF, val & 0xF0);
+    m_hot.lazyFlagsOp = LAZY_FLAGS_NONE;
 }
 
 uint16_t GBZ80::getRegisterBC(){
-    return BC;
+    return m_hot.BC;
 }
 
 void GBZ80::setRegisterBC(uint16_t val){
-    BC = val;
+    m_hot.BC = val;
 }
 
 uint8_t GBZ80::getRegisterB(){
-    return getMSB(BC);
+    return getMSB(m_hot.BC);
 }
 
 void GBZ80::setRegisterB(uint8_t val){
-    BC = setMSB(BC, val);
+    m_hot.BC = setMSB(m_hot.BC, val);
 }
 
 uint8_t GBZ80::getRegisterC(){
-    return getLSB(BC);
+    return getLSB(m_hot.BC);
 }
 
 void GBZ80::setRegisterC(uint8_t val){
-    BC = setLSB(BC, val);
+    m_hot.BC = setLSB(m_hot.BC, val);
 }
 
 
 uint16_t GBZ80::getRegisterDE(){
-    return DE;
+    return m_hot.DE;
 }
 
 void GBZ80::setRegisterDE(uint16_t val){
-    DE = val;
+    m_hot.DE = val;
 }
 
 uint8_t GBZ80::getRegisterD(){
-    return getMSB(DE);
+    return getMSB(m_hot.DE);
 }
 
 void GBZ80::setRegisterD(uint8_t val){
-    DE = setMSB(DE, val);
+    m_hot.DE = setMSB(m_hot.DE, val);
 }
 
 uint8_t GBZ80::getRegisterE(){
-    return getLSB(DE);
+    return getLSB(m_hot.DE);
 }
 
 void GBZ80::setRegisterE(uint8_t val){
-    DE = setLSB(DE, val);
+    m_hot.DE = setLSB(m_hot.DE, val);
 }
 
 
 uint16_t GBZ80::getRegisterHL(){
-    return HL;
+    return m_hot.HL;
 }
 
  void GBZ80::setRegisterHL(uint16_t val){
-    HL = val;
+    m_hot.HL = val;
 }
 
 
 uint8_t GBZ80::getRegisterH(){
-    return getMSB(HL);
+    return getMSB(m_hot.HL);
 }
 
 void GBZ80::setRegisterH(uint8_t val){;
-    HL = setMSB(HL, val);
+    m_hot.HL = setMSB(m_hot.HL, val);
 }
 
 uint8_t GBZ80::getRegisterL(){
-    return getLSB(HL);
+    return getLSB(m_hot.HL);
 }
 
 void GBZ80::setRegisterL(uint8_t val){
-    HL = setLSB(HL, val);
+    m_hot.HL = setLSB(m_hot.HL, val);
 }
 
 
 
 uint16_t GBZ80::getRegisterSP(){
-    return SP;
+    return m_hot.SP;
 }
 
 void GBZ80::setRegisterSP(uint16_t val){
-    SP = val;
+    m_hot.SP = val;
 }
 
 
 uint16_t GBZ80::getRegisterPC(){
-    return PC;
+    return m_hot.PC;
 }
 
 void GBZ80::setRegisterPC(uint16_t val){
-    PC = val;
+    m_hot.PC = val;
 }
 
 
@@ -447,6 +645,99 @@ void GBZ80::setFlag_C(bool val){
     }
 }
 
+//Records an ALU op so its flags can be worked out when F is next read
+void GBZ80::set_lazy_flags(uint8_t op, uint8_t operand1, uint8_t operand2, uint8_t carry){
+    m_hot.lazyFlagsOp = op;
+    m_hot.lazyFlagsOperand1 = operand1;
+    m_hot.lazyFlagsOperand2 = operand2;
+    m_hot.lazyFlagsCarry = carry;
+}
+
+//Works out F for the last recorded ALU op. Matches the flags the eager versions of each op set.
+uint8_t GBZ80::get_lazy_flags(){
+    uint8_t val1 = m_hot.lazyFlagsOperand1;
+    uint8_t val2 = m_hot.lazyFlagsOperand2;
+    uint8_t carry = m_hot.lazyFlagsCarry;
+    uint8_t result = 0;
+    uint8_t flags = 0;
+    
+    switch(m_hot.lazyFlagsOp){
+        case LAZY_FLAGS_ADD:
+            result = val1 + val2;
+            if(((val1 & 0x0F) + (val2 & 0x0F)) > 0x0F) flags |= FLAG_BIT_H;
+            if((val1 + val2) > 0xFF) flags |= FLAG_BIT_C;
+            break;
+        case LAZY_FLAGS_ADC:
+            result = val1 + val2 + carry;
+            if(((val1 & 0x0F) + (val2 & 0x0F) + carry) > 0x0F) flags |= FLAG_BIT_H;
+            if((val1 + val2 + carry) > 0xFF) flags |= FLAG_BIT_C;
+            break;
+        case LAZY_FLAGS_SUB:
+            result = val1 - val2;
+            flags |= FLAG_BIT_N;
+            if((val2 & 0x0F) > (val1 & 0x0F)) flags |= FLAG_BIT_H;
+            if(val2 > val1) flags |= FLAG_BIT_C;
+            break;
+        case LAZY_FLAGS_SBC:
+            result = val1 - val2 - carry;
+            flags |= FLAG_BIT_N;
+            if((val1 & 0x0F) < ((val2 & 0x0F) + carry)) flags |= FLAG_BIT_H;
+            if(val1 < (val2 + carry)) flags |= FLAG_BIT_C;
+            break;
+        case LAZY_FLAGS_AND:
+            result = val1;
+            flags |= FLAG_BIT_H;
+            break;
+        case LAZY_FLAGS_OR:
+            result = val1;
+            break;
+        case LAZY_FLAGS_INC:
+            result = val1 + 1;
+            if((val1 & 0x0F) == 0x0F) flags |= FLAG_BIT_H;
+            if(carry) flags |= FLAG_BIT_C;
+            break;
+        case LAZY_FLAGS_DEC:
+            result = val1 - 1;
+            flags |= FLAG_BIT_N;
+            if((val1 & 0x0F) == 0) flags |= FLAG_BIT_H;
+            if(carry) flags |= FLAG_BIT_C;
+            break;
+        default:
+            return getLSB(m_hot.AF);
+    }
+    
+    if(result == 0) flags |= FLAG_BIT_Z;
+    
+    return flags;
+}
+
+//Works out just the carry flag, without bringing F up to date.
+//Ops that carry C through, like INC and DEC, use this so the rest of F can stay lazy.
+uint8_t GBZ80::get_lazy_carry(){
+    uint8_t val1 = m_hot.lazyFlagsOperand1;
+    uint8_t val2 = m_hot.lazyFlagsOperand2;
+    uint8_t carry = m_hot.lazyFlagsCarry;
+    
+    switch(m_hot.lazyFlagsOp){
+        case LAZY_FLAGS_ADD:
+            return (val1 + val2) > 0xFF;
+        case LAZY_FLAGS_ADC:
+            return (val1 + val2 + carry) > 0xFF;
+        case LAZY_FLAGS_SUB:
+            return val2 > val1;
+        case LAZY_FLAGS_SBC:
+            return val1 < (val2 + carry);
+        case LAZY_FLAGS_AND:
+        case LAZY_FLAGS_OR:
+            return 0;
+        case LAZY_FLAGS_INC:
+        case LAZY_FLAGS_DEC:
+            return carry;
+        default:
+            return (getLSB(m_hot.AF) >> 4) & 1;
+    }
+}
+
 //8-Bit load instructions
 
 //ld r,n
@@ -519,7 +810,7 @@ void GBZ80::instruction_ld_A_L(){
 
 void GBZ80::instruction_ld_A_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ld A,(HL)" << "\n";
-    setRegisterA(m_gbmemory->read(getRegisterHL()));
+    setRegisterA(readMemory(getRegisterHL()));
 }
 
 void GBZ80::instruction_ld_B_A(){
@@ -559,7 +850,7 @@ void GBZ80::instruction_ld_B_L(){
     
 void GBZ80::instruction_ld_B_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ld B,(HL)" << "\n";
-    setRegisterB(m_gbmemory->read(getRegisterHL()));
+    setRegisterB(readMemory(getRegisterHL()));
 }
 
 void GBZ80::instruction_ld_C_A(){
@@ -599,7 +890,7 @@ void GBZ80::instruction_ld_C_L(){
 
 void GBZ80::instruction_ld_C_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ld C,(HL)" << "\n";
-    setRegisterC(m_gbmemory->read(getRegisterHL()));
+    setRegisterC(readMemory(getRegisterHL()));
 }
 
 void GBZ80::instruction_ld_D_A(){
@@ -639,7 +930,7 @@ void GBZ80::instruction_ld_D_L(){
 
 void GBZ80::instruction_ld_D_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ld D,(HL)" << "\n";
-    setRegisterD(m_gbmemory->read(getRegisterHL()));
+    setRegisterD(readMemory(getRegisterHL()));
 }
 
 void GBZ80::instruction_ld_E_A(){
@@ -679,7 +970,7 @@ void GBZ80::instruction_ld_E_L(){
 
 void GBZ80::instruction_ld_E_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ld E,(HL)" << "\n";
-    setRegisterE(m_gbmemory->read(getRegisterHL()));
+    setRegisterE(readMemory(getRegisterHL()));
 }
 
 void GBZ80::instruction_ld_H_A(){
@@ -719,7 +1010,7 @@ void GBZ80::instruction_ld_H_L(){
 
 void GBZ80::instruction_ld_H_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ld H,(HL)" << "\n";
-    setRegisterH(m_gbmemory->read(getRegisterHL()));
+    setRegisterH(readMemory(getRegisterHL()));
 }
 
 void GBZ80::instruction_ld_L_A(){
@@ -759,62 +1050,62 @@ void GBZ80::instruction_ld_L_L(){
 
 void GBZ80::instruction_ld_L_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ld H,(HL)" << "\n";
-    setRegisterL(m_gbmemory->read(getRegisterHL()));
+    setRegisterL(readMemory(getRegisterHL()));
 }
 
 void GBZ80::instruction_ld_HLI_A(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ld (HL),A" << "\n";
-    m_gbmemory->write(getRegisterHL(), getRegisterA());
+    writeMemory(getRegisterHL(), getRegisterA());
 }
 
 void GBZ80::instruction_ld_HLI_B(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ld (HL),B" << "\n";
-    m_gbmemory->write(getRegisterHL(), getRegisterB());
+    writeMemory(getRegisterHL(), getRegisterB());
 }
 
 void GBZ80::instruction_ld_HLI_C(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ld (HL),C" << "\n";
-    m_gbmemory->write(getRegisterHL(), getRegisterC());
+    writeMemory(getRegisterHL(), getRegisterC());
 }
 
 void GBZ80::instruction_ld_HLI_D(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ld (HL),D" << "\n";
-    m_gbmemory->write(getRegisterHL(), getRegisterD());
+    writeMemory(getRegisterHL(), getRegisterD());
 }
 
 void GBZ80::instruction_ld_HLI_E(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ld (HL),E" << "\n";
-    m_gbmemory->write(getRegisterHL(), getRegisterE());
+    writeMemory(getRegisterHL(), getRegisterE());
 }
 
 void GBZ80::instruction_ld_HLI_H(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ld (HL),H" << "\n";
-    m_gbmemory->write(getRegisterHL(), getRegisterH());
+    writeMemory(getRegisterHL(), getRegisterH());
 }
 
 void GBZ80::instruction_ld_HLI_L(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ld (HL),L" << "\n";
-    m_gbmemory->write(getRegisterHL(), getRegisterL());
+    writeMemory(getRegisterHL(), getRegisterL());
 }
 
 void GBZ80::instruction_ld_HLI_N(uint8_t n){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ld (HL)," << +n << "\n";
-    m_gbmemory->write(getRegisterHL(), n);
+    writeMemory(getRegisterHL(), n);
 }
 
 void GBZ80::instruction_ld_A_BCI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ld A,(BC)" << "\n";
-    setRegisterA(m_gbmemory->read(getRegisterBC()));
+    setRegisterA(readMemory(getRegisterBC()));
 }
 
 void GBZ80::instruction_ld_A_DEI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ld A,(DE)" << "\n";
-    setRegisterA(m_gbmemory->read(getRegisterDE()));
+    setRegisterA(readMemory(getRegisterDE()));
 }
 
 void GBZ80::instruction_ld_A_NNI(uint16_t nn){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ld A,(" << nn << ")" << "\n";
-    setRegisterA(m_gbmemory->read(nn));
+    setRegisterA(readMemory(nn));
 }
 
 void GBZ80::instruction_ld_A_CONST(uint8_t val){
@@ -824,70 +1115,70 @@ void GBZ80::instruction_ld_A_CONST(uint8_t val){
 
 void GBZ80::instruction_ld_BCI_A(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ld (BC),A" << "\n";
-    m_gbmemory->write(getRegisterBC(), getRegisterA());
+    writeMemory(getRegisterBC(), getRegisterA());
 }
 
 void GBZ80::instruction_ld_DEI_A(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ld (DE),A" << "\n";
-    m_gbmemory->write(getRegisterDE(), getRegisterA());
+    writeMemory(getRegisterDE(), getRegisterA());
 }
 
 void GBZ80::instruction_ld_NNI_A(uint16_t nn){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ld (" << nn << "),A" << "\n";
-    m_gbmemory->write(nn, getRegisterA());
+    writeMemory(nn, getRegisterA());
 }
 
 //LD with memory address $FF00 + register C into A
 void GBZ80::instruction_ld_A_FF00CI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ld A,(0xFF00+" << getRegisterC() << ")" << "\n";
-    setRegisterA(m_gbmemory->read(0xFF00 + getRegisterC()));
+    setRegisterA(readMemory(0xFF00 + getRegisterC()));
 }
 
 //LD with A into memory address $FF00 + register C
 void GBZ80::instruction_ld_FF00CI_A(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ld (0xFF00+" << getRegisterC() << "),A" << "\n";
-    m_gbmemory->write(0xFF00 + getRegisterC(), getRegisterA());
+    writeMemory(0xFF00 + getRegisterC(), getRegisterA());
 }
 
 //Put val at address in HL into A, decrement HL
 void GBZ80::instruction_ldd_A_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ldd A,(HL)" << "\n";
-    setRegisterA(m_gbmemory->read(getRegisterHL()));
-    HL--;
+    setRegisterA(readMemory(getRegisterHL()));
+    m_hot.HL--;
 }
 
 //Put val in A into memory address of AL, decrement HL
 void GBZ80::instruction_ldd_HLI_A(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ldd (HL),A" << "\n";
-    m_gbmemory->write(getRegisterHL(), getRegisterA());
-    HL--;
+    writeMemory(getRegisterHL(), getRegisterA());
+    m_hot.HL--;
 }
 
 //Put val at address HL into A, increment HL
 void GBZ80::instruction_ldi_A_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ldi A,(HL)" << "\n";
-    setRegisterA(m_gbmemory->read(getRegisterHL()));
-    HL++;
+    setRegisterA(readMemory(getRegisterHL()));
+    m_hot.HL++;
 }
 
 //Put val in A into memory address of AL, increment HL
 void GBZ80::instruction_ldi_HLI_A(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ldi (HL),A" << "\n";
-    m_gbmemory->write(getRegisterHL(), getRegisterA());
-    HL++;
+    writeMemory(getRegisterHL(), getRegisterA());
+    m_hot.HL++;
 }
 
 
 //Put A into memory address $FF00+n
 void GBZ80::instruction_ldh_FF00NI_A(uint8_t n){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ldh (0xFF00+" << +n << "),A" << "\n";
-    m_gbmemory->write(0xFF00 + n, getRegisterA());
+    writeMemory(0xFF00 + n, getRegisterA());
 }
 
 //Put memory address $FF00+n into A
 void GBZ80::instruction_ldh_A_FF00NI(uint8_t n){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ldh A,(0xFF00+" << +n << ")" << "\n";
-    setRegisterA(m_gbmemory->read(0xFF00 + n));
+    setRegisterA(readMemory(0xFF00 + n));
 }
 
 //16-bit load ops
@@ -924,8 +1215,8 @@ void GBZ80::instruction_ldhl(int8_t n){
     setFlag_Z(false);
     setFlag_N(false);
     //H and C flags are relative to 8-bit input, not 16-bit HL.
-    setFlag_H((SP & 0x0F) + (n & 0x0F) > 0x0F);
-    setFlag_C((SP & 0xFF) + (n & 0xFF) > 0xFF);
+    setFlag_H((m_hot.SP & 0x0F) + (n & 0x0F) > 0x0F);
+    setFlag_C((m_hot.SP & 0xFF) + (n & 0xFF) > 0xFF);
     
     setRegisterHL(result);
 }
@@ -933,18 +1224,18 @@ void GBZ80::instruction_ldhl(int8_t n){
 //Put SP into address n
 void GBZ80::instruction_ld_NNI_SP(uint16_t nn){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ld (" << nn << "),SP" << "\n";
-    m_gbmemory->write(nn, getRegisterSP() & 0xFF);
-    m_gbmemory->write(nn+1, (getRegisterSP() >> 8) & 0xFF);
+    writeMemory(nn, getRegisterSP() & 0xFF);
+    writeMemory(nn+1, (getRegisterSP() >> 8) & 0xFF);
 }
 
 //Push the given two bytes onto the stack and decrement SP accordingly
 void GBZ80::instruction_push_generic(uint16_t val){
-    SP--;
-    m_gbmemory->write(getRegisterSP(), getMSB(val));
-    SP--;
-    m_gbmemory->write(getRegisterSP(), getLSB(val));
+    m_hot.SP--;
+    writeMemory(getRegisterSP(), getMSB(val));
+    m_hot.SP--;
+    writeMemory(getRegisterSP(), getLSB(val));
     
-    if(CONSOLE_OUTPUT_ENABLED) std::cout << "\nPush instruction performed! Value pushed: " << +val << "SP: " << +SP << std::endl;
+    if(CONSOLE_OUTPUT_ENABLED) std::cout << "\nPush instruction performed! Value pushed: " << +val << "SP: " << +m_hot.SP << std::endl;
 }
 
 //Push specified register (two bytes) onto stack.
@@ -972,12 +1263,12 @@ void GBZ80::instruction_push_HL(){
 uint16_t GBZ80::instruction_pop_generic(){
     uint16_t val = 0;
     
-    val += m_gbmemory->read(getRegisterSP());
-    SP++;
-    val = setMSB(val, m_gbmemory->read(getRegisterSP()));
-    SP++;
+    val += readMemory(getRegisterSP());
+    m_hot.SP++;
+    val = setMSB(val, readMemory(getRegisterSP()));
+    m_hot.SP++;
     
-    if(CONSOLE_OUTPUT_ENABLED) std::cout << "\nPop instruction called! Value popped: " << val << "\nSP: " << SP << std::endl;
+    if(CONSOLE_OUTPUT_ENABLED) std::cout << "\nPop instruction called! Value popped: " << val << "\nSP: " << m_hot.SP << std::endl;
     return val;
 }
 
@@ -1009,10 +1300,14 @@ void GBZ80::instruction_add_generic(uint8_t val){
     uint8_t regA = getRegisterA();
     uint8_t result = val + regA;
     
-    setFlag_Z(result == 0);
-    setFlag_N(false);
-    setFlag_H(((regA & 0x0F) + (val & 0x0F)) > 0x0F);
-    setFlag_C((regA + val) > 0xFF);
+    if(USE_LAZY_FLAGS){
+        set_lazy_flags(LAZY_FLAGS_ADD, regA, val, 0);
+    } else {
+        setFlag_Z(result == 0);
+        setFlag_N(false);
+        setFlag_H(((regA & 0x0F) + (val & 0x0F)) > 0x0F);
+        setFlag_C((regA + val) > 0xFF);
+    }
     
     setRegisterA(result); 
 }
@@ -1055,7 +1350,7 @@ void GBZ80::instruction_add_L(){
 
 void GBZ80::instruction_add_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "add A,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     instruction_add_generic(val);
 }
 
@@ -1067,13 +1362,18 @@ void GBZ80::instruction_add_CONST(uint8_t val){
 //Adds the value + carry flag to A
 void GBZ80::instruction_adc_generic(uint8_t val){
     uint8_t regA = getRegisterA();
-    uint8_t result = regA + val + getFlag_C();
-    uint16_t cTest = regA + val + getFlag_C();
+    uint8_t carry = USE_LAZY_FLAGS ? get_lazy_carry() : getFlag_C();
+    uint8_t result = regA + val + carry;
+    uint16_t cTest = regA + val + carry;
     
-    setFlag_Z(result == 0);
-    setFlag_H((regA & 0x0F) + (val & 0x0F) + getFlag_C() > 0x0F);
-    setFlag_C(cTest > 0xFF);
-    setFlag_N(false);
+    if(USE_LAZY_FLAGS){
+        set_lazy_flags(LAZY_FLAGS_ADC, regA, val, carry);
+    } else {
+        setFlag_Z(result == 0);
+        setFlag_H((regA & 0x0F) + (val & 0x0F) + carry > 0x0F);
+        setFlag_C(cTest > 0xFF);
+        setFlag_N(false);
+    }
     
     setRegisterA(result);
 }
@@ -1116,7 +1416,7 @@ void GBZ80::instruction_adc_L(){
 
 void GBZ80::instruction_adc_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "adc A,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     instruction_adc_generic(val);
 }
 
@@ -1130,10 +1430,14 @@ void GBZ80::instruction_sub_generic(uint8_t val){
     uint8_t regA = getRegisterA();
     uint8_t result = regA - val;
     
-    setFlag_Z(result == 0);
-    setFlag_N(true);
-    setFlag_H((val & 0x0F) > (regA & 0x0F));
-    setFlag_C(val > regA);
+    if(USE_LAZY_FLAGS){
+        set_lazy_flags(LAZY_FLAGS_SUB, regA, val, 0);
+    } else {
+        setFlag_Z(result == 0);
+        setFlag_N(true);
+        setFlag_H((val & 0x0F) > (regA & 0x0F));
+        setFlag_C(val > regA);
+    }
     
     setRegisterA(result);
 }
@@ -1175,7 +1479,7 @@ void GBZ80::instruction_sub_L(){
 
 void GBZ80::instruction_sub_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "sub (HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     instruction_sub_generic(val);
 }
 
@@ -1187,13 +1491,18 @@ void GBZ80::instruction_sub_CONST(uint8_t val){
 //Sub register + carry flag from A
 void GBZ80::instruction_sbc_generic(uint8_t val){
     uint8_t regA = getRegisterA();
-    uint8_t result = regA - val - getFlag_C();
-    uint16_t cTest = regA - val - getFlag_C();
+    uint8_t carry = USE_LAZY_FLAGS ? get_lazy_carry() : getFlag_C();
+    uint8_t result = regA - val - carry;
+    uint16_t cTest = regA - val - carry;
     
-    setFlag_Z(result == 0);
-    setFlag_H((regA & 0x0F) < (val & 0x0F) + getFlag_C());
-    setFlag_C(cTest > 0xFF);
-    setFlag_N(true);
+    if(USE_LAZY_FLAGS){
+        set_lazy_flags(LAZY_FLAGS_SBC, regA, val, carry);
+    } else {
+        setFlag_Z(result == 0);
+        setFlag_H((regA & 0x0F) < (val & 0x0F) + carry);
+        setFlag_C(cTest > 0xFF);
+        setFlag_N(true);
+    }
     
     setRegisterA(result);
 }
@@ -1235,7 +1544,7 @@ void GBZ80::instruction_sbc_L(){
 
 void GBZ80::instruction_sbc_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "sbc (HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     instruction_sbc_generic(val);
 }
 
@@ -1245,10 +1554,14 @@ void GBZ80::instruction_sbc_CONST(uint8_t val){
 }
 
 uint8_t GBZ80::instruction_and_generic(uint8_t r1, uint8_t r2){
-    setFlag_Z((r1 & r2) == 0);
-    setFlag_N(false);
-    setFlag_H(true);
-    setFlag_C(false);
+    if(USE_LAZY_FLAGS){
+        set_lazy_flags(LAZY_FLAGS_AND, r1 & r2, 0, 0);
+    } else {
+        setFlag_Z((r1 & r2) == 0);
+        setFlag_N(false);
+        setFlag_H(true);
+        setFlag_C(false);
+    }
     
     return (r1 & r2);
 }
@@ -1291,7 +1604,7 @@ void GBZ80::instruction_and_L(){
 
 void GBZ80::instruction_and_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "and A,(HL)" << "\n";
-    setRegisterA(instruction_and_generic(getRegisterA(), m_gbmemory->read(getRegisterHL())));
+    setRegisterA(instruction_and_generic(getRegisterA(), readMemory(getRegisterHL())));
 }
 
 void GBZ80::instruction_and_CONST(uint8_t val){
@@ -1301,10 +1614,14 @@ void GBZ80::instruction_and_CONST(uint8_t val){
 
 //Logically OR registers, store in register A
 uint8_t GBZ80::instruction_or_generic(uint8_t r1, uint8_t r2){
-    setFlag_Z((r1 | r2) == 0);
-    setFlag_N(false);
-    setFlag_H(false);
-    setFlag_C(false);
+    if(USE_LAZY_FLAGS){
+        set_lazy_flags(LAZY_FLAGS_OR, r1 | r2, 0, 0);
+    } else {
+        setFlag_Z((r1 | r2) == 0);
+        setFlag_N(false);
+        setFlag_H(false);
+        setFlag_C(false);
+    }
     
     return (r1 | r2);
 }
@@ -1346,7 +1663,7 @@ void GBZ80::instruction_or_L(){
 
 void GBZ80::instruction_or_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "or A,(HL)" << "\n";
-    setRegisterA(instruction_or_generic(getRegisterA(), m_gbmemory->read(getRegisterHL())));
+    setRegisterA(instruction_or_generic(getRegisterA(), readMemory(getRegisterHL())));
 }
 
 void GBZ80::instruction_or_CONST(uint8_t val){
@@ -1356,10 +1673,14 @@ void GBZ80::instruction_or_CONST(uint8_t val){
 
 //Logically XOR registers, store in A
 uint8_t GBZ80::instruction_xor_generic(uint8_t r1, uint8_t r2){
-    setFlag_Z((r1 ^ r2) == 0);
-    setFlag_N(false);
-    setFlag_H(false);
-    setFlag_C(false);
+    if(USE_LAZY_FLAGS){
+        set_lazy_flags(LAZY_FLAGS_OR, r1 ^ r2, 0, 0);
+    } else {
+        setFlag_Z((r1 ^ r2) == 0);
+        setFlag_N(false);
+        setFlag_H(false);
+        setFlag_C(false);
+    }
     
     return (r1 ^ r2);
 }
@@ -1401,7 +1722,7 @@ void GBZ80::instruction_xor_L(){
 
 void GBZ80::instruction_xor_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "xor A,(HL)" << "\n";
-    setRegisterA(instruction_xor_generic(getRegisterA(), m_gbmemory->read(getRegisterHL())));
+    setRegisterA(instruction_xor_generic(getRegisterA(), readMemory(getRegisterHL())));
 }
 
 void GBZ80::instruction_xor_CONST(uint8_t val){ 
@@ -1416,10 +1737,14 @@ void GBZ80::instruction_cp_generic(uint8_t val){
     
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "Comparison: " << +regA << " - " << +val << std::endl;
     
-    setFlag_Z(regA == val);
-    setFlag_N(true);
-    setFlag_H((val & 0x0f) > (regA & 0x0f));
-    setFlag_C(regA < val);
+    if(USE_LAZY_FLAGS){
+        set_lazy_flags(LAZY_FLAGS_SUB, regA, val, 0);
+    } else {
+        setFlag_Z(regA == val);
+        setFlag_N(true);
+        setFlag_H((val & 0x0f) > (regA & 0x0f));
+        setFlag_C(regA < val);
+    }
 }
 
 void GBZ80::instruction_cp_A(){
@@ -1459,7 +1784,7 @@ void GBZ80::instruction_cp_L(){
 
 void GBZ80::instruction_cp_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "cp (HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     instruction_cp_generic(val);
 }
 
@@ -1472,9 +1797,14 @@ void GBZ80::instruction_cp_CONST(uint8_t val){
 uint8_t GBZ80::instruction_inc_generic(uint8_t val){
     uint8_t result = val + 1;
     
-    setFlag_Z(result == 0);
-    setFlag_N(false);
-    setFlag_H((((val & 0x0F) + 1)) > 0x0F);
+    //Carry is left alone
+    if(USE_LAZY_FLAGS){
+        set_lazy_flags(LAZY_FLAGS_INC, val, 0, get_lazy_carry());
+    } else {
+        setFlag_Z(result == 0);
+        setFlag_N(false);
+        setFlag_H((((val & 0x0F) + 1)) > 0x0F);
+    }
     
     return result;
 }
@@ -1516,9 +1846,9 @@ void GBZ80::instruction_inc_L(){
 
 void GBZ80::instruction_inc_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "inc (HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     val = instruction_inc_generic(val);
-    m_gbmemory->write(getRegisterHL(), val);
+    writeMemory(getRegisterHL(), val);
 }
 
 //Decrement register
@@ -1527,9 +1857,14 @@ uint8_t GBZ80::instruction_dec_generic(uint8_t val){
     uint8_t hFlagTest = val & 0x0F;
     hFlagTest -= 1;
     
-    setFlag_Z(result == 0);
-    setFlag_N(true);
-    setFlag_H(hFlagTest > 0x0F);
+    //Carry is left alone
+    if(USE_LAZY_FLAGS){
+        set_lazy_flags(LAZY_FLAGS_DEC, val, 0, get_lazy_carry());
+    } else {
+        setFlag_Z(result == 0);
+        setFlag_N(true);
+        setFlag_H(hFlagTest > 0x0F);
+    }
     
     return result;
 }
@@ -1571,23 +1906,23 @@ void GBZ80::instruction_dec_L(){
 
 void GBZ80::instruction_dec_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "dec (HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     val = instruction_dec_generic(val);
-    m_gbmemory->write(getRegisterHL(), val);
+    writeMemory(getRegisterHL(), val);
 }
 
 //16 Bit arithmetic
 
 //Add register to HL directly
 void GBZ80::instruction_add_generic(uint16_t val){
-    uint16_t hFlag = (HL & 0x0FFF) + (val & 0x0FFF) ;
-    uint16_t cFlag = HL + val;
+    uint16_t hFlag = (m_hot.HL & 0x0FFF) + (val & 0x0FFF) ;
+    uint16_t cFlag = m_hot.HL + val;
     
     setFlag_N(false);
     setFlag_H(hFlag & 0x1000);
-    setFlag_C(cFlag < HL);
+    setFlag_C(cFlag < m_hot.HL);
     
-    HL += val;
+    m_hot.HL += val;
 }
 
 void GBZ80::instruction_add_BC(){
@@ -1614,59 +1949,59 @@ void GBZ80::instruction_add_SP(){
 //Add value to SP
 void GBZ80::instruction_add_SP_CONST(int8_t val){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "add SP," << val << "\n";
-    uint16_t cTest = SP + val;
+    uint16_t cTest = m_hot.SP + val;
     
     setFlag_Z(false);
     setFlag_N(false);
     //H and C flags are relative to 8-bit input, not 16-bit SP.
-    setFlag_H((SP & 0x0F) + (val & 0x0F) > 0x0F);
-    setFlag_C((SP & 0xFF) + (val & 0xFF) > 0xFF);
+    setFlag_H((m_hot.SP & 0x0F) + (val & 0x0F) > 0x0F);
+    setFlag_C((m_hot.SP & 0xFF) + (val & 0xFF) > 0xFF);
     
-    SP += val;
+    m_hot.SP += val;
 }
 
 
 //Increment register
 void GBZ80::instruction_inc_BC(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "inc BC" << "\n";
-    BC++;
+    m_hot.BC++;
 }
 
 void GBZ80::instruction_inc_DE(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "inc DE" << "\n";
-    DE++;
+    m_hot.DE++;
 }
 
 void GBZ80::instruction_inc_HL(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "inc HL" << "\n";
-    HL++;
+    m_hot.HL++;
 }
 
 void GBZ80::instruction_inc_SP(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "inc SP" << "\n";
-    SP++;
+    m_hot.SP++;
 }
 
 
 //Decrement register
 void GBZ80::instruction_dec_BC(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "dec BC" << "\n";
-    BC--;
+    m_hot.BC--;
 }
 
 void GBZ80::instruction_dec_DE(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "dec DE" << "\n";
-    DE--;
+    m_hot.DE--;
 }
 
 void GBZ80::instruction_dec_HL(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "dec HL" << "\n";
-    HL--;
+    m_hot.HL--;
 }
 
 void GBZ80::instruction_dec_SP(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "dec SP" << "\n";
-    SP--;
+    m_hot.SP--;
 }
 
 //Swap upper and lower nibbles of register
@@ -1718,8 +2053,8 @@ void GBZ80::instruction_swap_L(){
 
 void GBZ80::instruction_swap_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "swap (HL)" << "\n";
-    uint8_t toSwap = m_gbmemory->read(getRegisterHL());
-    m_gbmemory->write(getRegisterHL(), instruction_swap_generic(toSwap));
+    uint8_t toSwap = readMemory(getRegisterHL());
+    writeMemory(getRegisterHL(), instruction_swap_generic(toSwap));
 }
 
 //Adjusts register A to contain correct representation of Binary Coded Decimal
@@ -1785,7 +2120,7 @@ void GBZ80::instruction_nop(){
 //Powers down CPU until an interupt occures
 void GBZ80::instruction_halt(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "halt" << "\n";
-    m_bHalt = true;
+    m_hot.bHalt = true;
 }
   
 //Halt CPU and LCD
@@ -1807,22 +2142,22 @@ void GBZ80::instruction_stop() {
 		std::cout << "Clock speed switched to " << m_Clock << std::endl;
 	} else {
 		//If not in GBC mode, or the flag is not set, stop has its normal behavior.
-		m_bStop = true;
+		m_hot.bStop = true;
 	}
 }
   
 //Disable interrupts after next instruction
 void GBZ80::instruction_di(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "di" << "\n";
-    m_bInterruptsEnabledNext = false;
-    m_bInterruptsEnabled = false;
+    m_hot.bInterruptsEnabledNext = false;
+    m_hot.bInterruptsEnabled = false;
 }
 
 //Enable interrupts after next instruction
 void GBZ80::instruction_ei(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ei" << "\n";
     //TODO - bring back enabled next in tick and set to false here once CPU is more accurate elsewhere
-    m_bInterruptsEnabledNext = true;
+    m_hot.bInterruptsEnabledNext = true;
     //m_bInterruptsEnabled = true;
 }
 
@@ -1968,9 +2303,9 @@ void GBZ80::instruction_rlc_L(){
 
 void GBZ80::instruction_rlc_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "rlc (HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     val = instruction_rlc_generic(val);
-    m_gbmemory->write(getRegisterHL(), val);
+    writeMemory(getRegisterHL(), val);
 }
 
 void GBZ80::instruction_rl_A(){
@@ -2010,9 +2345,9 @@ void GBZ80::instruction_rl_L(){
 
 void GBZ80::instruction_rl_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "rl (HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     val = instruction_rl_generic(val);
-    m_gbmemory->write(getRegisterHL(), val);
+    writeMemory(getRegisterHL(), val);
 }
 
 //Rotate register right. Old bit 0 stored in Carry flag
@@ -2053,9 +2388,9 @@ void GBZ80::instruction_rrc_L(){
 
 void GBZ80::instruction_rrc_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "rrc (HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     val = instruction_rrc_generic(val);
-    m_gbmemory->write(getRegisterHL(), val);
+    writeMemory(getRegisterHL(), val);
 }
 
 //Rotate register right through Carry flag (How is this different form rrc?)
@@ -2096,9 +2431,9 @@ void GBZ80::instruction_rr_L(){
 
 void GBZ80::instruction_rr_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "rr (HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     val = instruction_rr_generic(val);
-    m_gbmemory->write(getRegisterHL(), val);
+    writeMemory(getRegisterHL(), val);
 }
 
 
@@ -2149,9 +2484,9 @@ void GBZ80::instruction_sla_L(){
 
 void GBZ80::instruction_sla_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "sla (HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     val = instruction_sla_generic(val);
-    m_gbmemory->write(getRegisterHL(), val);
+    writeMemory(getRegisterHL(), val);
 }
 
 //Shift register right into carry. MSB doesn't change
@@ -2203,9 +2538,9 @@ void GBZ80::instruction_sra_L(){
 
 void GBZ80::instruction_sra_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "sra (HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     val = instruction_sra_generic(val);
-    m_gbmemory->write(getRegisterHL(), val);
+    writeMemory(getRegisterHL(), val);
 }
 
   
@@ -2257,9 +2592,9 @@ void GBZ80::instruction_srl_L(){
 
 void GBZ80::instruction_srl_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "srl (HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     val = instruction_srl_generic(val);
-    m_gbmemory->write(getRegisterHL(), val);
+    writeMemory(getRegisterHL(), val);
 }
 
 
@@ -2313,7 +2648,7 @@ void GBZ80::instruction_bit_0_L(){
 
 void GBZ80::instruction_bit_0_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "bit " << "0,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     instruction_bit_generic(0, val);
 }
 
@@ -2354,7 +2689,7 @@ void GBZ80::instruction_bit_1_L(){
 
 void GBZ80::instruction_bit_1_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "bit " << "1,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     instruction_bit_generic(1, val);
 }
 
@@ -2395,7 +2730,7 @@ void GBZ80::instruction_bit_2_L(){
 
 void GBZ80::instruction_bit_2_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "bit " << "2,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     instruction_bit_generic(2, val);
 }
 
@@ -2436,7 +2771,7 @@ void GBZ80::instruction_bit_3_L(){
 
 void GBZ80::instruction_bit_3_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "bit " << "3,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     instruction_bit_generic(3, val);
 }
 
@@ -2477,7 +2812,7 @@ void GBZ80::instruction_bit_4_L(){
 
 void GBZ80::instruction_bit_4_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "bit " << "4,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     instruction_bit_generic(4, val);
 }
 
@@ -2518,7 +2853,7 @@ void GBZ80::instruction_bit_5_L(){
 
 void GBZ80::instruction_bit_5_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "bit " << "5,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     instruction_bit_generic(5, val);
 }
 
@@ -2559,7 +2894,7 @@ void GBZ80::instruction_bit_6_L(){
 
 void GBZ80::instruction_bit_6_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "bit " << "6,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     instruction_bit_generic(6, val);
 }
 
@@ -2600,7 +2935,7 @@ void GBZ80::instruction_bit_7_L(){
 
 void GBZ80::instruction_bit_7_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "bit " << "7,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     instruction_bit_generic(7, val);
 }
 
@@ -2647,9 +2982,9 @@ void GBZ80::instruction_set_0_L(){
 
 void GBZ80::instruction_set_0_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "set " << "0,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     val = instruction_set_generic(0, val);
-    m_gbmemory->write(getRegisterHL(), val);
+    writeMemory(getRegisterHL(), val);
 }
 
 void GBZ80::instruction_set_1_A(){
@@ -2689,9 +3024,9 @@ void GBZ80::instruction_set_1_L(){
 
 void GBZ80::instruction_set_1_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "set " << "1,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     val = instruction_set_generic(1, val);
-    m_gbmemory->write(getRegisterHL(), val);
+    writeMemory(getRegisterHL(), val);
 }
 
 void GBZ80::instruction_set_2_A(){
@@ -2731,9 +3066,9 @@ void GBZ80::instruction_set_2_L(){
 
 void GBZ80::instruction_set_2_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "set " << "2,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     val = instruction_set_generic(2, val);
-    m_gbmemory->write(getRegisterHL(), val);
+    writeMemory(getRegisterHL(), val);
 }
 
 void GBZ80::instruction_set_3_A(){
@@ -2773,9 +3108,9 @@ void GBZ80::instruction_set_3_L(){
 
 void GBZ80::instruction_set_3_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "set " << "3,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     val = instruction_set_generic(3, val);
-    m_gbmemory->write(getRegisterHL(), val);
+    writeMemory(getRegisterHL(), val);
 }
 
 void GBZ80::instruction_set_4_A(){
@@ -2815,9 +3150,9 @@ void GBZ80::instruction_set_4_L(){
 
 void GBZ80::instruction_set_4_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "set " << "4,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     val = instruction_set_generic(4, val);
-    m_gbmemory->write(getRegisterHL(), val);
+    writeMemory(getRegisterHL(), val);
 }
 
 void GBZ80::instruction_set_5_A(){
@@ -2857,9 +3192,9 @@ void GBZ80::instruction_set_5_L(){
 
 void GBZ80::instruction_set_5_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "set " << "5,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     val = instruction_set_generic(5, val);
-    m_gbmemory->write(getRegisterHL(), val);
+    writeMemory(getRegisterHL(), val);
 }
 
 void GBZ80::instruction_set_6_A(){
@@ -2899,9 +3234,9 @@ void GBZ80::instruction_set_6_L(){
 
 void GBZ80::instruction_set_6_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "set " << "6,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     val = instruction_set_generic(6, val);
-    m_gbmemory->write(getRegisterHL(), val);
+    writeMemory(getRegisterHL(), val);
 }
 
 void GBZ80::instruction_set_7_A(){
@@ -2941,9 +3276,9 @@ void GBZ80::instruction_set_7_L(){
 
 void GBZ80::instruction_set_7_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "set " << "7,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     val = instruction_set_generic(7, val);
-    m_gbmemory->write(getRegisterHL(), val);
+    writeMemory(getRegisterHL(), val);
 }
 
 uint8_t GBZ80::instruction_res_generic(uint8_t bit, uint8_t val){
@@ -2989,9 +3324,9 @@ void GBZ80::instruction_res_0_L(){
 
 void GBZ80::instruction_res_0_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "res " << "0,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     val = instruction_res_generic(0, val);
-    m_gbmemory->write(getRegisterHL(), val);
+    writeMemory(getRegisterHL(), val);
 }
 
 void GBZ80::instruction_res_1_A(){
@@ -3031,9 +3366,9 @@ void GBZ80::instruction_res_1_L(){
 
 void GBZ80::instruction_res_1_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "res " << "1,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     val = instruction_res_generic(1, val);
-    m_gbmemory->write(getRegisterHL(), val);
+    writeMemory(getRegisterHL(), val);
 }
 
 void GBZ80::instruction_res_2_A(){
@@ -3073,9 +3408,9 @@ void GBZ80::instruction_res_2_L(){
 
 void GBZ80::instruction_res_2_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "res " << "2,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     val = instruction_res_generic(2, val);
-    m_gbmemory->write(getRegisterHL(), val);
+    writeMemory(getRegisterHL(), val);
 }
 
 void GBZ80::instruction_res_3_A(){
@@ -3115,9 +3450,9 @@ void GBZ80::instruction_res_3_L(){
 
 void GBZ80::instruction_res_3_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "res " << "3,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     val = instruction_res_generic(3, val);
-    m_gbmemory->write(getRegisterHL(), val);
+    writeMemory(getRegisterHL(), val);
 }
 
 void GBZ80::instruction_res_4_A(){
@@ -3157,9 +3492,9 @@ void GBZ80::instruction_res_4_L(){
 
 void GBZ80::instruction_res_4_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "res " << "4,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     val = instruction_res_generic(4, val);
-    m_gbmemory->write(getRegisterHL(), val);
+    writeMemory(getRegisterHL(), val);
 }
 
 void GBZ80::instruction_res_5_A(){
@@ -3199,9 +3534,9 @@ void GBZ80::instruction_res_5_L(){
 
 void GBZ80::instruction_res_5_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "res " << "5,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     val = instruction_res_generic(5, val);
-    m_gbmemory->write(getRegisterHL(), val);
+    writeMemory(getRegisterHL(), val);
 }
 
 void GBZ80::instruction_res_6_A(){
@@ -3241,9 +3576,9 @@ void GBZ80::instruction_res_6_L(){
 
 void GBZ80::instruction_res_6_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "res " << "6,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     val = instruction_res_generic(6, val);
-    m_gbmemory->write(getRegisterHL(), val);
+    writeMemory(getRegisterHL(), val);
 }
 
 void GBZ80::instruction_res_7_A(){
@@ -3283,9 +3618,9 @@ void GBZ80::instruction_res_7_L(){
 
 void GBZ80::instruction_res_7_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "res " << "7,(HL)" << "\n";
-    uint8_t val = m_gbmemory->read(getRegisterHL());
+    uint8_t val = readMemory(getRegisterHL());
     val = instruction_res_generic(7, val);
-    m_gbmemory->write(getRegisterHL(), val);
+    writeMemory(getRegisterHL(), val);
 }
 
 //Jump instructions
@@ -3293,7 +3628,7 @@ void GBZ80::instruction_res_7_HLI(){
 //Jumps to the given address
 void GBZ80::instruction_jp(uint16_t nn){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "jp " << nn << "\n";
-    PC = nn;
+    m_hot.PC = nn;
 }
 
 //Jumps to the given address if NZ
@@ -3301,7 +3636,7 @@ void GBZ80::instruction_jp_NZ(uint16_t nn){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "jp nz," << nn << "\n";
     if(!getFlag_Z()){
         if(CONSOLE_OUTPUT_ENABLED) std::cout << "Z is not zero. Jumping" << "\n";
-        PC = nn;
+        m_hot.PC = nn;
     } else {
         if(CONSOLE_OUTPUT_ENABLED) std::cout << "Z is zero. Not jumping" << "\n";
     }
@@ -3312,7 +3647,7 @@ void GBZ80::instruction_jp_Z(uint16_t nn){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "jp z," << nn << "\n";
     if(getFlag_Z()){
         if(CONSOLE_OUTPUT_ENABLED) std::cout << "Z is zero. Jumping" << "\n";
-        PC = nn;
+        m_hot.PC = nn;
     } else {
         if(CONSOLE_OUTPUT_ENABLED) std::cout << "Z is not zero. Not jumping." << "\n";
     }
@@ -3324,7 +3659,7 @@ void GBZ80::instruction_jp_NC(uint16_t nn){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "jp nc," << nn << "\n";
     if(!getFlag_C()){
         if(CONSOLE_OUTPUT_ENABLED) std::cout << "C is not set. Jumping" << "\n";
-        PC = nn;
+        m_hot.PC = nn;
     } else {
         if(CONSOLE_OUTPUT_ENABLED) std::cout << "C is set. Not jumping" << "\n";
     }
@@ -3335,7 +3670,7 @@ void GBZ80::instruction_jp_C(uint16_t nn){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "jp c," << nn << "\n";
     if(getFlag_C()){
         if(CONSOLE_OUTPUT_ENABLED) std::cout << "C is set. Jumping" << "\n";
-        PC = nn;
+        m_hot.PC = nn;
     } else {
         if(CONSOLE_OUTPUT_ENABLED) std::cout << "C is not set. Not jumping" << "\n";
     }
@@ -3345,23 +3680,23 @@ void GBZ80::instruction_jp_C(uint16_t nn){
 //TODO - RENAME TO jp HL SINCE THIS IS NOT ACTUALLY AN INDIRECT INSTRUCTION ACCORDING TO BGB!!!
 void GBZ80::instruction_jp_HLI(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "jp HL" << "\n";
-    PC = HL;
+    m_hot.PC = m_hot.HL;
 }
 
 
 //Adds n to current address and jumps to it
 void GBZ80::instruction_jr(int8_t n){
-    if(CONSOLE_OUTPUT_ENABLED) std::cout << "jr " << +(PC + n) << " (PC + " << +n  << ")" << "\n";
-    PC += n;
+    if(CONSOLE_OUTPUT_ENABLED) std::cout << "jr " << +(m_hot.PC + n) << " (PC + " << +n  << ")" << "\n";
+    m_hot.PC += n;
 }
 
 //Adds n to current address and jumps to it if NZ
 void GBZ80::instruction_jr_NZ(int8_t n){
-    if(CONSOLE_OUTPUT_ENABLED) std::cout << "jr nz," << +(PC + n)  << " (PC + " << +n  << ")" << "\n";
+    if(CONSOLE_OUTPUT_ENABLED) std::cout << "jr nz," << +(m_hot.PC + n)  << " (PC + " << +n  << ")" << "\n";
     
     if(!getFlag_Z()){
         if(CONSOLE_OUTPUT_ENABLED) std::cout << "Z is not zero. Jumping" << "\n";
-        PC += n;
+        m_hot.PC += n;
     } else {
         if(CONSOLE_OUTPUT_ENABLED) std::cout << "Z is zero. Not jumping" << "\n";
     }
@@ -3369,10 +3704,10 @@ void GBZ80::instruction_jr_NZ(int8_t n){
   
 //Adds n to current address and jumps to it if Z
 void GBZ80::instruction_jr_Z(int8_t n){
-    if(CONSOLE_OUTPUT_ENABLED) std::cout << "jr z," << +(PC + n) << " (PC + " << +n  << ")" << "\n";
+    if(CONSOLE_OUTPUT_ENABLED) std::cout << "jr z," << +(m_hot.PC + n) << " (PC + " << +n  << ")" << "\n";
     if(getFlag_Z()){
         if(CONSOLE_OUTPUT_ENABLED) std::cout << "Z is zero. Jumping" << "\n";
-        PC += n;
+        m_hot.PC += n;
     } else {
         if(CONSOLE_OUTPUT_ENABLED) std::cout << "Z is not zero. Not jumping" << "\n";
     }
@@ -3380,10 +3715,10 @@ void GBZ80::instruction_jr_Z(int8_t n){
   
 //Adds n to current address and jumps to it if NC
 void GBZ80::instruction_jr_NC(int8_t n){
-    if(CONSOLE_OUTPUT_ENABLED) std::cout << "jr nc," << +(PC + n) << " (PC + " << +n  << ")" << "\n";
+    if(CONSOLE_OUTPUT_ENABLED) std::cout << "jr nc," << +(m_hot.PC + n) << " (PC + " << +n  << ")" << "\n";
     if(!getFlag_C()){
         if(CONSOLE_OUTPUT_ENABLED) std::cout << "C is not set. Jumping" << "\n";
-        PC += n;
+        m_hot.PC += n;
     } else {
         if(CONSOLE_OUTPUT_ENABLED) std::cout << "C is set. Not jumping" << "\n";
     }
@@ -3391,10 +3726,10 @@ void GBZ80::instruction_jr_NC(int8_t n){
   
 //Adds n to current address and jumps to it if C
 void GBZ80::instruction_jr_C(int8_t n){
-    if(CONSOLE_OUTPUT_ENABLED) std::cout << "jr c," << +(PC + n) << " (PC + " << +n  << ")" << "\n";
+    if(CONSOLE_OUTPUT_ENABLED) std::cout << "jr c," << +(m_hot.PC + n) << " (PC + " << +n  << ")" << "\n";
     if(getFlag_C()){
         if(CONSOLE_OUTPUT_ENABLED) std::cout << "C is set. Jumping" << "\n";
-        PC += n;
+        m_hot.PC += n;
     } else {
         if(CONSOLE_OUTPUT_ENABLED) std::cout << "C is not set. Not jumping" << "\n";
     }
@@ -3405,8 +3740,8 @@ void GBZ80::instruction_jr_C(int8_t n){
 //Push address of next instruction onto stack and jump to address nn
 void GBZ80::instruction_call(uint16_t nn){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "call " << nn;
-    instruction_push_generic(PC);
-    PC = nn;
+    instruction_push_generic(m_hot.PC);
+    m_hot.PC = nn;
 }
 
 //Calls address nn if NZ
@@ -3458,50 +3793,50 @@ void GBZ80::instruction_call_C(uint16_t nn){
 //Push present address onto stack and jump to $0000 + hex constant
 void GBZ80::instruction_rst_00H(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "rst 00H" << "\n";
-    instruction_push_generic(PC);
-    PC = 0x00;
+    instruction_push_generic(m_hot.PC);
+    m_hot.PC = 0x00;
 }
 
 void GBZ80::instruction_rst_08H(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "rst 08H" << "\n";
-    instruction_push_generic(PC);
-    PC = 0x08;
+    instruction_push_generic(m_hot.PC);
+    m_hot.PC = 0x08;
 }
 
 void GBZ80::instruction_rst_10H(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "rst 10H" << "\n";
-    instruction_push_generic(PC);
-    PC = 0x10;
+    instruction_push_generic(m_hot.PC);
+    m_hot.PC = 0x10;
 }
 
 void GBZ80::instruction_rst_18H(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "rst 18H" << "\n";
-    instruction_push_generic(PC);
-    PC = 0x18;
+    instruction_push_generic(m_hot.PC);
+    m_hot.PC = 0x18;
 }
 
 void GBZ80::instruction_rst_20H(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "rst 20H" << "\n";
-    instruction_push_generic(PC);
-    PC = 0x20;
+    instruction_push_generic(m_hot.PC);
+    m_hot.PC = 0x20;
 }
 
 void GBZ80::instruction_rst_28H(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "rst 28H" << "\n";
-    instruction_push_generic(PC);
-    PC = 0x28;
+    instruction_push_generic(m_hot.PC);
+    m_hot.PC = 0x28;
 }
 
 void GBZ80::instruction_rst_30H(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "rst 30H" << "\n";
-    instruction_push_generic(PC);
-    PC = 0x30;
+    instruction_push_generic(m_hot.PC);
+    m_hot.PC = 0x30;
 }
 
 void GBZ80::instruction_rst_38H(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "rst 38H" << "\n";
-    instruction_push_generic(PC);
-    PC = 0x38;
+    instruction_push_generic(m_hot.PC);
+    m_hot.PC = 0x38;
 }
 
 //Return instructions
@@ -3509,7 +3844,7 @@ void GBZ80::instruction_rst_38H(){
 //Pop two bytes from stack and jump to that address
 void GBZ80::instruction_ret(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ret" << "\n";
-    PC = instruction_pop_generic();
+    m_hot.PC = instruction_pop_generic();
 }
 
 //Pop two bytes from stack and jump to that address if NZ
@@ -3517,7 +3852,7 @@ void GBZ80::instruction_ret_NZ(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ret nz" << "\n";
     if(!getFlag_Z()){
         if(CONSOLE_OUTPUT_ENABLED) std::cout << "Z is not zero. Returning" << "\n";
-        PC = instruction_pop_generic();
+        m_hot.PC = instruction_pop_generic();
     } else {
         if(CONSOLE_OUTPUT_ENABLED) std::cout << "Z is zero. Not returning" << "\n";
     }
@@ -3528,7 +3863,7 @@ void GBZ80::instruction_ret_Z(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ret z" << "\n";
     if(getFlag_Z()){
         if(CONSOLE_OUTPUT_ENABLED) std::cout << "Z is zero. Returning" << "\n";
-        PC = instruction_pop_generic();
+        m_hot.PC = instruction_pop_generic();
     } else {
         if(CONSOLE_OUTPUT_ENABLED) std::cout << "Z is not zero. Not returning" << "\n";
     }
@@ -3539,7 +3874,7 @@ void GBZ80::instruction_ret_NC(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ret nc" << "\n";
     if(!getFlag_C()){
         if(CONSOLE_OUTPUT_ENABLED) std::cout << "C is not set. Returning" << "\n";
-        PC = instruction_pop_generic();
+        m_hot.PC = instruction_pop_generic();
     } else {
         if(CONSOLE_OUTPUT_ENABLED) std::cout << "C is set. Not returning" << "\n";
     }
@@ -3550,7 +3885,7 @@ void GBZ80::instruction_ret_C(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "ret c" << "\n";
     if(getFlag_C()){
         if(CONSOLE_OUTPUT_ENABLED) std::cout << "C is set. Returning" << "\n";
-        PC = instruction_pop_generic();
+        m_hot.PC = instruction_pop_generic();
     } else {
         if(CONSOLE_OUTPUT_ENABLED) std::cout << "C is not set. Not returning" << "\n";
     }
@@ -3559,398 +3894,213 @@ void GBZ80::instruction_ret_C(){
 //Pop two bytes from stack, jump to that address, then enable interrupts (Immediately? Or after one instruction?)
 void GBZ80::instruction_reti(){
     if(CONSOLE_OUTPUT_ENABLED) std::cout << "reti" << "\n";
-    PC = instruction_pop_generic();
+    m_hot.PC = instruction_pop_generic();
     //This enables interrupts on the next instruction, not after next. Unsure if correct
     
     //Set both interrupt flags at once so that the next flag won't undo the current flag. 
-    m_bInterruptsEnabled = true;
-    m_bInterruptsEnabledNext = false;
+    m_hot.bInterruptsEnabled = true;
+    m_hot.bInterruptsEnabledNext = false;
 }
 
 //Execution functions
 
-//Grabs the next byte and increments PC
-uint8_t GBZ80::read_next_byte(){
-    uint8_t next = m_gbmemory->read(getRegisterPC());
-    PC++;
-    return next;
-}
-
-//Grabs the next two bytes and increments PC twice
-uint16_t GBZ80::read_next_word(){
-    uint16_t next = 0;
-    next = read_next_byte();
-    next = setMSB(next, read_next_byte());
-    return next;
-}
-
-//Returns the cycle length for the passed in opcode
-int GBZ80::get_cycle_length(uint8_t opcode){
-    //Default to 4 since this is the minimum cycle length for an instruction
-    int toReturn = 4;
-    
-    //Coppied and adapted from process_opcode
-    uint16_t cbop = 0;
-    
-    switch(opcode){
-        case OP_LD_A_CONST:
-        case OP_LD_B:
-        case OP_LD_C:
-        case OP_LD_D:
-        case OP_LD_E:
-        case OP_LD_H:
-        case OP_LD_L:
-            toReturn = CYCLES_OP_LD_R_N;
-            break;
-        case OP_LD_A_A:
-        case OP_LD_A_B:
-        case OP_LD_A_C:
-        case OP_LD_A_D:
-        case OP_LD_A_E:
-        case OP_LD_A_H:
-        case OP_LD_A_L:
-        case OP_LD_B_A:
-        case OP_LD_B_B:
-        case OP_LD_B_C:
-        case OP_LD_B_D:
-        case OP_LD_B_E:
-        case OP_LD_B_H:
-        case OP_LD_B_L:
-        case OP_LD_C_A:
-        case OP_LD_C_B:
-        case OP_LD_C_C:
-        case OP_LD_C_D:
-        case OP_LD_C_E:
-        case OP_LD_C_H:
-        case OP_LD_C_L:
-        case OP_LD_D_A:
-        case OP_LD_D_B:
-        case OP_LD_D_C:
-        case OP_LD_D_D:
-        case OP_LD_D_E:
-        case OP_LD_D_H:
-        case OP_LD_D_L:
-        case OP_LD_E_A:
-        case OP_LD_E_B:
-        case OP_LD_E_C:
-        case OP_LD_E_D:
-        case OP_LD_E_E:
-        case OP_LD_E_H:
-        case OP_LD_E_L:
-        case OP_LD_H_A:
-        case OP_LD_H_B:
-        case OP_LD_H_C:
-        case OP_LD_H_D:
-        case OP_LD_H_E:
-        case OP_LD_H_H:
-        case OP_LD_H_L:
-        case OP_LD_L_A:
-        case OP_LD_L_B:
-        case OP_LD_L_C:
-        case OP_LD_L_D:
-        case OP_LD_L_E:
-        case OP_LD_L_H:
-        case OP_LD_L_L:
-            toReturn = CYCLES_OP_LD_R_R;
-            break;
-        case OP_LD_A_HLI:
-        case OP_LD_B_HLI:
-        case OP_LD_C_HLI:
-        case OP_LD_D_HLI:
-        case OP_LD_E_HLI:
-        case OP_LD_H_HLI:
-        case OP_LD_L_HLI:
-        case OP_LD_HLI_A:
-        case OP_LD_HLI_B:
-        case OP_LD_HLI_C:
-        case OP_LD_HLI_D:
-        case OP_LD_HLI_E:
-        case OP_LD_HLI_H:
-        case OP_LD_HLI_L:
-        case OP_LD_A_BCI:
-        case OP_LD_A_DEI:
-        case OP_LD_BCI_A:
-        case OP_LD_DEI_A:
-            toReturn = CYCLES_OP_LD_R_RRI;
-            break;        
-        case OP_LD_HLI_N:
-            toReturn = CYCLES_OP_LD_HLI_N;
-            break;
-        case OP_LD_A_NNI:
-        case OP_LD_NNI_A:
-            toReturn = CYCLES_OP_LD_NNI_R;
-            break;
-        case OP_LD_A_FF00CI:
-        case OP_LD_FF00CI_A:
-            toReturn = CYCLES_OP_LD_FF00CI;
-            break;
-        case OP_LDD_A_HLI:
-        case OP_LDD_HLI_A:
-            toReturn = CYCLES_OP_LDD;
-            break;
-        case OP_LDI_A_HLI:
-        case OP_LDI_HLI_A:
-            toReturn = CYCLES_OP_LDI;
-            break;
-        case OP_LDH_FF00NI_A:
-        case OP_LDH_A_FF00NI:
-            toReturn = CYCLES_OP_LDH;
-            break;
-        case OP_LD_BC_NN:
-        case OP_LD_DE_NN:
-        case OP_LD_HL_NN:
-        case OP_LD_SP_NN:
-            toReturn = CYCLES_OP_LD_RR_NN;
-            break;
-        case OP_LD_SP_HL:
-            toReturn = CYCLES_OP_LD_SP_HL;
-            break;
-        case OP_LDHL_SP_N:
-            toReturn = CYCLES_OP_LDHL;
-            break;
-        case OP_LD_NNI_SP:
-            toReturn = CYCLES_OP_LD_NNI_SP;
-            break;
-        case OP_PUSH_AF:
-        case OP_PUSH_BC:
-        case OP_PUSH_DE:
-        case OP_PUSH_HL:
-            toReturn = CYCLES_OP_PUSH;
-            break;
-        case OP_POP_AF:
-        case OP_POP_BC:
-        case OP_POP_DE:
-        case OP_POP_HL:
-            toReturn = CYCLES_OP_POP;
-            break;
-        case OP_ADD_A:
-        case OP_ADD_B:
-        case OP_ADD_C:
-        case OP_ADD_D:
-        case OP_ADD_E:
-        case OP_ADD_H:
-        case OP_ADD_L:
-            toReturn = CYCLES_OP_ADD_R;
-            break;
-        case OP_ADD_HLI:
-            toReturn = CYCLES_OP_ADD_HLI;
-            break;
-        case OP_ADD_CONST:
-            toReturn = CYCLES_OP_ADD_N;
-            break;
-        case OP_ADC_A:
-        case OP_ADC_B:
-        case OP_ADC_C:
-        case OP_ADC_D:
-        case OP_ADC_E:
-        case OP_ADC_H:
-        case OP_ADC_L:
-            toReturn = CYCLES_OP_ADC_R;
-            break;
-        case OP_ADC_HLI:
-            toReturn = CYCLES_OP_ADC_HLI;
-            break;
-        case OP_ADC_CONST:
-            toReturn = CYCLES_OP_ADC_N;
-            break;
-        case OP_SUB_A:
-        case OP_SUB_B:
-        case OP_SUB_C:
-        case OP_SUB_D:
-        case OP_SUB_E:
-        case OP_SUB_H:
-        case OP_SUB_L:
-            toReturn = CYCLES_OP_SUB_R;
-            break;
-        case OP_SUB_HLI:
-            toReturn = CYCLES_OP_SUB_HLI;
-            break;
-        case OP_SUB_CONST:
-            toReturn = CYCLES_OP_SUB_N;
-            break;
-        case OP_SBC_A:
-        case OP_SBC_B:
-        case OP_SBC_C:
-        case OP_SBC_D:
-        case OP_SBC_E:
-        case OP_SBC_H:
-        case OP_SBC_L:
-            toReturn = CYCLES_OP_SBC_R;
-            break;
-        case OP_SBC_HLI:
-            toReturn = CYCLES_OP_SBC_HLI;
-            break;
-        case OP_SBC_CONST:
-            toReturn = CYCLES_OP_SBC_N;
-            break;
-        case OP_AND_A:
-        case OP_AND_B:
-        case OP_AND_C:
-        case OP_AND_D:
-        case OP_AND_E:
-        case OP_AND_H:
-        case OP_AND_L:
-            toReturn = CYCLES_OP_AND_R;
-            break;
-        case OP_AND_HLI:
-            toReturn = CYCLES_OP_AND_HLI;
-            break;
-        case OP_AND_CONST:
-            toReturn = CYCLES_OP_AND_N;
-            break;
-        case OP_OR_A:
-        case OP_OR_B:
-        case OP_OR_C:
-        case OP_OR_D:
-        case OP_OR_E:
-        case OP_OR_H:
-        case OP_OR_L:
-            toReturn = CYCLES_OP_OR_R;
-            break;
-        case OP_OR_HLI:
-            toReturn = CYCLES_OP_OR_HLI;
-            break;
-        case OP_OR_CONST:
-            toReturn = CYCLES_OP_OR_N;
-            break;
-        case OP_XOR_A:
-        case OP_XOR_B:
-        case OP_XOR_C:
-        case OP_XOR_D:
-        case OP_XOR_E:
-        case OP_XOR_H:
-        case OP_XOR_L:
-            toReturn = CYCLES_XOR_R;
-            break;
-        case OP_XOR_HLI:
-            toReturn = CYCLES_XOR_HLI;
-            break;
-        case OP_XOR_CONST:
-            toReturn = CYCLES_XOR_N;
-            break;
-        case OP_CP_A:
-        case OP_CP_B:
-        case OP_CP_C:
-        case OP_CP_D:
-        case OP_CP_E:
-        case OP_CP_H:
-        case OP_CP_L:
-            toReturn = CYCLES_CP_R;
-            break;
-        case OP_CP_HLI:
-            toReturn = CYCLES_CP_HLI;
-            break;
-        case OP_CP_CONST:
-            toReturn = CYCLES_CP_N;
-            break;
-        case OP_INC_A:
-        case OP_INC_B:
-        case OP_INC_C:
-        case OP_INC_D:
-        case OP_INC_E:
-        case OP_INC_H:
-        case OP_INC_L:
-            toReturn = CYCLES_INC_R;
-            break;
-        case OP_INC_HLI:
-            toReturn = CYCLES_INC_HLI;
-            break;
-        case OP_DEC_A:
-        case OP_DEC_B:
-        case OP_DEC_C:
-        case OP_DEC_D:
-        case OP_DEC_E:
-        case OP_DEC_H:
-        case OP_DEC_L:
-            toReturn = CYCLES_DEC_R;
-            break;
-        case OP_DEC_HLI:
-            toReturn = CYCLES_DEC_HLI;
-            break;
-        case OP_ADD_BC:
-        case OP_ADD_DE:
-        case OP_ADD_HL:
-        case OP_ADD_SP:
-            toReturn = CYCLES_ADD_HL_RR;
-            break;
-        case OP_ADD_SP_CONST:
-            toReturn = CYCLES_ADD_SP_N;
-            break;
-        case OP_INC_BC:
-        case OP_INC_DE:
-        case OP_INC_HL:
-        case OP_INC_SP:
-            toReturn = CYCLES_INC_RR;
-            break;
-        case OP_DEC_BC:
-        case OP_DEC_DE:
-        case OP_DEC_HL:
-        case OP_DEC_SP:
-            toReturn = CYCLES_DEC_RR;
-            break;
-        //SWAP instructions appear later with other CB prefixes
-        case OP_DAA:
-            toReturn = CYCLES_DAA;
-            break;
-        case OP_CPL:
-            toReturn = CYCLES_CPL;
-            break;
-        case OP_CCF:
-            toReturn = CYCLES_CCF;
-            break;
-        case OP_SCF:
-            toReturn = CYCLES_SCF;
-            break;
-        case OP_NOP:
-            toReturn = CYCLES_NOP;
-            break;
-        case OP_HALT:
-            toReturn = CYCLES_HALT;
-            break;
-        //Stop is at end since it is a two byte opcode
-        case OP_DI:
-            toReturn = CYCLES_DI;
-            break;
-        case OP_EI:
-            toReturn = CYCLES_EI;
-            break;
-        case OP_RLCA:
-            toReturn = CYCLES_RLCA;
-            break;
-        case OP_RLA:
-            toReturn = CYCLES_RLA;
-            break;
-        case OP_RRCA:
-            toReturn = CYCLES_RRCA;
+//Decodes the instruction at the given address into a micro-op, including its immediate operand.
+//CB prefixed opcodes are looked up by the byte following the prefix.
+void GBZ80::decode_opcode(uint16_t address, MicroOp& op){
+    op.opcode = readMemory(address);
+    
+    if(op.opcode == OP_IS_CB_PREFIXED){
+        op.entry = &s_cbOpcodeTable[readMemory(address + 1)];
+    } else {
+        op.entry = &s_opcodeTable[op.opcode];
+    }
+    
+    op.address = address;
+    op.length = op.entry->length + op.entry->operandLength;
+    
+    //Operand immediately follows the opcode
+    uint16_t operandAddress = address + op.entry->length;
+    op.operand = 0;
+    if(op.entry->operandLength == 1){
+        op.operand = readMemory(operandAddress);
+    } else if(op.entry->operandLength == 2){
+        op.operand = readMemory(operandAddress);
+        op.operand = setMSB(op.operand, readMemory(operandAddress + 1));
+    }
+}
+
+//Returns the micro-op for the instruction at PC. Comes from the block cache when possible.
+const GBZ80::MicroOp* GBZ80::fetch_micro_op(){
+    if(USE_BLOCK_CACHE){
+        //Keep stepping through the current block as long as nothing has been banked in or written over it
+        bool bBlockValid = (m_hot.currentBlock != NULL) && (m_hot.currentBlockMapVersion == m_gbmemory->getCodeMapVersion());
+        if(bBlockValid && m_hot.currentBlock->bIsRam){
+            bBlockValid = (m_hot.currentBlock->pageVersion == m_gbmemory->getCodePageVersion(m_hot.currentBlock->startAddress));
+        }
+        
+        if(bBlockValid){
+            if((m_hot.currentBlockIndex < m_hot.currentBlock->ops.size()) && (m_hot.currentBlock->ops[m_hot.currentBlockIndex].address == m_hot.PC)){
+                return &m_hot.currentBlock->ops[m_hot.currentBlockIndex];
+            }
+            
+            //Tight loops jump back to the start of the block they are in
+            if(m_hot.currentBlock->startAddress == m_hot.PC){
+                m_hot.currentBlockIndex = 0;
+                return &m_hot.currentBlock->ops[0];
+            }
+        }
+        
+        m_hot.currentBlock = find_block(m_hot.PC);
+        m_hot.currentBlockIndex = 0;
+        m_hot.currentBlockMapVersion = m_gbmemory->getCodeMapVersion();
+        
+        if(m_hot.currentBlock != NULL){
+            return &m_hot.currentBlock->ops[0];
+        }
+    }
+    
+    //Code that can't be cached is decoded every time
+    decode_opcode(m_hot.PC, m_uncachedOp);
+    return &m_uncachedOp;
+}
+
+//Calls the handler for a micro-op
+void GBZ80::execute_micro_op(const MicroOp* op){
+    //Show debug prompt if needed. //TODO - replace false with breakpoint check.
+    if(m_bSingleStep || false){
+        showDebugPrompt();
+    }
+    
+    //Step to the next micro-op in the block
+    if(op != &m_uncachedOp){
+        m_hot.currentBlockIndex++;
+    }
+    
+    //Step past the whole instruction. Handlers take their operand from m_hot.operand.
+    m_hot.PC = op->address + op->length;
+    m_hot.operand = op->operand;
+    (this->*(op->entry->handler))();
+}
+
+//Finds which cache region an address belongs to. Returns false if code at the address isn't cached.
+bool GBZ80::get_block_region(uint16_t address, uint32_t& key, bool& bIsRam, uint16_t& regionEnd){
+    uint16_t bank = 0;
+    bIsRam = false;
+    
+    if(address <= ROM_BANK_0_END){
+        //Boot rom only runs once, not worth caching
+        if(m_gbmemory->getBootRomEnabled() && (address < BLOCK_CACHE_BOOTROM_END)){
+            return false;
+        }
+        regionEnd = ROM_BANK_0_END;
+    } else if(address <= ROM_BANK_N_END){
+        bank = m_gbmemory->getRomBank();
+        regionEnd = ROM_BANK_N_END;
+    } else if((address >= WRAM_BANK_0_START) && (address <= WRAM_BANK_0_END)){
+        bIsRam = true;
+        regionEnd = address | 0xFF;
+    } else if((address >= WRAM_BANK_1_START) && (address <= WRAM_BANK_1_END)){
+        bank = m_gbmemory->getWRamBank();
+        bIsRam = true;
+        regionEnd = address | 0xFF;
+    } else if((address >= HRAM_START) && (address <= HRAM_END)){
+        bIsRam = true;
+        regionEnd = HRAM_END;
+    } else {
+        //VRam, cart ram, echo ram and IO are always interpreted
+        return false;
+    }
+    
+    key = (bank << 16) | address;
+    return true;
+}
+
+//Returns the cached block starting at the given address, decoding it if needed. Returns NULL if the code can't be cached.
+GBZ80::CodeBlock* GBZ80::find_block(uint16_t address){
+    uint32_t key = 0;
+    bool bIsRam = false;
+    uint16_t regionEnd = 0;
+    if(!get_block_region(address, key, bIsRam, regionEnd)){
+        return NULL;
+    }
+    
+    CodeBlock*& block = m_blockCache[key];
+    if(block == NULL){
+        block = new CodeBlock();
+        build_block(block, address, bIsRam, regionEnd);
+    } else if(bIsRam && (block->pageVersion != m_gbmemory->getCodePageVersion(address))){
+        //Ram has been written to since the block was decoded
+        build_block(block, address, bIsRam, regionEnd);
+    }
+    
+    if(block->ops.empty()){
+        return NULL;
+    }
+    
+    return block;
+}
+
+//Decodes instructions starting at the given address until a jump or the end of the region
+void GBZ80::build_block(CodeBlock* block, uint16_t address, bool bIsRam, uint16_t regionEnd){
+    block->ops.clear();
+    block->startAddress = address;
+    block->bIsRam = bIsRam;
+    block->pageVersion = m_gbmemory->getCodePageVersion(address);
+    block->execCount = 0;
+    block->jitCode = NULL;
+    block->cycles = 0;
+    block->idleLoopRegister = 0;
+    block->idleLoopCycles = 0;
+    
+    uint32_t currentAddress = address;
+    while(block->ops.size() < BLOCK_CACHE_MAX_OPS){
+        MicroOp op;
+        decode_opcode(currentAddress, op);
+        
+        //Instructions crossing the end of the region are left to the interpreter
+        if((currentAddress + op.length - 1) > regionEnd){
             break;
-        case OP_RRA:
-            toReturn = CYCLES_RRA;
+        }
+        
+        block->ops.push_back(op);
+        block->cycles += op.entry->cycles;
+        
+        if(get_ends_block(op)){
             break;
-        //CB instructions appear after all single byte opcodes
+        }
+        
+        currentAddress += op.length;
+    }
+    
+    find_idle_loop(block);
+    
+    if(CONSOLE_OUTPUT_ENABLED) std::cout << "Decoded block at " << +address << " with " << block->ops.size() << " ops" << std::endl;
+}
+
+//Returns true if the micro-op can move PC somewhere other than the next instruction
+bool GBZ80::get_ends_block(const MicroOp& op){
+    //Unused opcodes stop the processor
+    if(op.entry->handler == &GBZ80::opcode_invalid){
+        return true;
+    }
+    
+    switch(op.opcode){
         case OP_JP:
         case OP_JP_NZ:
         case OP_JP_Z:
         case OP_JP_NC:
         case OP_JP_C:
-            toReturn = CYCLES_JP_NN;
-            break;
         case OP_JP_HLI:
-            toReturn = CYCLES_JP_HLI;
-            break;
         case OP_JR:
         case OP_JR_NZ:
         case OP_JR_Z:
         case OP_JR_NC:
         case OP_JR_C:
-            toReturn = CYCLES_JR;
-            break;
         case OP_CALL:
         case OP_CALL_NZ:
         case OP_CALL_Z:
         case OP_CALL_NC:
         case OP_CALL_C:
-            toReturn = CYCLES_CALL;
-            break;
         case OP_RST_00H:
         case OP_RST_08H:
         case OP_RST_10H:
@@ -3959,1909 +4109,1075 @@ int GBZ80::get_cycle_length(uint8_t opcode){
         case OP_RST_28H:
         case OP_RST_30H:
         case OP_RST_38H:
-            toReturn = CYCLES_RST;
-            break;
         case OP_RET:
         case OP_RET_NZ:
         case OP_RET_Z:
         case OP_RET_NC:
         case OP_RET_C:
         case OP_RETI:
-            toReturn = CYCLES_RET;
-            break;
+        case OP_HALT:
         case OP_STOP8:
-            toReturn = CYCLES_STOP;
-            break;
-        case OP_IS_CB_PREFIXED:
-            cbop = setMSB(m_gbmemory->read(PC + 1), opcode);
-            if(CONSOLE_OUTPUT_ENABLED) std::cout << "cbopcode: " << +cbop << "\n";
-            switch(cbop){
-                case OP_SWAP_A:
-                case OP_SWAP_B:
-                case OP_SWAP_C:
-                case OP_SWAP_D:
-                case OP_SWAP_E:
-                case OP_SWAP_H:
-                case OP_SWAP_L:
-                    toReturn = CYCLES_SWAP_R;
-                    break;
-                case OP_SWAP_HLI:
-                    toReturn = CYCLES_SWAP_HLI;
-                    break;
-                case OP_RLC_A:
-                case OP_RLC_B:
-                case OP_RLC_C:
-                case OP_RLC_D:
-                case OP_RLC_E:
-                case OP_RLC_H:
-                case OP_RLC_L:
-                    toReturn = CYCLES_RLC_R;
-                    break;
-                case OP_RLC_HLI:
-                    toReturn = CYCLES_RLC_HLI;
-                    break;
-                case OP_RL_A:
-                case OP_RL_B:
-                case OP_RL_C:
-                case OP_RL_D:
-                case OP_RL_E:
-                case OP_RL_H:
-                case OP_RL_L:
-                    toReturn = CYCLES_RL_R;
-                    break;
-                case OP_RL_HLI:
-                    toReturn = CYCLES_RL_HLI;
-                    break;
-                case OP_RRC_A:
-                case OP_RRC_B:
-                case OP_RRC_C:
-                case OP_RRC_D:
-                case OP_RRC_E:
-                case OP_RRC_H:
-                case OP_RRC_L:
-                    toReturn = CYCLES_RRC_R;
-                    break;
-                case OP_RRC_HLI:
-                    toReturn = CYCLES_RRC_HLI;
-                    break;
-                case OP_RR_A:
-                case OP_RR_B:
-                case OP_RR_C:
-                case OP_RR_D:
-                case OP_RR_E:
-                case OP_RR_H:
-                case OP_RR_L:
-                    toReturn = CYCLES_RR_R;
-                    break;
-                case OP_RR_HLI:
-                    toReturn = CYCLES_RR_HLI;
-                    break;
-                case OP_SLA_A:
-                case OP_SLA_B:
-                case OP_SLA_C:
-                case OP_SLA_D:
-                case OP_SLA_E:
-                case OP_SLA_H:
-                case OP_SLA_L:
-                    toReturn = CYCLES_SLA_R;
-                    break;
-                case OP_SLA_HLI:
-                    toReturn = CYCLES_SLA_HLI;
-                    break;
-                case OP_SRA_A:
-                case OP_SRA_B:
-                case OP_SRA_C:
-                case OP_SRA_D:
-                case OP_SRA_E:
-                case OP_SRA_H:
-                case OP_SRA_L:
-                    toReturn = CYCLES_SRA_R;
-                    break;
-                case OP_SRA_HLI:
-                    toReturn = CYCLES_SRA_HLI;
-                    break;
-                case OP_SRL_A:
-                case OP_SRL_B:
-                case OP_SRL_C:
-                case OP_SRL_D:
-                case OP_SRL_E:
-                case OP_SRL_H:
-                case OP_SRL_L:
-                    toReturn = CYCLES_SRL_R;
-                    break;
-                case OP_SRL_HLI:
-                    toReturn = CYCLES_SRL_HLI;
-                    break;
-                case OP_BIT_0_A:
-                case OP_BIT_0_B:
-                case OP_BIT_0_C:
-                case OP_BIT_0_D:
-                case OP_BIT_0_E:
-                case OP_BIT_0_H:
-                case OP_BIT_0_L:
-                case OP_BIT_1_A:
-                case OP_BIT_1_B:
-                case OP_BIT_1_C:
-                case OP_BIT_1_D:
-                case OP_BIT_1_E:
-                case OP_BIT_1_H:
-                case OP_BIT_1_L:
-                case OP_BIT_2_A:
-                case OP_BIT_2_B:
-                case OP_BIT_2_C:
-                case OP_BIT_2_D:
-                case OP_BIT_2_E:
-                case OP_BIT_2_H:
-                case OP_BIT_2_L:
-                case OP_BIT_3_A:
-                case OP_BIT_3_B:
-                case OP_BIT_3_C:
-                case OP_BIT_3_D:
-                case OP_BIT_3_E:
-                case OP_BIT_3_H:
-                case OP_BIT_3_L:
-                case OP_BIT_4_A:
-                case OP_BIT_4_B:
-                case OP_BIT_4_C:
-                case OP_BIT_4_D:
-                case OP_BIT_4_E:
-                case OP_BIT_4_H:
-                case OP_BIT_4_L:
-                case OP_BIT_5_A:
-                case OP_BIT_5_B:
-                case OP_BIT_5_C:
-                case OP_BIT_5_D:
-                case OP_BIT_5_E:
-                case OP_BIT_5_H:
-                case OP_BIT_5_L:
-                case OP_BIT_6_A:
-                case OP_BIT_6_B:
-                case OP_BIT_6_C:
-                case OP_BIT_6_D:
-                case OP_BIT_6_E:
-                case OP_BIT_6_H:
-                case OP_BIT_6_L:
-                case OP_BIT_7_A:
-                case OP_BIT_7_B:
-                case OP_BIT_7_C:
-                case OP_BIT_7_D:
-                case OP_BIT_7_E:
-                case OP_BIT_7_H:
-                case OP_BIT_7_L:
-                    toReturn = CYCLES_BIT_B_R;
-                    break;
-                case OP_BIT_0_HLI:
-                case OP_BIT_1_HLI:
-                case OP_BIT_2_HLI:
-                case OP_BIT_3_HLI:
-                case OP_BIT_4_HLI:
-                case OP_BIT_5_HLI:
-                case OP_BIT_6_HLI:
-                case OP_BIT_7_HLI:
-                    toReturn = CYCLES_BIT_B_HLI;
-                    break;
-                case OP_SET_0_A:
-                case OP_SET_0_B:
-                case OP_SET_0_C:
-                case OP_SET_0_D:
-                case OP_SET_0_E:
-                case OP_SET_0_H:
-                case OP_SET_0_L:
-                case OP_SET_1_A:
-                case OP_SET_1_B:
-                case OP_SET_1_C:
-                case OP_SET_1_D:
-                case OP_SET_1_E:
-                case OP_SET_1_H:
-                case OP_SET_1_L:
-                case OP_SET_2_A:
-                case OP_SET_2_B:
-                case OP_SET_2_C:
-                case OP_SET_2_D:
-                case OP_SET_2_E:
-                case OP_SET_2_H:
-                case OP_SET_2_L:
-                case OP_SET_3_A:
-                case OP_SET_3_B:
-                case OP_SET_3_C:
-                case OP_SET_3_D:
-                case OP_SET_3_E:
-                case OP_SET_3_H:
-                case OP_SET_3_L:
-                case OP_SET_4_A:
-                case OP_SET_4_B:
-                case OP_SET_4_C:
-                case OP_SET_4_D:
-                case OP_SET_4_E:
-                case OP_SET_4_H:
-                case OP_SET_4_L:
-                case OP_SET_5_A:
-                case OP_SET_5_B:
-                case OP_SET_5_C:
-                case OP_SET_5_D:
-                case OP_SET_5_E:
-                case OP_SET_5_H:
-                case OP_SET_5_L:
-                case OP_SET_6_A:
-                case OP_SET_6_B:
-                case OP_SET_6_C:
-                case OP_SET_6_D:
-                case OP_SET_6_E:
-                case OP_SET_6_H:
-                case OP_SET_6_L:
-                case OP_SET_7_A:
-                case OP_SET_7_B:
-                case OP_SET_7_C:
-                case OP_SET_7_D:
-                case OP_SET_7_E:
-                case OP_SET_7_H:
-                case OP_SET_7_L:
-                    toReturn = CYCLES_SET_B_R;
-                    break;
-                case OP_SET_0_HLI:
-                case OP_SET_1_HLI:
-                case OP_SET_2_HLI:
-                case OP_SET_3_HLI:
-                case OP_SET_4_HLI:
-                case OP_SET_5_HLI:
-                case OP_SET_6_HLI:
-                case OP_SET_7_HLI:
-                    toReturn = CYCLES_SET_B_HLI;
-                    break;
-                case OP_RES_0_A:
-                case OP_RES_0_B:
-                case OP_RES_0_C:
-                case OP_RES_0_D:
-                case OP_RES_0_E:
-                case OP_RES_0_H:
-                case OP_RES_0_L:
-                case OP_RES_1_A:
-                case OP_RES_1_B:
-                case OP_RES_1_C:
-                case OP_RES_1_D:
-                case OP_RES_1_E:
-                case OP_RES_1_H:
-                case OP_RES_1_L:
-                case OP_RES_2_A:
-                case OP_RES_2_B:
-                case OP_RES_2_C:
-                case OP_RES_2_D:
-                case OP_RES_2_E:
-                case OP_RES_2_H:
-                case OP_RES_2_L:
-                case OP_RES_3_A:
-                case OP_RES_3_B:
-                case OP_RES_3_C:
-                case OP_RES_3_D:
-                case OP_RES_3_E:
-                case OP_RES_3_H:
-                case OP_RES_3_L:
-                case OP_RES_4_A:
-                case OP_RES_4_B:
-                case OP_RES_4_C:
-                case OP_RES_4_D:
-                case OP_RES_4_E:
-                case OP_RES_4_H:
-                case OP_RES_4_L:
-                case OP_RES_5_A:
-                case OP_RES_5_B:
-                case OP_RES_5_C:
-                case OP_RES_5_D:
-                case OP_RES_5_E:
-                case OP_RES_5_H:
-                case OP_RES_5_L:
-                case OP_RES_6_A:
-                case OP_RES_6_B:
-                case OP_RES_6_C:
-                case OP_RES_6_D:
-                case OP_RES_6_E:
-                case OP_RES_6_H:
-                case OP_RES_6_L:
-                case OP_RES_7_A:
-                case OP_RES_7_B:
-                case OP_RES_7_C:
-                case OP_RES_7_D:
-                case OP_RES_7_E:
-                case OP_RES_7_H:
-                case OP_RES_7_L:
-                    toReturn = CYCLES_RES_B_R;
-                    break;
-                case OP_RES_0_HLI:
-                case OP_RES_1_HLI:
-                case OP_RES_2_HLI:
-                case OP_RES_3_HLI:
-                case OP_RES_4_HLI:
-                case OP_RES_5_HLI:
-                case OP_RES_6_HLI:
-                case OP_RES_7_HLI:
-                    toReturn = CYCLES_RES_B_HLI;
-                    break;
-                default:
-                    std::cout << "Unrecognized CB prefix opcode " << +cbop << ". Using default cycle length\n";
-                    
-                    break;
-            }
-            break;
+            return true;
         default:
-            std::cout << "Unrecognized opcode " << +opcode << ". Using default cycle length\n";
-            
-            break;
+            return false;
     }
-    
-    return toReturn;
 }
 
-void GBZ80::process_opcode(uint8_t opcode){
-    uint16_t cbop = 0;
-    uint8_t nextByte = 0x00;
+//Flags blocks that poll an IO register and branch back to themselves without changing anything else.
+//Matches loops like "ldh a,(LY); cp n; jr nz,loop". Only A and F change, and both are the same on every pass.
+void GBZ80::find_idle_loop(CodeBlock* block){
+    if(!USE_IDLE_LOOP_DETECTION || !m_bIdleLoopSkip || (block->ops.size() < 2)){
+        return;
+    }
     
-    //Show debug prompt if needed. //TODO - replace false with breakpoint check.
-    if(m_bSingleStep || false){
-        showDebugPrompt();
+    //First op reads the register into A
+    const MicroOp& load = block->ops[0];
+    uint16_t address = 0;
+    if(load.opcode == OP_LDH_A_FF00NI){
+        address = 0xFF00 | (load.operand & 0xFF);
+    } else if(load.opcode == OP_LD_A_NNI){
+        address = load.operand;
+    } else {
+        return;
     }
-        
-    switch(opcode){
-        case OP_LD_B:
-            instruction_ld_B(read_next_byte());
-            break;
-        case OP_LD_C:
-            instruction_ld_C(read_next_byte());
-            break;
-        case OP_LD_D:
-            instruction_ld_D(read_next_byte());
-            break;
-        case OP_LD_E:
-            instruction_ld_E(read_next_byte());
-            break;
-        case OP_LD_H:
-            instruction_ld_H(read_next_byte());
-            break;
-        case OP_LD_L:
-            instruction_ld_L(read_next_byte());
-            break;
-        case OP_LD_A_A:
-            instruction_ld_A_A();
-            break;
-        case OP_LD_A_B:
-            instruction_ld_A_B();
-            break;
-        case OP_LD_A_C:
-            instruction_ld_A_C();
-            break;
-        case OP_LD_A_D:
-            instruction_ld_A_D();
-            break;
-        case OP_LD_A_E:
-            instruction_ld_A_E();
-            break;
-        case OP_LD_A_H:
-            instruction_ld_A_H();
-            break;
-        case OP_LD_A_L:
-            instruction_ld_A_L();
-            break;
-        case OP_LD_A_HLI:
-            instruction_ld_A_HLI();
-            break;
-        case OP_LD_B_A:
-            instruction_ld_B_A();
-            break;
-        case OP_LD_B_B:
-            instruction_ld_B_B();
-            break;
-        case OP_LD_B_C:
-            instruction_ld_B_C();
-            break;
-        case OP_LD_B_D:
-            instruction_ld_B_D();
-            break;
-        case OP_LD_B_E:
-            instruction_ld_B_E();
-            break;
-        case OP_LD_B_H:
-            instruction_ld_B_H();
-            break;
-        case OP_LD_B_L:
-            instruction_ld_B_L();
-            break;
-        case OP_LD_B_HLI:
-            instruction_ld_B_HLI();
-            break;
-        case OP_LD_C_A:
-            instruction_ld_C_A();
-            break;
-        case OP_LD_C_B:
-            instruction_ld_C_B();
-            break;
-        case OP_LD_C_C:
-            instruction_ld_C_C();
-            break;
-        case OP_LD_C_D:
-            instruction_ld_C_D();
-            break;
-        case OP_LD_C_E:
-            instruction_ld_C_E();
-            break;
-        case OP_LD_C_H:
-            instruction_ld_C_H();
-            break;
-        case OP_LD_C_L:
-            instruction_ld_C_L();
-            break;
-        case OP_LD_C_HLI:
-            instruction_ld_C_HLI();
-            break;
-        case OP_LD_D_A:
-            instruction_ld_D_A();
-            break;
-        case OP_LD_D_B:
-            instruction_ld_D_B();
-            break;
-        case OP_LD_D_C:
-            instruction_ld_D_C();
-            break;
-        case OP_LD_D_D:
-            instruction_ld_D_D();
-            break;
-        case OP_LD_D_E:
-            instruction_ld_D_E();
-            break;
-        case OP_LD_D_H:
-            instruction_ld_D_H();
-            break;
-        case OP_LD_D_L:
-            instruction_ld_D_L();
-            break;
-        case OP_LD_D_HLI:
-            instruction_ld_D_HLI();
-            break;
-        case OP_LD_E_A:
-            instruction_ld_E_A();
-            break;
-        case OP_LD_E_B:
-            instruction_ld_E_B();
-            break;
-        case OP_LD_E_C:
-            instruction_ld_E_C();
-            break;
-        case OP_LD_E_D:
-            instruction_ld_E_D();
-            break;
-        case OP_LD_E_E:
-            instruction_ld_E_E();
-            break;
-        case OP_LD_E_H:
-            instruction_ld_E_H();
-            break;
-        case OP_LD_E_L:
-            instruction_ld_E_L();
-            break;
-        case OP_LD_E_HLI:
-            instruction_ld_E_HLI();
-            break;
-        case OP_LD_H_A:
-            instruction_ld_H_A();
-            break;
-        case OP_LD_H_B:
-            instruction_ld_H_B();
-            break;
-        case OP_LD_H_C:
-            instruction_ld_H_C();
-            break;
-        case OP_LD_H_D:
-            instruction_ld_H_D();
-            break;
-        case OP_LD_H_E:
-            instruction_ld_H_E();
-            break;
-        case OP_LD_H_H:
-            instruction_ld_H_H();
-            break;
-        case OP_LD_H_L:
-            instruction_ld_H_L();
-            break;
-        case OP_LD_H_HLI:
-            instruction_ld_H_HLI();
-            break;
-        case OP_LD_L_A:
-            instruction_ld_L_A();
-            break;
-        case OP_LD_L_B:
-            instruction_ld_L_B();
-            break;
-        case OP_LD_L_C:
-            instruction_ld_L_C();
-            break;
-        case OP_LD_L_D:
-            instruction_ld_L_D();
-            break;
-        case OP_LD_L_E:
-            instruction_ld_L_E();
-            break;
-        case OP_LD_L_H:
-            instruction_ld_L_H();
-            break;
-        case OP_LD_L_L:
-            instruction_ld_L_L();
-            break;
-        case OP_LD_L_HLI:
-            instruction_ld_L_HLI();
-            break;
-        case OP_LD_HLI_A:
-            instruction_ld_HLI_A();
-            break;
-        case OP_LD_HLI_B:
-            instruction_ld_HLI_B();
-            break;
-        case OP_LD_HLI_C:
-            instruction_ld_HLI_C();
-            break;
-        case OP_LD_HLI_D:
-            instruction_ld_HLI_D();
-            break;
-        case OP_LD_HLI_E:
-            instruction_ld_HLI_E();
-            break;
-        case OP_LD_HLI_H:
-            instruction_ld_HLI_H();
-            break;
-        case OP_LD_HLI_L:
-            instruction_ld_HLI_L();
-            break;
-        case OP_LD_HLI_N:
-            instruction_ld_HLI_N(read_next_byte());
-            break;
-        case OP_LD_A_BCI:
-            instruction_ld_A_BCI();
-            break;
-        case OP_LD_A_DEI:
-            instruction_ld_A_DEI();
-            break;
-        case OP_LD_A_NNI:
-            instruction_ld_A_NNI(read_next_word());
-            break;
-        case OP_LD_A_CONST:
-            instruction_ld_A_CONST(read_next_byte());
-            break;
-        case OP_LD_BCI_A:
-            instruction_ld_BCI_A();
-            break;
-        case OP_LD_DEI_A:
-            instruction_ld_DEI_A();
-            break;
-        case OP_LD_NNI_A:
-            instruction_ld_NNI_A(read_next_word());
-            break;
-        case OP_LD_A_FF00CI:
-            instruction_ld_A_FF00CI();
-            break;
-        case OP_LD_FF00CI_A:
-            instruction_ld_FF00CI_A();
-            break;
-        case OP_LDD_A_HLI:
-            instruction_ldd_A_HLI();
-            break;
-        case OP_LDD_HLI_A:
-            instruction_ldd_HLI_A();
-            break;
-        case OP_LDI_A_HLI:
-            instruction_ldi_A_HLI();
-            break;
-        case OP_LDI_HLI_A:
-            instruction_ldi_HLI_A();
-            break;
-        case OP_LDH_FF00NI_A:
-            instruction_ldh_FF00NI_A(read_next_byte());
-            break;
-        case OP_LDH_A_FF00NI:
-            instruction_ldh_A_FF00NI(read_next_byte());
-            break;
-        case OP_LD_BC_NN:
-            instruction_ld_BC_NN(read_next_word());
-            break;
-        case OP_LD_DE_NN:
-            instruction_ld_DE_NN(read_next_word());
-            break;
-        case OP_LD_HL_NN:
-            instruction_ld_HL_NN(read_next_word());
-            break;
-        case OP_LD_SP_NN:
-            instruction_ld_SP_NN(read_next_word());
-            break;
-        case OP_LD_SP_HL:
-            instruction_ld_SP_HL();
-            break;
-        case OP_LDHL_SP_N:
-            nextByte = read_next_byte();
-            instruction_ldhl(reinterpret_cast<int8_t &>(nextByte));
-            break;
-        case OP_LD_NNI_SP:
-            instruction_ld_NNI_SP(read_next_word());
-            break;
-        case OP_PUSH_AF:
-            instruction_push_AF();
-            break;
-        case OP_PUSH_BC:
-            instruction_push_BC();
-            break;
-        case OP_PUSH_DE:
-            instruction_push_DE();
-            break;
-        case OP_PUSH_HL:
-            instruction_push_HL();
-            break;
-        case OP_POP_AF:
-            instruction_pop_AF();
-            break;
-        case OP_POP_BC:
-            instruction_pop_BC();
-            break;
-        case OP_POP_DE:
-            instruction_pop_DE();
-            break;
-        case OP_POP_HL:
-            instruction_pop_HL();
-            break;
-        case OP_ADD_A:
-            instruction_add_A();
-            break;
-        case OP_ADD_B:
-            instruction_add_B();
-            break;
-        case OP_ADD_C:
-            instruction_add_C();
-            break;
-        case OP_ADD_D:
-            instruction_add_D();
-            break;
-        case OP_ADD_E:
-            instruction_add_E();
-            break;
-        case OP_ADD_H:
-            instruction_add_H();
-            break;
-        case OP_ADD_L:
-            instruction_add_L();
-            break;
-        case OP_ADD_HLI:
-            instruction_add_HLI();
-            break;
-        case OP_ADD_CONST:
-            instruction_add_CONST(read_next_byte());
-            break;
-        case OP_ADC_A:
-            instruction_adc_A();
-            break;
-        case OP_ADC_B:
-            instruction_adc_B();
-            break;
-        case OP_ADC_C:
-            instruction_adc_C();
-            break;
-        case OP_ADC_D:
-            instruction_adc_D();
-            break;
-        case OP_ADC_E:
-            instruction_adc_E();
-            break;
-        case OP_ADC_H:
-            instruction_adc_H();
-            break;
-        case OP_ADC_L:
-            instruction_adc_L();
-            break;
-        case OP_ADC_HLI:
-            instruction_adc_HLI();
-            break;
-        case OP_ADC_CONST:
-            instruction_adc_CONST(read_next_byte());
-            break;
-        case OP_SUB_A:
-            instruction_sub_A();
-            break;
-        case OP_SUB_B:
-            instruction_sub_B();
-            break;
-        case OP_SUB_C:
-            instruction_sub_C();
-            break;
-        case OP_SUB_D:
-            instruction_sub_D();
-            break;
-        case OP_SUB_E:
-            instruction_sub_E();
-            break;
-        case OP_SUB_H:
-            instruction_sub_H();
-            break;
-        case OP_SUB_L:
-            instruction_sub_L();
-            break;
-        case OP_SUB_HLI:
-            instruction_sub_HLI();
-            break;
-        case OP_SUB_CONST:
-            instruction_sub_CONST(read_next_byte());
-            break;
-        case OP_SBC_A:
-            instruction_sbc_A();
-            break;
-        case OP_SBC_B:
-            instruction_sbc_B();
-            break;
-        case OP_SBC_C:
-            instruction_sbc_C();
-            break;
-        case OP_SBC_D:
-            instruction_sbc_D();
-            break;
-        case OP_SBC_E:
-            instruction_sbc_E();
-            break;
-        case OP_SBC_H:
-            instruction_sbc_H();
-            break;
-        case OP_SBC_L:
-            instruction_sbc_L();
-            break;
-        case OP_SBC_HLI:
-            instruction_sbc_HLI();
-            break;
-        case OP_SBC_CONST:
-            instruction_sbc_CONST(read_next_byte());
-            break;
-        case OP_AND_A:
-            instruction_and_A();
-            break;
-        case OP_AND_B:
-            instruction_and_B();
-            break;
-        case OP_AND_C:
-            instruction_and_C();
-            break;
-        case OP_AND_D:
-            instruction_and_D();
-            break;
-        case OP_AND_E:
-            instruction_and_E();
-            break;
-        case OP_AND_H:
-            instruction_and_H();
-            break;
-        case OP_AND_L:
-            instruction_and_L();
-            break;
-        case OP_AND_HLI:
-            instruction_and_HLI();
-            break;
-        case OP_AND_CONST:
-            instruction_and_CONST(read_next_byte());
-            break;
-        case OP_OR_A:
-            instruction_or_A();
-            break;
-        case OP_OR_B:
-            instruction_or_B();
-            break;
-        case OP_OR_C:
-            instruction_or_C();
-            break;
-        case OP_OR_D:
-            instruction_or_D();
-            break;
-        case OP_OR_E:
-            instruction_or_E();
-            break;
-        case OP_OR_H:
-            instruction_or_H();
-            break;
-        case OP_OR_L:
-            instruction_or_L();
-            break;
-        case OP_OR_HLI:
-            instruction_or_HLI();
-            break;
-        case OP_OR_CONST:
-            instruction_or_CONST(read_next_byte());
-            break;
-        case OP_XOR_A:
-            instruction_xor_A();
-            break;
-        case OP_XOR_B:
-            instruction_xor_B();
-            break;
-        case OP_XOR_C:
-            instruction_xor_C();
-            break;
-        case OP_XOR_D:
-            instruction_xor_D();
-            break;
-        case OP_XOR_E:
-            instruction_xor_E();
-            break;
-        case OP_XOR_H:
-            instruction_xor_H();
-            break;
-        case OP_XOR_L:
-            instruction_xor_L();
-            break;
-        case OP_XOR_HLI:
-            instruction_xor_HLI();
-            break;
-        case OP_XOR_CONST:
-            instruction_xor_CONST(read_next_byte());
-            break;
-        case OP_CP_A:
-            instruction_cp_A();
-            break;
-        case OP_CP_B:
-            instruction_cp_B();
-            break;
-        case OP_CP_C:
-            instruction_cp_C();
-            break;
-        case OP_CP_D:
-            instruction_cp_D();
-            break;
-        case OP_CP_E:
-            instruction_cp_E();
-            break;
-        case OP_CP_H:
-            instruction_cp_H();
-            break;
-        case OP_CP_L:
-            instruction_cp_L();
-            break;
-        case OP_CP_HLI:
-            instruction_cp_HLI();
-            break;
-        case OP_CP_CONST:
-            instruction_cp_CONST(read_next_byte());
-            break;
-        case OP_INC_A:
-            instruction_inc_A();
-            break;
-        case OP_INC_B:
-            instruction_inc_B();
-            break;
-        case OP_INC_C:
-            instruction_inc_C();
-            break;
-        case OP_INC_D:
-            instruction_inc_D();
-            break;
-        case OP_INC_E:
-            instruction_inc_E();
-            break;
-        case OP_INC_H:
-            instruction_inc_H();
-            break;
-        case OP_INC_L:
-            instruction_inc_L();
-            break;
-        case OP_INC_HLI:
-            instruction_inc_HLI();
-            break;
-        case OP_DEC_A:
-            instruction_dec_A();
-            break;
-        case OP_DEC_B:
-            instruction_dec_B();
-            break;
-        case OP_DEC_C:
-            instruction_dec_C();
-            break;
-        case OP_DEC_D:
-            instruction_dec_D();
-            break;
-        case OP_DEC_E:
-            instruction_dec_E();
-            break;
-        case OP_DEC_H:
-            instruction_dec_H();
-            break;
-        case OP_DEC_L:
-            instruction_dec_L();
-            break;
-        case OP_DEC_HLI:
-            instruction_dec_HLI();
-            break;
-        case OP_ADD_BC:
-            instruction_add_BC();
-            break;
-        case OP_ADD_DE:
-            instruction_add_DE();
-            break;
-        case OP_ADD_HL:
-            instruction_add_HL();
-            break;
-        case OP_ADD_SP:
-            instruction_add_SP();
-            break;
-        case OP_ADD_SP_CONST:
-            nextByte = read_next_byte();
-            instruction_add_SP_CONST(reinterpret_cast<int8_t &>(nextByte));
-            break;
-        case OP_INC_BC:
-            instruction_inc_BC();
-            break;
-        case OP_INC_DE:
-            instruction_inc_DE();
-            break;
-        case OP_INC_HL:
-            instruction_inc_HL();
-            break;
-        case OP_INC_SP:
-            instruction_inc_SP();
-            break;
-        case OP_DEC_BC:
-            instruction_dec_BC();
-            break;
-        case OP_DEC_DE:
-            instruction_dec_DE();
-            break;
-        case OP_DEC_HL:
-            instruction_dec_HL();
-            break;
-        case OP_DEC_SP:
-            instruction_dec_SP();
-            break;
-        //SWAP instructions appear later with other CB prefixes
-        case OP_DAA:
-            instruction_daa();
-            break;
-        case OP_CPL:
-            instruction_cpl();
-            break;
-        case OP_CCF:
-            instruction_ccf();
-            break;
-        case OP_SCF:
-            instruction_scf();
-            break;
-        case OP_NOP:
-            instruction_nop();
-            break;
-        case OP_HALT:
-            instruction_halt();
-            break;
-        //Stop is at end since it is a two byte opcode
-        case OP_DI:
-            instruction_di();
-            break;
-        case OP_EI:
-            instruction_ei();
-            break;
-        case OP_RLCA:
-            instruction_rlca();
-            break;
-        case OP_RLA:
-            instruction_rla();
-            break;
-        case OP_RRCA:
-            instruction_rrca();
-            break;
-        case OP_RRA:
-            instruction_rra();
-            break;
-        case OP_JP:
-            instruction_jp(read_next_word());
-            break;
-        case OP_JP_NZ:
-            instruction_jp_NZ(read_next_word());
-            break;
-        case OP_JP_Z:
-            instruction_jp_Z(read_next_word());
-            break;
-        case OP_JP_NC:
-            instruction_jp_NC(read_next_word());
-            break;
-        case OP_JP_C:
-            instruction_jp_C(read_next_word());
-            break;
-        case OP_JP_HLI:
-            instruction_jp_HLI();
-            break;
-        case OP_JR:
-            nextByte = read_next_byte();
-            instruction_jr(reinterpret_cast<int8_t &>(nextByte));
+    
+    switch(address){
+        case ADDRESS_IF:
+        case ADDRESS_STAT:
+        case ADDRESS_LY:
+        case ADDRESS_DIV:
+        case ADDRESS_TIMA:
             break;
+        default:
+            return;
+    }
+    
+    //Last op branches back to the first
+    const MicroOp& branch = block->ops.back();
+    uint16_t target = 0;
+    switch(branch.opcode){
         case OP_JR_NZ:
-            nextByte = read_next_byte();
-            instruction_jr_NZ(reinterpret_cast<int8_t &>(nextByte));
-            break;
         case OP_JR_Z:
-            nextByte = read_next_byte();
-            instruction_jr_Z(reinterpret_cast<int8_t &>(nextByte));
-            break;
         case OP_JR_NC:
-            nextByte = read_next_byte();
-            instruction_jr_NC(reinterpret_cast<int8_t &>(nextByte));
-            break;
         case OP_JR_C:
-            nextByte = read_next_byte();
-            instruction_jr_C(reinterpret_cast<int8_t &>(nextByte));
-            break;
-        case OP_CALL:
-            instruction_call(read_next_word());
-            break;
-        case OP_CALL_NZ:
-            instruction_call_NZ(read_next_word());
-            break;
-        case OP_CALL_Z:
-            instruction_call_Z(read_next_word());
-            break;
-        case OP_CALL_NC:
-            instruction_call_NC(read_next_word());
-            break;
-        case OP_CALL_C:
-            instruction_call_C(read_next_word());
-            break;
-        case OP_RST_00H:
-            instruction_rst_00H();
-            break;
-        case OP_RST_08H:
-            instruction_rst_08H();
+            target = branch.address + branch.length + (int8_t)branch.operand;
             break;
-        case OP_RST_10H:
-            instruction_rst_10H();
-            break;
-        case OP_RST_18H:
-            instruction_rst_18H();
-            break;
-        case OP_RST_20H:
-            instruction_rst_20H();
-            break;
-        case OP_RST_28H:
-            instruction_rst_28H();
-            break;
-        case OP_RST_30H:
-            instruction_rst_30H();
-            break;
-        case OP_RST_38H:
-            instruction_rst_38H();
-            break;
-        case OP_RET:
-            instruction_ret();
-            break;
-        case OP_RET_NZ:
-            instruction_ret_NZ();
-            break;
-        case OP_RET_Z:
-            instruction_ret_Z();
-            break;
-        case OP_RET_NC:
-            instruction_ret_NC();
-            break;
-        case OP_RET_C:
-            instruction_ret_C();
-            break;
-        case OP_RETI:
-            instruction_reti();
-            break;
-        case OP_STOP8:
-            //Reuse cbop variable...
-            //TODO - rename cbop with nextOp!
-            cbop = read_next_byte();
-            if(cbop == 0x00){
-                instruction_stop();
-            } else {
-                std::cout << "A non-zero byte is following the stop byte!!! Value: " << +cbop << std::endl;
-                
-                //According to https://github.com/AntonioND/giibiiadvance/blob/master/docs/TCAGBD.pdf
-                //Gameboy turns LCD on when invalid stop instruction is hit.
-                if(BAD_STOP_IS_LCD_ON){
-                    uint8_t lcdc = m_gblcd->getLCDC();
-                    m_gblcd->setLCDC(lcdc | LCDC_DISPLAY_ENABLE);
-                } 
-                
-                if(STOP_ON_BAD_STOP){
-                    exit(1);
-                }
-            }
-            break;
-        case OP_IS_CB_PREFIXED: 
-            cbop = setMSB(read_next_byte(), opcode);
-            if(CONSOLE_OUTPUT_ENABLED) std::cout << "cbopcode: " << +cbop << "\n";
-            switch(cbop){
-                case OP_SWAP_A:
-                    instruction_swap_A();
-                    break;
-                case OP_SWAP_B:
-                    instruction_swap_B();
-                    break;
-                case OP_SWAP_C:
-                    instruction_swap_C();
-                    break;
-                case OP_SWAP_D:
-                    instruction_swap_D();
-                    break;
-                case OP_SWAP_E:
-                    instruction_swap_E();
-                    break;
-                case OP_SWAP_H:
-                    instruction_swap_H();
-                    break;
-                case OP_SWAP_L:
-                    instruction_swap_L();
-                    break;
-                case OP_SWAP_HLI:
-                    instruction_swap_HLI();
-                    break;
-                case OP_RLC_A:
-                    instruction_rlc_A();
-                    break;
-                case OP_RLC_B:
-                    instruction_rlc_B();
-                    break;
-                case OP_RLC_C:
-                    instruction_rlc_C();
-                    break;
-                case OP_RLC_D:
-                    instruction_rlc_D();
-                    break;
-                case OP_RLC_E:
-                    instruction_rlc_E();
-                    break;
-                case OP_RLC_H:
-                    instruction_rlc_H();
-                    break;
-                case OP_RLC_L:
-                    instruction_rlc_L();
-                    break;
-                case OP_RLC_HLI:
-                    instruction_rlc_HLI();
-                    break;
-                case OP_RL_A:
-                    instruction_rl_A();
-                    break;
-                case OP_RL_B:
-                    instruction_rl_B();
-                    break;
-                case OP_RL_C:
-                    instruction_rl_C();
-                    break;
-                case OP_RL_D:
-                    instruction_rl_D();
-                    break;
-                case OP_RL_E:
-                    instruction_rl_E();
-                    break;
-                case OP_RL_H:
-                    instruction_rl_H();
-                    break;
-                case OP_RL_L:
-                    instruction_rl_L();
-                    break;
-                case OP_RL_HLI:
-                    instruction_rl_HLI();
-                    break;
-                case OP_RRC_A:
-                    instruction_rrc_A();
-                    break;
-                case OP_RRC_B:
-                    instruction_rrc_B();
-                    break;
-                case OP_RRC_C:
-                    instruction_rrc_C();
-                    break;
-                case OP_RRC_D:
-                    instruction_rrc_D();
-                    break;
-                case OP_RRC_E:
-                    instruction_rrc_E();
-                    break;
-                case OP_RRC_H:
-                    instruction_rrc_H();
-                    break;
-                case OP_RRC_L:
-                    instruction_rrc_L();
-                    break;
-                case OP_RRC_HLI:
-                    instruction_rrc_HLI();
-                    break;
-                case OP_RR_A:
-                    instruction_rr_A();
-                    break;
-                case OP_RR_B:
-                    instruction_rr_B();
-                    break;
-                case OP_RR_C:
-                    instruction_rr_C();
-                    break;
-                case OP_RR_D:
-                    instruction_rr_D();
-                    break;
-                case OP_RR_E:
-                    instruction_rr_E();
-                    break;
-                case OP_RR_H:
-                    instruction_rr_H();
-                    break;
-                case OP_RR_L:
-                    instruction_rr_L();
-                    break;
-                case OP_RR_HLI:
-                    instruction_rr_HLI();
-                    break;
-                case OP_SLA_A:
-                    instruction_sla_A();
-                    break;
-                case OP_SLA_B:
-                    instruction_sla_B();
-                    break;
-                case OP_SLA_C:
-                    instruction_sla_C();
-                    break;
-                case OP_SLA_D:
-                    instruction_sla_D();
-                    break;
-                case OP_SLA_E:
-                    instruction_sla_E();
-                    break;
-                case OP_SLA_H:
-                    instruction_sla_H();
-                    break;
-                case OP_SLA_L:
-                    instruction_sla_L();
-                    break;
-                case OP_SLA_HLI:
-                    instruction_sla_HLI();
-                    break;
-                case OP_SRA_A:
-                    instruction_sra_A();
-                    break;
-                case OP_SRA_B:
-                    instruction_sra_B();
-                    break;
-                case OP_SRA_C:
-                    instruction_sra_C();
-                    break;
-                case OP_SRA_D:
-                    instruction_sra_D();
-                    break;
-                case OP_SRA_E:
-                    instruction_sra_E();
-                    break;
-                case OP_SRA_H:
-                    instruction_sra_H();
-                    break;
-                case OP_SRA_L:
-                    instruction_sra_L();
-                    break;
-                case OP_SRA_HLI:
-                    instruction_sra_HLI();
-                    break;
-                case OP_SRL_A:
-                    instruction_srl_A();
-                    break;
-                case OP_SRL_B:
-                    instruction_srl_B();
-                    break;
-                case OP_SRL_C:
-                    instruction_srl_C();
-                    break;
-                case OP_SRL_D:
-                    instruction_srl_D();
-                    break;
-                case OP_SRL_E:
-                    instruction_srl_E();
-                    break;
-                case OP_SRL_H:
-                    instruction_srl_H();
-                    break;
-                case OP_SRL_L:
-                    instruction_srl_L();
-                    break;
-                case OP_SRL_HLI:
-                    instruction_srl_HLI();
-                    break;
-                case OP_BIT_0_A:
-                    instruction_bit_0_A();
-                    break;
-                case OP_BIT_0_B:
-                    instruction_bit_0_B();
-                    break;
-                case OP_BIT_0_C:
-                    instruction_bit_0_C();
-                    break;
-                case OP_BIT_0_D:
-                    instruction_bit_0_D();
-                    break;
-                case OP_BIT_0_E:
-                    instruction_bit_0_E();
-                    break;
-                case OP_BIT_0_H:
-                    instruction_bit_0_H();
-                    break;
-                case OP_BIT_0_L:
-                    instruction_bit_0_L();
-                    break;
-                case OP_BIT_0_HLI:
-                    instruction_bit_0_HLI();
-                    break;
-                case OP_BIT_1_A:
-                    instruction_bit_1_A();
-                    break;
-                case OP_BIT_1_B:
-                    instruction_bit_1_B();
-                    break;
-                case OP_BIT_1_C:
-                    instruction_bit_1_C();
-                    break;
-                case OP_BIT_1_D:
-                    instruction_bit_1_D();
-                    break;
-                case OP_BIT_1_E:
-                    instruction_bit_1_E();
-                    break;
-                case OP_BIT_1_H:
-                    instruction_bit_1_H();
-                    break;
-                case OP_BIT_1_L:
-                    instruction_bit_1_L();
-                    break;
-                case OP_BIT_1_HLI:
-                    instruction_bit_1_HLI();
-                    break;
-                case OP_BIT_2_A:
-                    instruction_bit_2_A();
-                    break;
-                case OP_BIT_2_B:
-                    instruction_bit_2_B();
-                    break;
-                case OP_BIT_2_C:
-                    instruction_bit_2_C();
-                    break;
-                case OP_BIT_2_D:
-                    instruction_bit_2_D();
-                    break;
-                case OP_BIT_2_E:
-                    instruction_bit_2_E();
-                    break;
-                case OP_BIT_2_H:
-                    instruction_bit_2_H();
-                    break;
-                case OP_BIT_2_L:
-                    instruction_bit_2_L();
-                    break;
-                case OP_BIT_2_HLI:
-                    instruction_bit_2_HLI();
-                    break;
-                case OP_BIT_3_A:
-                    instruction_bit_3_A();
-                    break;
-                case OP_BIT_3_B:
-                    instruction_bit_3_B();
-                    break;
-                case OP_BIT_3_C:
-                    instruction_bit_3_C();
-                    break;
-                case OP_BIT_3_D:
-                    instruction_bit_3_D();
-                    break;
-                case OP_BIT_3_E:
-                    instruction_bit_3_E();
-                    break;
-                case OP_BIT_3_H:
-                    instruction_bit_3_H();
-                    break;
-                case OP_BIT_3_L:
-                    instruction_bit_3_L();
-                    break;
-                case OP_BIT_3_HLI:
-                    instruction_bit_3_HLI();
-                    break;
-                case OP_BIT_4_A:
-                    instruction_bit_4_A();
-                    break;
-                case OP_BIT_4_B:
-                    instruction_bit_4_B();
-                    break;
-                case OP_BIT_4_C:
-                    instruction_bit_4_C();
-                    break;
-                case OP_BIT_4_D:
-                    instruction_bit_4_D();
-                    break;
-                case OP_BIT_4_E:
-                    instruction_bit_4_E();
-                    break;
-                case OP_BIT_4_H:
-                    instruction_bit_4_H();
-                    break;
-                case OP_BIT_4_L:
-                    instruction_bit_4_L();
-                    break;
-                case OP_BIT_4_HLI:
-                    instruction_bit_4_HLI();
-                    break;
-                case OP_BIT_5_A:
-                    instruction_bit_5_A();
-                    break;
-                case OP_BIT_5_B:
-                    instruction_bit_5_B();
-                    break;
-                case OP_BIT_5_C:
-                    instruction_bit_5_C();
-                    break;
-                case OP_BIT_5_D:
-                    instruction_bit_5_D();
-                    break;
-                case OP_BIT_5_E:
-                    instruction_bit_5_E();
-                    break;
-                case OP_BIT_5_H:
-                    instruction_bit_5_H();
-                    break;
-                case OP_BIT_5_L:
-                    instruction_bit_5_L();
-                    break;
-                case OP_BIT_5_HLI:
-                    instruction_bit_5_HLI();
-                    break;
-                case OP_BIT_6_A:
-                    instruction_bit_6_A();
-                    break;
-                case OP_BIT_6_B:
-                    instruction_bit_6_B();
-                    break;
-                case OP_BIT_6_C:
-                    instruction_bit_6_C();
-                    break;
-                case OP_BIT_6_D:
-                    instruction_bit_6_D();
-                    break;
-                case OP_BIT_6_E:
-                    instruction_bit_6_E();
-                    break;
-                case OP_BIT_6_H:
-                    instruction_bit_6_H();
-                    break;
-                case OP_BIT_6_L:
-                    instruction_bit_6_L();
-                    break;
-                case OP_BIT_6_HLI:
-                    instruction_bit_6_HLI();
-                    break;
-                case OP_BIT_7_A:
-                    instruction_bit_7_A();
-                    break;
-                case OP_BIT_7_B:
-                    instruction_bit_7_B();
-                    break;
-                case OP_BIT_7_C:
-                    instruction_bit_7_C();
-                    break;
-                case OP_BIT_7_D:
-                    instruction_bit_7_D();
-                    break;
-                case OP_BIT_7_E:
-                    instruction_bit_7_E();
-                    break;
-                case OP_BIT_7_H:
-                    instruction_bit_7_H();
-                    break;
-                case OP_BIT_7_L:
-                    instruction_bit_7_L();
-                    break;
-                case OP_BIT_7_HLI:
-                    instruction_bit_7_HLI();
-                    break;
-                case OP_SET_0_A:
-                    instruction_set_0_A();
-                    break;
-                case OP_SET_0_B:
-                    instruction_set_0_B();
-                    break;
-                case OP_SET_0_C:
-                    instruction_set_0_C();
-                    break;
-                case OP_SET_0_D:
-                    instruction_set_0_D();
-                    break;
-                case OP_SET_0_E:
-                    instruction_set_0_E();
-                    break;
-                case OP_SET_0_H:
-                    instruction_set_0_H();
-                    break;
-                case OP_SET_0_L:
-                    instruction_set_0_L();
-                    break;
-                case OP_SET_0_HLI:
-                    instruction_set_0_HLI();
-                    break;
-                case OP_SET_1_A:
-                    instruction_set_1_A();
-                    break;
-                case OP_SET_1_B:
-                    instruction_set_1_B();
-                    break;
-                case OP_SET_1_C:
-                    instruction_set_1_C();
-                    break;
-                case OP_SET_1_D:
-                    instruction_set_1_D();
-                    break;
-                case OP_SET_1_E:
-                    instruction_set_1_E();
-                    break;
-                case OP_SET_1_H:
-                    instruction_set_1_H();
-                    break;
-                case OP_SET_1_L:
-                    instruction_set_1_L();
-                    break;
-                case OP_SET_1_HLI:
-                    instruction_set_1_HLI();
-                    break;
-                case OP_SET_2_A:
-                    instruction_set_2_A();
-                    break;
-                case OP_SET_2_B:
-                    instruction_set_2_B();
-                    break;
-                case OP_SET_2_C:
-                    instruction_set_2_C();
-                    break;
-                case OP_SET_2_D:
-                    instruction_set_2_D();
-                    break;
-                case OP_SET_2_E:
-                    instruction_set_2_E();
-                    break;
-                case OP_SET_2_H:
-                    instruction_set_2_H();
-                    break;
-                case OP_SET_2_L:
-                    instruction_set_2_L();
-                    break;
-                case OP_SET_2_HLI:
-                    instruction_set_2_HLI();
-                    break;
-                case OP_SET_3_A:
-                    instruction_set_3_A();
-                    break;
-                case OP_SET_3_B:
-                    instruction_set_3_B();
-                    break;
-                case OP_SET_3_C:
-                    instruction_set_3_C();
-                    break;
-                case OP_SET_3_D:
-                    instruction_set_3_D();
-                    break;
-                case OP_SET_3_E:
-                    instruction_set_3_E();
-                    break;
-                case OP_SET_3_H:
-                    instruction_set_3_H();
-                    break;
-                case OP_SET_3_L:
-                    instruction_set_3_L();
-                    break;
-                case OP_SET_3_HLI:
-                    instruction_set_3_HLI();
-                    break;
-                case OP_SET_4_A:
-                    instruction_set_4_A();
-                    break;
-                case OP_SET_4_B:
-                    instruction_set_4_B();
-                    break;
-                case OP_SET_4_C:
-                    instruction_set_4_C();
-                    break;
-                case OP_SET_4_D:
-                    instruction_set_4_D();
-                    break;
-                case OP_SET_4_E:
-                    instruction_set_4_E();
-                    break;
-                case OP_SET_4_H:
-                    instruction_set_4_H();
-                    break;
-                case OP_SET_4_L:
-                    instruction_set_4_L();
-                    break;
-                case OP_SET_4_HLI:
-                    instruction_set_4_HLI();
-                    break;
-                case OP_SET_5_A:
-                    instruction_set_5_A();
-                    break;
-                case OP_SET_5_B:
-                    instruction_set_5_B();
-                    break;
-                case OP_SET_5_C:
-                    instruction_set_5_C();
-                    break;
-                case OP_SET_5_D:
-                    instruction_set_5_D();
-                    break;
-                case OP_SET_5_E:
-                    instruction_set_5_E();
-                    break;
-                case OP_SET_5_H:
-                    instruction_set_5_H();
-                    break;
-                case OP_SET_5_L:
-                    instruction_set_5_L();
-                    break;
-                case OP_SET_5_HLI:
-                    instruction_set_5_HLI();
-                    break;
-                case OP_SET_6_A:
-                    instruction_set_6_A();
-                    break;
-                case OP_SET_6_B:
-                    instruction_set_6_B();
-                    break;
-                case OP_SET_6_C:
-                    instruction_set_6_C();
-                    break;
-                case OP_SET_6_D:
-                    instruction_set_6_D();
-                    break;
-                case OP_SET_6_E:
-                    instruction_set_6_E();
-                    break;
-                case OP_SET_6_H:
-                    instruction_set_6_H();
-                    break;
-                case OP_SET_6_L:
-                    instruction_set_6_L();
-                    break;
-                case OP_SET_6_HLI:
-                    instruction_set_6_HLI();
-                    break;
-                case OP_SET_7_A:
-                    instruction_set_7_A();
-                    break;
-                case OP_SET_7_B:
-                    instruction_set_7_B();
-                    break;
-                case OP_SET_7_C:
-                    instruction_set_7_C();
-                    break;
-                case OP_SET_7_D:
-                    instruction_set_7_D();
-                    break;
-                case OP_SET_7_E:
-                    instruction_set_7_E();
-                    break;
-                case OP_SET_7_H:
-                    instruction_set_7_H();
-                    break;
-                case OP_SET_7_L:
-                    instruction_set_7_L();
-                    break;
-                case OP_SET_7_HLI:
-                    instruction_set_7_HLI();
-                    break;
-                case OP_RES_0_A:
-                    instruction_res_0_A();
-                    break;
-                case OP_RES_0_B:
-                    instruction_res_0_B();
-                    break;
-                case OP_RES_0_C:
-                    instruction_res_0_C();
-                    break;
-                case OP_RES_0_D:
-                    instruction_res_0_D();
-                    break;
-                case OP_RES_0_E:
-                    instruction_res_0_E();
-                    break;
-                case OP_RES_0_H:
-                    instruction_res_0_H();
-                    break;
-                case OP_RES_0_L:
-                    instruction_res_0_L();
-                    break;
-                case OP_RES_0_HLI:
-                    instruction_res_0_HLI();
-                    break;
-                case OP_RES_1_A:
-                    instruction_res_1_A();
-                    break;
-                case OP_RES_1_B:
-                    instruction_res_1_B();
-                    break;
-                case OP_RES_1_C:
-                    instruction_res_1_C();
-                    break;
-                case OP_RES_1_D:
-                    instruction_res_1_D();
-                    break;
-                case OP_RES_1_E:
-                    instruction_res_1_E();
-                    break;
-                case OP_RES_1_H:
-                    instruction_res_1_H();
-                    break;
-                case OP_RES_1_L:
-                    instruction_res_1_L();
-                    break;
-                case OP_RES_1_HLI:
-                    instruction_res_1_HLI();
-                    break;
-                case OP_RES_2_A:
-                    instruction_res_2_A();
-                    break;
-                case OP_RES_2_B:
-                    instruction_res_2_B();
-                    break;
-                case OP_RES_2_C:
-                    instruction_res_2_C();
-                    break;
-                case OP_RES_2_D:
-                    instruction_res_2_D();
-                    break;
-                case OP_RES_2_E:
-                    instruction_res_2_E();
-                    break;
-                case OP_RES_2_H:
-                    instruction_res_2_H();
-                    break;
-                case OP_RES_2_L:
-                    instruction_res_2_L();
-                    break;
-                case OP_RES_2_HLI:
-                    instruction_res_2_HLI();
-                    break;
-                case OP_RES_3_A:
-                    instruction_res_3_A();
-                    break;
-                case OP_RES_3_B:
-                    instruction_res_3_B();
-                    break;
-                case OP_RES_3_C:
-                    instruction_res_3_C();
-                    break;
-                case OP_RES_3_D:
-                    instruction_res_3_D();
-                    break;
-                case OP_RES_3_E:
-                    instruction_res_3_E();
-                    break;
-                case OP_RES_3_H:
-                    instruction_res_3_H();
-                    break;
-                case OP_RES_3_L:
-                    instruction_res_3_L();
-                    break;
-                case OP_RES_3_HLI:
-                    instruction_res_3_HLI();
-                    break;
-                case OP_RES_4_A:
-                    instruction_res_4_A();
-                    break;
-                case OP_RES_4_B:
-                    instruction_res_4_B();
-                    break;
-                case OP_RES_4_C:
-                    instruction_res_4_C();
-                    break;
-                case OP_RES_4_D:
-                    instruction_res_4_D();
-                    break;
-                case OP_RES_4_E:
-                    instruction_res_4_E();
-                    break;
-                case OP_RES_4_H:
-                    instruction_res_4_H();
-                    break;
-                case OP_RES_4_L:
-                    instruction_res_4_L();
-                    break;
-                case OP_RES_4_HLI:
-                    instruction_res_4_HLI();
-                    break;
-                case OP_RES_5_A:
-                    instruction_res_5_A();
-                    break;
-                case OP_RES_5_B:
-                    instruction_res_5_B();
-                    break;
-                case OP_RES_5_C:
-                    instruction_res_5_C();
-                    break;
-                case OP_RES_5_D:
-                    instruction_res_5_D();
-                    break;
-                case OP_RES_5_E:
-                    instruction_res_5_E();
-                    break;
-                case OP_RES_5_H:
-                    instruction_res_5_H();
-                    break;
-                case OP_RES_5_L:
-                    instruction_res_5_L();
-                    break;
-                case OP_RES_5_HLI:
-                    instruction_res_5_HLI();
-                    break;
-                case OP_RES_6_A:
-                    instruction_res_6_A();
-                    break;
-                case OP_RES_6_B:
-                    instruction_res_6_B();
-                    break;
-                case OP_RES_6_C:
-                    instruction_res_6_C();
-                    break;
-                case OP_RES_6_D:
-                    instruction_res_6_D();
-                    break;
-                case OP_RES_6_E:
-                    instruction_res_6_E();
-                    break;
-                case OP_RES_6_H:
-                    instruction_res_6_H();
-                    break;
-                case OP_RES_6_L:
-                    instruction_res_6_L();
-                    break;
-                case OP_RES_6_HLI:
-                    instruction_res_6_HLI();
-                    break;
-                case OP_RES_7_A:
-                    instruction_res_7_A();
-                    break;
-                case OP_RES_7_B:
-                    instruction_res_7_B();
-                    break;
-                case OP_RES_7_C:
-                    instruction_res_7_C();
-                    break;
-                case OP_RES_7_D:
-                    instruction_res_7_D();
-                    break;
-                case OP_RES_7_E:
-                    instruction_res_7_E();
-                    break;
-                case OP_RES_7_H:
-                    instruction_res_7_H();
-                    break;
-                case OP_RES_7_L:
-                    instruction_res_7_L();
-                    break;
-                case OP_RES_7_HLI:
-                    instruction_res_7_HLI();
-                    break;
-                default:
-                 std::cout << std::hex << "Unrecognized CB-prefix opcode " << +cbop << "!!!" << std::endl;
-                
-                if(STOP_ON_BAD_OPCODE){
-                    exit(1);
-                }
-                instruction_stop();                    
-            }
+        case OP_JP_NZ:
+        case OP_JP_Z:
+        case OP_JP_NC:
+        case OP_JP_C:
+            target = branch.operand;
             break;
         default:
-             std::cout << std::hex << "Unrecognized opcode " << +opcode << "!!!" << std::endl;
-            
-            if(STOP_ON_BAD_OPCODE){
-                exit(1);
+            return;
+    }
+    
+    if(target != block->startAddress){
+        return;
+    }
+    
+    //Everything in between only works on A and an immediate value
+    uint32_t cycles = load.entry->cycles + branch.entry->cycles;
+    for(size_t i = 1; i < block->ops.size() - 1; i++){
+        switch(block->ops[i].opcode){
+            case OP_CP_CONST:
+            case OP_AND_CONST:
+            case OP_OR_CONST:
+            case OP_XOR_CONST:
+            case OP_ADD_CONST:
+            case OP_SUB_CONST:
+                cycles += block->ops[i].entry->cycles;
+                break;
+            default:
+                return;
+        }
+    }
+    
+    block->idleLoopRegister = address;
+    block->idleLoopCycles = cycles;
+}
+
+//Releases all cached blocks
+void GBZ80::clear_block_cache(){
+    for(std::unordered_map<uint32_t, CodeBlock*>::iterator it = m_blockCache.begin(); it != m_blockCache.end(); ++it){
+        delete it->second;
+    }
+    
+    m_blockCache.clear();
+    m_hot.currentBlock = NULL;
+    m_hot.currentBlockIndex = 0;
+    m_idleLoopBlock = NULL;
+    
+    if(m_jit != NULL){
+        m_jit->flush();
+    }
+}
+
+//Runs the current block as native code if it's hot enough. Returns false if the interpreter should run the op instead.
+bool GBZ80::run_jit_block(const MicroOp* op){
+    CodeBlock* block = m_hot.currentBlock;
+    
+    //Only rom blocks are compiled, and only from their first op. Ram can be written to at any time.
+    if((block == NULL) || block->bIsRam || (op != &block->ops[0])){
+        return false;
+    }
+    
+    if(m_hot.bStop || (m_hot.bHalt && !IGNORE_HALT) || m_bSingleStep || (m_jit == NULL) || !m_jit->getEnabled()){
+        return false;
+    }
+    
+    //Idle loops stay interpreted to be skipped
+    if(USE_IDLE_LOOP_DETECTION && (block->idleLoopRegister != 0)){
+        return false;
+    }
+    
+    if(block->jitCode == NULL){
+        block->execCount++;
+        if(block->execCount < JIT_HOT_BLOCK_THRESHOLD){
+            return false;
+        }
+        
+        block->jitCode = m_jit->compile(block);
+        
+        //Start over with an empty code cache once it fills up
+        if(block->jitCode == NULL){
+            clear_jit_code();
+            block->jitCode = m_jit->compile(block);
+            if(block->jitCode == NULL){
+                return false;
             }
-                    
-            instruction_stop();
+        }
+    }
+    
+    //Compiled blocks don't check for events or interrupts between ops, so only run one when there are cycles for all of it,
+    //no event is due before its last op and nothing is waiting to be serviced.
+    if((m_hot.cycles < block->cycles) || m_hot.bInterruptsEnabledNext || get_interrupt_ready()){
+        return false;
     }
+    
+    if(m_scheduler->getCyclesUntilNextEvent() <= block->cycles - block->ops.back().entry->cycles){
+        return false;
+    }
+    
+    //Compiled code works out flags as it goes, so start it with F up to date
+    getRegisterF();
+    
+    m_jitCyclesTicked = 0;
+    block->jitCode(this);
+    return true;
+}
+
+//Ticks the scheduler up to the start of the op at site, so memory mapped IO sees the same time it would from the interpreter.
+//run_jit_block made sure this can't reach an event.
+void GBZ80::sync_jit_clock(uint32_t site){
+    uint32_t cycles = JIT_SITE_CYCLES(site);
+    m_scheduler->tick(cycles - m_jitCyclesTicked);
+    m_jitCyclesTicked = cycles;
+}
+
+//Retires every op of the running block up to and including the one at site, leaving the interpreter on the op after it
+void GBZ80::retire_jit_ops(uint32_t site){
+    size_t index = JIT_SITE_INDEX(site);
+    uint8_t cycleLength = m_hot.currentBlock->ops[index].entry->cycles;
+    
+    sync_jit_clock(site);
+    retire_instruction(cycleLength);
+    m_hot.cycles -= JIT_SITE_CYCLES(site) + cycleLength;
+    m_hot.currentBlockIndex = index + 1;
+}
+
+//Called after an op that might have changed something compiled code relies on.
+//Returns true if the block can go straight on to its next op, otherwise retires it so far and returns false.
+bool GBZ80::continue_jit_block(uint32_t site){
+    const CodeBlock* block = m_hot.currentBlock;
+    size_t index = JIT_SITE_INDEX(site);
+    
+    //Leave when jumping elsewhere, halting, turning on interrupts, after a bank switch, once an interrupt can be serviced,
+    //or once an event is due before the last op
+    bool bContinue = (index + 1 < block->ops.size()) && (block->ops[index + 1].address == m_hot.PC);
+    bContinue = bContinue && !m_hot.bStop && !(m_hot.bHalt && !IGNORE_HALT) && !m_hot.bInterruptsEnabledNext;
+    bContinue = bContinue && (m_hot.currentBlockMapVersion == m_gbmemory->getCodeMapVersion()) && !get_interrupt_ready();
+    bContinue = bContinue && (m_scheduler->getCyclesUntilNextEvent() + m_jitCyclesTicked > block->cycles - block->ops.back().entry->cycles);
+    
+    if(!bContinue){
+        retire_jit_ops(site);
+        return false;
+    }
+    
+    //Interpreted ops leave flags lazy, compiled ones expect F to be current
+    getRegisterF();
+    return true;
+}
+
+//True if process_interrupts would service an interrupt right now
+bool GBZ80::get_interrupt_ready(){
+    return m_hot.bInterruptsEnabled && (m_gbmemory->direct_read(INTERRUPT_ENABLE) & m_gbmemory->direct_read(ADDRESS_IF) & 0x1F);
+}
+
+//Throws away all compiled code. Blocks start counting towards being compiled again.
+void GBZ80::clear_jit_code(){
+    for(std::unordered_map<uint32_t, CodeBlock*>::iterator it = m_blockCache.begin(); it != m_blockCache.end(); ++it){
+        it->second->execCount = 0;
+        it->second->jitCode = NULL;
+    }
+    
+    m_jit->flush();
+}
+
+//Memory that compiled code can't reach through the page table
+uint8_t GBZ80::jit_read(GBZ80* cpu, uint32_t address, uint32_t site){
+    const MicroOp& op = cpu->m_hot.currentBlock->ops[JIT_SITE_INDEX(site)];
+    cpu->m_hot.PC = op.address + op.length;
+    cpu->sync_jit_clock(site);
+    return cpu->readMemory(address);
+}
+
+//Writes can switch banks, raise interrupts or move events, so the block might have to stop after them
+bool GBZ80::jit_write(GBZ80* cpu, uint32_t address, uint32_t value, uint32_t site){
+    const MicroOp& op = cpu->m_hot.currentBlock->ops[JIT_SITE_INDEX(site)];
+    cpu->m_hot.PC = op.address + op.length;
+    cpu->sync_jit_clock(site);
+    cpu->writeMemory(address, value);
+    return cpu->continue_jit_block(site);
 }
 
+//Ops that aren't translated run on the interpreter
+bool GBZ80::jit_execute(GBZ80* cpu, const MicroOp* op, uint32_t site){
+    cpu->sync_jit_clock(site);
+    cpu->execute_micro_op(op);
+    return cpu->continue_jit_block(site);
+}
+
+void GBZ80::jit_finish(GBZ80* cpu, uint32_t site){
+    cpu->retire_jit_ops(site);
+}
+
+//Dispatch wrappers for opcodes with immediate operands.
+//Pass the operand fetched during decode on to the matching instruction.
+
+void GBZ80::opcode_ld_BC_NN(){
+    instruction_ld_BC_NN(m_hot.operand);
+}
+
+void GBZ80::opcode_ld_B(){
+    instruction_ld_B(getLSB(m_hot.operand));
+}
+
+void GBZ80::opcode_ld_NNI_SP(){
+    instruction_ld_NNI_SP(m_hot.operand);
+}
+
+void GBZ80::opcode_ld_C(){
+    instruction_ld_C(getLSB(m_hot.operand));
+}
+
+void GBZ80::opcode_ld_DE_NN(){
+    instruction_ld_DE_NN(m_hot.operand);
+}
+
+void GBZ80::opcode_ld_D(){
+    instruction_ld_D(getLSB(m_hot.operand));
+}
+
+void GBZ80::opcode_jr(){
+    uint8_t nextByte = getLSB(m_hot.operand);
+    instruction_jr(reinterpret_cast<int8_t &>(nextByte));
+}
+
+void GBZ80::opcode_ld_E(){
+    instruction_ld_E(getLSB(m_hot.operand));
+}
+
+void GBZ80::opcode_jr_NZ(){
+    uint8_t nextByte = getLSB(m_hot.operand);
+    instruction_jr_NZ(reinterpret_cast<int8_t &>(nextByte));
+}
+
+void GBZ80::opcode_ld_HL_NN(){
+    instruction_ld_HL_NN(m_hot.operand);
+}
+
+void GBZ80::opcode_ld_H(){
+    instruction_ld_H(getLSB(m_hot.operand));
+}
+
+void GBZ80::opcode_jr_Z(){
+    uint8_t nextByte = getLSB(m_hot.operand);
+    instruction_jr_Z(reinterpret_cast<int8_t &>(nextByte));
+}
+
+void GBZ80::opcode_ld_L(){
+    instruction_ld_L(getLSB(m_hot.operand));
+}
+
+void GBZ80::opcode_jr_NC(){
+    uint8_t nextByte = getLSB(m_hot.operand);
+    instruction_jr_NC(reinterpret_cast<int8_t &>(nextByte));
+}
+
+void GBZ80::opcode_ld_SP_NN(){
+    instruction_ld_SP_NN(m_hot.operand);
+}
+
+void GBZ80::opcode_ld_HLI_N(){
+    instruction_ld_HLI_N(getLSB(m_hot.operand));
+}
+
+void GBZ80::opcode_jr_C(){
+    uint8_t nextByte = getLSB(m_hot.operand);
+    instruction_jr_C(reinterpret_cast<int8_t &>(nextByte));
+}
+
+void GBZ80::opcode_ld_A_CONST(){
+    instruction_ld_A_CONST(getLSB(m_hot.operand));
+}
+
+void GBZ80::opcode_jp_NZ(){
+    instruction_jp_NZ(m_hot.operand);
+}
+
+void GBZ80::opcode_jp(){
+    instruction_jp(m_hot.operand);
+}
+
+void GBZ80::opcode_call_NZ(){
+    instruction_call_NZ(m_hot.operand);
+}
+
+void GBZ80::opcode_add_CONST(){
+    instruction_add_CONST(getLSB(m_hot.operand));
+}
+
+void GBZ80::opcode_jp_Z(){
+    instruction_jp_Z(m_hot.operand);
+}
+
+void GBZ80::opcode_call_Z(){
+    instruction_call_Z(m_hot.operand);
+}
+
+void GBZ80::opcode_call(){
+    instruction_call(m_hot.operand);
+}
+
+void GBZ80::opcode_adc_CONST(){
+    instruction_adc_CONST(getLSB(m_hot.operand));
+}
+
+void GBZ80::opcode_jp_NC(){
+    instruction_jp_NC(m_hot.operand);
+}
+
+void GBZ80::opcode_call_NC(){
+    instruction_call_NC(m_hot.operand);
+}
+
+void GBZ80::opcode_sub_CONST(){
+    instruction_sub_CONST(getLSB(m_hot.operand));
+}
+
+void GBZ80::opcode_jp_C(){
+    instruction_jp_C(m_hot.operand);
+}
+
+void GBZ80::opcode_call_C(){
+    instruction_call_C(m_hot.operand);
+}
+
+void GBZ80::opcode_sbc_CONST(){
+    instruction_sbc_CONST(getLSB(m_hot.operand));
+}
+
+void GBZ80::opcode_ldh_FF00NI_A(){
+    instruction_ldh_FF00NI_A(getLSB(m_hot.operand));
+}
+
+void GBZ80::opcode_and_CONST(){
+    instruction_and_CONST(getLSB(m_hot.operand));
+}
+
+void GBZ80::opcode_add_SP_CONST(){
+    uint8_t nextByte = getLSB(m_hot.operand);
+    instruction_add_SP_CONST(reinterpret_cast<int8_t &>(nextByte));
+}
+
+void GBZ80::opcode_ld_NNI_A(){
+    instruction_ld_NNI_A(m_hot.operand);
+}
+
+void GBZ80::opcode_xor_CONST(){
+    instruction_xor_CONST(getLSB(m_hot.operand));
+}
+
+void GBZ80::opcode_ldh_A_FF00NI(){
+    instruction_ldh_A_FF00NI(getLSB(m_hot.operand));
+}
+
+void GBZ80::opcode_or_CONST(){
+    instruction_or_CONST(getLSB(m_hot.operand));
+}
+
+void GBZ80::opcode_ldhl(){
+    uint8_t nextByte = getLSB(m_hot.operand);
+    instruction_ldhl(reinterpret_cast<int8_t &>(nextByte));
+}
+
+void GBZ80::opcode_ld_A_NNI(){
+    instruction_ld_A_NNI(m_hot.operand);
+}
+
+void GBZ80::opcode_cp_CONST(){
+    instruction_cp_CONST(getLSB(m_hot.operand));
+}
+
+void GBZ80::opcode_stop(){
+    uint8_t nextOp = getLSB(m_hot.operand);
+    if(nextOp == 0x00){
+        instruction_stop();
+    } else {
+        std::cout << "A non-zero byte is following the stop byte!!! Value: " << +nextOp << std::endl;
+        
+        //According to https://github.com/AntonioND/giibiiadvance/blob/master/docs/TCAGBD.pdf
+        //Gameboy turns LCD on when invalid stop instruction is hit.
+        if(BAD_STOP_IS_LCD_ON){
+            uint8_t lcdc = m_gblcd->getLCDC();
+            m_gblcd->setLCDC(lcdc | LCDC_DISPLAY_ENABLE);
+        } 
+        
+        if(STOP_ON_BAD_STOP){
+            exit(1);
+        }
+    }
+}
+
+void GBZ80::opcode_invalid(){
+    //PC has already been moved past the opcode
+    uint8_t opcode = readMemory(m_hot.PC - 1);
+    std::cout << std::hex << "Unrecognized opcode " << +opcode << "!!!" << std::endl;
+    
+    if(STOP_ON_BAD_OPCODE){
+        exit(1);
+    }
+            
+    instruction_stop();
+}
+
+//Opcode dispatch tables. Cycle lengths come from opcycles.h.
+constexpr GBZ80::OpcodeEntry GBZ80::s_opcodeTable[256] = {
+    {&GBZ80::instruction_nop,           CYCLES_NOP,            1, 0}, //0x00 OP_NOP
+    {&GBZ80::opcode_ld_BC_NN,           CYCLES_OP_LD_RR_NN,    1, 2}, //0x01 OP_LD_BC_NN
+    {&GBZ80::instruction_ld_BCI_A,      CYCLES_OP_LD_R_RRI,    1, 0}, //0x02 OP_LD_BCI_A
+    {&GBZ80::instruction_inc_BC,        CYCLES_INC_RR,         1, 0}, //0x03 OP_INC_BC
+    {&GBZ80::instruction_inc_B,         CYCLES_INC_R,          1, 0}, //0x04 OP_INC_B
+    {&GBZ80::instruction_dec_B,         CYCLES_DEC_R,          1, 0}, //0x05 OP_DEC_B
+    {&GBZ80::opcode_ld_B,               CYCLES_OP_LD_R_N,      1, 1}, //0x06 OP_LD_B
+    {&GBZ80::instruction_rlca,          CYCLES_RLCA,           1, 0}, //0x07 OP_RLCA
+    {&GBZ80::opcode_ld_NNI_SP,          CYCLES_OP_LD_NNI_SP,   1, 2}, //0x08 OP_LD_NNI_SP
+    {&GBZ80::instruction_add_BC,        CYCLES_ADD_HL_RR,      1, 0}, //0x09 OP_ADD_BC
+    {&GBZ80::instruction_ld_A_BCI,      CYCLES_OP_LD_R_RRI,    1, 0}, //0x0A OP_LD_A_BCI
+    {&GBZ80::instruction_dec_BC,        CYCLES_DEC_RR,         1, 0}, //0x0B OP_DEC_BC
+    {&GBZ80::instruction_inc_C,         CYCLES_INC_R,          1, 0}, //0x0C OP_INC_C
+    {&GBZ80::instruction_dec_C,         CYCLES_DEC_R,          1, 0}, //0x0D OP_DEC_C
+    {&GBZ80::opcode_ld_C,               CYCLES_OP_LD_R_N,      1, 1}, //0x0E OP_LD_C
+    {&GBZ80::instruction_rrca,          CYCLES_RRCA,           1, 0}, //0x0F OP_RRCA
+    {&GBZ80::opcode_stop,               CYCLES_STOP,           1, 1}, //0x10 OP_STOP8
+    {&GBZ80::opcode_ld_DE_NN,           CYCLES_OP_LD_RR_NN,    1, 2}, //0x11 OP_LD_DE_NN
+    {&GBZ80::instruction_ld_DEI_A,      CYCLES_OP_LD_R_RRI,    1, 0}, //0x12 OP_LD_DEI_A
+    {&GBZ80::instruction_inc_DE,        CYCLES_INC_RR,         1, 0}, //0x13 OP_INC_DE
+    {&GBZ80::instruction_inc_D,         CYCLES_INC_R,          1, 0}, //0x14 OP_INC_D
+    {&GBZ80::instruction_dec_D,         CYCLES_DEC_R,          1, 0}, //0x15 OP_DEC_D
+    {&GBZ80::opcode_ld_D,               CYCLES_OP_LD_R_N,      1, 1}, //0x16 OP_LD_D
+    {&GBZ80::instruction_rla,           CYCLES_RLA,            1, 0}, //0x17 OP_RLA
+    {&GBZ80::opcode_jr,                 CYCLES_JR,             1, 1}, //0x18 OP_JR
+    {&GBZ80::instruction_add_DE,        CYCLES_ADD_HL_RR,      1, 0}, //0x19 OP_ADD_DE
+    {&GBZ80::instruction_ld_A_DEI,      CYCLES_OP_LD_R_RRI,    1, 0}, //0x1A OP_LD_A_DEI
+    {&GBZ80::instruction_dec_DE,        CYCLES_DEC_RR,         1, 0}, //0x1B OP_DEC_DE
+    {&GBZ80::instruction_inc_E,         CYCLES_INC_R,          1, 0}, //0x1C OP_INC_E
+    {&GBZ80::instruction_dec_E,         CYCLES_DEC_R,          1, 0}, //0x1D OP_DEC_E
+    {&GBZ80::opcode_ld_E,               CYCLES_OP_LD_R_N,      1, 1}, //0x1E OP_LD_E
+    {&GBZ80::instruction_rra,           CYCLES_RRA,            1, 0}, //0x1F OP_RRA
+    {&GBZ80::opcode_jr_NZ,              CYCLES_JR,             1, 1}, //0x20 OP_JR_NZ
+    {&GBZ80::opcode_ld_HL_NN,           CYCLES_OP_LD_RR_NN,    1, 2}, //0x21 OP_LD_HL_NN
+    {&GBZ80::instruction_ldi_HLI_A,     CYCLES_OP_LDI,         1, 0}, //0x22 OP_LDI_HLI_A
+    {&GBZ80::instruction_inc_HL,        CYCLES_INC_RR,         1, 0}, //0x23 OP_INC_HL
+    {&GBZ80::instruction_inc_H,         CYCLES_INC_R,          1, 0}, //0x24 OP_INC_H
+    {&GBZ80::instruction_dec_H,         CYCLES_DEC_R,          1, 0}, //0x25 OP_DEC_H
+    {&GBZ80::opcode_ld_H,               CYCLES_OP_LD_R_N,      1, 1}, //0x26 OP_LD_H
+    {&GBZ80::instruction_daa,           CYCLES_DAA,            1, 0}, //0x27 OP_DAA
+    {&GBZ80::opcode_jr_Z,               CYCLES_JR,             1, 1}, //0x28 OP_JR_Z
+    {&GBZ80::instruction_add_HL,        CYCLES_ADD_HL_RR,      1, 0}, //0x29 OP_ADD_HL
+    {&GBZ80::instruction_ldi_A_HLI,     CYCLES_OP_LDI,         1, 0}, //0x2A OP_LDI_A_HLI
+    {&GBZ80::instruction_dec_HL,        CYCLES_DEC_RR,         1, 0}, //0x2B OP_DEC_HL
+    {&GBZ80::instruction_inc_L,         CYCLES_INC_R,          1, 0}, //0x2C OP_INC_L
+    {&GBZ80::instruction_dec_L,         CYCLES_DEC_R,          1, 0}, //0x2D OP_DEC_L
+    {&GBZ80::opcode_ld_L,               CYCLES_OP_LD_R_N,      1, 1}, //0x2E OP_LD_L
+    {&GBZ80::instruction_cpl,           CYCLES_CPL,            1, 0}, //0x2F OP_CPL
+    {&GBZ80::opcode_jr_NC,              CYCLES_JR,             1, 1}, //0x30 OP_JR_NC
+    {&GBZ80::opcode_ld_SP_NN,           CYCLES_OP_LD_RR_NN,    1, 2}, //0x31 OP_LD_SP_NN
+    {&GBZ80::instruction_ldd_HLI_A,     CYCLES_OP_LDD,         1, 0}, //0x32 OP_LDD_HLI_A
+    {&GBZ80::instruction_inc_SP,        CYCLES_INC_RR,         1, 0}, //0x33 OP_INC_SP
+    {&GBZ80::instruction_inc_HLI,       CYCLES_INC_HLI,        1, 0}, //0x34 OP_INC_HLI
+    {&GBZ80::instruction_dec_HLI,       CYCLES_DEC_HLI,        1, 0}, //0x35 OP_DEC_HLI
+    {&GBZ80::opcode_ld_HLI_N,           CYCLES_OP_LD_HLI_N,    1, 1}, //0x36 OP_LD_HLI_N
+    {&GBZ80::instruction_scf,           CYCLES_SCF,            1, 0}, //0x37 OP_SCF
+    {&GBZ80::opcode_jr_C,               CYCLES_JR,             1, 1}, //0x38 OP_JR_C
+    {&GBZ80::instruction_add_SP,        CYCLES_ADD_HL_RR,      1, 0}, //0x39 OP_ADD_SP
+    {&GBZ80::instruction_ldd_A_HLI,     CYCLES_OP_LDD,         1, 0}, //0x3A OP_LDD_A_HLI
+    {&GBZ80::instruction_dec_SP,        CYCLES_DEC_RR,         1, 0}, //0x3B OP_DEC_SP
+    {&GBZ80::instruction_inc_A,         CYCLES_INC_R,          1, 0}, //0x3C OP_INC_A
+    {&GBZ80::instruction_dec_A,         CYCLES_DEC_R,          1, 0}, //0x3D OP_DEC_A
+    {&GBZ80::opcode_ld_A_CONST,         CYCLES_OP_LD_R_N,      1, 1}, //0x3E OP_LD_A_CONST
+    {&GBZ80::instruction_ccf,           CYCLES_CCF,            1, 0}, //0x3F OP_CCF
+    {&GBZ80::instruction_ld_B_B,        CYCLES_OP_LD_R_R,      1, 0}, //0x40 OP_LD_B_B
+    {&GBZ80::instruction_ld_B_C,        CYCLES_OP_LD_R_R,      1, 0}, //0x41 OP_LD_B_C
+    {&GBZ80::instruction_ld_B_D,        CYCLES_OP_LD_R_R,      1, 0}, //0x42 OP_LD_B_D
+    {&GBZ80::instruction_ld_B_E,        CYCLES_OP_LD_R_R,      1, 0}, //0x43 OP_LD_B_E
+    {&GBZ80::instruction_ld_B_H,        CYCLES_OP_LD_R_R,      1, 0}, //0x44 OP_LD_B_H
+    {&GBZ80::instruction_ld_B_L,        CYCLES_OP_LD_R_R,      1, 0}, //0x45 OP_LD_B_L
+    {&GBZ80::instruction_ld_B_HLI,      CYCLES_OP_LD_R_RRI,    1, 0}, //0x46 OP_LD_B_HLI
+    {&GBZ80::instruction_ld_B_A,        CYCLES_OP_LD_R_R,      1, 0}, //0x47 OP_LD_B_A
+    {&GBZ80::instruction_ld_C_B,        CYCLES_OP_LD_R_R,      1, 0}, //0x48 OP_LD_C_B
+    {&GBZ80::instruction_ld_C_C,        CYCLES_OP_LD_R_R,      1, 0}, //0x49 OP_LD_C_C
+    {&GBZ80::instruction_ld_C_D,        CYCLES_OP_LD_R_R,      1, 0}, //0x4A OP_LD_C_D
+    {&GBZ80::instruction_ld_C_E,        CYCLES_OP_LD_R_R,      1, 0}, //0x4B OP_LD_C_E
+    {&GBZ80::instruction_ld_C_H,        CYCLES_OP_LD_R_R,      1, 0}, //0x4C OP_LD_C_H
+    {&GBZ80::instruction_ld_C_L,        CYCLES_OP_LD_R_R,      1, 0}, //0x4D OP_LD_C_L
+    {&GBZ80::instruction_ld_C_HLI,      CYCLES_OP_LD_R_RRI,    1, 0}, //0x4E OP_LD_C_HLI
+    {&GBZ80::instruction_ld_C_A,        CYCLES_OP_LD_R_R,      1, 0}, //0x4F OP_LD_C_A
+    {&GBZ80::instruction_ld_D_B,        CYCLES_OP_LD_R_R,      1, 0}, //0x50 OP_LD_D_B
+    {&GBZ80::instruction_ld_D_C,        CYCLES_OP_LD_R_R,      1, 0}, //0x51 OP_LD_D_C
+    {&GBZ80::instruction_ld_D_D,        CYCLES_OP_LD_R_R,      1, 0}, //0x52 OP_LD_D_D
+    {&GBZ80::instruction_ld_D_E,        CYCLES_OP_LD_R_R,      1, 0}, //0x53 OP_LD_D_E
+    {&GBZ80::instruction_ld_D_H,        CYCLES_OP_LD_R_R,      1, 0}, //0x54 OP_LD_D_H
+    {&GBZ80::instruction_ld_D_L,        CYCLES_OP_LD_R_R,      1, 0}, //0x55 OP_LD_D_L
+    {&GBZ80::instruction_ld_D_HLI,      CYCLES_OP_LD_R_RRI,    1, 0}, //0x56 OP_LD_D_HLI
+    {&GBZ80::instruction_ld_D_A,        CYCLES_OP_LD_R_R,      1, 0}, //0x57 OP_LD_D_A
+    {&GBZ80::instruction_ld_E_B,        CYCLES_OP_LD_R_R,      1, 0}, //0x58 OP_LD_E_B
+    {&GBZ80::instruction_ld_E_C,        CYCLES_OP_LD_R_R,      1, 0}, //0x59 OP_LD_E_C
+    {&GBZ80::instruction_ld_E_D,        CYCLES_OP_LD_R_R,      1, 0}, //0x5A OP_LD_E_D
+    {&GBZ80::instruction_ld_E_E,        CYCLES_OP_LD_R_R,      1, 0}, //0x5B OP_LD_E_E
+    {&GBZ80::instruction_ld_E_H,        CYCLES_OP_LD_R_R,      1, 0}, //0x5C OP_LD_E_H
+    {&GBZ80::instruction_ld_E_L,        CYCLES_OP_LD_R_R,      1, 0}, //0x5D OP_LD_E_L
+    {&GBZ80::instruction_ld_E_HLI,      CYCLES_OP_LD_R_RRI,    1, 0}, //0x5E OP_LD_E_HLI
+    {&GBZ80::instruction_ld_E_A,        CYCLES_OP_LD_R_R,      1, 0}, //0x5F OP_LD_E_A
+    {&GBZ80::instruction_ld_H_B,        CYCLES_OP_LD_R_R,      1, 0}, //0x60 OP_LD_H_B
+    {&GBZ80::instruction_ld_H_C,        CYCLES_OP_LD_R_R,      1, 0}, //0x61 OP_LD_H_C
+    {&GBZ80::instruction_ld_H_D,        CYCLES_OP_LD_R_R,      1, 0}, //0x62 OP_LD_H_D
+    {&GBZ80::instruction_ld_H_E,        CYCLES_OP_LD_R_R,      1, 0}, //0x63 OP_LD_H_E
+    {&GBZ80::instruction_ld_H_H,        CYCLES_OP_LD_R_R,      1, 0}, //0x64 OP_LD_H_H
+    {&GBZ80::instruction_ld_H_L,        CYCLES_OP_LD_R_R,      1, 0}, //0x65 OP_LD_H_L
+    {&GBZ80::instruction_ld_H_HLI,      CYCLES_OP_LD_R_RRI,    1, 0}, //0x66 OP_LD_H_HLI
+    {&GBZ80::instruction_ld_H_A,        CYCLES_OP_LD_R_R,      1, 0}, //0x67 OP_LD_H_A
+    {&GBZ80::instruction_ld_L_B,        CYCLES_OP_LD_R_R,      1, 0}, //0x68 OP_LD_L_B
+    {&GBZ80::instruction_ld_L_C,        CYCLES_OP_LD_R_R,      1, 0}, //0x69 OP_LD_L_C
+    {&GBZ80::instruction_ld_L_D,        CYCLES_OP_LD_R_R,      1, 0}, //0x6A OP_LD_L_D
+    {&GBZ80::instruction_ld_L_E,        CYCLES_OP_LD_R_R,      1, 0}, //0x6B OP_LD_L_E
+    {&GBZ80::instruction_ld_L_H,        CYCLES_OP_LD_R_R,      1, 0}, //0x6C OP_LD_L_H
+    {&GBZ80::instruction_ld_L_L,        CYCLES_OP_LD_R_R,      1, 0}, //0x6D OP_LD_L_L
+    {&GBZ80::instruction_ld_L_HLI,      CYCLES_OP_LD_R_RRI,    1, 0}, //0x6E OP_LD_L_HLI
+    {&GBZ80::instruction_ld_L_A,        CYCLES_OP_LD_R_R,      1, 0}, //0x6F OP_LD_L_A
+    {&GBZ80::instruction_ld_HLI_B,      CYCLES_OP_LD_R_RRI,    1, 0}, //0x70 OP_LD_HLI_B
+    {&GBZ80::instruction_ld_HLI_C,      CYCLES_OP_LD_R_RRI,    1, 0}, //0x71 OP_LD_HLI_C
+    {&GBZ80::instruction_ld_HLI_D,      CYCLES_OP_LD_R_RRI,    1, 0}, //0x72 OP_LD_HLI_D
+    {&GBZ80::instruction_ld_HLI_E,      CYCLES_OP_LD_R_RRI,    1, 0}, //0x73 OP_LD_HLI_E
+    {&GBZ80::instruction_ld_HLI_H,      CYCLES_OP_LD_R_RRI,    1, 0}, //0x74 OP_LD_HLI_H
+    {&GBZ80::instruction_ld_HLI_L,      CYCLES_OP_LD_R_RRI,    1, 0}, //0x75 OP_LD_HLI_L
+    {&GBZ80::instruction_halt,          CYCLES_HALT,           1, 0}, //0x76 OP_HALT
+    {&GBZ80::instruction_ld_HLI_A,      CYCLES_OP_LD_R_RRI,    1, 0}, //0x77 OP_LD_HLI_A
+    {&GBZ80::instruction_ld_A_B,        CYCLES_OP_LD_R_R,      1, 0}, //0x78 OP_LD_A_B
+    {&GBZ80::instruction_ld_A_C,        CYCLES_OP_LD_R_R,      1, 0}, //0x79 OP_LD_A_C
+    {&GBZ80::instruction_ld_A_D,        CYCLES_OP_LD_R_R,      1, 0}, //0x7A OP_LD_A_D
+    {&GBZ80::instruction_ld_A_E,        CYCLES_OP_LD_R_R,      1, 0}, //0x7B OP_LD_A_E
+    {&GBZ80::instruction_ld_A_H,        CYCLES_OP_LD_R_R,      1, 0}, //0x7C OP_LD_A_H
+    {&GBZ80::instruction_ld_A_L,        CYCLES_OP_LD_R_R,      1, 0}, //0x7D OP_LD_A_L
+    {&GBZ80::instruction_ld_A_HLI,      CYCLES_OP_LD_R_RRI,    1, 0}, //0x7E OP_LD_A_HLI
+    {&GBZ80::instruction_ld_A_A,        CYCLES_OP_LD_R_R,      1, 0}, //0x7F OP_LD_A_A
+    {&GBZ80::instruction_add_B,         CYCLES_OP_ADD_R,       1, 0}, //0x80 OP_ADD_B
+    {&GBZ80::instruction_add_C,         CYCLES_OP_ADD_R,       1, 0}, //0x81 OP_ADD_C
+    {&GBZ80::instruction_add_D,         CYCLES_OP_ADD_R,       1, 0}, //0x82 OP_ADD_D
+    {&GBZ80::instruction_add_E,         CYCLES_OP_ADD_R,       1, 0}, //0x83 OP_ADD_E
+    {&GBZ80::instruction_add_H,         CYCLES_OP_ADD_R,       1, 0}, //0x84 OP_ADD_H
+    {&GBZ80::instruction_add_L,         CYCLES_OP_ADD_R,       1, 0}, //0x85 OP_ADD_L
+    {&GBZ80::instruction_add_HLI,       CYCLES_OP_ADD_HLI,     1, 0}, //0x86 OP_ADD_HLI
+    {&GBZ80::instruction_add_A,         CYCLES_OP_ADD_R,       1, 0}, //0x87 OP_ADD_A
+    {&GBZ80::instruction_adc_B,         CYCLES_OP_ADC_R,       1, 0}, //0x88 OP_ADC_B
+    {&GBZ80::instruction_adc_C,         CYCLES_OP_ADC_R,       1, 0}, //0x89 OP_ADC_C
+    {&GBZ80::instruction_adc_D,         CYCLES_OP_ADC_R,       1, 0}, //0x8A OP_ADC_D
+    {&GBZ80::instruction_adc_E,         CYCLES_OP_ADC_R,       1, 0}, //0x8B OP_ADC_E
+    {&GBZ80::instruction_adc_H,         CYCLES_OP_ADC_R,       1, 0}, //0x8C OP_ADC_H
+    {&GBZ80::instruction_adc_L,         CYCLES_OP_ADC_R,       1, 0}, //0x8D OP_ADC_L
+    {&GBZ80::instruction_adc_HLI,       CYCLES_OP_ADC_HLI,     1, 0}, //0x8E OP_ADC_HLI
+    {&GBZ80::instruction_adc_A,         CYCLES_OP_ADC_R,       1, 0}, //0x8F OP_ADC_A
+    {&GBZ80::instruction_sub_B,         CYCLES_OP_SUB_R,       1, 0}, //0x90 OP_SUB_B
+    {&GBZ80::instruction_sub_C,         CYCLES_OP_SUB_R,       1, 0}, //0x91 OP_SUB_C
+    {&GBZ80::instruction_sub_D,         CYCLES_OP_SUB_R,       1, 0}, //0x92 OP_SUB_D
+    {&GBZ80::instruction_sub_E,         CYCLES_OP_SUB_R,       1, 0}, //0x93 OP_SUB_E
+    {&GBZ80::instruction_sub_H,         CYCLES_OP_SUB_R,       1, 0}, //0x94 OP_SUB_H
+    {&GBZ80::instruction_sub_L,         CYCLES_OP_SUB_R,       1, 0}, //0x95 OP_SUB_L
+    {&GBZ80::instruction_sub_HLI,       CYCLES_OP_SUB_HLI,     1, 0}, //0x96 OP_SUB_HLI
+    {&GBZ80::instruction_sub_A,         CYCLES_OP_SUB_R,       1, 0}, //0x97 OP_SUB_A
+    {&GBZ80::instruction_sbc_B,         CYCLES_OP_SBC_R,       1, 0}, //0x98 OP_SBC_B
+    {&GBZ80::instruction_sbc_C,         CYCLES_OP_SBC_R,       1, 0}, //0x99 OP_SBC_C
+    {&GBZ80::instruction_sbc_D,         CYCLES_OP_SBC_R,       1, 0}, //0x9A OP_SBC_D
+    {&GBZ80::instruction_sbc_E,         CYCLES_OP_SBC_R,       1, 0}, //0x9B OP_SBC_E
+    {&GBZ80::instruction_sbc_H,         CYCLES_OP_SBC_R,       1, 0}, //0x9C OP_SBC_H
+    {&GBZ80::instruction_sbc_L,         CYCLES_OP_SBC_R,       1, 0}, //0x9D OP_SBC_L
+    {&GBZ80::instruction_sbc_HLI,       CYCLES_OP_SBC_HLI,     1, 0}, //0x9E OP_SBC_HLI
+    {&GBZ80::instruction_sbc_A,         CYCLES_OP_SBC_R,       1, 0}, //0x9F OP_SBC_A
+    {&GBZ80::instruction_and_B,         CYCLES_OP_AND_R,       1, 0}, //0xA0 OP_AND_B
+    {&GBZ80::instruction_and_C,         CYCLES_OP_AND_R,       1, 0}, //0xA1 OP_AND_C
+    {&GBZ80::instruction_and_D,         CYCLES_OP_AND_R,       1, 0}, //0xA2 OP_AND_D
+    {&GBZ80::instruction_and_E,         CYCLES_OP_AND_R,       1, 0}, //0xA3 OP_AND_E
+    {&GBZ80::instruction_and_H,         CYCLES_OP_AND_R,       1, 0}, //0xA4 OP_AND_H
+    {&GBZ80::instruction_and_L,         CYCLES_OP_AND_R,       1, 0}, //0xA5 OP_AND_L
+    {&GBZ80::instruction_and_HLI,       CYCLES_OP_AND_HLI,     1, 0}, //0xA6 OP_AND_HLI
+    {&GBZ80::instruction_and_A,         CYCLES_OP_AND_R,       1, 0}, //0xA7 OP_AND_A
+    {&GBZ80::instruction_xor_B,         CYCLES_XOR_R,          1, 0}, //0xA8 OP_XOR_B
+    {&GBZ80::instruction_xor_C,         CYCLES_XOR_R,          1, 0}, //0xA9 OP_XOR_C
+    {&GBZ80::instruction_xor_D,         CYCLES_XOR_R,          1, 0}, //0xAA OP_XOR_D
+    {&GBZ80::instruction_xor_E,         CYCLES_XOR_R,          1, 0}, //0xAB OP_XOR_E
+    {&GBZ80::instruction_xor_H,         CYCLES_XOR_R,          1, 0}, //0xAC OP_XOR_H
+    {&GBZ80::instruction_xor_L,         CYCLES_XOR_R,          1, 0}, //0xAD OP_XOR_L
+    {&GBZ80::instruction_xor_HLI,       CYCLES_XOR_HLI,        1, 0}, //0xAE OP_XOR_HLI
+    {&GBZ80::instruction_xor_A,         CYCLES_XOR_R,          1, 0}, //0xAF OP_XOR_A
+    {&GBZ80::instruction_or_B,          CYCLES_OP_OR_R,        1, 0}, //0xB0 OP_OR_B
+    {&GBZ80::instruction_or_C,          CYCLES_OP_OR_R,        1, 0}, //0xB1 OP_OR_C
+    {&GBZ80::instruction_or_D,          CYCLES_OP_OR_R,        1, 0}, //0xB2 OP_OR_D
+    {&GBZ80::instruction_or_E,          CYCLES_OP_OR_R,        1, 0}, //0xB3 OP_OR_E
+    {&GBZ80::instruction_or_H,          CYCLES_OP_OR_R,        1, 0}, //0xB4 OP_OR_H
+    {&GBZ80::instruction_or_L,          CYCLES_OP_OR_R,        1, 0}, //0xB5 OP_OR_L
+    {&GBZ80::instruction_or_HLI,        CYCLES_OP_OR_HLI,      1, 0}, //0xB6 OP_OR_HLI
+    {&GBZ80::instruction_or_A,          CYCLES_OP_OR_R,        1, 0}, //0xB7 OP_OR_A
+    {&GBZ80::instruction_cp_B,          CYCLES_CP_R,           1, 0}, //0xB8 OP_CP_B
+    {&GBZ80::instruction_cp_C,          CYCLES_CP_R,           1, 0}, //0xB9 OP_CP_C
+    {&GBZ80::instruction_cp_D,          CYCLES_CP_R,           1, 0}, //0xBA OP_CP_D
+    {&GBZ80::instruction_cp_E,          CYCLES_CP_R,           1, 0}, //0xBB OP_CP_E
+    {&GBZ80::instruction_cp_H,          CYCLES_CP_R,           1, 0}, //0xBC OP_CP_H
+    {&GBZ80::instruction_cp_L,          CYCLES_CP_R,           1, 0}, //0xBD OP_CP_L
+    {&GBZ80::instruction_cp_HLI,        CYCLES_CP_HLI,         1, 0}, //0xBE OP_CP_HLI
+    {&GBZ80::instruction_cp_A,          CYCLES_CP_R,           1, 0}, //0xBF OP_CP_A
+    {&GBZ80::instruction_ret_NZ,        CYCLES_RET,            1, 0}, //0xC0 OP_RET_NZ
+    {&GBZ80::instruction_pop_BC,        CYCLES_OP_POP,         1, 0}, //0xC1 OP_POP_BC
+    {&GBZ80::opcode_jp_NZ,              CYCLES_JP_NN,          1, 2}, //0xC2 OP_JP_NZ
+    {&GBZ80::opcode_jp,                 CYCLES_JP_NN,          1, 2}, //0xC3 OP_JP
+    {&GBZ80::opcode_call_NZ,            CYCLES_CALL,           1, 2}, //0xC4 OP_CALL_NZ
+    {&GBZ80::instruction_push_BC,       CYCLES_OP_PUSH,        1, 0}, //0xC5 OP_PUSH_BC
+    {&GBZ80::opcode_add_CONST,          CYCLES_OP_ADD_N,       1, 1}, //0xC6 OP_ADD_CONST
+    {&GBZ80::instruction_rst_00H,       CYCLES_RST,            1, 0}, //0xC7 OP_RST_00H
+    {&GBZ80::instruction_ret_Z,         CYCLES_RET,            1, 0}, //0xC8 OP_RET_Z
+    {&GBZ80::instruction_ret,           CYCLES_RET,            1, 0}, //0xC9 OP_RET
+    {&GBZ80::opcode_jp_Z,               CYCLES_JP_NN,          1, 2}, //0xCA OP_JP_Z
+    {NULL,                              0,                     1, 0}, //0xCB OP_IS_CB_PREFIXED - decoded through s_cbOpcodeTable
+    {&GBZ80::opcode_call_Z,             CYCLES_CALL,           1, 2}, //0xCC OP_CALL_Z
+    {&GBZ80::opcode_call,               CYCLES_CALL,           1, 2}, //0xCD OP_CALL
+    {&GBZ80::opcode_adc_CONST,          CYCLES_OP_ADC_N,       1, 1}, //0xCE OP_ADC_CONST
+    {&GBZ80::instruction_rst_08H,       CYCLES_RST,            1, 0}, //0xCF OP_RST_08H
+    {&GBZ80::instruction_ret_NC,        CYCLES_RET,            1, 0}, //0xD0 OP_RET_NC
+    {&GBZ80::instruction_pop_DE,        CYCLES_OP_POP,         1, 0}, //0xD1 OP_POP_DE
+    {&GBZ80::opcode_jp_NC,              CYCLES_JP_NN,          1, 2}, //0xD2 OP_JP_NC
+    {&GBZ80::opcode_invalid,            4,                     1, 0}, //0xD3
+    {&GBZ80::opcode_call_NC,            CYCLES_CALL,           1, 2}, //0xD4 OP_CALL_NC
+    {&GBZ80::instruction_push_DE,       CYCLES_OP_PUSH,        1, 0}, //0xD5 OP_PUSH_DE
+    {&GBZ80::opcode_sub_CONST,          CYCLES_OP_SUB_N,       1, 1}, //0xD6 OP_SUB_CONST
+    {&GBZ80::instruction_rst_10H,       CYCLES_RST,            1, 0}, //0xD7 OP_RST_10H
+    {&GBZ80::instruction_ret_C,         CYCLES_RET,            1, 0}, //0xD8 OP_RET_C
+    {&GBZ80::instruction_reti,          CYCLES_RET,            1, 0}, //0xD9 OP_RETI
+    {&GBZ80::opcode_jp_C,               CYCLES_JP_NN,          1, 2}, //0xDA OP_JP_C
+    {&GBZ80::opcode_invalid,            4,                     1, 0}, //0xDB
+    {&GBZ80::opcode_call_C,             CYCLES_CALL,           1, 2}, //0xDC OP_CALL_C
+    {&GBZ80::opcode_invalid,            4,                     1, 0}, //0xDD
+    {&GBZ80::opcode_sbc_CONST,          CYCLES_OP_SBC_N,       1, 1}, //0xDE OP_SBC_CONST
+    {&GBZ80::instruction_rst_18H,       CYCLES_RST,            1, 0}, //0xDF OP_RST_18H
+    {&GBZ80::opcode_ldh_FF00NI_A,       CYCLES_OP_LDH,         1, 1}, //0xE0 OP_LDH_FF00NI_A
+    {&GBZ80::instruction_pop_HL,        CYCLES_OP_POP,         1, 0}, //0xE1 OP_POP_HL
+    {&GBZ80::instruction_ld_FF00CI_A,   CYCLES_OP_LD_FF00CI,   1, 0}, //0xE2 OP_LD_FF00CI_A
+    {&GBZ80::opcode_invalid,            4,                     1, 0}, //0xE3
+    {&GBZ80::opcode_invalid,            4,                     1, 0}, //0xE4
+    {&GBZ80::instruction_push_HL,       CYCLES_OP_PUSH,        1, 0}, //0xE5 OP_PUSH_HL
+    {&GBZ80::opcode_and_CONST,          CYCLES_OP_AND_N,       1, 1}, //0xE6 OP_AND_CONST
+    {&GBZ80::instruction_rst_20H,       CYCLES_RST,            1, 0}, //0xE7 OP_RST_20H
+    {&GBZ80::opcode_add_SP_CONST,       CYCLES_ADD_SP_N,       1, 1}, //0xE8 OP_ADD_SP_CONST
+    {&GBZ80::instruction_jp_HLI,        CYCLES_JP_HLI,         1, 0}, //0xE9 OP_JP_HLI
+    {&GBZ80::opcode_ld_NNI_A,           CYCLES_OP_LD_NNI_R,    1, 2}, //0xEA OP_LD_NNI_A
+    {&GBZ80::opcode_invalid,            4,                     1, 0}, //0xEB
+    {&GBZ80::opcode_invalid,            4,                     1, 0}, //0xEC
+    {&GBZ80::opcode_invalid,            4,                     1, 0}, //0xED
+    {&GBZ80::opcode_xor_CONST,          CYCLES_XOR_N,          1, 1}, //0xEE OP_XOR_CONST
+    {&GBZ80::instruction_rst_28H,       CYCLES_RST,            1, 0}, //0xEF OP_RST_28H
+    {&GBZ80::opcode_ldh_A_FF00NI,       CYCLES_OP_LDH,         1, 1}, //0xF0 OP_LDH_A_FF00NI
+    {&GBZ80::instruction_pop_AF,        CYCLES_OP_POP,         1, 0}, //0xF1 OP_POP_AF
+    {&GBZ80::instruction_ld_A_FF00CI,   CYCLES_OP_LD_FF00CI,   1, 0}, //0xF2 OP_LD_A_FF00CI
+    {&GBZ80::instruction_di,            CYCLES_DI,             1, 0}, //0xF3 OP_DI
+    {&GBZ80::opcode_invalid,            4,                     1, 0}, //0xF4
+    {&GBZ80::instruction_push_AF,       CYCLES_OP_PUSH,        1, 0}, //0xF5 OP_PUSH_AF
+    {&GBZ80::opcode_or_CONST,           CYCLES_OP_OR_N,        1, 1}, //0xF6 OP_OR_CONST
+    {&GBZ80::instruction_rst_30H,       CYCLES_RST,            1, 0}, //0xF7 OP_RST_30H
+    {&GBZ80::opcode_ldhl,               CYCLES_OP_LDHL,        1, 1}, //0xF8 OP_LDHL_SP_N
+    {&GBZ80::instruction_ld_SP_HL,      CYCLES_OP_LD_SP_HL,    1, 0}, //0xF9 OP_LD_SP_HL
+    {&GBZ80::opcode_ld_A_NNI,           CYCLES_OP_LD_NNI_R,    1, 2}, //0xFA OP_LD_A_NNI
+    {&GBZ80::instruction_ei,            CYCLES_EI,             1, 0}, //0xFB OP_EI
+    {&GBZ80::opcode_invalid,            4,                     1, 0}, //0xFC
+    {&GBZ80::opcode_invalid,            4,                     1, 0}, //0xFD
+    {&GBZ80::opcode_cp_CONST,           CYCLES_CP_N,           1, 1}, //0xFE OP_CP_CONST
+    {&GBZ80::instruction_rst_38H,       CYCLES_RST,            1, 0}, //0xFF OP_RST_38H
+};
+
+//CB prefixed opcodes, indexed by the byte following the prefix
+constexpr GBZ80::OpcodeEntry GBZ80::s_cbOpcodeTable[256] = {
+    {&GBZ80::instruction_rlc_B,         CYCLES_RLC_R,          2, 0}, //0xCB00 OP_RLC_B
+    {&GBZ80::instruction_rlc_C,         CYCLES_RLC_R,          2, 0}, //0xCB01 OP_RLC_C
+    {&GBZ80::instruction_rlc_D,         CYCLES_RLC_R,          2, 0}, //0xCB02 OP_RLC_D
+    {&GBZ80::instruction_rlc_E,         CYCLES_RLC_R,          2, 0}, //0xCB03 OP_RLC_E
+    {&GBZ80::instruction_rlc_H,         CYCLES_RLC_R,          2, 0}, //0xCB04 OP_RLC_H
+    {&GBZ80::instruction_rlc_L,         CYCLES_RLC_R,          2, 0}, //0xCB05 OP_RLC_L
+    {&GBZ80::instruction_rlc_HLI,       CYCLES_RLC_HLI,        2, 0}, //0xCB06 OP_RLC_HLI
+    {&GBZ80::instruction_rlc_A,         CYCLES_RLC_R,          2, 0}, //0xCB07 OP_RLC_A
+    {&GBZ80::instruction_rrc_B,         CYCLES_RRC_R,          2, 0}, //0xCB08 OP_RRC_B
+    {&GBZ80::instruction_rrc_C,         CYCLES_RRC_R,          2, 0}, //0xCB09 OP_RRC_C
+    {&GBZ80::instruction_rrc_D,         CYCLES_RRC_R,          2, 0}, //0xCB0A OP_RRC_D
+    {&GBZ80::instruction_rrc_E,         CYCLES_RRC_R,          2, 0}, //0xCB0B OP_RRC_E
+    {&GBZ80::instruction_rrc_H,         CYCLES_RRC_R,          2, 0}, //0xCB0C OP_RRC_H
+    {&GBZ80::instruction_rrc_L,         CYCLES_RRC_R,          2, 0}, //0xCB0D OP_RRC_L
+    {&GBZ80::instruction_rrc_HLI,       CYCLES_RRC_HLI,        2, 0}, //0xCB0E OP_RRC_HLI
+    {&GBZ80::instruction_rrc_A,         CYCLES_RRC_R,          2, 0}, //0xCB0F OP_RRC_A
+    {&GBZ80::instruction_rl_B,          CYCLES_RL_R,           2, 0}, //0xCB10 OP_RL_B
+    {&GBZ80::instruction_rl_C,          CYCLES_RL_R,           2, 0}, //0xCB11 OP_RL_C
+    {&GBZ80::instruction_rl_D,          CYCLES_RL_R,           2, 0}, //0xCB12 OP_RL_D
+    {&GBZ80::instruction_rl_E,          CYCLES_RL_R,           2, 0}, //0xCB13 OP_RL_E
+    {&GBZ80::instruction_rl_H,          CYCLES_RL_R,           2, 0}, //0xCB14 OP_RL_H
+    {&GBZ80::instruction_rl_L,          CYCLES_RL_R,           2, 0}, //0xCB15 OP_RL_L
+    {&GBZ80::instruction_rl_HLI,        CYCLES_RL_HLI,         2, 0}, //0xCB16 OP_RL_HLI
+    {&GBZ80::instruction_rl_A,          CYCLES_RL_R,           2, 0}, //0xCB17 OP_RL_A
+    {&GBZ80::instruction_rr_B,          CYCLES_RR_R,           2, 0}, //0xCB18 OP_RR_B
+    {&GBZ80::instruction_rr_C,          CYCLES_RR_R,           2, 0}, //0xCB19 OP_RR_C
+    {&GBZ80::instruction_rr_D,          CYCLES_RR_R,           2, 0}, //0xCB1A OP_RR_D
+    {&GBZ80::instruction_rr_E,          CYCLES_RR_R,           2, 0}, //0xCB1B OP_RR_E
+    {&GBZ80::instruction_rr_H,          CYCLES_RR_R,           2, 0}, //0xCB1C OP_RR_H
+    {&GBZ80::instruction_rr_L,          CYCLES_RR_R,           2, 0}, //0xCB1D OP_RR_L
+    {&GBZ80::instruction_rr_HLI,        CYCLES_RR_HLI,         2, 0}, //0xCB1E OP_RR_HLI
+    {&GBZ80::instruction_rr_A,          CYCLES_RR_R,           2, 0}, //0xCB1F OP_RR_A
+    {&GBZ80::instruction_sla_B,         CYCLES_SLA_R,          2, 0}, //0xCB20 OP_SLA_B
+    {&GBZ80::instruction_sla_C,         CYCLES_SLA_R,          2, 0}, //0xCB21 OP_SLA_C
+    {&GBZ80::instruction_sla_D,         CYCLES_SLA_R,          2, 0}, //0xCB22 OP_SLA_D
+    {&GBZ80::instruction_sla_E,         CYCLES_SLA_R,          2, 0}, //0xCB23 OP_SLA_E
+    {&GBZ80::instruction_sla_H,         CYCLES_SLA_R,          2, 0}, //0xCB24 OP_SLA_H
+    {&GBZ80::instruction_sla_L,         CYCLES_SLA_R,          2, 0}, //0xCB25 OP_SLA_L
+    {&GBZ80::instruction_sla_HLI,       CYCLES_SLA_HLI,        2, 0}, //0xCB26 OP_SLA_HLI
+    {&GBZ80::instruction_sla_A,         CYCLES_SLA_R,          2, 0}, //0xCB27 OP_SLA_A
+    {&GBZ80::instruction_sra_B,         CYCLES_SRA_R,          2, 0}, //0xCB28 OP_SRA_B
+    {&GBZ80::instruction_sra_C,         CYCLES_SRA_R,          2, 0}, //0xCB29 OP_SRA_C
+    {&GBZ80::instruction_sra_D,         CYCLES_SRA_R,          2, 0}, //0xCB2A OP_SRA_D
+    {&GBZ80::instruction_sra_E,         CYCLES_SRA_R,          2, 0}, //0xCB2B OP_SRA_E
+    {&GBZ80::instruction_sra_H,         CYCLES_SRA_R,          2, 0}, //0xCB2C OP_SRA_H
+    {&GBZ80::instruction_sra_L,         CYCLES_SRA_R,          2, 0}, //0xCB2D OP_SRA_L
+    {&GBZ80::instruction_sra_HLI,       CYCLES_SRA_HLI,        2, 0}, //0xCB2E OP_SRA_HLI
+    {&GBZ80::instruction_sra_A,         CYCLES_SRA_R,          2, 0}, //0xCB2F OP_SRA_A
+    {&GBZ80::instruction_swap_B,        CYCLES_SWAP_R,         2, 0}, //0xCB30 OP_SWAP_B
+    {&GBZ80::instruction_swap_C,        CYCLES_SWAP_R,         2, 0}, //0xCB31 OP_SWAP_C
+    {&GBZ80::instruction_swap_D,        CYCLES_SWAP_R,         2, 0}, //0xCB32 OP_SWAP_D
+    {&GBZ80::instruction_swap_E,        CYCLES_SWAP_R,         2, 0}, //0xCB33 OP_SWAP_E
+    {&GBZ80::instruction_swap_H,        CYCLES_SWAP_R,         2, 0}, //0xCB34 OP_SWAP_H
+    {&GBZ80::instruction_swap_L,        CYCLES_SWAP_R,         2, 0}, //0xCB35 OP_SWAP_L
+    {&GBZ80::instruction_swap_HLI,      CYCLES_SWAP_HLI,       2, 0}, //0xCB36 OP_SWAP_HLI
+    {&GBZ80::instruction_swap_A,        CYCLES_SWAP_R,         2, 0}, //0xCB37 OP_SWAP_A
+    {&GBZ80::instruction_srl_B,         CYCLES_SRL_R,          2, 0}, //0xCB38 OP_SRL_B
+    {&GBZ80::instruction_srl_C,         CYCLES_SRL_R,          2, 0}, //0xCB39 OP_SRL_C
+    {&GBZ80::instruction_srl_D,         CYCLES_SRL_R,          2, 0}, //0xCB3A OP_SRL_D
+    {&GBZ80::instruction_srl_E,         CYCLES_SRL_R,          2, 0}, //0xCB3B OP_SRL_E
+    {&GBZ80::instruction_srl_H,         CYCLES_SRL_R,          2, 0}, //0xCB3C OP_SRL_H
+    {&GBZ80::instruction_srl_L,         CYCLES_SRL_R,          2, 0}, //0xCB3D OP_SRL_L
+    {&GBZ80::instruction_srl_HLI,       CYCLES_SRL_HLI,        2, 0}, //0xCB3E OP_SRL_HLI
+    {&GBZ80::instruction_srl_A,         CYCLES_SRL_R,          2, 0}, //0xCB3F OP_SRL_A
+    {&GBZ80::instruction_bit_0_B,       CYCLES_BIT_B_R,        2, 0}, //0xCB40 OP_BIT_0_B
+    {&GBZ80::instruction_bit_0_C,       CYCLES_BIT_B_R,        2, 0}, //0xCB41 OP_BIT_0_C
+    {&GBZ80::instruction_bit_0_D,       CYCLES_BIT_B_R,        2, 0}, //0xCB42 OP_BIT_0_D
+    {&GBZ80::instruction_bit_0_E,       CYCLES_BIT_B_R,        2, 0}, //0xCB43 OP_BIT_0_E
+    {&GBZ80::instruction_bit_0_H,       CYCLES_BIT_B_R,        2, 0}, //0xCB44 OP_BIT_0_H
+    {&GBZ80::instruction_bit_0_L,       CYCLES_BIT_B_R,        2, 0}, //0xCB45 OP_BIT_0_L
+    {&GBZ80::instruction_bit_0_HLI,     CYCLES_BIT_B_HLI,      2, 0}, //0xCB46 OP_BIT_0_HLI
+    {&GBZ80::instruction_bit_0_A,       CYCLES_BIT_B_R,        2, 0}, //0xCB47 OP_BIT_0_A
+    {&GBZ80::instruction_bit_1_B,       CYCLES_BIT_B_R,        2, 0}, //0xCB48 OP_BIT_1_B
+    {&GBZ80::instruction_bit_1_C,       CYCLES_BIT_B_R,        2, 0}, //0xCB49 OP_BIT_1_C
+    {&GBZ80::instruction_bit_1_D,       CYCLES_BIT_B_R,        2, 0}, //0xCB4A OP_BIT_1_D
+    {&GBZ80::instruction_bit_1_E,       CYCLES_BIT_B_R,        2, 0}, //0xCB4B OP_BIT_1_E
+    {&GBZ80::instruction_bit_1_H,       CYCLES_BIT_B_R,        2, 0}, //0xCB4C OP_BIT_1_H
+    {&GBZ80::instruction_bit_1_L,       CYCLES_BIT_B_R,        2, 0}, //0xCB4D OP_BIT_1_L
+    {&GBZ80::instruction_bit_1_HLI,     CYCLES_BIT_B_HLI,      2, 0}, //0xCB4E OP_BIT_1_HLI
+    {&GBZ80::instruction_bit_1_A,       CYCLES_BIT_B_R,        2, 0}, //0xCB4F OP_BIT_1_A
+    {&GBZ80::instruction_bit_2_B,       CYCLES_BIT_B_R,        2, 0}, //0xCB50 OP_BIT_2_B
+    {&GBZ80::instruction_bit_2_C,       CYCLES_BIT_B_R,        2, 0}, //0xCB51 OP_BIT_2_C
+    {&GBZ80::instruction_bit_2_D,       CYCLES_BIT_B_R,        2, 0}, //0xCB52 OP_BIT_2_D
+    {&GBZ80::instruction_bit_2_E,       CYCLES_BIT_B_R,        2, 0}, //0xCB53 OP_BIT_2_E
+    {&GBZ80::instruction_bit_2_H,       CYCLES_BIT_B_R,        2, 0}, //0xCB54 OP_BIT_2_H
+    {&GBZ80::instruction_bit_2_L,       CYCLES_BIT_B_R,        2, 0}, //0xCB55 OP_BIT_2_L
+    {&GBZ80::instruction_bit_2_HLI,     CYCLES_BIT_B_HLI,      2, 0}, //0xCB56 OP_BIT_2_HLI
+    {&GBZ80::instruction_bit_2_A,       CYCLES_BIT_B_R,        2, 0}, //0xCB57 OP_BIT_2_A
+    {&GBZ80::instruction_bit_3_B,       CYCLES_BIT_B_R,        2, 0}, //0xCB58 OP_BIT_3_B
+    {&GBZ80::instruction_bit_3_C,       CYCLES_BIT_B_R,        2, 0}, //0xCB59 OP_BIT_3_C
+    {&GBZ80::instruction_bit_3_D,       CYCLES_BIT_B_R,        2, 0}, //0xCB5A OP_BIT_3_D
+    {&GBZ80::instruction_bit_3_E,       CYCLES_BIT_B_R,        2, 0}, //0xCB5B OP_BIT_3_E
+    {&GBZ80::instruction_bit_3_H,       CYCLES_BIT_B_R,        2, 0}, //0xCB5C OP_BIT_3_H
+    {&GBZ80::instruction_bit_3_L,       CYCLES_BIT_B_R,        2, 0}, //0xCB5D OP_BIT_3_L
+    {&GBZ80::instruction_bit_3_HLI,     CYCLES_BIT_B_HLI,      2, 0}, //0xCB5E OP_BIT_3_HLI
+    {&GBZ80::instruction_bit_3_A,       CYCLES_BIT_B_R,        2, 0}, //0xCB5F OP_BIT_3_A
+    {&GBZ80::instruction_bit_4_B,       CYCLES_BIT_B_R,        2, 0}, //0xCB60 OP_BIT_4_B
+    {&GBZ80::instruction_bit_4_C,       CYCLES_BIT_B_R,        2, 0}, //0xCB61 OP_BIT_4_C
+    {&GBZ80::instruction_bit_4_D,       CYCLES_BIT_B_R,        2, 0}, //0xCB62 OP_BIT_4_D
+    {&GBZ80::instruction_bit_4_E,       CYCLES_BIT_B_R,        2, 0}, //0xCB63 OP_BIT_4_E
+    {&GBZ80::instruction_bit_4_H,       CYCLES_BIT_B_R,        2, 0}, //0xCB64 OP_BIT_4_H
+    {&GBZ80::instruction_bit_4_L,       CYCLES_BIT_B_R,        2, 0}, //0xCB65 OP_BIT_4_L
+    {&GBZ80::instruction_bit_4_HLI,     CYCLES_BIT_B_HLI,      2, 0}, //0xCB66 OP_BIT_4_HLI
+    {&GBZ80::instruction_bit_4_A,       CYCLES_BIT_B_R,        2, 0}, //0xCB67 OP_BIT_4_A
+    {&GBZ80::instruction_bit_5_B,       CYCLES_BIT_B_R,        2, 0}, //0xCB68 OP_BIT_5_B
+    {&GBZ80::instruction_bit_5_C,       CYCLES_BIT_B_R,        2, 0}, //0xCB69 OP_BIT_5_C
+    {&GBZ80::instruction_bit_5_D,       CYCLES_BIT_B_R,        2, 0}, //0xCB6A OP_BIT_5_D
+    {&GBZ80::instruction_bit_5_E,       CYCLES_BIT_B_R,        2, 0}, //0xCB6B OP_BIT_5_E
+    {&GBZ80::instruction_bit_5_H,       CYCLES_BIT_B_R,        2, 0}, //0xCB6C OP_BIT_5_H
+    {&GBZ80::instruction_bit_5_L,       CYCLES_BIT_B_R,        2, 0}, //0xCB6D OP_BIT_5_L
+    {&GBZ80::instruction_bit_5_HLI,     CYCLES_BIT_B_HLI,      2, 0}, //0xCB6E OP_BIT_5_HLI
+    {&GBZ80::instruction_bit_5_A,       CYCLES_BIT_B_R,        2, 0}, //0xCB6F OP_BIT_5_A
+    {&GBZ80::instruction_bit_6_B,       CYCLES_BIT_B_R,        2, 0}, //0xCB70 OP_BIT_6_B
+    {&GBZ80::instruction_bit_6_C,       CYCLES_BIT_B_R,        2, 0}, //0xCB71 OP_BIT_6_C
+    {&GBZ80::instruction_bit_6_D,       CYCLES_BIT_B_R,        2, 0}, //0xCB72 OP_BIT_6_D
+    {&GBZ80::instruction_bit_6_E,       CYCLES_BIT_B_R,        2, 0}, //0xCB73 OP_BIT_6_E
+    {&GBZ80::instruction_bit_6_H,       CYCLES_BIT_B_R,        2, 0}, //0xCB74 OP_BIT_6_H
+    {&GBZ80::instruction_bit_6_L,       CYCLES_BIT_B_R,        2, 0}, //0xCB75 OP_BIT_6_L
+    {&GBZ80::instruction_bit_6_HLI,     CYCLES_BIT_B_HLI,      2, 0}, //0xCB76 OP_BIT_6_HLI
+    {&GBZ80::instruction_bit_6_A,       CYCLES_BIT_B_R,        2, 0}, //0xCB77 OP_BIT_6_A
+    {&GBZ80::instruction_bit_7_B,       CYCLES_BIT_B_R,        2, 0}, //0xCB78 OP_BIT_7_B
+    {&GBZ80::instruction_bit_7_C,       CYCLES_BIT_B_R,        2, 0}, //0xCB79 OP_BIT_7_C
+    {&GBZ80::instruction_bit_7_D,       CYCLES_BIT_B_R,        2, 0}, //0xCB7A OP_BIT_7_D
+    {&GBZ80::instruction_bit_7_E,       CYCLES_BIT_B_R,        2, 0}, //0xCB7B OP_BIT_7_E
+    {&GBZ80::instruction_bit_7_H,       CYCLES_BIT_B_R,        2, 0}, //0xCB7C OP_BIT_7_H
+    {&GBZ80::instruction_bit_7_L,       CYCLES_BIT_B_R,        2, 0}, //0xCB7D OP_BIT_7_L
+    {&GBZ80::instruction_bit_7_HLI,     CYCLES_BIT_B_HLI,      2, 0}, //0xCB7E OP_BIT_7_HLI
+    {&GBZ80::instruction_bit_7_A,       CYCLES_BIT_B_R,        2, 0}, //0xCB7F OP_BIT_7_A
+    {&GBZ80::instruction_res_0_B,       CYCLES_RES_B_R,        2, 0}, //0xCB80 OP_RES_0_B
+    {&GBZ80::instruction_res_0_C,       CYCLES_RES_B_R,        2, 0}, //0xCB81 OP_RES_0_C
+    {&GBZ80::instruction_res_0_D,       CYCLES_RES_B_R,        2, 0}, //0xCB82 OP_RES_0_D
+    {&GBZ80::instruction_res_0_E,       CYCLES_RES_B_R,        2, 0}, //0xCB83 OP_RES_0_E
+    {&GBZ80::instruction_res_0_H,       CYCLES_RES_B_R,        2, 0}, //0xCB84 OP_RES_0_H
+    {&GBZ80::instruction_res_0_L,       CYCLES_RES_B_R,        2, 0}, //0xCB85 OP_RES_0_L
+    {&GBZ80::instruction_res_0_HLI,     CYCLES_RES_B_HLI,      2, 0}, //0xCB86 OP_RES_0_HLI
+    {&GBZ80::instruction_res_0_A,       CYCLES_RES_B_R,        2, 0}, //0xCB87 OP_RES_0_A
+    {&GBZ80::instruction_res_1_B,       CYCLES_RES_B_R,        2, 0}, //0xCB88 OP_RES_1_B
+    {&GBZ80::instruction_res_1_C,       CYCLES_RES_B_R,        2, 0}, //0xCB89 OP_RES_1_C
+    {&GBZ80::instruction_res_1_D,       CYCLES_RES_B_R,        2, 0}, //0xCB8A OP_RES_1_D
+    {&GBZ80::instruction_res_1_E,       CYCLES_RES_B_R,        2, 0}, //0xCB8B OP_RES_1_E
+    {&GBZ80::instruction_res_1_H,       CYCLES_RES_B_R,        2, 0}, //0xCB8C OP_RES_1_H
+    {&GBZ80::instruction_res_1_L,       CYCLES_RES_B_R,        2, 0}, //0xCB8D OP_RES_1_L
+    {&GBZ80::instruction_res_1_HLI,     CYCLES_RES_B_HLI,      2, 0}, //0xCB8E OP_RES_1_HLI
+    {&GBZ80::instruction_res_1_A,       CYCLES_RES_B_R,        2, 0}, //0xCB8F OP_RES_1_A
+    {&GBZ80::instruction_res_2_B,       CYCLES_RES_B_R,        2, 0}, //0xCB90 OP_RES_2_B
+    {&GBZ80::instruction_res_2_C,       CYCLES_RES_B_R,        2, 0}, //0xCB91 OP_RES_2_C
+    {&GBZ80::instruction_res_2_D,       CYCLES_RES_B_R,        2, 0}, //0xCB92 OP_RES_2_D
+    {&GBZ80::instruction_res_2_E,       CYCLES_RES_B_R,        2, 0}, //0xCB93 OP_RES_2_E
+    {&GBZ80::instruction_res_2_H,       CYCLES_RES_B_R,        2, 0}, //0xCB94 OP_RES_2_H
+    {&GBZ80::instruction_res_2_L,       CYCLES_RES_B_R,        2, 0}, //0xCB95 OP_RES_2_L
+    {&GBZ80::instruction_res_2_HLI,     CYCLES_RES_B_HLI,      2, 0}, //0xCB96 OP_RES_2_HLI
+    {&GBZ80::instruction_res_2_A,       CYCLES_RES_B_R,        2, 0}, //0xCB97 OP_RES_2_A
+    {&GBZ80::instruction_res_3_B,       CYCLES_RES_B_R,        2, 0}, //0xCB98 OP_RES_3_B
+    {&GBZ80::instruction_res_3_C,       CYCLES_RES_B_R,        2, 0}, //0xCB99 OP_RES_3_C
+    {&GBZ80::instruction_res_3_D,       CYCLES_RES_B_R,        2, 0}, //0xCB9A OP_RES_3_D
+    {&GBZ80::instruction_res_3_E,       CYCLES_RES_B_R,        2, 0}, //0xCB9B OP_RES_3_E
+    {&GBZ80::instruction_res_3_H,       CYCLES_RES_B_R,        2, 0}, //0xCB9C OP_RES_3_H
+    {&GBZ80::instruction_res_3_L,       CYCLES_RES_B_R,        2, 0}, //0xCB9D OP_RES_3_L
+    {&GBZ80::instruction_res_3_HLI,     CYCLES_RES_B_HLI,      2, 0}, //0xCB9E OP_RES_3_HLI
+    {&GBZ80::instruction_res_3_A,       CYCLES_RES_B_R,        2, 0}, //0xCB9F OP_RES_3_A
+    {&GBZ80::instruction_res_4_B,       CYCLES_RES_B_R,        2, 0}, //0xCBA0 OP_RES_4_B
+    {&GBZ80::instruction_res_4_C,       CYCLES_RES_B_R,        2, 0}, //0xCBA1 OP_RES_4_C
+    {&GBZ80::instruction_res_4_D,       CYCLES_RES_B_R,        2, 0}, //0xCBA2 OP_RES_4_D
+    {&GBZ80::instruction_res_4_E,       CYCLES_RES_B_R,        2, 0}, //0xCBA3 OP_RES_4_E
+    {&GBZ80::instruction_res_4_H,       CYCLES_RES_B_R,        2, 0}, //0xCBA4 OP_RES_4_H
+    {&GBZ80::instruction_res_4_L,       CYCLES_RES_B_R,        2, 0}, //0xCBA5 OP_RES_4_L
+    {&GBZ80::instruction_res_4_HLI,     CYCLES_RES_B_HLI,      2, 0}, //0xCBA6 OP_RES_4_HLI
+    {&GBZ80::instruction_res_4_A,       CYCLES_RES_B_R,        2, 0}, //0xCBA7 OP_RES_4_A
+    {&GBZ80::instruction_res_5_B,       CYCLES_RES_B_R,        2, 0}, //0xCBA8 OP_RES_5_B
+    {&GBZ80::instruction_res_5_C,       CYCLES_RES_B_R,        2, 0}, //0xCBA9 OP_RES_5_C
+    {&GBZ80::instruction_res_5_D,       CYCLES_RES_B_R,        2, 0}, //0xCBAA OP_RES_5_D
+    {&GBZ80::instruction_res_5_E,       CYCLES_RES_B_R,        2, 0}, //0xCBAB OP_RES_5_E
+    {&GBZ80::instruction_res_5_H,       CYCLES_RES_B_R,        2, 0}, //0xCBAC OP_RES_5_H
+    {&GBZ80::instruction_res_5_L,       CYCLES_RES_B_R,        2, 0}, //0xCBAD OP_RES_5_L
+    {&GBZ80::instruction_res_5_HLI,     CYCLES_RES_B_HLI,      2, 0}, //0xCBAE OP_RES_5_HLI
+    {&GBZ80::instruction_res_5_A,       CYCLES_RES_B_R,        2, 0}, //0xCBAF OP_RES_5_A
+    {&GBZ80::instruction_res_6_B,       CYCLES_RES_B_R,        2, 0}, //0xCBB0 OP_RES_6_B
+    {&GBZ80::instruction_res_6_C,       CYCLES_RES_B_R,        2, 0}, //0xCBB1 OP_RES_6_C
+    {&GBZ80::instruction_res_6_D,       CYCLES_RES_B_R,        2, 0}, //0xCBB2 OP_RES_6_D
+    {&GBZ80::instruction_res_6_E,       CYCLES_RES_B_R,        2, 0}, //0xCBB3 OP_RES_6_E
+    {&GBZ80::instruction_res_6_H,       CYCLES_RES_B_R,        2, 0}, //0xCBB4 OP_RES_6_H
+    {&GBZ80::instruction_res_6_L,       CYCLES_RES_B_R,        2, 0}, //0xCBB5 OP_RES_6_L
+    {&GBZ80::instruction_res_6_HLI,     CYCLES_RES_B_HLI,      2, 0}, //0xCBB6 OP_RES_6_HLI
+    {&GBZ80::instruction_res_6_A,       CYCLES_RES_B_R,        2, 0}, //0xCBB7 OP_RES_6_A
+    {&GBZ80::instruction_res_7_B,       CYCLES_RES_B_R,        2, 0}, //0xCBB8 OP_RES_7_B
+    {&GBZ80::instruction_res_7_C,       CYCLES_RES_B_R,        2, 0}, //0xCBB9 OP_RES_7_C
+    {&GBZ80::instruction_res_7_D,       CYCLES_RES_B_R,        2, 0}, //0xCBBA OP_RES_7_D
+    {&GBZ80::instruction_res_7_E,       CYCLES_RES_B_R,        2, 0}, //0xCBBB OP_RES_7_E
+    {&GBZ80::instruction_res_7_H,       CYCLES_RES_B_R,        2, 0}, //0xCBBC OP_RES_7_H
+    {&GBZ80::instruction_res_7_L,       CYCLES_RES_B_R,        2, 0}, //0xCBBD OP_RES_7_L
+    {&GBZ80::instruction_res_7_HLI,     CYCLES_RES_B_HLI,      2, 0}, //0xCBBE OP_RES_7_HLI
+    {&GBZ80::instruction_res_7_A,       CYCLES_RES_B_R,        2, 0}, //0xCBBF OP_RES_7_A
+    {&GBZ80::instruction_set_0_B,       CYCLES_SET_B_R,        2, 0}, //0xCBC0 OP_SET_0_B
+    {&GBZ80::instruction_set_0_C,       CYCLES_SET_B_R,        2, 0}, //0xCBC1 OP_SET_0_C
+    {&GBZ80::instruction_set_0_D,       CYCLES_SET_B_R,        2, 0}, //0xCBC2 OP_SET_0_D
+    {&GBZ80::instruction_set_0_E,       CYCLES_SET_B_R,        2, 0}, //0xCBC3 OP_SET_0_E
+    {&GBZ80::instruction_set_0_H,       CYCLES_SET_B_R,        2, 0}, //0xCBC4 OP_SET_0_H
+    {&GBZ80::instruction_set_0_L,       CYCLES_SET_B_R,        2, 0}, //0xCBC5 OP_SET_0_L
+    {&GBZ80::instruction_set_0_HLI,     CYCLES_SET_B_HLI,      2, 0}, //0xCBC6 OP_SET_0_HLI
+    {&GBZ80::instruction_set_0_A,       CYCLES_SET_B_R,        2, 0}, //0xCBC7 OP_SET_0_A
+    {&GBZ80::instruction_set_1_B,       CYCLES_SET_B_R,        2, 0}, //0xCBC8 OP_SET_1_B
+    {&GBZ80::instruction_set_1_C,       CYCLES_SET_B_R,        2, 0}, //0xCBC9 OP_SET_1_C
+    {&GBZ80::instruction_set_1_D,       CYCLES_SET_B_R,        2, 0}, //0xCBCA OP_SET_1_D
+    {&GBZ80::instruction_set_1_E,       CYCLES_SET_B_R,        2, 0}, //0xCBCB OP_SET_1_E
+    {&GBZ80::instruction_set_1_H,       CYCLES_SET_B_R,        2, 0}, //0xCBCC OP_SET_1_H
+    {&GBZ80::instruction_set_1_L,       CYCLES_SET_B_R,        2, 0}, //0xCBCD OP_SET_1_L
+    {&GBZ80::instruction_set_1_HLI,     CYCLES_SET_B_HLI,      2, 0}, //0xCBCE OP_SET_1_HLI
+    {&GBZ80::instruction_set_1_A,       CYCLES_SET_B_R,        2, 0}, //0xCBCF OP_SET_1_A
+    {&GBZ80::instruction_set_2_B,       CYCLES_SET_B_R,        2, 0}, //0xCBD0 OP_SET_2_B
+    {&GBZ80::instruction_set_2_C,       CYCLES_SET_B_R,        2, 0}, //0xCBD1 OP_SET_2_C
+    {&GBZ80::instruction_set_2_D,       CYCLES_SET_B_R,        2, 0}, //0xCBD2 OP_SET_2_D
+    {&GBZ80::instruction_set_2_E,       CYCLES_SET_B_R,        2, 0}, //0xCBD3 OP_SET_2_E
+    {&GBZ80::instruction_set_2_H,       CYCLES_SET_B_R,        2, 0}, //0xCBD4 OP_SET_2_H
+    {&GBZ80::instruction_set_2_L,       CYCLES_SET_B_R,        2, 0}, //0xCBD5 OP_SET_2_L
+    {&GBZ80::instruction_set_2_HLI,     CYCLES_SET_B_HLI,      2, 0}, //0xCBD6 OP_SET_2_HLI
+    {&GBZ80::instruction_set_2_A,       CYCLES_SET_B_R,        2, 0}, //0xCBD7 OP_SET_2_A
+    {&GBZ80::instruction_set_3_B,       CYCLES_SET_B_R,        2, 0}, //0xCBD8 OP_SET_3_B
+    {&GBZ80::instruction_set_3_C,       CYCLES_SET_B_R,        2, 0}, //0xCBD9 OP_SET_3_C
+    {&GBZ80::instruction_set_3_D,       CYCLES_SET_B_R,        2, 0}, //0xCBDA OP_SET_3_D
+    {&GBZ80::instruction_set_3_E,       CYCLES_SET_B_R,        2, 0}, //0xCBDB OP_SET_3_E
+    {&GBZ80::instruction_set_3_H,       CYCLES_SET_B_R,        2, 0}, //0xCBDC OP_SET_3_H
+    {&GBZ80::instruction_set_3_L,       CYCLES_SET_B_R,        2, 0}, //0xCBDD OP_SET_3_L
+    {&GBZ80::instruction_set_3_HLI,     CYCLES_SET_B_HLI,      2, 0}, //0xCBDE OP_SET_3_HLI
+    {&GBZ80::instruction_set_3_A,       CYCLES_SET_B_R,        2, 0}, //0xCBDF OP_SET_3_A
+    {&GBZ80::instruction_set_4_B,       CYCLES_SET_B_R,        2, 0}, //0xCBE0 OP_SET_4_B
+    {&GBZ80::instruction_set_4_C,       CYCLES_SET_B_R,        2, 0}, //0xCBE1 OP_SET_4_C
+    {&GBZ80::instruction_set_4_D,       CYCLES_SET_B_R,        2, 0}, //0xCBE2 OP_SET_4_D
+    {&GBZ80::instruction_set_4_E,       CYCLES_SET_B_R,        2, 0}, //0xCBE3 OP_SET_4_E
+    {&GBZ80::instruction_set_4_H,       CYCLES_SET_B_R,        2, 0}, //0xCBE4 OP_SET_4_H
+    {&GBZ80::instruction_set_4_L,       CYCLES_SET_B_R,        2, 0}, //0xCBE5 OP_SET_4_L
+    {&GBZ80::instruction_set_4_HLI,     CYCLES_SET_B_HLI,      2, 0}, //0xCBE6 OP_SET_4_HLI
+    {&GBZ80::instruction_set_4_A,       CYCLES_SET_B_R,        2, 0}, //0xCBE7 OP_SET_4_A
+    {&GBZ80::instruction_set_5_B,       CYCLES_SET_B_R,        2, 0}, //0xCBE8 OP_SET_5_B
+    {&GBZ80::instruction_set_5_C,       CYCLES_SET_B_R,        2, 0}, //0xCBE9 OP_SET_5_C
+    {&GBZ80::instruction_set_5_D,       CYCLES_SET_B_R,        2, 0}, //0xCBEA OP_SET_5_D
+    {&GBZ80::instruction_set_5_E,       CYCLES_SET_B_R,        2, 0}, //0xCBEB OP_SET_5_E
+    {&GBZ80::instruction_set_5_H,       CYCLES_SET_B_R,        2, 0}, //0xCBEC OP_SET_5_H
+    {&GBZ80::instruction_set_5_L,       CYCLES_SET_B_R,        2, 0}, //0xCBED OP_SET_5_L
+    {&GBZ80::instruction_set_5_HLI,     CYCLES_SET_B_HLI,      2, 0}, //0xCBEE OP_SET_5_HLI
+    {&GBZ80::instruction_set_5_A,       CYCLES_SET_B_R,        2, 0}, //0xCBEF OP_SET_5_A
+    {&GBZ80::instruction_set_6_B,       CYCLES_SET_B_R,        2, 0}, //0xCBF0 OP_SET_6_B
+    {&GBZ80::instruction_set_6_C,       CYCLES_SET_B_R,        2, 0}, //0xCBF1 OP_SET_6_C
+    {&GBZ80::instruction_set_6_D,       CYCLES_SET_B_R,        2, 0}, //0xCBF2 OP_SET_6_D
+    {&GBZ80::instruction_set_6_E,       CYCLES_SET_B_R,        2, 0}, //0xCBF3 OP_SET_6_E
+    {&GBZ80::instruction_set_6_H,       CYCLES_SET_B_R,        2, 0}, //0xCBF4 OP_SET_6_H
+    {&GBZ80::instruction_set_6_L,       CYCLES_SET_B_R,        2, 0}, //0xCBF5 OP_SET_6_L
+    {&GBZ80::instruction_set_6_HLI,     CYCLES_SET_B_HLI,      2, 0}, //0xCBF6 OP_SET_6_HLI
+    {&GBZ80::instruction_set_6_A,       CYCLES_SET_B_R,        2, 0}, //0xCBF7 OP_SET_6_A
+    {&GBZ80::instruction_set_7_B,       CYCLES_SET_B_R,        2, 0}, //0xCBF8 OP_SET_7_B
+    {&GBZ80::instruction_set_7_C,       CYCLES_SET_B_R,        2, 0}, //0xCBF9 OP_SET_7_C
+    {&GBZ80::instruction_set_7_D,       CYCLES_SET_B_R,        2, 0}, //0xCBFA OP_SET_7_D
+    {&GBZ80::instruction_set_7_E,       CYCLES_SET_B_R,        2, 0}, //0xCBFB OP_SET_7_E
+    {&GBZ80::instruction_set_7_H,       CYCLES_SET_B_R,        2, 0}, //0xCBFC OP_SET_7_H
+    {&GBZ80::instruction_set_7_L,       CYCLES_SET_B_R,        2, 0}, //0xCBFD OP_SET_7_L
+    {&GBZ80::instruction_set_7_HLI,     CYCLES_SET_B_HLI,      2, 0}, //0xCBFE OP_SET_7_HLI
+    {&GBZ80::instruction_set_7_A,       CYCLES_SET_B_R,        2, 0}, //0xCBFF OP_SET_7_A
+};
+
+#if THREADED_DISPATCH_ENABLED
+
+//Every opcode, one table row at a time
+#define THREADED_OPCODE_ROW(X, row) \
+    X(row##0) X(row##1) X(row##2) X(row##3) X(row##4) X(row##5) X(row##6) X(row##7) \
+    X(row##8) X(row##9) X(row##A) X(row##B) X(row##C) X(row##D) X(row##E) X(row##F)
+
+#define THREADED_OPCODES(X) \
+    THREADED_OPCODE_ROW(X, 0x0) THREADED_OPCODE_ROW(X, 0x1) THREADED_OPCODE_ROW(X, 0x2) THREADED_OPCODE_ROW(X, 0x3) \
+    THREADED_OPCODE_ROW(X, 0x4) THREADED_OPCODE_ROW(X, 0x5) THREADED_OPCODE_ROW(X, 0x6) THREADED_OPCODE_ROW(X, 0x7) \
+    THREADED_OPCODE_ROW(X, 0x8) THREADED_OPCODE_ROW(X, 0x9) THREADED_OPCODE_ROW(X, 0xA) THREADED_OPCODE_ROW(X, 0xB) \
+    THREADED_OPCODE_ROW(X, 0xC) THREADED_OPCODE_ROW(X, 0xD) THREADED_OPCODE_ROW(X, 0xE) THREADED_OPCODE_ROW(X, 0xF)
+
+#define THREADED_LABEL_ADDRESS(n) &&threaded_op_##n,
+
+//Retires the op that just ran, fetches the next one and jumps straight to its label.
+//Anything out of the ordinary (out of cycles, halted, a block that might be compiled or skipped) goes through threaded_check instead.
+#define THREADED_NEXT() \
+    retire_instruction(cycleLength); \
+    m_hot.cycles -= cycleLength; \
+    op = fetch_micro_op(); \
+    cycleLength = op->entry->cycles; \
+    if((m_hot.cycles < cycleLength) || m_hot.bStop || m_hot.bHalt || m_bSingleStep || ((USE_JIT || USE_IDLE_LOOP_DETECTION) && (m_hot.currentBlock != NULL) && (op == &m_hot.currentBlock->ops[0]))){ \
+        goto threaded_check; \
+    } \
+    goto *s_labels[op->opcode];
+
+//Same as execute_micro_op, but the opcode is known so the handler is called directly instead of through the dispatch table.
+//CB prefixed ops still go through their table entry.
+#define THREADED_LABEL(n) \
+    threaded_op_##n: \
+        if(op != &m_uncachedOp){ \
+            m_hot.currentBlockIndex++; \
+        } \
+        m_hot.PC = op->address + op->length; \
+        m_hot.operand = op->operand; \
+        (this->*(((n) == OP_IS_CB_PREFIXED) ? op->entry->handler : s_opcodeTable[(n)].handler))(); \
+        THREADED_NEXT()
+
+//Direct threaded version of the loop in tick, using labels as values.
+//Each opcode has its own label that ends by jumping to the next opcode's label, so every handler gets its own indirect branch.
+//Returns the next op once there aren't enough cycles left to run it.
+const GBZ80::MicroOp* GBZ80::run_threaded(const MicroOp* op){
+    static void* const s_labels[256] = { THREADED_OPCODES(THREADED_LABEL_ADDRESS) };
+    uint8_t cycleLength = op->entry->cycles;
+    
+threaded_check:
+    while(true){
+        if((m_hot.cycles < cycleLength) || m_bSingleStep){
+            //Single stepping is left to the normal loop so the debug prompt is shown
+            return op;
+        }
+        
+        if(USE_IDLE_LOOP_DETECTION && (m_hot.currentBlock != NULL) && (m_hot.currentBlock->idleLoopRegister != 0) && (op == &m_hot.currentBlock->ops[0])){
+            skip_idle_loop();
+        }
+        
+        if(USE_JIT && run_jit_block(op)){
+            op = fetch_micro_op();
+            cycleLength = op->entry->cycles;
+            continue;
+        }
+        
+        if(!(m_hot.bStop || (m_hot.bHalt && !IGNORE_HALT))){
+            break;
+        }
+        
+        //Nothing to run, but everything else keeps ticking
+        if(USE_HALT_FAST_FORWARD){
+            fast_forward_halt(cycleLength);
+        }
+        retire_instruction(cycleLength);
+        m_hot.cycles -= cycleLength;
+        op = fetch_micro_op();
+        cycleLength = op->entry->cycles;
+    }
+    
+    goto *s_labels[op->opcode];
+    
+    THREADED_OPCODES(THREADED_LABEL)
+    
+    return op;
+}
+
+#endif
+
 //If interrupts are enabled, handles interrupts
 void GBZ80::process_interrupts(){
     uint8_t enabledInterrupts = m_gbmemory->direct_read(INTERRUPT_ENABLE);
     uint8_t raisedFlags = m_gbmemory->direct_read(ADDRESS_IF);
     
     //Only process interrupts if they're enabled and 
-    if(m_bInterruptsEnabled && (raisedFlags > 0) && (enabledInterrupts > 0)){
+    if(m_hot.bInterruptsEnabled && (raisedFlags > 0) && (enabledInterrupts > 0)){
         
         bool bPerformInterrupt = false;
-        uint16_t interruptAddress = PC;
+        uint16_t interruptAddress = m_hot.PC;
         uint8_t currentFlag = 0x00;
         
         //Check for interrupt and set address based on priority
@@ -5892,7 +5208,7 @@ void GBZ80::process_interrupts(){
             interruptAddress = 0x60;
             
             //Joypad also disbales stop
-            m_bStop = false;
+            m_hot.bStop = false;
         } 
         
         //Perform the selected interrupt
@@ -5901,20 +5217,20 @@ void GBZ80::process_interrupts(){
             m_gbmemory->direct_write(ADDRESS_IF, raisedFlags & ~currentFlag);
             
             //Disable interrupts - originally true. Was this because of the above comment?
-            m_bInterruptsEnabled = false;
+            m_hot.bInterruptsEnabled = false;
             //m_bInterruptsEnabledNext = false;
                         
             //Store next instruction on the stack
-            instruction_push_generic(PC);
+            instruction_push_generic(m_hot.PC);
             
             //Jump to interrupt handler
-            PC = interruptAddress;
+            m_hot.PC = interruptAddress;
         }
     }
     
     //Disable halt, even if interrupts are disabled
     if(raisedFlags & enabledInterrupts){
-        m_bHalt = false;
+        m_hot.bHalt = false;
     }
 }
 
@@ -1,7 +1,9 @@
 #pragma once
 #include <stdint.h>
 #include <vector>
+#include <unordered_map>
 #include "gbmem.h"
+#include "gbbus.h"
 #include "gblcd.h"
 #include "gbaudio.h"
 #include "../IRenderer.h"
@@ -17,7 +19,46 @@
 
 #define SINGLE_STEP false
 
+//Block cache limits
+#define BLOCK_CACHE_MAX_OPS 64
+#define BLOCK_CACHE_BOOTROM_END 0x0900 //GBC boot rom is mapped up to 0x08FF
+
+//Flag bits in F
+#define FLAG_BIT_Z 0x80
+#define FLAG_BIT_N 0x40
+#define FLAG_BIT_H 0x20
+#define FLAG_BIT_C 0x10
+
+//Operations that can leave F to be worked out later
+#define LAZY_FLAGS_NONE 0
+#define LAZY_FLAGS_ADD  1
+#define LAZY_FLAGS_ADC  2
+#define LAZY_FLAGS_SUB  3 //Also used by CP
+#define LAZY_FLAGS_SBC  4
+#define LAZY_FLAGS_AND  5
+#define LAZY_FLAGS_OR   6 //Also used by XOR
+#define LAZY_FLAGS_INC  7
+#define LAZY_FLAGS_DEC  8
+
+//Threaded dispatch relies on labels as values, a GCC and Clang extension
+#if USE_THREADED_DISPATCH && defined(__GNUC__)
+#define THREADED_DISPATCH_ENABLED true
+#else
+#define THREADED_DISPATCH_ENABLED false
+#endif
+
+//Bus policy the CPU reaches memory through
+#if USE_INSTRUMENTED_BUS
+typedef GBInstrumentedBus GBCPUBus;
+#else
+typedef GBFastBus GBCPUBus;
+#endif
+
+class GBJit;
+
 class GBZ80{
+  friend class GBJit;
+  
   public:
     GBZ80(GBMem* memory, GBLCD* lcd, GBAudio* audio);
     ~GBZ80();
@@ -36,38 +77,93 @@ class GBZ80{
     void showRegisters();
     void step();
     
+    //Gets the bus the CPU accesses memory through, for setting watchpoints or reading stats in instrumented builds
+    GBCPUBus* getBus();
+    
+    //Turns skipping of idle loop passes on or off, for checking it against a run without it. Clears the block cache.
+    void setIdleLoopSkipEnabled(bool enabled);
+    
+    //Checksum of the registers, interrupt and halt state, and the cycles run since power on
+    uint32_t getStateChecksum();
+    
+    //GBZ80 is over-aligned for the hot state, which plain new doesn't honour before C++17
+    static void* operator new(size_t size);
+    static void operator delete(void* pointer);
+    
   private:
+    struct CodeBlock;
+    
+    //State touched by every instruction, kept together in one cache line.
+    //Everything else in the CPU is only used on slower paths.
+    struct alignas(64) HotState{
+        //Registers. Gameboy treats these as combined 16-bit values, but for ease of implementation we store as 8 bit values where possible
+        uint16_t AF; //Accumulator (upper) and Flags (lower)
+        uint16_t BC;
+        uint16_t DE;
+        uint16_t HL;
+        uint16_t SP; //Stack Pointer
+        uint16_t PC; //Program Counter / Pointer
+        
+        //Lazy flags. 8-bit ALU ops only record their operands, and F is worked out from them the next time it's read.
+        //While lazyFlagsOp isn't LAZY_FLAGS_NONE, the low byte of AF is out of date.
+        uint8_t lazyFlagsOp;
+        uint8_t lazyFlagsOperand1;
+        uint8_t lazyFlagsOperand2;
+        uint8_t lazyFlagsCarry; //Carry flag going into the op, for ADC, SBC, INC and DEC
+        
+        //Interrupts are enabled when bInterruptsEnabled true
+        //When bInterruptsEnabledNext is different from bInterruptsEnabled, bInterruptsEnabled will be set to the value in Next AFTER the next instruction.
+        bool bInterruptsEnabled;
+        bool bInterruptsEnabledNext;
+        
+        //Halt stops execution until next interrupt. Stop stops all execution, period.
+        bool bHalt;
+        bool bStop;
+        
+        //Immediate operand for the instruction being executed
+        uint16_t operand;
+        
+        //Block the next instruction comes from, and the memory map version it was found with
+        uint32_t currentBlockMapVersion;
+        CodeBlock* currentBlock;
+        size_t currentBlockIndex;
+        
+        //Cycles left to run this tick
+        long long cycles;
+    };
+    HotState m_hot;
+    static_assert(sizeof(HotState) == 64, "CPU hot state should fit in one cache line");
+    
     GBMem* m_gbmemory;
+    GBCPUBus m_bus;
+    
+    //All CPU memory accesses go through the bus policy
+    uint8_t readMemory(uint16_t address){
+        return m_bus.read(m_gbmemory, address);
+    }
+    
+    void writeMemory(uint16_t address, uint8_t value){
+        m_bus.write(m_gbmemory, address, value);
+    }
+    
     GBLCD* m_gblcd;
     GBAudio* m_gbaudio;
     
+    //Runs the LCD, timer and audio when they have work due
+    GBScheduler* m_scheduler;
+    
     //TODO - find a better place for this? Dont think it belongs in the CPU!
     IInputChecker* m_InputChecker;
     
-    //Interrupts are enabled when InterruptsEnabled true
-    //When InterruptsEnabledNext is different from InterruptsEnabled, InterruptsEnabled will be set to the value in Next AFTER the next instruction.
-    bool m_bInterruptsEnabled;
-    bool m_bInterruptsEnabledNext; 
-    
-    //Halt stops execution until next interrupt. Stop stops all execution, period. 
-    bool m_bHalt;
-    bool m_bStop;
-    
     //Debug single step
     bool m_bSingleStep;
     
     //System clock speed
     float m_Clock;
     
-    //Registers. Gameboy treats these as combined 16-bit values, but for ease of implementation we store as 8 bit values where possible
-    uint16_t AF; //Accumulator (upper) and Flags (lower)
-    uint16_t BC; 
-    uint16_t DE;
-    uint16_t HL;
-    uint16_t SP; //Stack Pointer
-    uint16_t PC; //Program Counter / Pointer
-
-
+    //Cycles left over from the last tick
+    long long m_timeRollover;
+    
     //Register access funcs
     uint16_t getRegisterAF();
     void setRegisterAF(uint16_t val);
@@ -113,6 +209,11 @@ class GBZ80{
     bool getFlag_C(); //Carry Flag, bit 4
     void setFlag_C(bool val); //?
     //Bits 3 through 0 are unused
+    
+    //Lazy flag funcs
+    void set_lazy_flags(uint8_t op, uint8_t operand1, uint8_t operand2, uint8_t carry);
+    uint8_t get_lazy_flags();
+    uint8_t get_lazy_carry();
  
     //8-bit load instructions
   
@@ -821,17 +922,155 @@ class GBZ80{
     
     //Execution functions
     
-    //Grabs the next two bytes and increments PC
-    uint8_t read_next_byte();
+    //Dispatch table entry. Length is the opcode length including any CB prefix, operandLength the number of immediate bytes that follow.
+    struct OpcodeEntry{
+        void (GBZ80::*handler)();
+        uint8_t cycles;
+        uint8_t length;
+        uint8_t operandLength;
+    };
+    
+    //A decoded instruction, ready to be executed without touching memory again
+    struct MicroOp{
+        const OpcodeEntry* entry;
+        uint16_t address; //Address of the opcode
+        uint16_t operand; //Immediate operand, if any
+        uint8_t opcode;   //First byte of the instruction
+        uint8_t length;   //Total length of the instruction
+    };
+    
+    //Compiled native code for a block
+    typedef void (*JitBlockFunc)(GBZ80* cpu);
+    
+    //A run of decoded instructions ending in a jump, call, return, halt or stop
+    struct CodeBlock{
+        std::vector<MicroOp> ops;
+        uint16_t startAddress;
+        bool bIsRam;
+        uint32_t pageVersion; //Memory page version at decode time. Only checked for ram blocks.
+        uint32_t execCount;   //Times the block has been entered from the interpreter, until it gets compiled
+        JitBlockFunc jitCode; //NULL until compiled. Only rom blocks are compiled.
+        uint32_t cycles;      //Cycles for every op in the block
+        uint16_t idleLoopRegister; //IO register polled by the block if it's an idle loop, 0 otherwise
+        uint32_t idleLoopCycles;   //Cycles for one pass through an idle loop
+    };
+    
+    //Block cache, keyed by (bank << 16) | address
+    std::unordered_map<uint32_t, CodeBlock*> m_blockCache;
+    
+    //Used for code that can't be cached
+    MicroOp m_uncachedOp;
+    
+    //Last arrival at the start of an idle loop
+    bool m_bIdleLoopSkip;
+    const CodeBlock* m_idleLoopBlock;
+    uint64_t m_idleLoopArrival;
+    uint8_t m_idleLoopValue;
+    
+    //Native code generator for hot rom blocks
+    GBJit* m_jit;
+    
+    //Cycles of the running compiled block already passed on to the scheduler
+    uint32_t m_jitCyclesTicked;
+    
+    //Dispatch tables indexed by opcode. CB table is indexed by the byte following the CB prefix.
+    static const OpcodeEntry s_opcodeTable[256];
+    static const OpcodeEntry s_cbOpcodeTable[256];
+    
+    //Decodes the instruction at the given address, including its immediate operand
+    void decode_opcode(uint16_t address, MicroOp& op);
+    
+    //Returns the micro-op for the instruction at PC, from the block cache when possible
+    const MicroOp* fetch_micro_op();
+    
+    //Calls the handler for a micro-op
+    void execute_micro_op(const MicroOp* op);
+    
+    //Ticks everything else along with an instruction, then handles interrupts
+    void retire_instruction(uint8_t cycleLength);
+    
+    //Skips over idle steps while halted or stopped that can't end the halt
+    void fast_forward_halt(uint8_t cycleLength);
+    
+    //Skips passes through a register polling loop that can't see the register change
+    void skip_idle_loop();
+    
+#if THREADED_DISPATCH_ENABLED
+    //Direct threaded alternative to the loop in tick
+    const MicroOp* run_threaded(const MicroOp* op);
+#endif
+    
+    //JIT functions. A compiled block only runs when it can finish before the next scheduler event, so it ticks the scheduler once at the end.
+    //Memory it can't reach directly and ops it doesn't translate call back in here, after catching the scheduler up to the op.
+    //Callbacks are passed the op's site, see JIT_SITE.
+    bool run_jit_block(const MicroOp* op);
+    void sync_jit_clock(uint32_t site);
+    void retire_jit_ops(uint32_t site);
+    bool continue_jit_block(uint32_t site);
+    bool get_interrupt_ready();
+    void clear_jit_code();
+    static uint8_t jit_read(GBZ80* cpu, uint32_t address, uint32_t site);
+    static bool jit_write(GBZ80* cpu, uint32_t address, uint32_t value, uint32_t site);
+    static bool jit_execute(GBZ80* cpu, const MicroOp* op, uint32_t site);
+    static void jit_finish(GBZ80* cpu, uint32_t site);
+    
+    //Block cache functions
+    bool get_block_region(uint16_t address, uint32_t& key, bool& bIsRam, uint16_t& regionEnd);
+    CodeBlock* find_block(uint16_t address);
+    void build_block(CodeBlock* block, uint16_t address, bool bIsRam, uint16_t regionEnd);
+    bool get_ends_block(const MicroOp& op);
+    void find_idle_loop(CodeBlock* block);
+    void clear_block_cache();
     
-    //Grabs the next two bytes and increments PC twice
-    uint16_t read_next_word();
+    //Dispatch wrappers for opcodes with immediate operands. Pass the decoded operand on to the matching instruction.
+    void opcode_ld_BC_NN();
+    void opcode_ld_B();
+    void opcode_ld_NNI_SP();
+    void opcode_ld_C();
+    void opcode_ld_DE_NN();
+    void opcode_ld_D();
+    void opcode_jr();
+    void opcode_ld_E();
+    void opcode_jr_NZ();
+    void opcode_ld_HL_NN();
+    void opcode_ld_H();
+    void opcode_jr_Z();
+    void opcode_ld_L();
+    void opcode_jr_NC();
+    void opcode_ld_SP_NN();
+    void opcode_ld_HLI_N();
+    void opcode_jr_C();
+    void opcode_ld_A_CONST();
+    void opcode_jp_NZ();
+    void opcode_jp();
+    void opcode_call_NZ();
+    void opcode_add_CONST();
+    void opcode_jp_Z();
+    void opcode_call_Z();
+    void opcode_call();
+    void opcode_adc_CONST();
+    void opcode_jp_NC();
+    void opcode_call_NC();
+    void opcode_sub_CONST();
+    void opcode_jp_C();
+    void opcode_call_C();
+    void opcode_sbc_CONST();
+    void opcode_ldh_FF00NI_A();
+    void opcode_and_CONST();
+    void opcode_add_SP_CONST();
+    void opcode_ld_NNI_A();
+    void opcode_xor_CONST();
+    void opcode_ldh_A_FF00NI();
+    void opcode_or_CONST();
+    void opcode_ldhl();
+    void opcode_ld_A_NNI();
+    void opcode_cp_CONST();
     
-    //Returns the cycle length for the passed in opcode
-    int get_cycle_length(uint8_t opcode);
+    //STOP is two bytes, the second of which should always be 0
+    void opcode_stop();
     
-    //Calls the appropriate function for the passed in opcode
-    void process_opcode(uint8_t opcode);
+    //Handler for unused opcodes
+    void opcode_invalid();
     
     //If interrupts are enabled, handles interrupts
     void process_interrupts();
@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include <iostream>
 #include <thread>
+#include <chrono>
 //SDL headers are not in an SDL2 directory on Windows
 #if defined(_WIN32) || defined(__APPLE__)
 #include <SDL.h>
@@ -15,12 +16,18 @@
 #include "gb/gblcd.h"
 #include "gb/gbaudio.h"
 #include "gb/gbserial.h"
+#include "gb/gbjit.h"
 #include "SDLBufferRenderer.h"
 #include "SDLAudioPlayer.h"
 #include "SDLInputChecker.h"
+#include "NullAudioPlayer.h"
 
 using namespace std;
 
+//Benchmark settings
+#define BENCHMARK_TICK_RATE 60.0f
+#define GB_FRAMES_PER_SECOND 59.73
+
 //Input parameters
 char* cartRomPath;
 char* bootRomPath;
@@ -155,8 +162,13 @@ void mainLoop(){
         //tick CPU, only if delta time is under a second.
         m_gbcpu->tick((deltaTime > 1.0f) ? 0 : deltaTime);
         
-        //Update frame data in the renderer
-        m_MainBufferRenderer->update(m_gblcd->getCompleteFrame(), FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT);
+        //Pass any changes to battery backed ram on to the save thread
+        m_gbcart->flushSave();
+        
+        //Hand the renderer the completed frame, only when there is a new one
+        if(m_gblcd->takeNewFrame()){
+            m_MainBufferRenderer->update(m_gblcd->getCompleteFrame(), FRAMEBUFFER_PITCH, FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT);
+        }
         
         //Render frame
         m_MainBufferRenderer->render();
@@ -173,7 +185,80 @@ void mainLoop(){
     }
 }
 
-bool parseArgs(int argc, char** argv, char* &bootRomPath, char* &cartRomPath, float &windowScale, Platform &systemType) {
+//Runs the emulator without a window as fast as possible for the given number of frames, then reports the speed.
+void runBenchmark(long benchFrames){
+    NullAudioPlayer* audioPlayer = new NullAudioPlayer();
+    m_gbaudio->setPlayer(audioPlayer);
+    
+    std::cout << "Benchmarking " << benchFrames << " frames, " << (THREADED_DISPATCH_ENABLED ? "threaded" : "table") << " dispatch, JIT " << ((USE_JIT && JIT_SUPPORTED) ? "on" : "off") << std::endl;
+    
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    while(m_gblcd->getFrames() < benchFrames){
+        m_gbcpu->tick(1.0f / BENCHMARK_TICK_RATE);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+    
+    double framesPerSecond = m_gblcd->getFrames() / elapsed.count();
+    std::cout << "Ran " << m_gblcd->getFrames() << " frames in " << elapsed.count() << "s" << std::endl;
+    std::cout << framesPerSecond << " frames per second, " << (framesPerSecond / GB_FRAMES_PER_SECOND) << "x real time" << std::endl;
+    
+    m_gbaudio->setPlayer(NULL);
+    delete audioPlayer;
+}
+
+//Checksum of everything the game can see: CPU state and cycle count, memory and the last complete frame
+uint32_t getEmulatorChecksum(){
+    uint32_t hash = m_gbcpu->getStateChecksum();
+    
+    for(uint32_t address = 0x8000; address <= 0xFFFF; address++){
+        hash = (hash ^ m_gbmem->direct_read(address)) * 16777619u;
+    }
+    
+    uint32_t* frame = m_gblcd->getCompleteFrame();
+    for(int pixel = 0; pixel < FRAMEBUFFER_PITCH * FRAMEBUFFER_HEIGHT; pixel++){
+        hash = (hash ^ frame[pixel]) * 16777619u;
+    }
+    
+    return hash;
+}
+
+//Runs the given number of frames with and without idle loop skipping, the same way as the benchmark, and checks both end up in the same state.
+//Returns false if they differ.
+bool runIdleLoopCheck(long checkFrames, Platform systemType, char* filename, char* bootrom){
+    uint32_t checksums[2];
+    
+    for(int pass = 0; pass < 2; pass++){
+        bool bSkip = (pass == 0);
+        init_gb(systemType, filename, bootrom);
+        m_gbcpu->setIdleLoopSkipEnabled(bSkip);
+        
+        NullAudioPlayer* audioPlayer = new NullAudioPlayer();
+        m_gbaudio->setPlayer(audioPlayer);
+        
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        while(m_gblcd->getFrames() < checkFrames){
+            m_gbcpu->tick(1.0f / BENCHMARK_TICK_RATE);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+        
+        checksums[pass] = getEmulatorChecksum();
+        std::cout << std::dec << "Idle loop skipping " << (bSkip ? "on" : "off") << ": " << m_gblcd->getFrames() << " frames in " << elapsed.count() << "s, checksum " << std::hex << checksums[pass] << std::dec << std::endl;
+        
+        m_gbaudio->setPlayer(NULL);
+        delete audioPlayer;
+        destroy_gb();
+    }
+    
+    if(checksums[0] != checksums[1]){
+        std::cout << "Idle loop skipping changed the emulator state!" << std::endl;
+        return false;
+    }
+    
+    std::cout << "Idle loop skipping matches running every pass" << std::endl;
+    return true;
+}
+
+bool parseArgs(int argc, char** argv, char* &bootRomPath, char* &cartRomPath, float &windowScale, Platform &systemType, long &benchFrames, long &checkFrames) {
 	bool bSuccess = true;
 	int argIndex = 1;
 	while (argIndex < argc) {
@@ -196,6 +281,12 @@ bool parseArgs(int argc, char** argv, char* &bootRomPath, char* &cartRomPath, fl
 		else if (strcmp(argv[argIndex], "-gbc") == 0) {
 			std::cout << "Forcing system to GBC" << std::endl;
 			systemType = Platform::PLATFORM_GBC;
+		} else if (strcmp(argv[argIndex], "-bench") == 0) {
+			benchFrames = atol(argv[argIndex + 1]);
+			argIndex++;
+		} else if (strcmp(argv[argIndex], "-checkidle") == 0) {
+			checkFrames = atol(argv[argIndex + 1]);
+			argIndex++;
 		} else {
 			std::cout << "Unrecognized argument " << argv[argIndex] << std::endl;
 			bSuccess = false;
@@ -224,11 +315,18 @@ int main(int argc, char** argv){
   char* bootRomPath = NULL;
   char* cartRomPath = NULL;
   float windowScale = 1.0f;
+  long benchFrames = 0;
+  long checkFrames = 0;
   thread* audioThread = nullptr;
     
   Platform systemType = Platform::PLATFORM_AUTO;
 
-  bool bArgsValid = parseArgs(argc, argv, bootRomPath, cartRomPath, windowScale, systemType);
+  bool bArgsValid = parseArgs(argc, argv, bootRomPath, cartRomPath, windowScale, systemType, benchFrames, checkFrames);
+  
+  //Idle loop check builds its own emulators, one for each run
+  if(bArgsValid && (cartRomPath != NULL) && (checkFrames > 0)){
+      return runIdleLoopCheck(checkFrames, systemType, cartRomPath, (ENABLE_BOOTROM ? bootRomPath : NULL)) ? 0 : 1;
+  }
 
   //If there is a cart path on the command line, initialize GB components.
   if (bArgsValid && (cartRomPath != NULL)) {
@@ -239,6 +337,13 @@ int main(int argc, char** argv){
 	  exit(1);
   }
   
+  //Benchmarks run headless, so skip SDL entirely
+  if(benchFrames > 0){
+      runBenchmark(benchFrames);
+      destroy_gb();
+      return 0;
+  }
+  
   //Initialize SDL
   init_sdl(windowScale);
   